@@ -1802,7 +1802,7 @@ else if ( cpu_en )
             spsr_fiq <= #`DEL  {cpsr_n,cpsr_z,cpsr_c,cpsr_v,1'b1,cpsr_f,5'b10111};
         else 
             spsr_fiq <= #`DEL  cpsr;
-    else if ( cmd_ok & ( cpsr_m==5'b11011) & ( cmd_is_msr0|cmd_is_msr1 ) & cmd[22] )
+    else if ( cmd_ok & ( cpsr_m==5'b10001) & ( cmd_is_msr0|cmd_is_msr1 ) & cmd[22] )
         spsr_fiq <= #`DEL  {{cmd[19]?sec_operand[31:28]:spsr_fiq[10:7]},{cmd[16]?{sec_operand[7:6],sec_operand[4:0]}:spsr_fiq[6:0]}}; 	
     else;
 else;		
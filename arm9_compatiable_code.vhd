@@ -2719,7 +2719,7 @@ begin
           else
             spsr_fiq <= cpsr;
           end if;
-        elsif (cmd_ok = '1' and (cpsr_m = "11011") and (cmd_is_msr0 = '1' or cmd_is_msr1= '1' ) and cmd(22) = '1') then
+        elsif (cmd_ok = '1' and (cpsr_m = "10001") and (cmd_is_msr0 = '1' or cmd_is_msr1= '1' ) and cmd(22) = '1') then
           -- spsr_fiq <= ((sec_operand(31 downto 28)
           -- when cmd(19) else spsr_fiq(10 downto 7)) & ((sec_operand(7 downto 6) & sec_operand(4 downto 0))
           -- when cmd(16) else spsr_fiq(6 downto 0)));
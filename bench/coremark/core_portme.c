@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ * Description:
+ *    CoreMark port to the core under simulation
+ *
+ *****************************************************************************/
+#include "coremark.h"
+#include "simctl.h"
+
+/******************************************************************************
+ * Public variables
+ *****************************************************************************/
+#if VALIDATION_RUN
+volatile ee_s32 seed1_volatile = 0x3415;
+volatile ee_s32 seed2_volatile = 0x3415;
+volatile ee_s32 seed3_volatile = 0x66;
+#endif
+#if PERFORMANCE_RUN
+volatile ee_s32 seed1_volatile = 0x0;
+volatile ee_s32 seed2_volatile = 0x0;
+volatile ee_s32 seed3_volatile = 0x66;
+#endif
+#if PROFILE_RUN
+volatile ee_s32 seed1_volatile = 0x8;
+volatile ee_s32 seed2_volatile = 0x8;
+volatile ee_s32 seed3_volatile = 0x8;
+#endif
+volatile ee_s32 seed4_volatile = ITERATIONS;
+volatile ee_s32 seed5_volatile = 0;
+
+ee_u32 default_num_contexts = 1;
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static CORETIMETYPE startTime, stopTime;
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+void
+start_time(void)
+{
+  simMark(1);
+  startTime = (CORETIMETYPE)simCycles();
+}
+
+void
+stop_time(void)
+{
+  stopTime = (CORETIMETYPE)simCycles();
+  simMark(2);
+}
+
+CORE_TICKS
+get_time(void)
+{
+  return (CORE_TICKS)(stopTime - startTime);
+}
+
+secs_ret
+time_in_secs(CORE_TICKS ticks)
+{
+  return (secs_ret)ticks / (secs_ret)SIM_CLOCK_HZ;
+}
+
+void
+portable_init(core_portable *p, int *argc, char *argv[])
+{
+  (void)argc;
+  (void)argv;
+
+  if (sizeof(ee_ptr_int) != sizeof(ee_u8 *))
+    ee_printf("ERROR! ee_ptr_int must hold a pointer\n");
+  if (sizeof(ee_u32) != 4)
+    ee_printf("ERROR! ee_u32 must be 32 bits\n");
+  p->portable_id = 1;
+}
+
+void
+portable_fini(core_portable *p)
+{
+  p->portable_id = 0;
+}
@@ -0,0 +1,383 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Cycles per sample of the fixed-point DSP kernels (dhry/dsp.h,
+ *    dhry/dsp_kernels.S) against the same arithmetic in plain C, compiled
+ *    with the flags of the other benchmarks:
+ *
+ *    - dot product, Q15 and Q31
+ *    - FIR, Q15 (FIR_TAPS taps) and Q31 (FIR31_TAPS taps)
+ *    - biquad cascade, Q15 (BIQ_STAGES sections)
+ *    - FFT, Q15 (FFT_N points), per point
+ *    - PID, Q15, per step
+ *
+ *    Each kernel runs RUNS times per version on the same input; the table
+ *    has the fastest run divided by the samples of a run. The C versions
+ *    are the reference: the outputs of the assembly must equal them bit
+ *    for bit. Timed region and exit status: see bench/run.sh.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dsp.h"
+#include "simctl.h"
+#include "timing.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define RUNS        4
+#define DOT_N       256
+#define FIR_TAPS    32
+#define FIR31_TAPS  16
+#define FIR_N       64
+#define BIQ_STAGES  2
+#define BIQ_N       128
+#define FFT_N       256
+#define PID_N       64
+
+typedef struct
+{
+  tTimer   c;
+  tTimer   a;
+  unsigned samples;                       /* per run */
+  unsigned errors;                        /* outputs that differ */
+} Kernel;
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static Kernel kernels[] = {
+  { TIMER_INIT("dot q15"),    TIMER_INIT(""), DOT_N, 0 },
+  { TIMER_INIT("dot q31"),    TIMER_INIT(""), DOT_N, 0 },
+  { TIMER_INIT("fir q15"),    TIMER_INIT(""), FIR_N, 0 },
+  { TIMER_INIT("fir q31"),    TIMER_INIT(""), FIR_N, 0 },
+  { TIMER_INIT("biquad q15"), TIMER_INIT(""), BIQ_N, 0 },
+  { TIMER_INIT("fft q15"),    TIMER_INIT(""), FFT_N, 0 },
+  { TIMER_INIT("pid q15"),    TIMER_INIT(""), PID_N, 0 },
+};
+
+static unsigned   seed = 1;
+
+/* input of all kernels, DOT_N >= FIR_N + FIR_TAPS and BIQ_N */
+static tQ15       a15[DOT_N], b15[DOT_N];
+static tQ31       a31[DOT_N], b31[DOT_N];
+static tQ15       h15[FIR_TAPS];
+static tQ31       h31[FIR31_TAPS];
+static tQ15       yC15[BIQ_N], yA15[BIQ_N];
+static tQ31       yC31[FIR_N], yA31[FIR_N];
+
+static tDspBiquad biqInit[BIQ_STAGES] = {
+  /* Butterworth low pass at fs / 10, +6 dB peak at fs / 4 (Q 2), Q14 */
+  { 1105, 2210, 1105, 18727, -6763, 0, 0, 0, 0 },
+  { 18836, 0, 9005, 0, -11457, 0, 0, 0, 0 },
+};
+static tDspBiquad biqC[BIQ_STAGES], biqA[BIQ_STAGES];
+
+static tQ15       twiddle[DSP_FFT_TWIDDLES(FFT_N)];
+static tDspFft    fft;
+static tCq15      fftIn[FFT_N], fftC[FFT_N], fftA[FFT_N];
+
+static tQ15       pidE[PID_N];
+static tDspPid    pidInit, pidC, pidA;
+
+/******************************************************************************
+ * Local functions
+ *****************************************************************************/
+
+/* in [-range, range) */
+static int
+noise(int range)
+{
+  seed = seed * 1103515245u + 12345u;
+  return (int)((seed >> 8) % (2u * range)) - range;
+}
+
+static tQ15
+sat15(int v)
+{
+  return v > 32767 ? 32767 : v < -32768 ? -32768 : v;
+}
+
+/* the references: the arithmetic of dsp.h in plain C */
+static int
+refDotQ15(const tQ15 *a, const tQ15 *b, unsigned n)
+{
+  int      s = 0;
+  unsigned i;
+
+  for (i = 0; i < n; i++)
+    s += a[i] * b[i];
+  return s;
+}
+
+static long long
+refDotQ31(const tQ31 *a, const tQ31 *b, unsigned n)
+{
+  long long s = 0;
+  unsigned  i;
+
+  for (i = 0; i < n; i++)
+    s += (long long)a[i] * b[i];
+  return s;
+}
+
+static void
+refFirQ15(const tQ15 *h, unsigned taps, const tQ15 *x, tQ15 *y, unsigned n)
+{
+  unsigned i, k;
+  int      s;
+
+  for (i = 0; i < n; i++) {
+    s = 0;
+    for (k = 0; k < taps; k++)
+      s += h[k] * x[i + k];
+    y[i] = sat15(s >> 15);
+  }
+}
+
+static void
+refFirQ31(const tQ31 *h, unsigned taps, const tQ31 *x, tQ31 *y, unsigned n)
+{
+  unsigned  i, k;
+  long long s;
+
+  for (i = 0; i < n; i++) {
+    s = 0;
+    for (k = 0; k < taps; k++)
+      s += (long long)h[k] * x[i + k];
+    s >>= 31;
+    y[i] = s > 0x7fffffff ? 0x7fffffff : s < -0x7fffffff - 1 ?
+           -0x7fffffff - 1 : (tQ31)s;
+  }
+}
+
+static void
+refBiquadQ15(tDspBiquad *s, unsigned stages, const tQ15 *x, tQ15 *y,
+             unsigned n)
+{
+  unsigned i;
+  int      in, out;
+
+  for (; stages > 0; stages--, s++, x = y)
+    for (i = 0; i < n; i++) {
+      in  = x[i];
+      out = sat15((s->b0 * in + s->b1 * s->x1 + s->b2 * s->x2 +
+                   s->a1 * s->y1 + s->a2 * s->y2) >> 14);
+      s->x2 = s->x1;
+      s->x1 = in;
+      s->y2 = s->y1;
+      s->y1 = out;
+      y[i]  = out;
+    }
+}
+
+static tQ15
+refPidQ15(tDspPid *p, tQ15 e)
+{
+  p->y += (p->a0 * e + p->a1 * p->e1 + p->a2 * p->e2) >> p->shift;
+  if (p->y < p->min)
+    p->y = p->min;
+  if (p->y > p->max)
+    p->y = p->max;
+  p->e2 = p->e1;
+  p->e1 = e;
+  return p->y;
+}
+
+/* y (re, im) * (c - j s) >> 15 */
+static void
+rotate(tCq15 *p, int re, int im, const tQ15 *w)
+{
+  p->re = (re * w[0] + im * w[1]) >> 15;
+  p->im = (im * w[0] - re * w[1]) >> 15;
+}
+
+static void
+refFftQ15(const tDspFft *f, tCq15 *x)
+{
+  const tQ15 *tw = f->twiddle;
+  unsigned    n = f->n, l, q, g, k, i, j, m;
+  int         t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i;
+  tCq15      *p, t;
+
+  for (l = n; l >= 4; tw += 6 * q, l >>= 2) {
+    q = l / 4;
+    for (g = 0; g < n; g += l)
+      for (k = 0; k < q; k++) {
+        p   = &x[g + k];
+        t0r = p[0].re + p[2 * q].re;
+        t0i = p[0].im + p[2 * q].im;
+        t1r = p[0].re - p[2 * q].re;
+        t1i = p[0].im - p[2 * q].im;
+        t2r = p[q].re + p[3 * q].re;
+        t2i = p[q].im + p[3 * q].im;
+        t3r = p[q].re - p[3 * q].re;
+        t3i = p[q].im - p[3 * q].im;
+        p[0].re = (t0r + t2r) >> 2;
+        p[0].im = (t0i + t2i) >> 2;
+        rotate(&p[q], (t0r - t2r) >> 2, (t0i - t2i) >> 2, &tw[6 * k]);
+        rotate(&p[2 * q], (t1r + t3i) >> 2, (t1i - t3r) >> 2,
+               &tw[6 * k + 2]);
+        rotate(&p[3 * q], (t1r - t3i) >> 2, (t1i + t3r) >> 2,
+               &tw[6 * k + 4]);
+      }
+  }
+  if (l == 2)
+    for (i = 0; i < n; i += 2) {
+      t0r = x[i].re;
+      t0i = x[i].im;
+      x[i].re     = (t0r + x[i + 1].re) >> 1;
+      x[i].im     = (t0i + x[i + 1].im) >> 1;
+      x[i + 1].re = (t0r - x[i + 1].re) >> 1;
+      x[i + 1].im = (t0i - x[i + 1].im) >> 1;
+    }
+
+  for (i = 0, j = 0; i < n - 1; i++) {
+    if (i < j) {
+      t    = x[i];
+      x[i] = x[j];
+      x[j] = t;
+    }
+    for (m = n >> 1; j & m; m >>= 1)
+      j ^= m;
+    j |= m;
+  }
+}
+
+static void
+check(Kernel *k, const void *c, const void *a, unsigned words,
+      unsigned size)
+{
+  const unsigned char *pc = c, *pa = a;
+  unsigned             i;
+
+  for (i = 0; i < words; i++)
+    if (memcmp(pc + i * size, pa + i * size, size) != 0)
+      k->errors++;
+}
+
+static void
+input(void)
+{
+  unsigned i;
+
+  for (i = 0; i < sizeof(a15) / sizeof(a15[0]); i++)
+    a15[i] = noise(8192);
+  for (i = 0; i < sizeof(b15) / sizeof(b15[0]); i++)
+    b15[i] = noise(8192);
+  for (i = 0; i < sizeof(a31) / sizeof(a31[0]); i++)
+    a31[i] = noise(0x10000000) * 4;
+  for (i = 0; i < sizeof(b31) / sizeof(b31[0]); i++)
+    b31[i] = noise(0x10000000) * 4;
+
+  /* taps around 1/16: sum |h| about 1, below 2 for Q15 */
+  for (i = 0; i < FIR_TAPS; i++)
+    h15[i] = (tQ15)(2048 - noise(1024));
+  for (i = 0; i < FIR31_TAPS; i++)
+    h31[i] = 0x08000000 - noise(0x01000000);
+
+  for (i = 0; i < FFT_N; i++) {
+    fftIn[i].re = noise(16384);
+    fftIn[i].im = noise(16384);
+  }
+  dspFftInit(&fft, FFT_N, twiddle);
+
+  for (i = 0; i < PID_N; i++)
+    pidE[i] = (tQ15)(i < PID_N / 2 ? 16384 : -8192) + noise(512);
+  /* kp 1.5, ki 0.25, kd 0.5 in Q12, output within +-0.75 */
+  dspPidInit(&pidInit, 6144, 1024, 2048, 12, -24576, 24576);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(void)
+{
+  volatile int       dot15[2];
+  volatile long long dot31[2];
+  Kernel            *k;
+  unsigned           r, i, cps, aps, errors = 0;
+
+  input();
+
+  /* no taps, n % 4 != 0: the one-output path gives 0 without a load */
+  k = &kernels[2];
+  memset(yA15, 0x55, sizeof(yA15));
+  refFirQ15(h15, 0, a15, yC15, 3);
+  dspFirQ15(h15, 0, a15, yA15, 3);
+  check(k, yC15, yA15, 3, sizeof(tQ15));
+  k->errors += yA15[3] != 0x5555;
+
+  simMark(1);
+  for (r = 0; r < RUNS; r++) {
+    k = &kernels[0];
+    TIMER_SCOPE(&k->c) dot15[0] = refDotQ15(a15, b15, DOT_N);
+    TIMER_SCOPE(&k->a) dot15[1] = dspDotQ15(a15, b15, DOT_N);
+    k->errors += dot15[0] != dot15[1];
+
+    k++;
+    TIMER_SCOPE(&k->c) dot31[0] = refDotQ31(a31, b31, DOT_N);
+    TIMER_SCOPE(&k->a) dot31[1] = dspDotQ31(a31, b31, DOT_N);
+    k->errors += dot31[0] != dot31[1];
+
+    k++;
+    TIMER_SCOPE(&k->c) refFirQ15(h15, FIR_TAPS, a15, yC15, FIR_N);
+    TIMER_SCOPE(&k->a) dspFirQ15(h15, FIR_TAPS, a15, yA15, FIR_N);
+    check(k, yC15, yA15, FIR_N, sizeof(tQ15));
+
+    k++;
+    TIMER_SCOPE(&k->c) refFirQ31(h31, FIR31_TAPS, a31, yC31, FIR_N);
+    TIMER_SCOPE(&k->a) dspFirQ31(h31, FIR31_TAPS, a31, yA31, FIR_N);
+    check(k, yC31, yA31, FIR_N, sizeof(tQ31));
+
+    k++;
+    memcpy(biqC, biqInit, sizeof(biqC));
+    memcpy(biqA, biqInit, sizeof(biqA));
+    TIMER_SCOPE(&k->c) refBiquadQ15(biqC, BIQ_STAGES, a15, yC15, BIQ_N);
+    TIMER_SCOPE(&k->a) dspBiquadQ15(biqA, BIQ_STAGES, a15, yA15, BIQ_N);
+    check(k, yC15, yA15, BIQ_N, sizeof(tQ15));
+    check(k, biqC, biqA, BIQ_STAGES, sizeof(tDspBiquad));
+
+    k++;
+    memcpy(fftC, fftIn, sizeof(fftC));
+    memcpy(fftA, fftIn, sizeof(fftA));
+    TIMER_SCOPE(&k->c) refFftQ15(&fft, fftC);
+    TIMER_SCOPE(&k->a) dspFftQ15(&fft, fftA);
+    check(k, fftC, fftA, FFT_N, sizeof(tCq15));
+
+    k++;
+    pidC = pidInit;
+    pidA = pidInit;
+    TIMER_SCOPE(&k->c) {
+      for (i = 0; i < PID_N; i++)
+        yC15[i] = refPidQ15(&pidC, pidE[i]);
+    }
+    TIMER_SCOPE(&k->a) {
+      for (i = 0; i < PID_N; i++)
+        yA15[i] = dspPidQ15(&pidA, pidE[i]);
+    }
+    check(k, yC15, yA15, PID_N, sizeof(tQ15));
+  }
+  simMark(2);
+
+  printf("dspbench: cycles per sample, fastest of %u runs\n", RUNS);
+  printf("%-12s %8s %8s %8s %8s\n", "", "samples", "C", "asm", "speedup");
+  for (k = kernels; k < kernels + sizeof(kernels) / sizeof(kernels[0]);
+       k++) {
+    /* tenths */
+    cps = (k->c.min * 10 + k->samples / 2) / k->samples;
+    aps = (k->a.min * 10 + k->samples / 2) / k->samples;
+    printf("%-12s %8u %6u.%u %6u.%u %6u.%02u\n", k->c.name, k->samples,
+           cps / 10, cps % 10, aps / 10, aps % 10, k->c.min / k->a.min,
+           k->c.min % k->a.min * 100 / k->a.min);
+    if (k->errors)
+      printf("%s: %u outputs differ from C\n", k->c.name, k->errors);
+    errors += k->errors;
+  }
+
+  exit(errors != 0);
+}
@@ -0,0 +1,33 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Embench board support for the core under simulation: the timed
+ *    region is bracketed with SIMCTL_MARK 1 and 2, bench/run.sh reads the
+ *    cycle and instret counts from the simulation log. main() returns
+ *    nonzero when the kernel fails its self check, which ends the run
+ *    with a nonzero SIM: exit status.
+ *
+ *****************************************************************************/
+#include "support.h"
+#include "simctl.h"
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+void
+initialise_board(void)
+{
+}
+
+void __attribute__((noinline))
+start_trigger(void)
+{
+  simMark(1);
+}
+
+void __attribute__((noinline))
+stop_trigger(void)
+{
+  simMark(2);
+}
@@ -0,0 +1,16 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Embench board support for the core under simulation. CPU_MHZ scales
+ *    the number of kernel iterations; 1 keeps the runs short enough for
+ *    RTL simulation.
+ *
+ *****************************************************************************/
+#ifndef _boardsupport_h_
+#define _boardsupport_h_
+
+#ifndef CPU_MHZ
+#define CPU_MHZ 1
+#endif
+
+#endif /* _boardsupport_h_ */
@@ -0,0 +1,203 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Cycles of malloc(), free() and realloc() of the heap of the runtime
+ *    (dhry/heap.c) and of a pool (dhry/pool.c) under a random workload:
+ *    SLOTS live blocks of mostly small sizes with the odd large one, each
+ *    slot freed, reallocated or allocated again in turn. Every call is
+ *    timed on its own, so the table has the worst case next to the mean;
+ *    for a bounded allocator the two stay close whatever the state of the
+ *    heap. The heap statistics at the end show its high-water mark and
+ *    how fragmented the free memory is. The contents of the blocks,
+ *    heapCheck() and a request of HEAP_MAX_ALLOC bytes are checked; the
+ *    heap is built with HEAP_SIZE_LOG2 12 here, so that request fits the
+ *    RAM. Timed region and exit status: see bench/run.sh.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "heap.h"
+#include "pool.h"
+#include "simctl.h"
+#include "timing.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define SLOTS   48
+#define ROUNDS  2000
+#define MSGS    16
+
+typedef struct
+{
+  unsigned short id;
+  unsigned short len;
+  unsigned char  data[20];
+} Msg;
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static unsigned char *slot[SLOTS];
+static unsigned       slotSize[SLOTS];
+static unsigned       seed = 1;
+static unsigned       errors;
+static unsigned       limitErrors;
+
+static tTimer stats[] = {
+  TIMER_INIT("malloc"),
+  TIMER_INIT("free"),
+  TIMER_INIT("realloc"),
+  TIMER_INIT("poolAlloc"),
+  TIMER_INIT("poolFree"),
+};
+
+POOL_MEM(msgMem, Msg, MSGS);
+static tPool msgPool;
+static Msg  *msg[MSGS];
+
+/******************************************************************************
+ * Local functions
+ *****************************************************************************/
+static unsigned
+rnd(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return seed >> 16;
+}
+
+/* one in eight blocks up to 1 KB, the others up to 96 bytes */
+static unsigned
+rndSize(void)
+{
+  unsigned r = rnd();
+
+  return (r & 7) == 0 ? (r >> 3) % 1024 : (r >> 3) % 96;
+}
+
+static void
+fill(unsigned i, unsigned from)
+{
+  unsigned k;
+
+  for (k = from; k < slotSize[i]; k++)
+    slot[i][k] = (unsigned char)(i + k);
+}
+
+static void
+verify(unsigned i)
+{
+  unsigned k;
+
+  for (k = 0; k < slotSize[i]; k++)
+    if (slot[i][k] != (unsigned char)(i + k)) {
+      errors++;
+      return;
+    }
+}
+
+static void
+step(unsigned i)
+{
+  unsigned char *p;
+  unsigned       n, old;
+
+  if (slot[i] == NULL) {
+    n = rndSize();
+    timerStart(&stats[0]);
+    p = malloc(n);
+    timerStop(&stats[0]);
+    if (p) {
+      slot[i]     = p;
+      slotSize[i] = n;
+      fill(i, 0);
+    }
+    return;
+  }
+
+  verify(i);
+  if (rnd() & 1) {
+    timerStart(&stats[1]);
+    free(slot[i]);
+    timerStop(&stats[1]);
+    slot[i] = NULL;
+  } else {
+    n = rndSize() + 1;
+    timerStart(&stats[2]);
+    p = realloc(slot[i], n);
+    timerStop(&stats[2]);
+    if (p) {
+      old         = slotSize[i];
+      slot[i]     = p;
+      slotSize[i] = n;
+      if (n > old)
+        fill(i, old);                   /* the new part only */
+    }
+  }
+}
+
+static void
+poolStep(unsigned i)
+{
+  if (msg[i] == NULL) {
+    timerStart(&stats[3]);
+    msg[i] = poolAlloc(&msgPool);
+    timerStop(&stats[3]);
+  } else {
+    timerStart(&stats[4]);
+    poolFree(&msgPool, msg[i]);
+    timerStop(&stats[4]);
+    msg[i] = NULL;
+  }
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(void)
+{
+  tHeapStats hs;
+  unsigned   r, s;
+  int        check;
+  void      *big;
+
+  poolInit(&msgPool, msgMem, sizeof(Msg), MSGS);
+
+  /* the largest request takes a region of its own from the empty heap;
+   * freed, the block must still be within the size classes (heapCheck()
+   * at the end), and a larger request must fail (one "failed" below) */
+  big = malloc(HEAP_MAX_ALLOC);
+  if (big == NULL || malloc(HEAP_MAX_ALLOC + 1) != NULL)
+    limitErrors++;
+  free(big);
+
+  simMark(1);
+  for (r = 0; r < ROUNDS; r++) {
+    step(rnd() % SLOTS);
+    poolStep(rnd() % MSGS);
+  }
+  simMark(2);
+
+  heapStats(&hs);
+  check = heapCheck();
+
+  printf("heapbench: cycles per call\n");
+  printf("%-10s %6s %6s %6s %6s\n", "", "calls", "min", "mean", "max");
+  for (s = 0; s < sizeof(stats) / sizeof(stats[0]); s++)
+    printf("%-10s %6u %6u %6u %6u\n", stats[s].name, stats[s].count,
+           stats[s].count ? stats[s].min : 0, timerMean(&stats[s]),
+           stats[s].max);
+  printf("heap %u bytes, peak %u used, %u free, largest %u, "
+         "fragmentation %u%%, %u failed\n", hs.size, hs.peak, hs.free,
+         hs.largest, hs.frag, hs.failures);
+  printf("pool %u of %u, peak %u, %u failed\n", msgPool.used, msgPool.count,
+         msgPool.peak, msgPool.failures);
+  if (errors || check || limitErrors)
+    printf("heapbench: %u blocks overwritten, heapCheck() %d, "
+           "HEAP_MAX_ALLOC %s\n", errors, check,
+           limitErrors ? "wrong" : "ok");
+
+  return errors != 0 || check != 0 || limitErrors != 0;
+}
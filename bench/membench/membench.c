@@ -0,0 +1,234 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Bytes per cycle of the string runtime (dhry/string.S) against the
+ *    byte loops it replaces: newlib-nano is built for size and its
+ *    memcpy, memmove, memset, memcmp and strcpy are the plain loops below.
+ *    Every routine runs on each size with the destination and the source
+ *    aligned, the source one byte off, and both off; memmove copies
+ *    backwards over an overlap. Each call is timed with a tTimer
+ *    (dhry/timing.h), so the call itself is counted for both. Timed
+ *    region and exit status: see bench/run.sh.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "simctl.h"
+#include "timing.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define MAX_SIZE  1024
+#define SLACK     16
+
+typedef void (*Kernel)(unsigned char *dst, unsigned char *src, unsigned n);
+
+typedef enum
+{
+  COPY,                                   /* src in A, dst in B */
+  OVERLAP,                                /* dst in A, above src */
+  COMPARE,                                /* dst a copy of src */
+  STRING                                  /* src a string of n - 1 */
+} Kind;
+
+typedef struct
+{
+  const char *name;
+  Kernel      loop;                       /* newlib-nano equivalent */
+  Kernel      fast;                       /* dhry/string.S */
+  Kind        kind;
+} Routine;
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static unsigned char bufA[MAX_SIZE + SLACK];
+static unsigned char bufB[MAX_SIZE + SLACK];
+static unsigned char bufRef[MAX_SIZE + SLACK];
+static volatile int  sink;
+static tTimer        timer = TIMER_INIT("membench");
+
+static const unsigned sizes[] = { 16, 64, 256, 1024 };
+static const unsigned align[][2] = { { 0, 0 }, { 0, 1 }, { 3, 1 } };
+
+/******************************************************************************
+ * Local functions
+ *****************************************************************************/
+
+/* the byte loops; built with -fno-tree-loop-distribute-patterns */
+static void __attribute__((noinline))
+loopCpy(unsigned char *dst, unsigned char *src, unsigned n)
+{
+  while (n--)
+    *dst++ = *src++;
+}
+
+static void __attribute__((noinline))
+loopMove(unsigned char *dst, unsigned char *src, unsigned n)
+{
+  if (dst <= src)
+    while (n--)
+      *dst++ = *src++;
+  else
+    while (n--)
+      dst[n] = src[n];
+}
+
+static void __attribute__((noinline))
+loopSet(unsigned char *dst, unsigned char *src, unsigned n)
+{
+  (void)src;
+  while (n--)
+    *dst++ = 0x5a;
+}
+
+static void __attribute__((noinline))
+loopCmp(unsigned char *dst, unsigned char *src, unsigned n)
+{
+  int d = 0;
+
+  while (n-- && (d = *dst++ - *src++) == 0)
+    ;
+  sink = d;
+}
+
+static void __attribute__((noinline))
+loopStr(unsigned char *dst, unsigned char *src, unsigned n)
+{
+  (void)n;
+  while ((*dst++ = *src++) != 0)
+    ;
+}
+
+/* the runtime; -fno-builtin keeps the calls */
+static void __attribute__((noinline))
+fastCpy(unsigned char *dst, unsigned char *src, unsigned n)
+{
+  memcpy(dst, src, n);
+}
+
+static void __attribute__((noinline))
+fastMove(unsigned char *dst, unsigned char *src, unsigned n)
+{
+  memmove(dst, src, n);
+}
+
+static void __attribute__((noinline))
+fastSet(unsigned char *dst, unsigned char *src, unsigned n)
+{
+  (void)src;
+  memset(dst, 0x5a, n);
+}
+
+static void __attribute__((noinline))
+fastCmp(unsigned char *dst, unsigned char *src, unsigned n)
+{
+  sink = memcmp(dst, src, n);
+}
+
+static void __attribute__((noinline))
+fastStr(unsigned char *dst, unsigned char *src, unsigned n)
+{
+  (void)n;
+  strcpy((char *)dst, (const char *)src);
+}
+
+static const Routine routines[] = {
+  { "memcpy",  loopCpy,  fastCpy,  COPY    },
+  { "memmove", loopMove, fastMove, OVERLAP },
+  { "memset",  loopSet,  fastSet,  COPY    },
+  { "memcmp",  loopCmp,  fastCmp,  COMPARE },
+  { "strcpy",  loopStr,  fastStr,  STRING  },
+};
+
+/* fresh buffers: a pattern in A, zeros in B */
+static void
+prepare(const Routine *r, unsigned char *dst, unsigned char *src, unsigned n)
+{
+  unsigned i;
+
+  for (i = 0; i < sizeof(bufA); i++) {
+    bufA[i] = (unsigned char)(i * 7 + 1);
+    bufB[i] = 0;
+  }
+  if (r->kind == COMPARE)
+    for (i = 0; i < n; i++)
+      dst[i] = src[i];
+  if (r->kind == STRING) {
+    for (i = 0; i + 1 < n; i++)
+      src[i] = (unsigned char)('a' + i % 26);
+    src[n - 1] = 0;
+  }
+}
+
+static unsigned
+run(Kernel k, unsigned char *dst, unsigned char *src, unsigned n)
+{
+  timerStart(&timer);
+  k(dst, src, n);
+  return timerStop(&timer);
+}
+
+/* "x.xx" */
+static void
+printRate(unsigned bytes, unsigned cycles)
+{
+  unsigned r = cycles ? bytes * 100 / cycles : 0;
+
+  printf(" %3u.%02u", r / 100, r % 100);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(void)
+{
+  unsigned r, s, a, errors = 0;
+
+  printf("membench: bytes/cycle, byte loop (newlib-nano) vs dhry/string.S\n");
+  printf("routine   size dst+ src+    loop    fast  speedup\n");
+
+  simMark(1);
+  for (r = 0; r < sizeof(routines) / sizeof(routines[0]); r++) {
+    const Routine *rt = &routines[r];
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+      for (a = 0; a < sizeof(align) / sizeof(align[0]); a++) {
+        unsigned       n   = sizes[s];
+        unsigned char *dst = bufB + align[a][0];
+        unsigned char *src = bufA + align[a][1];
+        unsigned char *out = rt->kind == OVERLAP ? bufA : bufB;
+        unsigned       slow, fast;
+        int            ref;
+
+        if (rt->kind == OVERLAP)          /* backwards: dst above src */
+          dst = bufA + 4 + align[a][0];
+
+        prepare(rt, dst, src, n);
+        slow = run(rt->loop, dst, src, n);
+        ref  = sink;
+        memcpy(bufRef, out, sizeof(bufRef));
+
+        prepare(rt, dst, src, n);
+        fast = run(rt->fast, dst, src, n);
+        if (memcmp(bufRef, out, sizeof(bufRef)) != 0 ||
+            (sink < 0) != (ref < 0) || (sink == 0) != (ref == 0)) {
+          printf("membench: %s size %u dst+%u src+%u: wrong result\n",
+                 rt->name, n, align[a][0], align[a][1]);
+          errors++;
+        }
+
+        printf("%-8s %5u %4u %4u", rt->name, n, align[a][0], align[a][1]);
+        printRate(n, slow);
+        printRate(n, fast);
+        printRate(slow, fast);
+        printf("x\n");
+      }
+  }
+  simMark(2);
+
+  return errors != 0;
+}
@@ -0,0 +1,147 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Cycles per call of the printf() family: the same cases built once
+ *    against newlib-nano (printbench-newlib) and once against the
+ *    integer-only formatter (dhry/printf.c, printbench-consol, built with
+ *    CONSOL_PRINTF). The string cases format into a buffer; the console
+ *    case includes the way into the transmit ring of dhry/uart.c. A fixed
+ *    point sensor value is %08.2hq for the formatter and %08.2f of the
+ *    value in float for newlib, which is what the callers did before.
+ *
+ *    Every case runs once before it is timed, so that newlib's first-call
+ *    set-up (the stdout buffer from _sbrk) is not counted, and its text is
+ *    checked; the heap taken is reported with the size of the code. The
+ *    CALLS calls of a case are one run of a tTimer (dhry/timing.h), the
+ *    loop included. Timed region and exit status: see bench/run.sh.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "simctl.h"
+#include "timing.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define CALLS 16
+
+#ifdef CONSOL_PRINTF
+#define LIBRARY "consol"
+#else
+#define LIBRARY "newlib-nano"
+#endif
+
+typedef struct
+{
+  const char *name;
+  int       (*run)(char *buf);
+  const char *expect;                     /* NULL: console output */
+} Case;
+
+/******************************************************************************
+ * External variables
+ *****************************************************************************/
+extern char    _etext;
+extern char    _end;
+extern caddr_t _sbrk(int incr);
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static char               buf[64];
+static volatile int       valInt   = -12345;
+static volatile unsigned  valUns   = 4000000000u;
+static volatile short     valLm75  = 0x1980;      /* 25.5 degrees, Q8.8 */
+static const char *volatile valStr = "sensor";
+static tTimer             timer    = TIMER_INIT("printbench");
+
+/******************************************************************************
+ * Local functions
+ *****************************************************************************/
+static int
+caseInt(char *b)
+{
+  return snprintf(b, sizeof(buf), "%d", valInt);
+}
+
+static int
+caseUns(char *b)
+{
+  return snprintf(b, sizeof(buf), "%u", valUns);
+}
+
+static int
+caseMixed(char *b)
+{
+  return snprintf(b, sizeof(buf), "%-8s|%6d|%08x", valStr, valInt, valUns);
+}
+
+static int
+caseFixed(char *b)
+{
+#ifdef CONSOL_PRINTF
+  return snprintf(b, sizeof(buf), "%s %08.2hq C", valStr, valLm75);
+#else
+  return snprintf(b, sizeof(buf), "%s %08.2f C", valStr, valLm75 / 256.0f);
+#endif
+}
+
+static int
+caseConsole(char *b)
+{
+  (void)b;
+  return printf("t=%d\n", valInt);
+}
+
+static const Case cases[] = {
+  { "snprintf %d",           caseInt,     "-12345"                    },
+  { "snprintf %u",           caseUns,     "4000000000"                },
+  { "snprintf %-8s|%6d|%08x", caseMixed,  "sensor  |-12345|ee6b2800"  },
+  { "snprintf fixed point",  caseFixed,   "sensor 00025.50 C"         },
+  { "printf line",           caseConsole, NULL                        },
+};
+
+static unsigned
+timeCase(int (*run)(char *))
+{
+  int i;
+
+  timerStart(&timer);
+  for (i = 0; i < CALLS; i++)
+    run(buf);
+  return timerStop(&timer);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(void)
+{
+  unsigned cycles[sizeof(cases) / sizeof(cases[0])];
+  unsigned c, errors = 0;
+
+  for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+    cases[c].run(buf);                    /* first call, not timed */
+    if (cases[c].expect && strcmp(buf, cases[c].expect) != 0)
+      errors++;
+  }
+
+  simMark(1);
+  for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    cycles[c] = timeCase(cases[c].run);
+  simMark(2);
+
+  printf("printbench: cycles per call, %s\n", LIBRARY);
+  for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    printf("%-28s %8u\n", cases[c].name, cycles[c] / CALLS);
+  printf("code %u bytes, heap %u bytes\n", (unsigned)&_etext,
+         (unsigned)(_sbrk(0) - &_end));
+  if (errors)
+    printf("printbench: %u wrong results\n", errors);
+
+  return errors != 0;
+}
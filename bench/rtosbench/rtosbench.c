@@ -0,0 +1,161 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Context switch latency of the scheduler of the runtime (dhry/rtos.c)
+ *    in cycles, and what tick-less idle saves:
+ *
+ *    - post to higher task: from before rtosSemPost() in a task to the
+ *      first instruction of the higher task it wakes (SWI, save, kernel,
+ *      restore); timerStart() in the one task, timerStop() in the other
+ *    - wait to lower task: from the higher task's rtosSemWait() back to
+ *      the task that posted
+ *    - tick to task: from the cycle of a tick to the first instruction
+ *      of the task whose rtosDelay() it ends, taken from the idle task
+ *      (IRQ, save, tick, kernel, restore)
+ *    - tick-less idle: tick interrupts taken while every task sleeps for
+ *      IDLE_TICKS ticks
+ *
+ *    A missed wake up or ticks that do not add up are errors. Timed
+ *    region and exit status: see bench/run.sh.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rtos.h"
+#include "simctl.h"
+#include "timing.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define ROUNDS      100
+#define TICK_ROUNDS 20
+#define IDLE_TICKS  100
+
+#define PRIO_CTRL   1
+#define PRIO_MID    2
+#define PRIO_HIGH   3
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static tTask    ctrlTask, midTask, highTask;
+static unsigned ctrlStack[512];
+static unsigned midStack[128];
+static unsigned highStack[128];
+
+static tSem     wake, go, done;
+static volatile unsigned highRuns;
+static unsigned idleTicks, idleIrqs, idleSleeps;
+
+static tTimer stats[] = {
+  TIMER_INIT("post to higher task"),
+  TIMER_INIT("wait to lower task"),
+  TIMER_INIT("tick to task"),
+};
+
+/******************************************************************************
+ * Local functions
+ *****************************************************************************/
+
+/* woken by ctrl, goes straight back to waiting */
+static void
+high(void *arg)
+{
+  (void)arg;
+  for (;;) {
+    rtosSemWait(&wake);
+    timerStop(&stats[0]);
+    highRuns++;
+    timerStart(&stats[1]);
+  }
+}
+
+/* sleeps while nothing else runs: every wake up comes from the idle task */
+static void
+mid(void *arg)
+{
+  tRtosStats s0, s1;
+  unsigned   i, t;
+
+  (void)arg;
+  rtosSemWait(&go);
+
+  for (i = 0; i < TICK_ROUNDS; i++) {
+    rtosDelay(1);
+    t = SIMCTL_CYCLE_LO;
+    rtosStats(&s0);
+    timerAdd(&stats[2], t - s0.tickCycle);
+  }
+
+  rtosStats(&s0);
+  rtosDelay(IDLE_TICKS);
+  rtosStats(&s1);
+  idleTicks  = s1.ticks - s0.ticks;
+  idleIrqs   = s1.tickIrqs - s0.tickIrqs;
+  idleSleeps = s1.idleSleeps - s0.idleSleeps;
+
+  rtosSemPost(&done);
+}
+
+static void
+ctrl(void *arg)
+{
+  tRtosStats rs;
+  unsigned   i, s;
+  int        errors;
+
+  (void)arg;
+  simMark(1);
+  for (i = 0; i < ROUNDS; i++) {
+    timerStart(&stats[0]);
+    rtosSemPost(&wake);
+    timerStop(&stats[1]);
+  }
+
+  rtosSemPost(&go);
+  rtosSemWait(&done);
+  simMark(2);
+
+  rtosStats(&rs);
+  errors = highRuns != ROUNDS || stats[2].count != TICK_ROUNDS ||
+           idleTicks < IDLE_TICKS || idleIrqs > 2;
+
+  printf("rtosbench: cycles per switch\n");
+  printf("%-20s %6s %6s %6s %6s\n", "", "count", "min", "mean", "max");
+  for (s = 0; s < sizeof(stats) / sizeof(stats[0]); s++)
+    printf("%-20s %6u %6u %6u %6u\n", stats[s].name, stats[s].count,
+           stats[s].count ? stats[s].min : 0, timerMean(&stats[s]),
+           stats[s].max);
+  printf("tick-less idle: %u ticks, %u tick irqs, %u sleeps\n", idleTicks,
+         idleIrqs, idleSleeps);
+  printf("%u ticks, %u tick irqs, %u irqs, %u switches\n", rs.ticks,
+         rs.tickIrqs, rs.irqs, rs.switches);
+  if (errors)
+    printf("rtosbench: %u of %u wake ups, %u of %u ticks\n", highRuns,
+           ROUNDS, idleTicks, IDLE_TICKS);
+
+  exit(errors);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(void)
+{
+  rtosSemInit(&wake, 0);
+  rtosSemInit(&go, 0);
+  rtosSemInit(&done, 0);
+
+  rtosTaskCreate(&ctrlTask, "ctrl", ctrl, NULL, PRIO_CTRL, ctrlStack,
+                 sizeof(ctrlStack) / sizeof(ctrlStack[0]));
+  rtosTaskCreate(&midTask, "mid", mid, NULL, PRIO_MID, midStack,
+                 sizeof(midStack) / sizeof(midStack[0]));
+  rtosTaskCreate(&highTask, "high", high, NULL, PRIO_HIGH, highStack,
+                 sizeof(highStack) / sizeof(highStack[0]));
+  rtosStart();
+
+  return 1;
+}
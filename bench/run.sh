@@ -0,0 +1,283 @@
+#!/bin/bash
+#
+# Benchmark runner
+#
+# Builds and simulates Dhrystone (dhry/), CoreMark, the Embench kernels,
+# membench, printbench, heapbench, rtosbench and dspbench (bench/Makefile)
+# and reports cycle-exact figures: the timed region of each benchmark is
+# bracketed by writes to the MARK register of the sim control block
+# (1 = start, 2 = stop), so start-up code and printf are not counted.
+# membench prints its bytes/cycle table to <out>/membench.uart,
+# printbench its cycles per printf call to
+# <out>/printbench-{newlib,consol}.uart, heapbench its cycles per
+# allocation to <out>/heapbench.uart, rtosbench its cycles per context
+# switch to <out>/rtosbench.uart, dspbench its cycles per sample of the
+# DSP kernels to <out>/dspbench.uart. These check their own results
+# and exit nonzero on a wrong one, which is reported as FAIL.
+#
+# usage: bench/run.sh [options] [benchmark ...]
+#
+#   -j <n>       parallel jobs (default: number of host cores)
+#   -t <sec>     per-run timeout in seconds (default: 1800)
+#   -o <dir>     output directory (default: bench/out)
+#   -n           do not (re)build the images
+#   -P           switching activity of the timed region (SIM=verilator):
+#                <out>/<benchmark>.saif and <out>/activity.csv with the
+#                toggles per block (sim/activity.h)
+#
+# Writes <out>/results.json and <out>/results.csv with, per benchmark, the
+# cycles and retired instructions of the timed region, CPI, and
+# DMIPS/MHz (Dhrystone, VAX 11/780 = 1757 Dhrystones/s) or CoreMark/MHz,
+# and the boot cycles from reset to main() (mark 256 of dhry/startup.S).
+# SIM selects the simulator flow as for regress/run.sh: iverilog (default)
+# or verilator.
+#
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+TOP_DIR=$(cd "$BENCH_DIR/.." && pwd)
+
+JOBS=$(nproc)
+TIMEOUT=1800
+OUT=$BENCH_DIR/out
+BUILD=1
+POWER=0
+SIM=${SIM:-iverilog}
+MAX_CYCLES=400000000
+
+while getopts "j:t:o:nP" opt; do
+  case $opt in
+    j) JOBS=$OPTARG ;;
+    t) TIMEOUT=$OPTARG ;;
+    o) OUT=$OPTARG ;;
+    n) BUILD=0 ;;
+    P) POWER=1 ;;
+    *) sed -n '3,33p' "$0"; exit 2 ;;
+  esac
+done
+shift $((OPTIND - 1))
+SELECT="$*"
+
+if [ $POWER -eq 1 ] && [ "$SIM" != verilator ]; then
+  echo "switching activity needs SIM=verilator"
+  exit 2
+fi
+
+#----------------------------------------------------------------------
+# IMAGES
+#----------------------------------------------------------------------
+mkdir -p "$OUT"
+if [ $BUILD -eq 1 ]; then
+  echo "build: dhry"
+  make -s -C "$TOP_DIR/dhry" > "$OUT/build-dhry.log" 2>&1 ||
+    echo "  dhry build failed, see $OUT/build-dhry.log"
+  for b in coremark embench membench printbench heapbench rtosbench dspbench; do
+    echo "build: $b"
+    make -s -k -C "$BENCH_DIR" $b > "$OUT/build-$b.log" 2>&1 ||
+      echo "  $b build failed or sources missing, see $OUT/build-$b.log"
+  done
+fi
+
+# name, image, kind
+: > "$OUT/jobs.txt"
+add_job() {
+  if [ -n "$SELECT" ] && ! echo " $SELECT " | grep -q " $1 "; then
+    return
+  fi
+  if [ ! -f "$2" ]; then
+    echo "skip: $1 ($2 not built)"
+    return
+  fi
+  printf "%s\0%s\0%s\0" "$1" "$2" "$3" >> "$OUT/jobs.txt"
+}
+
+add_job dhrystone "$TOP_DIR/dhry/dhry.bin" dhrystone
+add_job coremark "$BENCH_DIR/build/coremark.bin" coremark
+add_job membench "$BENCH_DIR/build/membench.bin" membench
+add_job printbench-newlib "$BENCH_DIR/build/printbench-newlib.bin" printbench
+add_job printbench-consol "$BENCH_DIR/build/printbench-consol.bin" printbench
+add_job heapbench "$BENCH_DIR/build/heapbench.bin" heapbench
+add_job rtosbench "$BENCH_DIR/build/rtosbench.bin" rtosbench
+add_job dspbench "$BENCH_DIR/build/dspbench.bin" dspbench
+for img in "$BENCH_DIR"/build/embench-*.bin; do
+  [ -f "$img" ] || continue
+  name=$(basename "$img" .bin)
+  add_job "${name#embench-}" "$img" embench
+done
+
+#----------------------------------------------------------------------
+# SIMULATOR FLOWS (see regress/run.sh)
+#----------------------------------------------------------------------
+sim_build_iverilog() {
+  iverilog -o "$1/tb.vvp" "$TOP_DIR/tb.v" "$TOP_DIR/arm9_compatiable_code.v"
+}
+sim_cmd_iverilog() {
+  local dir=$1; shift
+  echo vvp -n "$dir/tb.vvp" "$@"
+}
+sim_build_verilator() {
+  make -s -C "$TOP_DIR/sim" OBJ_DIR="$1/obj_dir" BIN="$1/arm9sim" EFLAGS=
+}
+sim_cmd_verilator() {
+  local dir=$1; shift
+  echo "$dir/arm9sim" "$@"
+}
+
+echo "build: testbench ($SIM)"
+if ! sim_build_$SIM "$OUT" > "$OUT/build-sim.log" 2>&1; then
+  echo "testbench build failed, see $OUT/build-sim.log"
+  exit 1
+fi
+
+#----------------------------------------------------------------------
+# ONE RUN: <name> <image> <kind>
+#
+# One result line per run:
+#   name kind status iterations cycles instret boot
+#----------------------------------------------------------------------
+run_one() {
+  local name=$1 image=$2 kind=$3
+  local log=$OUT/$name.log uart=$OUT/$name.uart
+  local c1 i1 c2 i2 boot iter simexit status rc power=""
+
+  [ $POWER -eq 1 ] && power="+activity_marks +saif=$OUT/$name.saif"
+  timeout "$TIMEOUT" $(sim_cmd_$SIM "$OUT" +binfile="$image" \
+      +uart_log="$uart" +max_cycles="$MAX_CYCLES" $power) > "$log" 2>&1
+  rc=$?
+
+  c1=$(sed -n 's/^SIM: mark=1 cycles=\([0-9]*\).*/\1/p' "$log" | head -1)
+  i1=$(sed -n 's/^SIM: mark=1 .*instret=\([0-9]*\).*/\1/p' "$log" | head -1)
+  c2=$(sed -n 's/^SIM: mark=2 cycles=\([0-9]*\).*/\1/p' "$log" | tail -1)
+  i2=$(sed -n 's/^SIM: mark=2 .*instret=\([0-9]*\).*/\1/p' "$log" | tail -1)
+  simexit=$(sed -n 's/^SIM: exit=\(-*[0-9]*\).*/\1/p' "$log" | tail -1)
+  boot=$(sed -n 's/^SIM: mark=256 cycles=\([0-9]*\).*/\1/p' "$log" | head -1)
+
+  case $kind in
+    dhrystone)
+      iter=$(sed -n 's/^Execution starts, \([0-9]*\) runs.*/\1/p' "$uart") ;;
+    coremark)
+      iter=$(sed -n 's/^Iterations *: *\([0-9]*\).*/\1/p' "$uart") ;;
+    *)
+      iter=1 ;;
+  esac
+
+  if [ $rc -eq 124 ]; then
+    status=TIMEOUT
+  elif [ -n "$simexit" ] && [ "$simexit" != 0 ]; then
+    status=FAIL
+  elif [ -z "$c1" ] || [ -z "$c2" ]; then
+    status=ERROR
+  else
+    status=OK
+  fi
+
+  if [ $status = OK ]; then
+    echo "$name $kind $status ${iter:-0} $((c2 - c1)) $((i2 - i1))" \
+         "${boot:-0}" >> "$OUT/results.txt"
+  else
+    echo "$name $kind $status 0 0 0 ${boot:-0}" >> "$OUT/results.txt"
+  fi
+  echo "$name: $status"
+}
+export -f run_one sim_cmd_$SIM
+export OUT TIMEOUT SIM TOP_DIR MAX_CYCLES POWER
+
+: > "$OUT/results.txt"
+xargs -0 -n 3 -P "$JOBS" bash -c 'run_one "$@"' _ < "$OUT/jobs.txt"
+
+#----------------------------------------------------------------------
+# REPORT
+#----------------------------------------------------------------------
+sort "$OUT/results.txt" | awk -v json="$OUT/results.json" \
+                              -v csv="$OUT/results.csv" -v sim="$SIM" '
+  function score(kind, iter, cyc) {
+    if (cyc == 0)
+      return ""
+    if (kind == "dhrystone")
+      return sprintf("%.4f", iter * 1e6 / cyc / 1757)
+    if (kind == "coremark")
+      return sprintf("%.4f", iter * 1e6 / cyc)
+    return ""
+  }
+  function unit(kind) {
+    if (kind == "dhrystone") return "DMIPS/MHz"
+    if (kind == "coremark")  return "CoreMark/MHz"
+    return ""
+  }
+  {
+    cpi = ($6 > 0) ? sprintf("%.4f", $5 / $6) : ""
+    s   = score($2, $4, $5)
+    row[n++] = sprintf("%-16s %-10s %-8s %8s %12s %12s %8s %8s %9s %s",
+                       $1, $2, $3, $4, $5, $6, cpi == "" ? "-" : cpi, $7,
+                       s == "" ? "-" : s, unit($2))
+    csvrow[n - 1] = sprintf("%s,%s,%s,%s,%s,%s,%s,%s,%s,%s",
+                            $1, $2, $3, $4, $5, $6, cpi, s, unit($2), $7)
+    js[n - 1] = sprintf("    {\"name\": \"%s\", \"kind\": \"%s\", " \
+                        "\"status\": \"%s\", \"iterations\": %d, " \
+                        "\"cycles\": %d, \"instret\": %d, " \
+                        "\"cpi\": %s, \"score\": %s, \"unit\": \"%s\", " \
+                        "\"boot_cycles\": %d}",
+                        $1, $2, $3, $4, $5, $6,
+                        cpi == "" ? "null" : cpi, s == "" ? "null" : s,
+                        unit($2), $7)
+  }
+  END {
+    print "name,kind,status,iterations,cycles,instret,cpi,score,unit," \
+          "boot_cycles" > csv
+    printf "{\n  \"simulator\": \"%s\",\n  \"benchmarks\": [\n", sim > json
+    for (i = 0; i < n; i++) {
+      print csvrow[i] > csv
+      printf "%s%s\n", js[i], (i < n - 1) ? "," : "" > json
+    }
+    printf "  ]\n}\n" > json
+
+    print ""
+    print "=== Benchmark summary ===================================================="
+    print ""
+    printf "%-16s %-10s %-8s %8s %12s %12s %8s %8s %9s\n",
+           "BENCHMARK", "KIND", "STATUS", "ITER", "CYCLES", "INSTRET",
+           "CPI", "BOOT", "SCORE"
+    printf "%-16s %-10s %-8s %8s %12s %12s %8s %8s %9s\n",
+           "=========", "====", "======", "====", "======", "=======",
+           "===", "====", "====="
+    for (i = 0; i < n; i++)
+      print row[i]
+    print ""
+  }'
+echo "results: $OUT/results.json $OUT/results.csv"
+
+#----------------------------------------------------------------------
+# SWITCHING ACTIVITY: the "SIM: activity" lines of every log
+#----------------------------------------------------------------------
+if [ $POWER -eq 1 ]; then
+  echo "name,block,bits,toggles,per_cycle,alpha,share,idle" \
+      > "$OUT/activity.csv"
+  for log in "$OUT"/*.log; do
+    name=$(basename "$log" .log)
+    case $name in build-*) continue ;; esac
+    sed -n 's/^SIM: activity \([a-z]*\) *bits=\([0-9]*\) *toggles=\([0-9]*\) *per_cycle=\([0-9.]*\) *alpha=\([0-9.]*\) *share= *\([0-9.]*\)% *idle= *\([0-9.]*\)%.*/\1,\2,\3,\4,\5,\6,\7/p' \
+        "$log" | sed "s/^/$name,/"
+  done >> "$OUT/activity.csv"
+
+  echo ""
+  echo "=== Switching activity (toggles per cycle) ================================"
+  echo ""
+  awk -F, 'NR > 1 {
+             if (!($1 in seen)) { seen[$1] = 1; names[n++] = $1 }
+             if (!($2 in bseen)) { bseen[$2] = 1; blocks[m++] = $2 }
+             v[$1, $2] = $4
+           }
+           END {
+             printf "%-16s", "BENCHMARK"
+             for (j = 0; j < m; j++) printf " %9s", blocks[j]
+             printf "\n"
+             for (i = 0; i < n; i++) {
+               printf "%-16s", names[i]
+               for (j = 0; j < m; j++) printf " %9s", v[names[i], blocks[j]]
+               printf "\n"
+             }
+           }' "$OUT/activity.csv"
+  echo ""
+  echo "activity: $OUT/activity.csv $OUT/*.saif"
+fi
+
+! grep -qE ' (FAIL|ERROR|TIMEOUT) ' "$OUT/results.txt"
@@ -59,20 +59,38 @@
 #define stackSize_UND     0//64
 #define stackSize_ABT     0//64
 //#define stackSize_IRQ   2048
-#define stackSize_IRQ	  0x80//64
+/* the IRQ stack takes the handler trampoline of startup.S (2 words) and
+ * the C code behind it: irqHandler() and uartTxIrq() of framework.c, or the
+ * kernel of rtos.c, whose deepest path rtosIrq() -> schedule() is about
+ * 24 words. The application handler of rtosSetIrqHandler() comes on top */
+#define stackSize_IRQ    0x200//64
 #define stackSize_FIQ     0//64
 
 /* define consol settings */
 #define CONSOL_UART              0
 #define CONSOL_BITRATE      115200
 /*#define USE_UART_FIFO             FALSE  */      /* Will be added in a future release */
-/*#define UART_API_NONBLOCKING      FALSE  */      /* Will be added in a future release */
-/*#define UART_API_NONBLOCKING_SIZE   512  */      /* Will be added in a future release */
+#define UART_API_NONBLOCKING          1            /* 0 = sendchar() waits for the transmitter,
+                                                      1 = ring buffer drained by the TX interrupt (uart.c) */
+#define UART_API_NONBLOCKING_SIZE   512            /* ring buffer size, a power of two */
 #define CONSOL_STARTUP_DELAY                       /* Short startup delay in order to remove
                                                       risk for false startbit detection,
                                                       timer #1 will be used in polled mode */
 #define CONSOL_STARTUP_DELAY_LENGTH 100            /* 100 us is slightly more than one character at 115200 bps */
 
+/* define heap settings (heap.c) */
+#ifndef HEAP_SIZE_LOG2
+#define HEAP_SIZE_LOG2      16   /* blocks up to 2^HEAP_SIZE_LOG2 - 1 bytes */
+#endif
+#define HEAP_GROW         1024   /* the heap takes at least this much from _sbrk() at a time */
+
+/* define the timer tick (framework.c) */
+#define TICK_CYCLES       10000   /* cycles per tick of timeval, the period of tb.v */
+
+/* define RTOS settings (rtos.c) */
+#define RTOS_TICK_CYCLES  10000   /* cycles per tick, 10 ms at the 1 MHz of tb.v */
+#define RTOS_IDLE_MAX      1000   /* ticks the idle task sleeps through at most */
+
 
 #define USE_NEWLIB           0   /* 0 = do not use newlib (= save about 22k FLASH),
                                     1 = use newlib = full implementation of printf(), scanf(), and malloc() */
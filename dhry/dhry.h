@@ -357,6 +357,15 @@
 #endif
                /* Use Microsoft C hi-res clock */
 
+#ifdef CYCLE_CLOCK
+#undef HZ
+#undef TIMES
+#undef MSC_CLOCK
+#include "timing.h"
+#define HZ     SIM_CLOCK_HZ
+#endif
+               /* Use the cycle counter of the simulation (timing.h) */
+
 #ifdef TIMES
 #include <sys/types.h>
 #include <sys/times.h>
@@ -18,6 +18,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include "dhry.h"
+#include "simctl.h"
 
 //extern int _HEAP_START;
 extern int _end;
@@ -65,6 +66,10 @@ extern long     time(long *);
 extern clock_t clock(void);
 #define Too_Small_Time (2*HZ)
 #endif
+#ifdef CYCLE_CLOCK
+#define Too_Small_Time (HZ/100)
+                /* Exact to the cycle: 10 ms are plenty */
+#endif
 
 long            Begin_Time,
                 End_Time,
@@ -246,7 +251,7 @@ int main (int argc, char **argv)
   {
     int n;
 #ifdef LPC2104
-    n = 6000;
+    n = 2000;
 #else
     scanf ("%d", &n);
 #endif
@@ -270,6 +275,10 @@ int main (int argc, char **argv)
 #ifdef MSC_CLOCK
   Begin_Time = clock();
 #endif
+#ifdef CYCLE_CLOCK
+  Begin_Time = (long) cyclesNow();
+#endif
+  simMark(1);
 
 
   for (Run_Index = 1; Run_Index <= Number_Of_Runs; ++Run_Index)
@@ -325,6 +334,8 @@ int main (int argc, char **argv)
   /* Stop timer */
   /**************/
 
+  simMark(2);
+
 #ifdef TIMES
   times (&time_info);
   End_Time = (long) time_info.tms_utime;
@@ -335,6 +346,9 @@ int main (int argc, char **argv)
 #ifdef MSC_CLOCK
   End_Time = clock();
 #endif
+#ifdef CYCLE_CLOCK
+  End_Time = (long) cyclesNow();
+#endif
 
   printf ("Execution ends\n");
   printf ("\n");
@@ -0,0 +1,124 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Fixed-point DSP kernels for the core (dsp_kernels.S, dsp.c): dot
+ *    product, FIR, biquad cascade, radix-4/2 FFT and PID, in Q15 and Q31.
+ *
+ *    The kernels are scheduled for the multiplier and the load pipeline of
+ *    the core:
+ *
+ *    - MUL and MLA take one cycle, SMULL and SMLAL two (hold_en), so every
+ *      Q15 kernel accumulates the 30-bit products in a 32-bit register
+ *      with MLA; only the Q31 kernels take SMLAL into 64 bits
+ *    - accumulators, coefficients and filter state stay in registers for
+ *      a whole block: the FIR computes four outputs per pass, so each
+ *      coefficient and sample load feeds four MLAs, and a biquad stage
+ *      loads its coefficients and state with one LDMIA
+ *    - every load has two instructions between it and its use, and the
+ *      result of MUL, MLA or a data operation is not the shifted or
+ *      multiplied operand of the next instruction, so the inner loops do
+ *      not stall (wait_en)
+ *
+ *    ARMv4 has no saturating arithmetic: results that narrow are clamped
+ *    with a compare of the bits above the sign, as the C reference of each
+ *    kernel in bench/dspbench does, bit for bit. The 32-bit accumulators
+ *    wrap: the limits on the gains below keep them in range.
+ *
+ *****************************************************************************/
+#ifndef _dsp_h_
+#define _dsp_h_
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+typedef short tQ15;                       /* [-1, 1) in 1.15 */
+typedef int   tQ31;                       /* [-1, 1) in 1.31 */
+
+typedef struct
+{
+  tQ15 re;
+  tQ15 im;
+} tCq15;
+
+/* one second order section, y = b0 x + b1 x1 + b2 x2 + a1 y1 + a2 y2;
+ * coefficients and state in the order dsp_kernels.S loads them */
+typedef struct
+{
+  int b0, b1, b2;                         /* Q2.14 */
+  int a1, a2;                             /* Q2.14, negated: y += a1 y1 */
+  int x1, x2;                             /* last two inputs, Q15 */
+  int y1, y2;                             /* last two outputs, Q15 */
+} tDspBiquad;
+
+/* PID in incremental form: y += (a0 e + a1 e1 + a2 e2) >> shift, with
+ * a0 = kp + ki + kd, a1 = -(kp + 2 kd), a2 = kd (dspPidInit()). y is
+ * the integrator: clamping it to [min, max] is the anti-windup. */
+typedef struct
+{
+  int a0, a1, a2;                         /* Q(shift) */
+  int shift;
+  int e1, e2;                             /* last two errors, Q15 */
+  int y;                                  /* output, Q15 */
+  int min, max;
+} tDspPid;
+
+#define DSP_FFT_MAX         1024
+
+/* tQ15 words of twiddles for an 'n' point FFT (6 per butterfly of each
+ * radix-4 stage) */
+#define DSP_FFT_TWIDDLES(n) (2 * (n))
+
+typedef struct
+{
+  unsigned    n;
+  const tQ15 *twiddle;                    /* per stage and butterfly */
+} tDspFft;
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+
+/* sum of a[i] * b[i], i < n: Q30 in 32 bits, wraps */
+int       dspDotQ15(const tQ15 *a, const tQ15 *b, unsigned n);
+
+/* sum of a[i] * b[i], i < n: Q62 */
+long long dspDotQ31(const tQ31 *a, const tQ31 *b, unsigned n);
+
+/* y[i] = sum of h[k] * x[i + k], k < taps, i < n, narrowed with
+ * saturation: >> 15 for Q15, >> 31 for Q31. h is the impulse response
+ * reversed; x holds n + taps - 1 samples, oldest first, and the next
+ * block starts at x + n. The Q15 sum is 32 bits: sum |h[k]| < 2. */
+void      dspFirQ15(const tQ15 *h, unsigned taps, const tQ15 *x, tQ15 *y,
+                    unsigned n);
+void      dspFirQ31(const tQ31 *h, unsigned taps, const tQ31 *x, tQ31 *y,
+                    unsigned n);
+
+/* run x[0..n-1] through 'stages' sections in turn into y, which may be x.
+ * Each output is the 32-bit sum >> 14, saturated: |b0| + |b1| + |b2| +
+ * |a1| + |a2| < 4 keeps the sum from wrapping. */
+void      dspBiquadQ15(tDspBiquad *s, unsigned stages, const tQ15 *x,
+                       tQ15 *y, unsigned n);
+
+/* gains in Q(shift); the sum is 32 bits: |a0| + |a1| + |a2| < 65536 */
+void      dspPidInit(tDspPid *p, int kp, int ki, int kd, int shift,
+                     tQ15 min, tQ15 max);
+
+/* one step with error e (setpoint - measurement); the new output */
+tQ15      dspPidQ15(tDspPid *p, tQ15 e);
+
+/* set up an 'n' point FFT, n a power of two from 4 to DSP_FFT_MAX, with
+ * twiddle[DSP_FFT_TWIDDLES(n)]; 0, or -1 for another n */
+int       dspFftInit(tDspFft *f, unsigned n, tQ15 *twiddle);
+
+/* forward FFT in place, scaled by 1/n, in natural order. Radix-4 stages
+ * (>> 2 each), one radix-2 stage (>> 1) when n is not a power of four,
+ * then bit reversal. Inputs of magnitude up to 1 do not overflow. */
+void      dspFftQ15(const tDspFft *f, tCq15 *x);
+
+/* the stages, for dspFftQ15(): one radix-4 stage over sub-transforms of
+ * 'l' points, with the twiddles of that stage; the final radix-2 stage */
+void      dspFftRadix4Q15(tCq15 *x, unsigned n, unsigned l,
+                          const tQ15 *twiddle);
+void      dspFftRadix2Q15(tCq15 *x, unsigned n);
+
+#endif /* _dsp_h_ */
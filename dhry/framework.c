@@ -14,6 +14,8 @@
 //#include "lpc2xxx.h"                            /* LPC2xxx definitions */
 #include <stdio.h>
 #include "config.h"
+#include "simctl.h"
+#include "uart.h"
 //#include "framework.h"
 
 /******************************************************************************
@@ -105,6 +107,7 @@ exceptionHandlerUndef(void)
   //consolSendString("Undefined instruction exception !!!\nAddress: 0x");
   //consolSendNumber(16, 8, 0, '0', value);
   printf("Undefined instruction exception !!!\nAddress: 0x%08x\n", value);
+  uartFlush();
   while(1)
     ;
 }
@@ -134,6 +137,7 @@ exceptionHandlerSwi(void)
   //consolSendString("SWI exception !!!\nAddress: 0x");
   //consolSendNumber(16, 8, 0, '0', value); 
   printf("SWI exception !!!\nAddress: 0x%08x\n", value);
+  uartFlush();
   while(1)
     ;
 }
@@ -163,6 +167,7 @@ exceptionHandlerPabort()
   //consolSendString("Pabort exception !!!\nAddress: 0x");
   //consolSendNumber(16, 8, 0, '0', value);
   printf("Pabort exception !!!\nAddress: 0x%08x\n", value);
+  uartFlush();
   while(1)
     ;
 }
@@ -192,6 +197,7 @@ exceptionHandlerDabort(void)
   //consolSendString("Dabort exception !!!\nAddress: 0x");
   //consolSendNumber(16, 8, 0, '0', value);
   printf("Dabort exception !!!\nAddress: 0x%08x\n", value);
+  uartFlush();
   while(1)
     ;
 }
@@ -222,6 +228,7 @@ exceptionHandlerFiq(void)
   //consolSendString("FIQ exception !!!\nAddress: 0x");
   //consolSendNumber(16, 8, 0, '0', value);
   printf("FIQ exception !!!\nAddress: 0x%08x\n", value);
+  uartFlush();
   while(1)
     ;
 }
@@ -229,13 +236,17 @@ exceptionHandlerFiq(void)
 long timeval = 0;
 
 #if (IRQ_HANDLER == 0)
+static unsigned int tickCmp;                    /* TICK_CMP as programmed */
+
 /*****************************************************************************
  *
  * Description:
- *    Default exception handler for normal interrupts. This handler should
- *    normally never be used.
- *    Prints information and halt. Observe that code execture in exception
- *    mode (as opposed to supervisor mode, which is the normal execution mode).
+ *    Default exception handler for normal interrupts: serves the serial
+ *    transmit interrupt (uart.c), then counts the timer ticks that are
+ *    due. Both are checked on every entry: the tick compare holds irq
+ *    until TICK_CMP moves on, so a tick that comes with the transmit
+ *    interrupt, or while interrupts are off, is counted late but not
+ *    lost.
  *
  ****************************************************************************/
 #ifdef __IAR_SYSTEMS_ICC__
@@ -257,7 +268,18 @@ exceptionHandlerIrq(void)
   //printf("IRQ exception !!!\nAddress: 0x%08x\n", value);
   //while(1)
   //  ;
-  timeval++;
+
+  uartTxIrq();
+
+  if ((int)(SIMCTL_CYCLE_LO - tickCmp) >= 0)
+  {
+    do
+    {
+      timeval++;
+      tickCmp += TICK_CYCLES;
+    } while ((int)(SIMCTL_CYCLE_LO - tickCmp) >= 0);
+    TICK_CMP = tickCmp;
+  }
 }
 #endif
 
@@ -283,6 +305,12 @@ exceptionHandlerInit(void)
 
 #if (IRQ_HANDLER == 0)
   pISR_IRQ    = (unsigned int)exceptionHandlerIrq;
+
+  /* the tick from the compare register instead of the periodic tick of
+     the testbench, which is a one-cycle pulse on the shared irq line */
+  tickCmp     = SIMCTL_CYCLE_LO + TICK_CYCLES;
+  TICK_CMP    = tickCmp;
+  TICK_CTRL   = TICK_CTRL_CMP;
 #endif
 
 #ifndef __IAR_SYSTEMS_ICC__
@@ -526,14 +554,16 @@ char * _sbrk_r (struct _reent *ptr, int nbytes)
 
     if (!heap_ptr)  {// if it is the very first time for memory allocation.
 //	   heap_ptr = (char *)&_heap_begin;      // the begining of the heap memory.
-	   heap_ptr = pHeapStart;
-	printf("Heap: %08x - %08x\n", pHeadStart, pHeapEnd);
+	   heap_ptr = (char *)pHeapStart;
+	printf("Heap: %08x - %08x\n", (unsigned)pHeapStart, (unsigned)pHeapEnd);
+    }
+    // out of heap memory: the stacks start at pHeapEnd, malloc() returns NULL
+    if ( nbytes > (char *)pHeapEnd - heap_ptr || nbytes < (char *)pHeapStart - heap_ptr ) {
+        ptr->_errno = ENOMEM;
+        return (char *)-1;
     }
     base = heap_ptr;
     heap_ptr += nbytes;
-//    if ( heap_ptr >= ( char *) &_heap_end )
-    if ( heap_ptr >= pHeapEnd )
-        _exit_r( 666);  // out of heap memory!!!
     return base;
 }
 
@@ -576,3 +606,129 @@ void * __get_memtop(void)
 }
 
 #endif
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Hooks for newlib that end the simulation, give a time base and
+ *    reach host files through the simulation control block of the
+ *    testbench (see simctl.h). The console (handles 0..2) stays on the
+ *    serial port in uart.c.
+ *
+ ****************************************************************************/
+#include <fcntl.h>
+#include <sys/times.h>
+#include <time.h>
+#include "simctl.h"
+#include "timing.h"
+
+static int
+simHostCall(int cmd, unsigned int arg0, unsigned int arg1, unsigned int arg2)
+{
+  SIMCTL_ARG0 = arg0;
+  SIMCTL_ARG1 = arg1;
+  SIMCTL_ARG2 = arg2;
+  SIMCTL_CMD  = cmd;
+  return SIMCTL_CMD;
+}
+
+unsigned long long
+simCycles(void)
+{
+  return cyclesNow();
+}
+
+unsigned long long
+simInstret(void)
+{
+  unsigned int lo = SIMCTL_INSTRET_LO;    /* latches the high word */
+
+  return ((unsigned long long)SIMCTL_INSTRET_HI << 32) | lo;
+}
+
+void
+simMark(unsigned int value)
+{
+  SIMCTL_MARK = value;
+}
+
+void
+_exit(int status)
+{
+  uartFlush();
+  SIMCTL_EXIT = status;
+  while (1)
+    ;                                     /* not simulated: halt here */
+}
+
+int
+_open(const char *name, int flags, int mode)
+{
+  int hostMode;
+
+  (void)mode;
+  if ((flags & O_ACCMODE) == O_RDONLY)
+    hostMode = SIMCTL_MODE_READ;
+  else if (flags & O_APPEND)
+    hostMode = SIMCTL_MODE_APPEND;
+  else
+    hostMode = SIMCTL_MODE_WRITE;
+
+  return simHostCall(SIMCTL_OPEN, (unsigned int)name, hostMode, 0);
+}
+
+int
+_close(int file)
+{
+  if (file <= 2)
+    return -1;
+  return simHostCall(SIMCTL_CLOSE, file, 0, 0);
+}
+
+int
+_write(int file, char *ptr, int len)
+{
+  int written = 0;
+
+  if (file > 2)
+    return simHostCall(SIMCTL_WRITE, file, (unsigned int)ptr, len);
+  if (file == 0)
+    return -1;
+
+  for (; len != 0; --len) {
+    sendchar(*ptr++);
+    ++written;
+  }
+  return written;
+}
+
+int
+_read(int file, char *ptr, int len)
+{
+  int read = 0;
+
+  if (file > 2)
+    return simHostCall(SIMCTL_READ, file, (unsigned int)ptr, len);
+  if (file != 0)
+    return -1;
+
+  for (; len > 0; --len) {
+    *ptr++ = getkey();
+    read++;
+  }
+  return read;
+}
+
+clock_t
+_times(struct tms *tp)
+{
+  clock_t ticks = cyclesNow() / (SIM_CLOCK_HZ / CLOCKS_PER_SEC);
+
+  if (tp) {
+    tp->tms_utime  = ticks;
+    tp->tms_stime  = 0;
+    tp->tms_cutime = 0;
+    tp->tms_cstime = 0;
+  }
+  return ticks;
+}
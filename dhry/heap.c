@@ -0,0 +1,544 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Two-level segregated fit heap (see heap.h).
+ *
+ *    Every block starts with a header of the previous block in memory and
+ *    the size of its data area; a free block keeps its free list links in
+ *    the data area. A region taken from _sbrk() ends with a used block of
+ *    size 0, so merging stops there; when the next region follows it
+ *    directly, that end block becomes the header of the new free block.
+ *    Two free blocks are never neighbours.
+ *
+ *    The size class of a block is the position of its top bit (first
+ *    level) and the next three bits (second level). ARMv4 has no CLZ, so
+ *    fls() finds the top bit in five steps.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * Includes
+ *****************************************************************************/
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <reent.h>
+#include <sys/types.h>
+
+#include "config.h"
+#include "heap.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define ALIGN     8
+#define SL_LOG2   3
+#define SL_COUNT  (1 << SL_LOG2)
+#define FL_SHIFT  (SL_LOG2 + 3)                 /* linear classes below 64 */
+#define SMALL     (1u << FL_SHIFT)
+#define FL_COUNT  (HEAP_SIZE_LOG2 - FL_SHIFT + 1)
+#define MAX_SIZE  ((1u << HEAP_SIZE_LOG2) - ALIGN)
+
+#define FREE      1u                            /* in Block.size */
+
+typedef struct Block
+{
+  struct Block *prev;                           /* block below, NULL: first */
+  unsigned      size;                           /* data bytes | FREE */
+  struct Block *nextFree;                       /* free blocks only */
+  struct Block *prevFree;
+} Block;
+
+#define HDR           offsetof(Block, nextFree)
+#define MIN_SIZE      (sizeof(Block) - HDR)
+#define SIZE(b)       ((b)->size & ~FREE)
+#define NEXT(b)       ((Block *)((char *)(b) + HDR + SIZE(b)))
+#define ROUND(n)      (((n) + ALIGN - 1) & ~(ALIGN - 1))
+
+#define MAX_ALLOC     (MAX_SIZE - 2 * HDR - ALIGN)
+
+/* the header keeps the data area aligned; FL_COUNT bits fit in flMap */
+typedef char hdrCheck[(HDR % ALIGN) == 0 && FL_COUNT <= 32 ? 1 : -1];
+
+/* no block taken from _sbrk() is larger than the classes reach */
+typedef char growCheck[MAX_ALLOC == HEAP_MAX_ALLOC &&
+                       HEAP_GROW <= MAX_SIZE ? 1 : -1];
+
+/******************************************************************************
+ * External functions
+ *****************************************************************************/
+extern caddr_t _sbrk(int incr);
+extern void    __malloc_lock(struct _reent *r);
+extern void    __malloc_unlock(struct _reent *r);
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static Block        *lists[FL_COUNT][SL_COUNT];
+static unsigned      flMap;                     /* non-empty first levels */
+static unsigned char slMap[FL_COUNT];           /* non-empty lists */
+static Block        *top;                       /* end of the last region */
+
+static unsigned      heapSize;
+static unsigned      usedBytes;
+static unsigned      peakBytes;
+static unsigned      freeBytes;
+static unsigned      allocCount;
+static unsigned      freeCount;
+static unsigned      failCount;
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+/* index of the top bit of x != 0 */
+static int
+fls(unsigned x)
+{
+  int n = 0;
+
+  if (x & 0xffff0000) { n += 16; x >>= 16; }
+  if (x & 0x0000ff00) { n +=  8; x >>=  8; }
+  if (x & 0x000000f0) { n +=  4; x >>=  4; }
+  if (x & 0x0000000c) { n +=  2; x >>=  2; }
+  if (x & 0x00000002) { n +=  1; }
+  return n;
+}
+
+/* index of the lowest bit of x != 0 */
+static int
+ffs0(unsigned x)
+{
+  return fls(x & -x);
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Size class of a block of 'size' data bytes.
+ *
+ ****************************************************************************/
+static void
+mapping(unsigned size, int *fl, int *sl)
+{
+  int t;
+
+  if (size < SMALL) {
+    *fl = 0;
+    *sl = size / (SMALL / SL_COUNT);
+  } else {
+    t   = fls(size);
+    *fl = t - FL_SHIFT + 1;
+    *sl = (size >> (t - SL_LOG2)) - SL_COUNT;
+  }
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    First non-empty list at or above the class of 'size' rounded up to
+ *    the next class boundary: every block in it is large enough. NULL
+ *    when there is none.
+ *
+ ****************************************************************************/
+static Block *
+findFree(unsigned size)
+{
+  unsigned map;
+  int      fl, sl;
+
+  if (size >= SMALL)
+    size += (1u << (fls(size) - SL_LOG2)) - 1;
+  mapping(size, &fl, &sl);
+  if (fl >= FL_COUNT)
+    return NULL;
+
+  map = slMap[fl] & (~0u << sl);
+  if (map == 0) {
+    map = flMap & (~0u << fl << 1);
+    if (map == 0)
+      return NULL;
+    fl  = ffs0(map);
+    map = slMap[fl];
+  }
+  return lists[fl][ffs0(map)];
+}
+
+static void
+insertFree(Block *b)
+{
+  int fl, sl;
+
+  mapping(SIZE(b), &fl, &sl);
+  b->size    |= FREE;
+  b->prevFree = NULL;
+  b->nextFree = lists[fl][sl];
+  if (b->nextFree)
+    b->nextFree->prevFree = b;
+  lists[fl][sl] = b;
+  slMap[fl]    |= 1u << sl;
+  flMap        |= 1u << fl;
+  freeBytes    += SIZE(b);
+}
+
+static void
+removeFree(Block *b)
+{
+  int fl, sl;
+
+  mapping(SIZE(b), &fl, &sl);
+  if (b->nextFree)
+    b->nextFree->prevFree = b->prevFree;
+  if (b->prevFree)
+    b->prevFree->nextFree = b->nextFree;
+  else if ((lists[fl][sl] = b->nextFree) == NULL) {
+    slMap[fl] &= ~(1u << sl);
+    if (slMap[fl] == 0)
+      flMap &= ~(1u << fl);
+  }
+  b->size   &= ~FREE;
+  freeBytes -= SIZE(b);
+}
+
+/* join 'b' and the block above it, which is not in a list */
+static void
+join(Block *b)
+{
+  Block *next = NEXT(b);
+
+  b->size = (SIZE(b) + HDR + SIZE(next)) | (b->size & FREE);
+  NEXT(b)->prev = b;
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Put 'b' into the free lists, merged with free neighbours unless the
+ *    result would be larger than the classes reach.
+ *
+ ****************************************************************************/
+static void
+release(Block *b)
+{
+  Block *next = NEXT(b);
+  Block *prev = b->prev;
+
+  if ((next->size & FREE) && SIZE(b) + HDR + SIZE(next) <= MAX_SIZE) {
+    removeFree(next);
+    join(b);
+  }
+  if (prev && (prev->size & FREE) && SIZE(prev) + HDR + SIZE(b) <= MAX_SIZE) {
+    removeFree(prev);
+    join(prev);
+    b = prev;
+  }
+  insertFree(b);
+}
+
+/* cut used block 'b' down to 'size' bytes, releasing the rest */
+static void
+split(Block *b, unsigned size)
+{
+  Block *rest;
+
+  if (SIZE(b) < size + HDR + MIN_SIZE)
+    return;
+  rest         = (Block *)((char *)b + HDR + size);
+  rest->prev   = b;
+  rest->size   = SIZE(b) - size - HDR;
+  NEXT(rest)->prev = rest;
+  b->size      = size;
+  release(rest);
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Take a new free block of at least 'size' bytes from _sbrk(), merged
+ *    with a free block at the end of the heap; not put into a list.
+ *    NULL when _sbrk() has no more. With 'size' at most MAX_ALLOC the
+ *    new block is at most MAX_SIZE bytes.
+ *
+ ****************************************************************************/
+static Block *
+grow(unsigned size)
+{
+  unsigned need = size + 2 * HDR + ALIGN;       /* worst case: new region */
+  unsigned n    = need < HEAP_GROW ? HEAP_GROW : ROUND(need);
+  char    *p    = (char *)_sbrk(n);
+  Block   *b;
+
+  if (p == (char *)-1 && n > need) {
+    n = ROUND(need);
+    p = (char *)_sbrk(n);
+  }
+  if (p == (char *)-1)
+    return NULL;
+  heapSize += n;
+
+  if (top && p >= (char *)top + HDR && p < (char *)top + HDR + ALIGN) {
+    b       = top;                              /* end block becomes header */
+  } else {
+    b       = (Block *)ROUND((unsigned long)p);
+    b->prev = NULL;
+  }
+  b->size   = (p + n - (char *)b - 2 * HDR) & ~(ALIGN - 1);
+  top       = NEXT(b);
+  top->prev = b;
+  top->size = 0;
+
+  if (b->prev && (b->prev->size & FREE) &&
+      SIZE(b->prev) + HDR + SIZE(b) <= MAX_SIZE) {
+    removeFree(b->prev);
+    b = b->prev;
+    join(b);
+  }
+  return b;
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Allocate 'size' bytes (rounded, at most MAX_ALLOC): the head of the
+ *    first list that fits, else new memory, cut to size.
+ *
+ ****************************************************************************/
+static void *
+allocate(unsigned size)
+{
+  Block *b = findFree(size);
+
+  if (b)
+    removeFree(b);
+  else if ((b = grow(size)) == NULL)
+    return NULL;
+  split(b, size);
+
+  usedBytes += SIZE(b);
+  if (usedBytes > peakBytes)
+    peakBytes = usedBytes;
+  allocCount++;
+  return (char *)b + HDR;
+}
+
+/* data size for a request of 'n' bytes, 0 when it is too large */
+static unsigned
+dataSize(size_t n)
+{
+  if (n > MAX_ALLOC)
+    return 0;
+  return n < MIN_SIZE ? MIN_SIZE : ROUND(n);
+}
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Description:
+ *    The allocation functions of newlib, reentrant (_r) and plain; both
+ *    are needed so that no part of newlib's allocator gets linked.
+ *
+ ****************************************************************************/
+void *
+_malloc_r(struct _reent *r, size_t n)
+{
+  unsigned size = dataSize(n);
+  void    *p    = NULL;
+
+  __malloc_lock(r);
+  if (size)
+    p = allocate(size);
+  if (p == NULL)
+    failCount++;
+  __malloc_unlock(r);
+
+  if (p == NULL)
+    r->_errno = ENOMEM;
+  return p;
+}
+
+void
+_free_r(struct _reent *r, void *p)
+{
+  Block *b;
+
+  if (p == NULL)
+    return;
+  b = (Block *)((char *)p - HDR);
+  if (b->size & FREE)
+    return;
+  __malloc_lock(r);
+  usedBytes -= SIZE(b);
+  freeCount++;
+  release(b);
+  __malloc_unlock(r);
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Resize in place when the block shrinks or the block above it is
+ *    free and large enough; otherwise allocate, copy and free.
+ *
+ ****************************************************************************/
+void *
+_realloc_r(struct _reent *r, void *p, size_t n)
+{
+  Block   *b, *next;
+  unsigned size, old;
+  void    *q;
+
+  if (p == NULL)
+    return _malloc_r(r, n);
+  if (n == 0) {
+    _free_r(r, p);
+    return NULL;
+  }
+  if ((size = dataSize(n)) == 0) {
+    r->_errno = ENOMEM;
+    return NULL;
+  }
+
+  __malloc_lock(r);
+  b    = (Block *)((char *)p - HDR);
+  old  = SIZE(b);
+  next = NEXT(b);
+  if (size > old && (next->size & FREE) && old + HDR + SIZE(next) >= size &&
+      old + HDR + SIZE(next) <= MAX_SIZE) {
+    removeFree(next);
+    join(b);
+  }
+  if (SIZE(b) >= size) {
+    split(b, size);
+    usedBytes += SIZE(b) - old;
+    if (usedBytes > peakBytes)
+      peakBytes = usedBytes;
+    __malloc_unlock(r);
+    return p;
+  }
+  __malloc_unlock(r);
+
+  if ((q = _malloc_r(r, n)) != NULL) {
+    memcpy(q, p, old);
+    _free_r(r, p);
+  }
+  return q;
+}
+
+void *
+_calloc_r(struct _reent *r, size_t n, size_t size)
+{
+  void *p;
+
+  if (size && n > MAX_ALLOC / size) {
+    r->_errno = ENOMEM;
+    return NULL;
+  }
+  if ((p = _malloc_r(r, n * size)) != NULL)
+    memset(p, 0, n * size);
+  return p;
+}
+
+void *
+malloc(size_t n)
+{
+  return _malloc_r(_REENT, n);
+}
+
+void
+free(void *p)
+{
+  _free_r(_REENT, p);
+}
+
+void *
+realloc(void *p, size_t n)
+{
+  return _realloc_r(_REENT, p, n);
+}
+
+void *
+calloc(size_t n, size_t size)
+{
+  return _calloc_r(_REENT, n, size);
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Current state of the heap. The largest free block is looked for in
+ *    the highest non-empty list only, so this is as cheap as a malloc().
+ *
+ ****************************************************************************/
+void
+heapStats(tHeapStats *stats)
+{
+  Block   *b;
+  unsigned largest = 0;
+  int      fl;
+
+  __malloc_lock(_REENT);
+  if (flMap) {
+    fl = fls(flMap);
+    for (b = lists[fl][fls(slMap[fl])]; b; b = b->nextFree)
+      if (SIZE(b) > largest)
+        largest = SIZE(b);
+  }
+  stats->size     = heapSize;
+  stats->used     = usedBytes;
+  stats->peak     = peakBytes;
+  stats->free     = freeBytes;
+  stats->largest  = largest;
+  stats->frag     = freeBytes ? (freeBytes - largest) * 100 / freeBytes : 0;
+  stats->allocs   = allocCount;
+  stats->frees    = freeCount;
+  stats->failures = failCount;
+  __malloc_unlock(_REENT);
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Walk the blocks of the last region down from its end and every free
+ *    list. Returns the number of the first check that fails, 0 if none.
+ *
+ ****************************************************************************/
+int
+heapCheck(void)
+{
+  Block   *b, *above;
+  unsigned inLists = 0;
+  int      fl, sl, f, s, err = 0;
+
+  __malloc_lock(_REENT);
+  for (above = top; above && above->prev && !err; above = b) {
+    b = above->prev;
+    if (NEXT(b) != above || SIZE(b) % ALIGN)
+      err = 1;                                  /* chain broken */
+    else if ((b->size & FREE) && (above->size & FREE))
+      err = 2;                                  /* free neighbours */
+  }
+
+  for (fl = 0; fl < FL_COUNT && !err; fl++) {
+    if (((flMap >> fl) & 1) != (slMap[fl] != 0))
+      err = 3;                                  /* first level bitmap */
+    for (sl = 0; sl < SL_COUNT && !err; sl++) {
+      if (((slMap[fl] >> sl) & 1) != (lists[fl][sl] != NULL))
+        err = 4;                                /* second level bitmap */
+      for (b = lists[fl][sl]; b && !err; b = b->nextFree) {
+        mapping(SIZE(b), &f, &s);
+        if (!(b->size & FREE) || f != fl || s != sl)
+          err = 5;                              /* wrong list */
+        else if (b->nextFree && b->nextFree->prevFree != b)
+          err = 6;                              /* list links */
+        inLists += SIZE(b);
+      }
+    }
+  }
+  if (!err && inLists != freeBytes)
+    err = 7;
+  __malloc_unlock(_REENT);
+  return err;
+}
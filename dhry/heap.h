@@ -0,0 +1,62 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Heap of the dhry runtime (heap.c): a two-level segregated fit (TLSF)
+ *    allocator behind malloc(), free(), realloc() and calloc(), in place
+ *    of newlib's. Allocation and release take a bounded number of steps
+ *    whatever the state of the heap, free blocks are merged with their
+ *    neighbours at once, and the heap grows by _sbrk() (reloc.c) only
+ *    up to pHeapEnd, below the stacks: when it is exhausted malloc()
+ *    returns NULL with errno ENOMEM instead of running into them.
+ *
+ *    Blocks are 8 byte aligned and carry an 8 byte header. Free blocks
+ *    are kept in lists by size class: a first level per power of two up
+ *    to 2^HEAP_SIZE_LOG2 (config.h), each split into 8 linear second
+ *    level classes, with a bitmap of the non-empty lists per level.
+ *    malloc() rounds the request up to the next class, so any block of
+ *    the first non-empty list at or above it fits. Requests above
+ *    HEAP_MAX_ALLOC fail.
+ *
+ *    Not for interrupt handlers. Callers in several threads serialize
+ *    through newlib's __malloc_lock(); objects of one size that come and
+ *    go all the time are better taken from a pool (pool.h).
+ *
+ *****************************************************************************/
+#ifndef _heap_h_
+#define _heap_h_
+
+#include "config.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+
+/* largest request: a new region for it, with its headers and alignment,
+ * stays within the largest size class */
+#define HEAP_MAX_ALLOC  ((1u << HEAP_SIZE_LOG2) - 32)
+
+typedef struct
+{
+  unsigned size;                          /* bytes taken from _sbrk() */
+  unsigned used;                          /* bytes in allocated blocks */
+  unsigned peak;                          /* high-water mark of used */
+  unsigned free;                          /* bytes in free blocks */
+  unsigned largest;                       /* largest free block */
+  unsigned frag;                          /* free bytes not in the largest
+                                             block, percent of free */
+  unsigned allocs;                        /* successful malloc() calls */
+  unsigned frees;
+  unsigned failures;                      /* malloc() calls that failed */
+} tHeapStats;
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+
+/* fill 'stats' with the current state of the heap */
+void heapStats(tHeapStats *stats);
+
+/* check the block chain and the free lists; 0 when they are consistent */
+int  heapCheck(void);
+
+#endif
@@ -13,7 +13,5 @@ int main(int argc, char **argv)
 	printf("%f\n", 12.3f);
 	printf("%6.1f\n", 12.3f);
 
-	while (1);
-
 	return 0;
 }
@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Fixed-size object pools (see pool.h).
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * Includes
+ *****************************************************************************/
+#include <stdlib.h>
+#include <reent.h>
+
+#include "pool.h"
+
+/******************************************************************************
+ * External functions
+ *****************************************************************************/
+extern void __malloc_lock(struct _reent *r);
+extern void __malloc_unlock(struct _reent *r);
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Set up 'pool' with every object on the free list, in address order.
+ *
+ ****************************************************************************/
+int
+poolInit(tPool *pool, void *mem, unsigned size, unsigned count)
+{
+  unsigned i;
+
+  size = (size + 7) & ~7u;
+  if (mem == NULL && (mem = malloc(size * count)) == NULL)
+    return -1;
+
+  pool->mem      = mem;
+  pool->size     = size;
+  pool->count    = count;
+  pool->used     = 0;
+  pool->peak     = 0;
+  pool->failures = 0;
+  pool->free     = NULL;
+  for (i = count; i-- > 0; ) {
+    *(void **)(pool->mem + i * size) = pool->free;
+    pool->free = pool->mem + i * size;
+  }
+  return 0;
+}
+
+void *
+poolAlloc(tPool *pool)
+{
+  void *obj;
+
+  __malloc_lock(_REENT);
+  if ((obj = pool->free) != NULL) {
+    pool->free = *(void **)obj;
+    if (++pool->used > pool->peak)
+      pool->peak = pool->used;
+  } else
+    pool->failures++;
+  __malloc_unlock(_REENT);
+  return obj;
+}
+
+void
+poolFree(tPool *pool, void *obj)
+{
+  unsigned offset;
+
+  if (obj == NULL || (char *)obj < pool->mem)
+    return;
+  offset = (char *)obj - pool->mem;
+  if (offset >= pool->size * pool->count || offset % pool->size)
+    return;
+
+  __malloc_lock(_REENT);
+  *(void **)obj = pool->free;
+  pool->free    = obj;
+  pool->used--;
+  __malloc_unlock(_REENT);
+}
@@ -0,0 +1,50 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Fixed-size object pools (pool.c) for objects that come and go all
+ *    the time, such as messages: allocation and release are a list pop
+ *    and push, the objects never fragment the heap, and the counters show
+ *    how many a pool needs. The storage is a static array (POOL_MEM) or
+ *    taken from the heap once by poolInit().
+ *
+ *    Like the heap a pool is used from one context, or its callers
+ *    serialize through newlib's __malloc_lock(), which poolAlloc() and
+ *    poolFree() take as well.
+ *
+ *****************************************************************************/
+#ifndef _pool_h_
+#define _pool_h_
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+typedef struct
+{
+  void     *free;                         /* linked through the first word */
+  char     *mem;
+  unsigned  size;                         /* object size, a multiple of 8 */
+  unsigned  count;
+  unsigned  used;                         /* objects allocated */
+  unsigned  peak;                         /* high-water mark of used */
+  unsigned  failures;                     /* poolAlloc() on an empty pool */
+} tPool;
+
+/* static storage 'name' for 'count' objects of 'type', 8 byte aligned */
+#define POOL_MEM(name, type, count) \
+  static long long name[(count) * ((sizeof(type) + 7) / 8)]
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+
+/* 'count' objects of 'size' bytes at 'mem', or from the heap for NULL;
+   0 when done, -1 when the heap has no room */
+int   poolInit(tPool *pool, void *mem, unsigned size, unsigned count);
+
+/* an object, or NULL when all are in use */
+void *poolAlloc(tPool *pool);
+
+/* return 'obj' to its pool; NULL and objects of other pools are ignored */
+void  poolFree(tPool *pool, void *obj);
+
+#endif
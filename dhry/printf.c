@@ -0,0 +1,159 @@
+/******************************************************************************
+ *
+ * Description:
+ *    printf() family on the integer-only formatter of the EA startup
+ *    framework (testcode/startup/format.c): no heap, no floating point,
+ *    plus %q/%r fixed point. The console functions write straight into
+ *    the transmit ring of uart.c, the string functions into the buffer.
+ *
+ *    Selected at link time: linked ahead of libc (make PRINTF=consol),
+ *    these definitions win over newlib's, so neither its stdio buffers
+ *    nor its floating point formatting end up in the image. puts() and
+ *    putchar() are here as well because the compiler turns simple printf
+ *    calls into them.
+ *
+ *****************************************************************************/
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "format.h"
+#include "uart.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+typedef struct
+{
+  char *p;
+  char *end;                              /* last byte, or NULL: no limit */
+} StrOut;
+
+/******************************************************************************
+ * Local functions
+ *****************************************************************************/
+
+/* into the console ring, waiting for room */
+static void
+consoleSink(void *arg, const char *buf, int len)
+{
+  int n;
+
+  (void)arg;
+  while (len > 0) {
+    n    = uartWrite(buf, len);
+    buf += n;
+    len -= n;
+  }
+}
+
+/* into a buffer, truncated before its last byte */
+static void
+stringSink(void *arg, const char *buf, int len)
+{
+  StrOut *s = arg;
+
+  if (s->end && len > s->end - s->p)
+    len = s->end - s->p;
+  while (len-- > 0)
+    *s->p++ = *buf++;
+}
+
+/* vsnprintf() without a limit */
+static int
+unbounded(char *buf, const char *fmt, va_list ap)
+{
+  StrOut s;
+  int    n;
+
+  s.p   = buf;
+  s.end = NULL;
+  n = formatPrint(stringSink, &s, fmt, ap);
+  *s.p = '\0';
+  return n;
+}
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+int
+vprintf(const char *fmt, va_list ap)
+{
+  return formatPrint(consoleSink, NULL, fmt, ap);
+}
+
+int
+printf(const char *fmt, ...)
+{
+  va_list ap;
+  int     n;
+
+  va_start(ap, fmt);
+  n = formatPrint(consoleSink, NULL, fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+int
+vsnprintf(char *buf, size_t size, const char *fmt, va_list ap)
+{
+  StrOut s;
+  int    n;
+
+  s.p   = buf;
+  s.end = size ? buf + size - 1 : buf;
+  n = formatPrint(stringSink, &s, fmt, ap);
+  if (size)
+    *s.p = '\0';
+  return n;
+}
+
+int
+snprintf(char *buf, size_t size, const char *fmt, ...)
+{
+  va_list ap;
+  int     n;
+
+  va_start(ap, fmt);
+  n = vsnprintf(buf, size, fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+int
+vsprintf(char *buf, const char *fmt, va_list ap)
+{
+  return unbounded(buf, fmt, ap);
+}
+
+int
+sprintf(char *buf, const char *fmt, ...)
+{
+  va_list ap;
+  int     n;
+
+  va_start(ap, fmt);
+  n = unbounded(buf, fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+int
+puts(const char *s)
+{
+  const char *p = s;
+
+  while (*p)
+    p++;
+  consoleSink(NULL, s, p - s);
+  consoleSink(NULL, "\n", 1);
+  return 0;
+}
+
+int
+putchar(int ch)
+{
+  char c = ch;
+
+  consoleSink(NULL, &c, 1);
+  return (unsigned char)c;
+}
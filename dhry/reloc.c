@@ -1,69 +1,48 @@
+#include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <time.h>
 
-extern long timeval;
+#include "simctl.h"
+#include "timing.h"
 
+/* processor time from the cycle counter, exact to 1/CLOCKS_PER_SEC s
+ * instead of the 10 ms of the timer tick */
 clock_t clock(void) {
-  return timeval;
-}
-
-void _clock_init(void) {
-  timeval = 0;
-}
-
-#define CR     0x0D
-
-/* registers for user-defined behavior rule */
-#define SERIAL_FLAG *(volatile unsigned char *) 0xe0000000
-#define SERIAL_OUT *(volatile unsigned char *) 0xe0000004
-#define SERIAL_IN *(volatile unsigned char *) 0xe0000008
-
-/* implementation of putchar (also used by printf function to output data)    */
-int sendchar (int ch)  {                 /* Write character to Serial Port    */
-
-  if (ch == '\n')  {
-    while (SERIAL_FLAG & 0x01);
-    SERIAL_OUT = CR;                          /* output CR */
-  }
-  while (SERIAL_FLAG & 0x01);
-  return (SERIAL_OUT = ch);
+  return cyclesNow() / (SIM_CLOCK_HZ / CLOCKS_PER_SEC);
 }
 
-
-int getkey (void)  {                     /* Read character from Serial Port   */
-
-  while (!(SERIAL_FLAG & 0x02));
-
-  return (SERIAL_IN);
-}
+/* sendchar() and getkey() are in uart.c */
 
 // LIBC SYSCALLS
 /////////////////////
 
-extern int _end;
+extern unsigned char *pHeapStart;             /* set in framework.c */
+extern unsigned char *pHeapEnd;
 
+/* the break moves between pHeapStart and pHeapEnd, below the stacks */
 caddr_t _sbrk(int incr) {
   static unsigned char *heap = NULL;
   unsigned char *prev_heap;
 
   if (heap == NULL) {
-    heap = (unsigned char *)&_end;
+    heap = pHeapStart;
   }
   prev_heap = heap;
 
+  if (incr > pHeapEnd - heap || incr < pHeapStart - heap) {
+    errno = ENOMEM;
+    return (caddr_t) -1;
+  }
   heap += incr;
   //printf("heap: %x\n", heap);
 
   return (caddr_t) prev_heap;
 }
 
-int _close(int file) {
-  return -1;
-}
-
 int _fstat(int file, struct stat *st) {
   st->st_mode = S_IFCHR;
 
@@ -78,10 +57,6 @@ int _lseek(int file, int ptr, int dir) {
   return 0;
 }
 
-//void _exit(int status) {
-//  __asm("BKPT #0");
-//}
-
 void _kill(int pid, int sig) {
   return;
 }
@@ -90,36 +65,4 @@ int _getpid(void) {
   return -1;
 }
 
-int _write (int file, char * ptr, int len) {
-  int written = 0;
-
-  if ((file != 1) && (file != 2) && (file != 3)) {
-    return -1;
-  }
-
-  for (; len != 0; --len) {
-    //if (sendchar( (uint8_t)*ptr++ )) {
-    //  return -1;
-    //}
-    sendchar( *ptr++ );
-    ++written;
-  }
-  return written;
-}
-
-int _read (int file, char * ptr, int len) {
-  int read = 0;
-
-  if (file != 0) {
-    return -1;
-  }
-
-  for (; len > 0; --len) {
-    //usart_serial_getchar(&stdio_uart_module, (uint8_t *)ptr++);
-    *ptr = getkey();
-    ptr++;
-    read++;
-  }
-  return read;
-}
-
+/* _exit, _open, _close, _read, _write and _times are in framework.c */
@@ -0,0 +1,403 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Preemptive priority scheduler (see rtos.h); the register save and
+ *    restore is in rtos_switch.S.
+ *
+ *    Every bit of 'ready' and 'delayed' stands for the task of that
+ *    priority, so picking the next task is one fls() of 'ready' and a
+ *    semaphore keeps its waiters as a bitmap as well. The kernel state is
+ *    only changed with interrupts off: in rtosIrq(), rtosKernelCall() and
+ *    rtosFirst(), which rtos_switch.S calls in IRQ mode, and by
+ *    rtosSemPost() from interrupt handlers. Tasks get there by SWI.
+ *
+ *****************************************************************************/
+#include <reent.h>
+
+#include "config.h"
+#include "rtos.h"
+#include "simctl.h"
+#include "uart.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define pISR_SWI       (*(unsigned int *)(SRAM_SADDR + 0x28))
+#define pISR_IRQ       (*(unsigned int *)(SRAM_SADDR + 0x34))
+
+#define MODE_MASK      0x1f
+#define MODE_USR       0x10
+#define T_BIT          0x20
+
+/* kernel calls, rtosCall() */
+enum
+{
+  CALL_START,
+  CALL_DELAY,
+  CALL_WAIT,
+  CALL_POST,
+  CALL_YIELD,
+  CALL_EXIT
+};
+
+/******************************************************************************
+ * External functions (rtos_switch.S)
+ *****************************************************************************/
+extern void rtosStartEntry(void);
+extern void rtosSwiEntry(void);
+extern void rtosIrqEntry(void);
+extern void rtosCall(unsigned call, unsigned arg);
+
+tTask *rtosIrq(void);
+tTask *rtosKernelCall(void);
+tTask *rtosFirst(void);
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static tTask            *task[RTOS_PRIORITIES];
+static tTask            *current;
+static unsigned          ready;                 /* bit per priority */
+static unsigned          delayed;
+static unsigned          ticks;
+static unsigned          tickBase;              /* cycle of tick 'ticks' */
+static unsigned          tickCmp;               /* TICK_CMP as programmed */
+static volatile unsigned lockCount;             /* of current, tTask.lock */
+static volatile unsigned preempted;             /* switch held off by lock */
+static void            (*irqHandler)(void);
+static tRtosStats        stat;
+
+static tTask             idleTask;
+static unsigned          idleStack[16];
+
+/******************************************************************************
+ * Local functions
+ *****************************************************************************/
+
+/* index of the top bit of x != 0 */
+static unsigned
+fls(unsigned x)
+{
+  unsigned n = 0;
+
+  if (x & 0xffff0000) { n += 16; x >>= 16; }
+  if (x & 0x0000ff00) { n +=  8; x >>=  8; }
+  if (x & 0x000000f0) { n +=  4; x >>=  4; }
+  if (x & 0x0000000c) { n +=  2; x >>=  2; }
+  if (x & 0x00000002) { n +=  1; }
+  return n;
+}
+
+/* nonzero in USR mode, i.e. in a task */
+static int
+inTask(void)
+{
+  unsigned int psr;
+
+  asm volatile ("mrs %0, cpsr" : "=r" (psr));
+  return (psr & MODE_MASK) == MODE_USR;
+}
+
+static void
+idle(void *arg)
+{
+  (void)arg;
+  for (;;)
+    ;
+}
+
+/* where the entry function of a task returns to */
+static void
+taskExit(void)
+{
+  rtosCall(CALL_EXIT, 0);
+}
+
+static void
+setup(tTask *t, const char *name, void (*entry)(void *), void *arg,
+      unsigned prio, unsigned *stack, unsigned words)
+{
+  unsigned i;
+
+  for (i = 0; i < sizeof(t->ctx) / sizeof(t->ctx[0]); i++)
+    t->ctx[i] = 0;
+  t->ctx[0]             = (unsigned)arg;
+  t->ctx[10]            = (unsigned)stack;      /* sl, -mapcs-stack-check */
+  t->ctx[RTOS_CTX_SP]   = (unsigned)(stack + words) & ~7u;
+  t->ctx[RTOS_CTX_LR]   = (unsigned)taskExit;
+  t->ctx[RTOS_CTX_PC]   = (unsigned)entry & ~1u;
+  t->ctx[RTOS_CTX_CPSR] = MODE_USR | ((unsigned)entry & 1 ? T_BIT : 0);
+  t->prio     = prio;
+  t->wake     = 0;
+  t->switches = 0;
+  t->lock     = 0;
+  t->stack    = stack;
+  t->name     = name;
+
+  task[prio] = t;
+  ready     |= 1u << prio;
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Account the ticks that passed since tickBase, several after a
+ *    tick-less idle, and make the delays that expired ready.
+ *
+ ****************************************************************************/
+static void
+tick(void)
+{
+  unsigned elapsed = SIMCTL_CYCLE_LO - tickBase;
+  unsigned n, d, p;
+
+  if (elapsed < RTOS_TICK_CYCLES)
+    return;
+
+  n         = elapsed < 2 * RTOS_TICK_CYCLES ? 1 : elapsed / RTOS_TICK_CYCLES;
+  ticks    += n;
+  tickBase += n * RTOS_TICK_CYCLES;
+  stat.tickCycle = tickBase;
+
+  for (d = delayed; d; d &= ~(1u << p)) {
+    p = fls(d);
+    if ((int)(ticks - task[p]->wake) >= 0) {
+      delayed &= ~(1u << p);
+      ready   |= 1u << p;
+    }
+  }
+}
+
+static void
+post(tSem *sem)
+{
+  unsigned p;
+
+  if (sem->waiting) {
+    p             = fls(sem->waiting);
+    sem->waiting &= ~(1u << p);
+    ready        |= 1u << p;
+  } else
+    sem->count++;
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    The task to run next: the highest ready one, unless the running task
+ *    holds rtosLock(); a task that waits takes its lock depth along.
+ *    Programs the tick compare for the next tick, or, when only the idle
+ *    task is left, for the first delay to expire.
+ *
+ ****************************************************************************/
+static tTask *
+schedule(void)
+{
+  tTask   *next = task[fls(ready)];
+  unsigned n, d, p, cmp;
+
+  if (lockCount && (ready & (1u << current->prio)) && next != current) {
+    preempted = 1;
+    next      = current;
+  }
+  if (next != current) {
+    stat.switches++;
+    next->switches++;
+    current->lock = lockCount;
+    lockCount     = next->lock;
+    preempted     = 0;
+    current       = next;
+  }
+
+  n = 1;
+  if (next == &idleTask) {
+    n = RTOS_IDLE_MAX;
+    for (d = delayed; d; d &= ~(1u << p)) {
+      p = fls(d);
+      if (task[p]->wake - ticks < n)
+        n = task[p]->wake - ticks;
+    }
+  }
+  cmp = tickBase + n * RTOS_TICK_CYCLES;
+  if (cmp != tickCmp) {
+    if (n > 1)
+      stat.idleSleeps++;
+    tickCmp  = cmp;
+    TICK_CMP = cmp;
+  }
+  return next;
+}
+
+/******************************************************************************
+ * Kernel entries (rtos_switch.S), IRQ mode
+ *****************************************************************************/
+tTask *
+rtosIrq(void)
+{
+  stat.irqs++;
+  if ((int)(SIMCTL_CYCLE_LO - tickCmp) >= 0)
+    stat.tickIrqs++;
+  tick();
+  uartTxIrq();
+  if (irqHandler)
+    irqHandler();
+  return schedule();
+}
+
+tTask *
+rtosKernelCall(void)
+{
+  unsigned *ctx = current->ctx;
+  unsigned  bit = 1u << current->prio;
+  tSem     *sem;
+
+  tick();
+  switch (ctx[0]) {
+  case CALL_DELAY:
+    current->wake = ticks + ctx[1];
+    ready        &= ~bit;
+    delayed      |= bit;
+    break;
+  case CALL_WAIT:
+    sem = (tSem *)ctx[1];
+    if (sem->count > 0)
+      sem->count--;
+    else {
+      sem->waiting |= bit;
+      ready        &= ~bit;
+    }
+    break;
+  case CALL_POST:
+    post((tSem *)ctx[1]);
+    break;
+  case CALL_YIELD:
+    preempted = 0;
+    break;
+  case CALL_EXIT:
+    ready &= ~bit;
+    break;
+  }
+  return schedule();
+}
+
+tTask *
+rtosFirst(void)
+{
+  pISR_SWI = (unsigned int)rtosSwiEntry;
+  pISR_IRQ = (unsigned int)rtosIrqEntry;
+
+  current        = &idleTask;
+  tickBase       = SIMCTL_CYCLE_LO;
+  stat.tickCycle = tickBase;
+  tickCmp        = tickBase + RTOS_TICK_CYCLES;
+  TICK_CMP       = tickCmp;
+  TICK_CTRL      = TICK_CTRL_CMP;
+  return schedule();
+}
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+int
+rtosTaskCreate(tTask *t, const char *name, void (*entry)(void *), void *arg,
+               unsigned prio, unsigned *stack, unsigned words)
+{
+  if (prio == 0 || prio >= RTOS_PRIORITIES || task[prio])
+    return -1;
+  setup(t, name, entry, arg, prio, stack, words);
+  return 0;
+}
+
+void
+rtosStart(void)
+{
+  setup(&idleTask, "idle", idle, 0, 0, idleStack,
+        sizeof(idleStack) / sizeof(idleStack[0]));
+  pISR_SWI = (unsigned int)rtosStartEntry;
+  rtosCall(CALL_START, 0);
+  for (;;)
+    ;
+}
+
+tTask *
+rtosSelf(void)
+{
+  return current;
+}
+
+void
+rtosDelay(unsigned n)
+{
+  if (n)
+    rtosCall(CALL_DELAY, n);
+}
+
+unsigned
+rtosTicks(void)
+{
+  return ticks;
+}
+
+void
+rtosSemInit(tSem *sem, int count)
+{
+  sem->count   = count;
+  sem->waiting = 0;
+}
+
+void
+rtosSemWait(tSem *sem)
+{
+  rtosCall(CALL_WAIT, (unsigned)sem);
+}
+
+void
+rtosSemPost(tSem *sem)
+{
+  if (inTask() && current)
+    rtosCall(CALL_POST, (unsigned)sem);
+  else
+    post(sem);                  /* the switch follows in rtosIrq() */
+}
+
+void
+rtosLock(void)
+{
+  lockCount++;
+}
+
+/* a switch held off while locked is made up for at once */
+void
+rtosUnlock(void)
+{
+  if (--lockCount == 0 && preempted)
+    rtosCall(CALL_YIELD, 0);
+}
+
+void
+rtosSetIrqHandler(void (*handler)(void))
+{
+  irqHandler = handler;
+}
+
+void
+rtosStats(tRtosStats *stats)
+{
+  *stats       = stat;
+  stats->ticks = ticks;
+}
+
+/* the heap (heap.c) and the pools (pool.c) of all tasks */
+void
+__malloc_lock(struct _reent *r)
+{
+  (void)r;
+  rtosLock();
+}
+
+void
+__malloc_unlock(struct _reent *r)
+{
+  (void)r;
+  rtosUnlock();
+}
@@ -0,0 +1,113 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Preemptive priority scheduler for the dhry runtime (rtos.c,
+ *    rtos_switch.S). One task per priority, 1 (lowest) to
+ *    RTOS_PRIORITIES - 1; priority 0 is the idle task of the kernel. The
+ *    highest ready task runs until it waits on a semaphore or a delay, or
+ *    an interrupt makes a higher one ready.
+ *
+ *    Tasks run in USR mode. The kernel has no stack of its own per task:
+ *    the IRQ and SWI entries store the user registers of the running task
+ *    with one STMDB {R0-R14}^ straight into its tTask, whose context the
+ *    banked SP of IRQ and SVC mode point at, and a switch reloads the next
+ *    one with one LDMDB {R0-R14}^. The kernel code runs on the IRQ stack of
+ *    startup.S (stackSize_IRQ, config.h) with interrupts off.
+ *
+ *    The tick is the tick compare of the testbenches (simctl.h) every
+ *    RTOS_TICK_CYCLES cycles. While the idle task runs it is programmed
+ *    for the first delay to expire instead (tick-less idle, at most
+ *    RTOS_IDLE_MAX ticks ahead); the ticks slept through are counted when
+ *    the next interrupt comes. Other interrupts (serial transmit, the
+ *    application's) are served by rtosIrq() in the kernel.
+ *
+ *    The console ring of uart.c takes one writer at a time: tasks that may
+ *    print at the same time do so under rtosLock(). The heap and the pools
+ *    are locked that way already (__malloc_lock()).
+ *
+ *    rtosStart() replaces the exception handlers of framework.c for IRQ
+ *    and SWI, so it needs IRQ_HANDLER 0, and the tasks own the time base:
+ *    timeval of framework.c stops counting.
+ *
+ *****************************************************************************/
+#ifndef _rtos_h_
+#define _rtos_h_
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define RTOS_PRIORITIES 32
+
+/* the words of tTask.ctx, as stored by rtos_switch.S */
+#define RTOS_CTX_SP     13
+#define RTOS_CTX_LR     14
+#define RTOS_CTX_CPSR   15
+#define RTOS_CTX_PC     16
+
+typedef struct
+{
+  unsigned    ctx[17];                    /* r0-r14 (USR), cpsr, pc; first */
+  unsigned    prio;
+  unsigned    wake;                       /* tick to wake at when delayed */
+  unsigned    switches;                   /* times switched to */
+  unsigned    lock;                       /* rtosLock() depth, switched out */
+  unsigned   *stack;                      /* lowest word of the stack */
+  const char *name;
+} tTask;
+
+typedef struct
+{
+  int      count;
+  unsigned waiting;                       /* bit per waiting priority */
+} tSem;
+
+typedef struct
+{
+  unsigned ticks;                         /* ticks since rtosStart() */
+  unsigned tickIrqs;                      /* tick interrupts taken */
+  unsigned tickCycle;                     /* SIMCTL_CYCLE_LO of the last tick */
+  unsigned switches;                      /* context switches */
+  unsigned idleSleeps;                    /* idle entries with the tick off */
+  unsigned irqs;                          /* interrupts, ticks included */
+} tRtosStats;
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+
+/* set up 'task' at priority 'prio' to run entry(arg) on stack[0..words-1];
+ * before rtosStart() only. 0, or -1 when the priority is taken */
+int  rtosTaskCreate(tTask *task, const char *name, void (*entry)(void *),
+                    void *arg, unsigned prio, unsigned *stack,
+                    unsigned words);
+
+/* start the tick and run the highest task; does not return */
+void rtosStart(void);
+
+/* the running task */
+tTask *rtosSelf(void);
+
+/* wait 'ticks' ticks (0: none) */
+void rtosDelay(unsigned ticks);
+
+/* ticks since rtosStart() */
+unsigned rtosTicks(void);
+
+void rtosSemInit(tSem *sem, int count);
+void rtosSemWait(tSem *sem);
+
+/* from tasks and from interrupt handlers */
+void rtosSemPost(tSem *sem);
+
+/* no switch between them; they nest. Interrupts are still served. The
+ * depth is the running task's: a task that waits while locked takes its
+ * lock along, and the next one runs unlocked */
+void rtosLock(void);
+void rtosUnlock(void);
+
+/* application interrupt service, called by the kernel on every IRQ */
+void rtosSetIrqHandler(void (*handler)(void));
+
+void rtosStats(tRtosStats *stats);
+
+#endif
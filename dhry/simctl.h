@@ -0,0 +1,74 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Simulation control block of the testbenches (tb.v, tb.vhd, sim/),
+ *    placed right after the serial port at 0xE0000000.
+ *
+ *    SIMCTL_EXIT        W  end the simulation with the written status
+ *    SIMCTL_CYCLE_LO/HI R  cycles since reset (reading LO latches HI)
+ *    SIMCTL_INSTRET_LO/HI
+ *                       R  instructions retired (reading LO latches HI)
+ *    SIMCTL_MARK        W  print "SIM: mark=<value> cycles=<n> instret=<n>"
+ *    SIMCTL_TIME_LO/HI  R  host timestamp in us (reading LO latches HI)
+ *    SIMCTL_ARG0..2     RW arguments of SIMCTL_CMD
+ *    SIMCTL_CMD         W  run a host file command, R its result
+ *    SIMCTL_WAVE        W  nonzero starts, zero stops a waveform capture
+ *    TICK_CMP           RW cycle at which the tick compare raises irq
+ *    TICK_CTRL          RW bit 0 = tick compare on: no periodic tick, irq
+ *                          while (int)(SIMCTL_CYCLE_LO - TICK_CMP) >= 0,
+ *                          acknowledged by moving TICK_CMP forward
+ *
+ *    Host file commands (handles 0..2 are the simulator's stdin/out/err):
+ *    SIMCTL_OPEN   ARG0 = path, ARG1 = SIMCTL_MODE_*  -> handle or -1
+ *    SIMCTL_CLOSE  ARG0 = handle                      -> 0 or -1
+ *    SIMCTL_READ   ARG0 = handle, ARG1 = buf, ARG2 = len -> bytes read
+ *    SIMCTL_WRITE  ARG0 = handle, ARG1 = buf, ARG2 = len -> bytes written
+ *
+ *****************************************************************************/
+#ifndef _simctl_h_
+#define _simctl_h_
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define SIMCTL_EXIT       (*(volatile unsigned int *) 0xe0000010)
+#define SIMCTL_CYCLE_LO   (*(volatile unsigned int *) 0xe0000014)
+#define SIMCTL_CYCLE_HI   (*(volatile unsigned int *) 0xe0000018)
+#define SIMCTL_INSTRET_LO (*(volatile unsigned int *) 0xe000001c)
+#define SIMCTL_INSTRET_HI (*(volatile unsigned int *) 0xe0000020)
+#define SIMCTL_MARK       (*(volatile unsigned int *) 0xe0000024)
+#define SIMCTL_TIME_LO    (*(volatile unsigned int *) 0xe0000028)
+#define SIMCTL_TIME_HI    (*(volatile unsigned int *) 0xe000002c)
+#define SIMCTL_ARG0       (*(volatile unsigned int *) 0xe0000030)
+#define SIMCTL_ARG1       (*(volatile unsigned int *) 0xe0000034)
+#define SIMCTL_ARG2       (*(volatile unsigned int *) 0xe0000038)
+#define SIMCTL_CMD        (*(volatile int *)          0xe000003c)
+#define SIMCTL_WAVE       (*(volatile unsigned int *) 0xe0000040)
+#define TICK_CMP          (*(volatile unsigned int *) 0xe0000044)
+#define TICK_CTRL         (*(volatile unsigned int *) 0xe0000048)
+
+#define TICK_CTRL_CMP     0x01
+
+#define SIMCTL_OPEN       1
+#define SIMCTL_CLOSE      2
+#define SIMCTL_READ       3
+#define SIMCTL_WRITE      4
+
+#define SIMCTL_MODE_READ   0
+#define SIMCTL_MODE_WRITE  1
+#define SIMCTL_MODE_APPEND 2
+
+/* mark written by startup.S right before main(): the boot cycles */
+#define SIMCTL_MARK_BOOT  0x100
+
+/* clock of tb.v (1 MHz), the time base of times() */
+#define SIM_CLOCK_HZ      1000000
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+unsigned long long simCycles(void);
+unsigned long long simInstret(void);
+void simMark(unsigned int value);
+
+#endif  /* _simctl_h_ */
@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Cycle counter and region timers (see timing.h).
+ *
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "timing.h"
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static unsigned overhead;                 /* cycles of one cyclesNow() */
+static int      calibrated;
+
+/******************************************************************************
+ * Local functions
+ *****************************************************************************/
+static void
+calibrate(void)
+{
+  unsigned long long t0, t1;
+
+  t0 = cyclesNow();
+  t1 = cyclesNow();
+  overhead   = (unsigned)(t1 - t0);
+  calibrated = 1;
+}
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+unsigned long long
+cyclesNow(void)
+{
+  register unsigned int lo asm ("r2");
+  register unsigned int hi asm ("r3");
+
+  /* low word first: it latches the high word for the second load */
+  asm volatile ("ldmia %2, {%0, %1}"
+                : "=r" (lo), "=r" (hi)
+                : "r" (&SIMCTL_CYCLE_LO)
+                : "memory");
+  return ((unsigned long long)hi << 32) | lo;
+}
+
+/* SIM_CLOCK_HZ is a whole number of MHz */
+unsigned long long
+usNow(void)
+{
+  return cyclesNow() / (SIM_CLOCK_HZ / 1000000);
+}
+
+void
+timerReset(tTimer *t)
+{
+  t->count = 0;
+  t->min   = ~0u;
+  t->max   = 0;
+  t->total = 0;
+}
+
+void
+timerStart(tTimer *t)
+{
+  if (!calibrated)
+    calibrate();
+  t->start = cyclesNow();
+}
+
+unsigned
+timerStop(tTimer *t)
+{
+  unsigned c = (unsigned)(cyclesNow() - t->start);
+
+  c = c > overhead ? c - overhead : 0;
+  timerAdd(t, c);
+  return c;
+}
+
+void
+timerAdd(tTimer *t, unsigned cycles)
+{
+  t->count++;
+  t->total += cycles;
+  if (cycles < t->min)
+    t->min = cycles;
+  if (cycles > t->max)
+    t->max = cycles;
+}
+
+unsigned
+timerMean(const tTimer *t)
+{
+  return t->count ? (unsigned)(t->total / t->count) : 0;
+}
+
+void
+timerPrint(const tTimer *t)
+{
+  printf("%s: %u runs, min/mean/max %u/%u/%u cycles\n", t->name, t->count,
+         t->count ? t->min : 0, timerMean(t), t->max);
+}
@@ -0,0 +1,77 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Timing on the 64-bit cycle counter of the simulation control block
+ *    (simctl.h), which counts every clock from reset (timing.c).
+ *
+ *    cyclesNow() reads both halves with one LDMIA: reading the low word
+ *    latches the high one, and no interrupt comes between the two loads
+ *    of one instruction, so an interrupt handler that reads the counter
+ *    as well cannot tear the value. clock(), times() and simCycles() are
+ *    built on it.
+ *
+ *    A tTimer accumulates the cycles of a code region over many runs:
+ *
+ *      static tTimer t = TIMER_INIT("filter");
+ *
+ *      TIMER_SCOPE(&t) {
+ *        filter(buf, n);
+ *      }
+ *      timerPrint(&t);
+ *
+ *    or timerStart()/timerStop() around it. The cost of reading the
+ *    counter is taken off each run, so an empty region counts 0.
+ *
+ *****************************************************************************/
+#ifndef _timing_h_
+#define _timing_h_
+
+#include "simctl.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+typedef struct
+{
+  const char        *name;
+  unsigned           count;               /* runs */
+  unsigned           min;
+  unsigned           max;
+  unsigned long long total;
+  unsigned long long start;               /* of the run in progress */
+} tTimer;
+
+#define TIMER_INIT(name)  { (name), 0, ~0u, 0, 0, 0 }
+
+/* time the statement or block that follows; leave it only at its end,
+ * not by break, goto or return */
+#define TIMER_SCOPE(t) \
+  for (int timerRun_ = (timerStart(t), 1); timerRun_; \
+       timerRun_ = (timerStop(t), 0))
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+
+/* cycles since reset */
+unsigned long long cyclesNow(void);
+
+/* microseconds since reset, at SIM_CLOCK_HZ */
+unsigned long long usNow(void);
+
+void     timerReset(tTimer *t);
+void     timerStart(tTimer *t);
+
+/* end the run started last; its cycles */
+unsigned timerStop(tTimer *t);
+
+/* count a run of 'cycles' measured some other way */
+void     timerAdd(tTimer *t, unsigned cycles);
+
+/* mean cycles per run, 0 before the first */
+unsigned timerMean(const tTimer *t);
+
+/* "<name>: <count> runs, min/mean/max <a>/<b>/<c> cycles" */
+void     timerPrint(const tTimer *t);
+
+#endif
@@ -0,0 +1,253 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Console on the serial port of the testbenches (see uart.h).
+ *
+ *    The transmit ring has one producer, the program, and one consumer,
+ *    the IRQ handler, so it needs no locks: txHead is only written by the
+ *    producer and txTail only by the consumer. Both count freely and are
+ *    masked on use. The producer sets TXIE after every character and the
+ *    handler clears it once the ring is empty.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * Includes
+ *****************************************************************************/
+#include "config.h"
+#include "uart.h"
+#ifdef __IAR_SYSTEMS_ICC__
+#include <intrinsics.h>
+#endif
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define CR     0x0D
+
+#if (UART_API_NONBLOCKING == 1)
+#define TX_MASK (UART_API_NONBLOCKING_SIZE - 1)
+
+/* the size must be a power of two */
+typedef char txSizeCheck[(UART_API_NONBLOCKING_SIZE & TX_MASK) == 0 ? 1 : -1];
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static char              txBuf[UART_API_NONBLOCKING_SIZE];
+static volatile unsigned txHead;                /* next free */
+static volatile unsigned txTail;                /* next to send */
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Nonzero when the IRQ is masked, i.e. the handler cannot drain the
+ *    ring: in exception modes and with the I bit set.
+ *
+ ****************************************************************************/
+static int
+irqMasked(void)
+{
+  unsigned int psr;
+
+#ifdef __IAR_SYSTEMS_ICC__
+  psr = __get_CPSR();
+#else
+  asm volatile ("mrs %0, cpsr" : "=r" (psr));
+#endif
+  return (psr & 0x80) != 0;
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Move queued characters to the transmitter; stops at a busy
+ *    transmitter unless 'wait' is set. Consumer side: only with the IRQ
+ *    masked or from the handler itself.
+ *
+ ****************************************************************************/
+static void
+txDrain(int wait)
+{
+  unsigned tail = txTail;
+
+  while (tail != txHead) {
+    if (SERIAL_FLAG & SERIAL_TX_BUSY) {
+      if (!wait)
+        break;
+      continue;
+    }
+    SERIAL_OUT = txBuf[tail & TX_MASK];
+    tail++;
+  }
+  txTail = tail;
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Queue one character; returns 0 when the ring is full.
+ *
+ ****************************************************************************/
+static int
+txPut(int ch)
+{
+  unsigned head = txHead;
+
+  if (head - txTail == UART_API_NONBLOCKING_SIZE)
+    return 0;
+  txBuf[head & TX_MASK] = ch;
+  txHead = head + 1;
+  return 1;
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Queue one character, waiting for room when the ring is full. With
+ *    the IRQ masked the ring is emptied and the character sent by polling.
+ *
+ ****************************************************************************/
+static void
+txSend(int ch)
+{
+  if (irqMasked()) {
+    txDrain(1);
+    while (SERIAL_FLAG & SERIAL_TX_BUSY)
+      ;
+    SERIAL_OUT = ch;
+    return;
+  }
+  while (!txPut(ch))
+    ;                                           /* the handler makes room */
+  SERIAL_CTRL = SERIAL_TXIE;
+}
+#endif
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Write a character to the serial port (also used by printf), with
+ *    CR before LF.
+ *
+ ****************************************************************************/
+int
+sendchar(int ch)
+{
+#if (UART_API_NONBLOCKING == 1)
+  if (ch == '\n')
+    txSend(CR);
+  txSend(ch);
+  return ch;
+#else
+  if (ch == '\n')  {
+    while (SERIAL_FLAG & SERIAL_TX_BUSY);
+    SERIAL_OUT = CR;                            /* output CR */
+  }
+  while (SERIAL_FLAG & SERIAL_TX_BUSY);
+  return (SERIAL_OUT = ch);
+#endif
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Read a character from the serial port, waiting for one.
+ *
+ ****************************************************************************/
+int
+getkey(void)
+{
+  while (!(SERIAL_FLAG & SERIAL_RX_READY));
+
+  return (SERIAL_IN);
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Queue as much of 'buf' as fits without waiting, with CR before LF
+ *    (an LF is only taken together with its CR). Returns the number of
+ *    bytes of 'buf' taken. Without UART_API_NONBLOCKING, or with the IRQ
+ *    masked, everything is sent before returning.
+ *
+ ****************************************************************************/
+int
+uartWrite(const char *buf, int len)
+{
+  int n = 0;
+
+#if (UART_API_NONBLOCKING == 1)
+  if (!irqMasked()) {
+    for (; n < len; n++) {
+      if (buf[n] == '\n') {
+        if (UART_API_NONBLOCKING_SIZE - (txHead - txTail) < 2)
+          break;
+        txPut(CR);
+      }
+      if (!txPut(buf[n]))
+        break;
+    }
+    if (n != 0)
+      SERIAL_CTRL = SERIAL_TXIE;
+    return n;
+  }
+#endif
+  for (; n < len; n++)
+    sendchar(buf[n]);
+  return n;
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Wait until the ring is empty and the last character has left the
+ *    transmitter. Polls the ring out itself when the IRQ is masked, so
+ *    panic handlers and _exit() lose no output.
+ *
+ ****************************************************************************/
+void
+uartFlush(void)
+{
+#if (UART_API_NONBLOCKING == 1)
+  if (irqMasked())
+    txDrain(1);
+  else
+    while (txTail != txHead)
+      ;
+#endif
+  while (SERIAL_FLAG & SERIAL_TX_BUSY)
+    ;
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Transmit interrupt: refill the transmitter while it is idle and turn
+ *    TXIE off once the ring is empty. Returns 0 when the serial port did
+ *    not request the interrupt.
+ *
+ ****************************************************************************/
+int
+uartTxIrq(void)
+{
+#if (UART_API_NONBLOCKING == 1)
+  if (!(SERIAL_CTRL & SERIAL_TXIE) || (SERIAL_FLAG & SERIAL_TX_BUSY))
+    return 0;
+
+  txDrain(0);
+  if (txTail == txHead)
+    SERIAL_CTRL = 0;
+  return 1;
+#else
+  return 0;
+#endif
+}
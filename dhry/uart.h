@@ -0,0 +1,52 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Serial port of the testbenches (tb.v, tb.vhd, sim/) at 0xE0000000 and
+ *    the console driver on it (uart.c).
+ *
+ *    SERIAL_FLAG  R   bit 0 = transmitter busy, bit 1 = receive data ready
+ *    SERIAL_OUT   W   transmit data
+ *    SERIAL_IN    R   receive data
+ *    SERIAL_CTRL  RW  bit 0 = TXIE, irq while the transmitter is idle
+ *
+ *    With UART_API_NONBLOCKING (config.h) sendchar() puts the character
+ *    into a ring buffer of UART_API_NONBLOCKING_SIZE bytes and returns;
+ *    the IRQ handler moves it to SERIAL_OUT when the transmitter is idle.
+ *    sendchar() only waits when the ring is full. With IRQs disabled
+ *    (exception handlers, panics) it empties the ring by polling first,
+ *    so the output stays in order. Without UART_API_NONBLOCKING every
+ *    character waits for the transmitter. An application IRQ handler
+ *    (IRQ_HANDLER != 0) must call uartTxIrq() like the one in framework.c.
+ *
+ *****************************************************************************/
+#ifndef _uart_h_
+#define _uart_h_
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define SERIAL_FLAG     (*(volatile unsigned char *) 0xe0000000)
+#define SERIAL_OUT      (*(volatile unsigned char *) 0xe0000004)
+#define SERIAL_IN       (*(volatile unsigned char *) 0xe0000008)
+#define SERIAL_CTRL     (*(volatile unsigned char *) 0xe000000c)
+
+#define SERIAL_TX_BUSY  0x01                    /* SERIAL_FLAG */
+#define SERIAL_RX_READY 0x02
+#define SERIAL_TXIE     0x01                    /* SERIAL_CTRL */
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+int  sendchar(int ch);
+int  getkey(void);
+
+/* queue what fits of buf[0..len-1] without waiting; the bytes taken */
+int  uartWrite(const char *buf, int len);
+
+/* wait until every queued character has left the transmitter */
+void uartFlush(void);
+
+/* transmit interrupt service, from the IRQ handler; nonzero if it was one */
+int  uartTxIrq(void);
+
+#endif
@@ -0,0 +1,85 @@
+#!/bin/bash
+#
+# Functional coverage report
+#
+# Merges the coverage files written by arm9sim +cov=<file> (sim/coverage.h)
+# and prints, per group of bins, how many were hit, followed by every bin
+# with its total and the number of runs that hit it. Bins never hit are
+# marked with '*'.
+#
+# usage: regress/covreport.sh [-m <merged>] <file> ...
+#
+#   -m <file>    also write the merged counts, in the same format as the
+#                input, so that reports can be merged again
+#
+
+MERGED=
+
+while getopts "m:" opt; do
+  case $opt in
+    m) MERGED=$OPTARG ;;
+    *) sed -n '3,14p' "$0"; exit 2 ;;
+  esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -eq 0 ]; then
+  echo "no coverage files"
+  exit 2
+fi
+
+awk -v merged="$MERGED" '
+  FNR == 1 { runs++ }
+  /^#/ { next }
+  {
+    if (!($2 in hits)) {
+      order[n++] = $2
+      hits[$2] = 0
+      runs_hit[$2] = 0
+    }
+    hits[$2] += $1
+    if ($1 > 0)
+      runs_hit[$2]++
+  }
+  END {
+    for (i = 0; i < n; i++) {
+      b = order[i]
+      g = b
+      sub(/\..*/, "", g)
+      if (!(g in total))
+        groups[ng++] = g
+      total[g]++
+      if (hits[b] > 0)
+        covered[g]++
+    }
+
+    print ""
+    print "=== Functional coverage =================================================="
+    print ""
+    printf "   %d runs\n\n", runs
+    printf "%-12s %6s %6s %8s\n", "GROUP", "BINS", "HIT", "COVER"
+    printf "%-12s %6s %6s %8s\n", "=====", "====", "===", "====="
+    for (i = 0; i < ng; i++) {
+      g = groups[i]
+      printf "%-12s %6d %6d %7.1f%%\n", g, total[g], covered[g] + 0,
+             100 * covered[g] / total[g]
+      all += total[g]
+      hit += covered[g]
+    }
+    printf "%-12s %6d %6d %7.1f%%\n", "total", all, hit,
+           all ? 100 * hit / all : 0
+    print ""
+    printf "  %-28s %16s %6s\n", "BIN", "HITS", "RUNS"
+    for (i = 0; i < n; i++) {
+      b = order[i]
+      printf "%s %-28s %16.0f %6d\n", hits[b] ? " " : "*", b, hits[b],
+             runs_hit[b]
+    }
+    print ""
+
+    if (merged != "") {
+      printf "# merged from %d runs\n", runs > merged
+      for (i = 0; i < n; i++)
+        printf "%.0f %s\n", hits[order[i]], order[i] > merged
+    }
+  }' "$@"
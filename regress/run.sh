@@ -0,0 +1,235 @@
+#!/bin/bash
+#
+# Regression runner
+#
+# Runs every image in tests.lst against every configuration in configs.lst,
+# spread over all host cores. Each run gets a wall clock timeout and a cycle
+# budget; its serial output is compared with golden/<test>.txt, leaving out
+# the lines that match one of the extended regular expressions in
+# golden/<test>.mask (timing that differs between configurations). The
+# simulator's own lines that match golden/<test>.sim (device counters) are
+# compared too, after the serial output. A nonzero status written to the
+# sim control block ("SIM: exit=") fails the run, as does a test without a
+# golden file (NOGOLD). Tests with +lpc in their plusargs need the LPC
+# peripherals of SIM=verilator and are SKIPPED with the other flows.
+#
+# usage: regress/run.sh [options] [test ...]
+#
+#   -j <n>       parallel jobs (default: number of host cores)
+#   -t <sec>     per-run timeout in seconds (default: 600)
+#   -c <file>    configuration list (default: regress/configs.lst)
+#   -l <file>    test list (default: regress/tests.lst)
+#   -o <dir>     output directory (default: regress/out)
+#   -b           bless: copy the serial output of the default configuration
+#                into golden/ instead of comparing (RTL flows only)
+#   -C           collect functional coverage (SIM=verilator) and write the
+#                merged report to <out>/coverage.txt (covreport.sh)
+#
+# SIM selects the simulator flow: iverilog (default), verilator (sim/,
+# which also takes ELF images) or iss (sim/arm9iss, the functional
+# reference: max_cycles counts instructions, there is no timer tick).
+# Goldens are blessed on one of the RTL flows, so they hold what the core
+# printed. The ISS ignores the testbench plusargs of the configurations
+# and runs the first one only, as a quick check; it cannot bless.
+#
+
+REGRESS_DIR=$(cd "$(dirname "$0")" && pwd)
+TOP_DIR=$(cd "$REGRESS_DIR/.." && pwd)
+
+JOBS=$(nproc)
+TIMEOUT=600
+CONFIGS=$REGRESS_DIR/configs.lst
+TESTS=$REGRESS_DIR/tests.lst
+OUT=$REGRESS_DIR/out
+BLESS=0
+COVER=0
+SIM=${SIM:-iverilog}
+
+while getopts "j:t:c:l:o:bC" opt; do
+  case $opt in
+    j) JOBS=$OPTARG ;;
+    t) TIMEOUT=$OPTARG ;;
+    c) CONFIGS=$OPTARG ;;
+    l) TESTS=$OPTARG ;;
+    o) OUT=$OPTARG ;;
+    b) BLESS=1 ;;
+    C) COVER=1 ;;
+    *) sed -n '3,33p' "$0"; exit 2 ;;
+  esac
+done
+shift $((OPTIND - 1))
+SELECT="$*"
+
+if [ $COVER -eq 1 ] && [ "$SIM" != verilator ]; then
+  echo "coverage needs SIM=verilator"
+  exit 2
+fi
+if [ $BLESS -eq 1 ] && [ "$SIM" = iss ]; then
+  echo "bless on an RTL flow: SIM=iverilog or SIM=verilator"
+  exit 2
+fi
+
+#----------------------------------------------------------------------
+# SIMULATOR FLOWS
+#
+# sim_build <config dir> <flags>         compile the testbench once
+# sim_cmd   <config dir> <plusargs...>   print the run command
+#----------------------------------------------------------------------
+sim_build_iverilog() {
+  iverilog -o "$1/tb.vvp" $2 "$TOP_DIR/tb.v" "$TOP_DIR/arm9_compatiable_code.v"
+}
+sim_cmd_iverilog() {
+  local dir=$1; shift
+  echo vvp -n "$dir/tb.vvp" "$@"
+}
+sim_build_verilator() {
+  make -s -C "$TOP_DIR/sim" OBJ_DIR="$1/obj_dir" BIN="$1/arm9sim" EFLAGS="$2"
+}
+sim_cmd_verilator() {
+  local dir=$1; shift
+  echo "$dir/arm9sim" "$@"
+}
+sim_build_iss() {
+  make -s -C "$TOP_DIR/sim" ISS_NAME="$1/arm9iss" iss
+}
+sim_cmd_iss() {
+  local dir=$1; shift
+  echo "$dir/arm9iss" "${@/#+max_cycles=/+max_instr=}"
+}
+
+#----------------------------------------------------------------------
+# ONE RUN: <test> <image> <max_cycles> <config> <plusargs>
+#----------------------------------------------------------------------
+run_one() {
+  local test=$1 image=$2 cycles=$3 cfg=$4 plus=$5
+  local dir=$OUT/$cfg
+  local log=$dir/$test.log uart=$dir/$test.uart
+  local golden=$REGRESS_DIR/golden/$test.txt mask=$REGRESS_DIR/golden/$test.mask
+  local simre=$REGRESS_DIR/golden/$test.sim out=$uart
+  local status simcycles simexit t0 t1 wall mhz rc
+
+  [ "$plus" = "-" ] && plus=
+  if [[ " $plus " == *" +lpc "* ]] && [ "$SIM" != verilator ]; then
+    printf "%-14s %-10s %-8s %12s %9s %9s\n" "$test" "$cfg" SKIPPED - - - \
+           >> "$OUT/results.txt"
+    echo "$test/$cfg: SKIPPED"
+    return
+  fi
+  [ $COVER -eq 1 ] && plus="$plus +cov=$dir/$test.cov"
+  t0=$(date +%s.%N)
+  timeout "$TIMEOUT" $(sim_cmd_$SIM "$dir" +binfile="$TOP_DIR/$image" \
+      +uart_log="$uart" +max_cycles="$cycles" $plus) > "$log" 2>&1
+  rc=$?
+  t1=$(date +%s.%N)
+
+  simcycles=$(sed -n 's/^SIM: cycles=\([0-9]*\).*/\1/p' "$log" | tail -1)
+  simexit=$(sed -n 's/^SIM: exit=\(-*[0-9]*\).*/\1/p' "$log" | tail -1)
+  wall=$(awk -v a="$t0" -v b="$t1" 'BEGIN { printf "%.2f", b - a }')
+  mhz=$(awk -v c="${simcycles:-0}" -v w="$wall" \
+        'BEGIN { printf "%.4f", (w > 0) ? c / w / 1e6 : 0 }')
+  if [ -f "$simre" ]; then
+    out=$dir/$test.out
+    { cat "$uart"; grep -aE -f "$simre" "$log"; } > "$out"
+  fi
+
+  if [ $rc -eq 124 ]; then
+    status=TIMEOUT
+  elif [ -n "$simexit" ] && [ "$simexit" != 0 ]; then
+    status=FAIL
+  elif [ $rc -ne 0 ] || [ -z "$simcycles" ]; then
+    status=ERROR
+  elif [ $BLESS -eq 1 ]; then
+    if [ "$cfg" = "default" ]; then
+      cp "$out" "$golden"
+      status=BLESSED
+    else
+      status=SKIPPED
+    fi
+  elif [ ! -f "$golden" ]; then
+    status=NOGOLD
+  elif [ ! -f "$mask" ] && cmp -s "$out" "$golden"; then
+    status=PASS
+  elif [ -f "$mask" ] && cmp -s <(grep -avE -f "$mask" "$out") \
+                                 <(grep -avE -f "$mask" "$golden"); then
+    status=PASS
+  else
+    status=FAIL
+  fi
+
+  printf "%-14s %-10s %-8s %12s %9s %9s\n" \
+         "$test" "$cfg" "$status" "${simcycles:--}" "$wall" "$mhz" \
+         >> "$OUT/results.txt"
+  echo "$test/$cfg: $status"
+}
+export -f run_one sim_cmd_$SIM
+export OUT TIMEOUT BLESS COVER SIM REGRESS_DIR TOP_DIR
+
+#----------------------------------------------------------------------
+# BUILD ONE TESTBENCH PER CONFIGURATION
+#----------------------------------------------------------------------
+mkdir -p "$OUT" "$REGRESS_DIR/golden"
+: > "$OUT/results.txt"
+: > "$OUT/jobs.txt"
+rm -f "$OUT"/*/*.cov
+
+grep -v '^\s*#' "$CONFIGS" | while read -r cfg flags plus; do
+  [ -z "$cfg" ] && continue
+  [ "$flags" = "-" ] && flags=
+  mkdir -p "$OUT/$cfg"
+  echo "build: $cfg"
+  if ! sim_build_$SIM "$OUT/$cfg" "$flags" > "$OUT/$cfg/build.log" 2>&1; then
+    echo "build of configuration $cfg failed, see $OUT/$cfg/build.log"
+    exit 1
+  fi
+  grep -v '^\s*#' "$TESTS" | while read -r test image cycles tplus; do
+    [ -z "$test" ] && continue
+    if [ -n "$SELECT" ] && ! echo " $SELECT " | grep -q " $test "; then
+      continue
+    fi
+    tplus=$(echo ${plus#-} $tplus)
+    printf "%s\0%s\0%s\0%s\0%s\0" "$test" "$image" "$cycles" "$cfg" \
+           "${tplus:--}" >> "$OUT/jobs.txt"
+  done
+  if [ "$SIM" = iss ]; then
+    break
+  fi
+done || exit 1
+
+#----------------------------------------------------------------------
+# FAN OUT
+#----------------------------------------------------------------------
+T0=$(date +%s.%N)
+xargs -0 -n 5 -P "$JOBS" bash -c 'run_one "$@"' _ < "$OUT/jobs.txt"
+T1=$(date +%s.%N)
+
+#----------------------------------------------------------------------
+# SUMMARY
+#----------------------------------------------------------------------
+echo ""
+echo "=== Regression summary ==================================================="
+echo ""
+printf "%-14s %-10s %-8s %12s %9s %9s\n" TEST CONFIG STATUS CYCLES WALL[s] SIM-MHz
+printf "%-14s %-10s %-8s %12s %9s %9s\n" ==== ====== ====== ====== ======= =======
+sort "$OUT/results.txt"
+echo ""
+awk -v a="$T0" -v b="$T1" -v j="$JOBS" '
+  { n++; s[$3]++; c += ($4 == "-") ? 0 : $4; w += $5 }
+  END {
+    printf "   %d runs on %d jobs in %.1f s (%.1f s of simulation, %.4f MHz aggregate)\n",
+           n, j, b - a, w, (b > a) ? c / (b - a) / 1e6 : 0
+    printf "  "
+    for (k in s) printf " %s=%d", k, s[k]
+    printf "\n"
+  }' "$OUT/results.txt"
+echo ""
+
+if [ $COVER -eq 1 ]; then
+  "$REGRESS_DIR/covreport.sh" -m "$OUT/coverage.cov" "$OUT"/*/*.cov \
+      > "$OUT/coverage.txt"
+  sed -n '/^GROUP/,/^total/p' "$OUT/coverage.txt"
+  echo ""
+  echo "   coverage report: $OUT/coverage.txt"
+  echo ""
+fi
+
+! grep -qE ' (FAIL|ERROR|TIMEOUT|NOGOLD) ' "$OUT/results.txt"
@@ -0,0 +1,364 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Switching activity and SAIF export
+ *
+ *****************************************************************************/
+#include <string.h>
+#include <time.h>
+
+#include "activity.h"
+#include "testbench.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+enum
+{
+  BLOCK_REGFILE,
+  BLOCK_DECODE,
+  BLOCK_SHIFTER,
+  BLOCK_ALU,
+  BLOCK_MULT,
+  BLOCK_LSU,
+  BLOCK_CONTROL,
+  BLOCKS
+};
+
+static const char *const blockNames[BLOCKS] = {
+  "regfile", "decode", "shifter", "alu", "mult", "lsu", "control"
+};
+
+#define SIG(block, sig, width) \
+  add(block, #sig, &RTL(tb, sig), sizeof(RTL(tb, sig)), width)
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+Activity::Activity(Testbench *tb)
+  : onMarks(false), tb(tb), counting(false), cycles(0),
+    blockBits(BLOCKS), blockToggles(BLOCKS), blockIdle(BLOCKS), multWasted(0)
+{
+  SIG(BLOCK_REGFILE, r0, 32);        SIG(BLOCK_REGFILE, r1, 32);
+  SIG(BLOCK_REGFILE, r2, 32);        SIG(BLOCK_REGFILE, r3, 32);
+  SIG(BLOCK_REGFILE, r4, 32);        SIG(BLOCK_REGFILE, r5, 32);
+  SIG(BLOCK_REGFILE, r6, 32);        SIG(BLOCK_REGFILE, r7, 32);
+  SIG(BLOCK_REGFILE, r8_usr, 32);    SIG(BLOCK_REGFILE, r8_fiq, 32);
+  SIG(BLOCK_REGFILE, r9_usr, 32);    SIG(BLOCK_REGFILE, r9_fiq, 32);
+  SIG(BLOCK_REGFILE, ra_usr, 32);    SIG(BLOCK_REGFILE, ra_fiq, 32);
+  SIG(BLOCK_REGFILE, rb_usr, 32);    SIG(BLOCK_REGFILE, rb_fiq, 32);
+  SIG(BLOCK_REGFILE, rc_usr, 32);    SIG(BLOCK_REGFILE, rc_fiq, 32);
+  SIG(BLOCK_REGFILE, rd_usr, 32);    SIG(BLOCK_REGFILE, rd_fiq, 32);
+  SIG(BLOCK_REGFILE, rd_irq, 32);    SIG(BLOCK_REGFILE, rd_svc, 32);
+  SIG(BLOCK_REGFILE, rd_abt, 32);    SIG(BLOCK_REGFILE, rd_und, 32);
+  SIG(BLOCK_REGFILE, re_usr, 32);    SIG(BLOCK_REGFILE, re_fiq, 32);
+  SIG(BLOCK_REGFILE, re_irq, 32);    SIG(BLOCK_REGFILE, re_svc, 32);
+  SIG(BLOCK_REGFILE, re_abt, 32);    SIG(BLOCK_REGFILE, re_und, 32);
+  SIG(BLOCK_REGFILE, rf, 32);        SIG(BLOCK_REGFILE, rf_b, 32);
+  SIG(BLOCK_REGFILE, r8, 32);        SIG(BLOCK_REGFILE, r9, 32);
+  SIG(BLOCK_REGFILE, ra, 32);        SIG(BLOCK_REGFILE, rb, 32);
+  SIG(BLOCK_REGFILE, rc, 32);        SIG(BLOCK_REGFILE, rd, 32);
+  SIG(BLOCK_REGFILE, re, 32);
+  SIG(BLOCK_REGFILE, cpsr_n, 1);     SIG(BLOCK_REGFILE, cpsr_z, 1);
+  SIG(BLOCK_REGFILE, cpsr_c, 1);     SIG(BLOCK_REGFILE, cpsr_v, 1);
+  SIG(BLOCK_REGFILE, cpsr_i, 1);     SIG(BLOCK_REGFILE, cpsr_f, 1);
+  SIG(BLOCK_REGFILE, cpsr_m, 5);     SIG(BLOCK_REGFILE, spsr, 11);
+  SIG(BLOCK_REGFILE, spsr_fiq, 11);  SIG(BLOCK_REGFILE, spsr_irq, 11);
+  SIG(BLOCK_REGFILE, spsr_svc, 11);  SIG(BLOCK_REGFILE, spsr_abt, 11);
+  SIG(BLOCK_REGFILE, spsr_und, 11);
+
+  SIG(BLOCK_DECODE, code, 32);       SIG(BLOCK_DECODE, cmd, 32);
+  SIG(BLOCK_DECODE, code_flag, 1);   SIG(BLOCK_DECODE, cmd_flag, 1);
+  SIG(BLOCK_DECODE, all_code, 1);    SIG(BLOCK_DECODE, cond_satisfy, 1);
+  SIG(BLOCK_DECODE, code_abort, 1);  SIG(BLOCK_DECODE, code_und, 1);
+  SIG(BLOCK_DECODE, code_sum_m, 5);  SIG(BLOCK_DECODE, cmd_sum_m, 5);
+  SIG(BLOCK_DECODE, code_rm_num, 4); SIG(BLOCK_DECODE, code_rm_vld, 1);
+  SIG(BLOCK_DECODE, code_rs_num, 4); SIG(BLOCK_DECODE, code_rs_vld, 1);
+  SIG(BLOCK_DECODE, code_rn_num, 4); SIG(BLOCK_DECODE, code_rn_vld, 1);
+  SIG(BLOCK_DECODE, code_rnhi_num, 4);
+  SIG(BLOCK_DECODE, code_rnhi_vld, 1);
+  SIG(BLOCK_DECODE, code_is_b, 1);   SIG(BLOCK_DECODE, code_is_bx, 1);
+  SIG(BLOCK_DECODE, code_is_dp0, 1); SIG(BLOCK_DECODE, code_is_dp1, 1);
+  SIG(BLOCK_DECODE, code_is_dp2, 1); SIG(BLOCK_DECODE, code_is_ldm, 1);
+  SIG(BLOCK_DECODE, code_is_ldr0, 1);
+  SIG(BLOCK_DECODE, code_is_ldr1, 1);
+  SIG(BLOCK_DECODE, code_is_ldrh0, 1);
+  SIG(BLOCK_DECODE, code_is_ldrh1, 1);
+  SIG(BLOCK_DECODE, code_is_ldrsb0, 1);
+  SIG(BLOCK_DECODE, code_is_ldrsb1, 1);
+  SIG(BLOCK_DECODE, code_is_ldrsh0, 1);
+  SIG(BLOCK_DECODE, code_is_ldrsh1, 1);
+  SIG(BLOCK_DECODE, code_is_mrs, 1); SIG(BLOCK_DECODE, code_is_msr0, 1);
+  SIG(BLOCK_DECODE, code_is_msr1, 1);
+  SIG(BLOCK_DECODE, code_is_mult, 1);
+  SIG(BLOCK_DECODE, code_is_multl, 1);
+  SIG(BLOCK_DECODE, code_is_swi, 1); SIG(BLOCK_DECODE, code_is_swp, 1);
+  SIG(BLOCK_DECODE, cmd_is_b, 1);    SIG(BLOCK_DECODE, cmd_is_bx, 1);
+  SIG(BLOCK_DECODE, cmd_is_dp0, 1);  SIG(BLOCK_DECODE, cmd_is_dp1, 1);
+  SIG(BLOCK_DECODE, cmd_is_dp2, 1);  SIG(BLOCK_DECODE, cmd_is_ldm, 1);
+  SIG(BLOCK_DECODE, cmd_is_ldr0, 1); SIG(BLOCK_DECODE, cmd_is_ldr1, 1);
+  SIG(BLOCK_DECODE, cmd_is_ldrh0, 1);
+  SIG(BLOCK_DECODE, cmd_is_ldrh1, 1);
+  SIG(BLOCK_DECODE, cmd_is_ldrsb0, 1);
+  SIG(BLOCK_DECODE, cmd_is_ldrsb1, 1);
+  SIG(BLOCK_DECODE, cmd_is_ldrsh0, 1);
+  SIG(BLOCK_DECODE, cmd_is_ldrsh1, 1);
+  SIG(BLOCK_DECODE, cmd_is_mrs, 1);  SIG(BLOCK_DECODE, cmd_is_msr0, 1);
+  SIG(BLOCK_DECODE, cmd_is_msr1, 1); SIG(BLOCK_DECODE, cmd_is_mult, 1);
+  SIG(BLOCK_DECODE, cmd_is_multl, 1);
+  SIG(BLOCK_DECODE, cmd_is_multlx, 1);
+  SIG(BLOCK_DECODE, cmd_is_swi, 1);  SIG(BLOCK_DECODE, cmd_is_swp, 1);
+  SIG(BLOCK_DECODE, cmd_is_swpx, 1);
+
+  SIG(BLOCK_SHIFTER, sec_operand, 32);
+  SIG(BLOCK_SHIFTER, code_rm, 32);   SIG(BLOCK_SHIFTER, code_rma, 32);
+  SIG(BLOCK_SHIFTER, code_rs, 32);   SIG(BLOCK_SHIFTER, code_rsa, 32);
+  SIG(BLOCK_SHIFTER, code_rot_num, 5);
+  SIG(BLOCK_SHIFTER, code_rs_flag, 3);
+  SIG(BLOCK_SHIFTER, rm_msb, 1);     SIG(BLOCK_SHIFTER, rs_msb, 1);
+
+  SIG(BLOCK_ALU, add_a, 32);         SIG(BLOCK_ALU, add_b, 32);
+  SIG(BLOCK_ALU, add_c, 1);          SIG(BLOCK_ALU, sum_middle, 32);
+  SIG(BLOCK_ALU, sum_rn_rm, 32);     SIG(BLOCK_ALU, high_middle, 2);
+  SIG(BLOCK_ALU, high_bit, 1);       SIG(BLOCK_ALU, and_ans, 32);
+  SIG(BLOCK_ALU, or_ans, 32);        SIG(BLOCK_ALU, eor_ans, 32);
+  SIG(BLOCK_ALU, bic_ans, 32);       SIG(BLOCK_ALU, dp_ans, 32);
+  SIG(BLOCK_ALU, bit_cy, 1);         SIG(BLOCK_ALU, bit_ov, 1);
+
+  SIG(BLOCK_MULT, mult_ans, 64);     SIG(BLOCK_MULT, reg_ans, 64);
+  SIG(BLOCK_MULT, mult_z, 1);        SIG(BLOCK_MULT, multl_extra_num, 1);
+
+  SIG(BLOCK_LSU, rom_addr, 32);      SIG(BLOCK_LSU, rom_en, 1);
+  SIG(BLOCK_LSU, ram_addr, 32);      SIG(BLOCK_LSU, ram_cen, 1);
+  SIG(BLOCK_LSU, ram_wen, 1);        SIG(BLOCK_LSU, ram_flag, 4);
+  SIG(BLOCK_LSU, ram_wdata, 32);     SIG(BLOCK_LSU, cmd_addr, 32);
+  SIG(BLOCK_LSU, rn, 32);            SIG(BLOCK_LSU, rna, 32);
+  SIG(BLOCK_LSU, rnb, 32);           SIG(BLOCK_LSU, rn_register, 32);
+  SIG(BLOCK_LSU, go_data, 32);       SIG(BLOCK_LSU, to_data, 32);
+  SIG(BLOCK_LSU, ldm_data, 32);
+
+  SIG(BLOCK_CONTROL, hold_en, 1);    SIG(BLOCK_CONTROL, hold_en_dly, 1);
+  SIG(BLOCK_CONTROL, wait_en, 1);    SIG(BLOCK_CONTROL, cmd_ok, 1);
+  SIG(BLOCK_CONTROL, int_all, 1);    SIG(BLOCK_CONTROL, fiq_flag, 1);
+  SIG(BLOCK_CONTROL, irq_flag, 1);   SIG(BLOCK_CONTROL, fiq_en, 1);
+  SIG(BLOCK_CONTROL, irq_en, 1);     SIG(BLOCK_CONTROL, sum_m, 5);
+  SIG(BLOCK_CONTROL, go_fmt, 6);     SIG(BLOCK_CONTROL, go_num, 4);
+  SIG(BLOCK_CONTROL, go_vld, 1);     SIG(BLOCK_CONTROL, go_rf_vld, 1);
+  SIG(BLOCK_CONTROL, cha_num, 4);    SIG(BLOCK_CONTROL, cha_vld, 1);
+  SIG(BLOCK_CONTROL, cha_rf_vld, 1); SIG(BLOCK_CONTROL, to_num, 4);
+  SIG(BLOCK_CONTROL, to_vld, 1);     SIG(BLOCK_CONTROL, to_rf_vld, 1);
+  SIG(BLOCK_CONTROL, ldm_num, 4);    SIG(BLOCK_CONTROL, ldm_sel, 4);
+  SIG(BLOCK_CONTROL, ldm_usr, 1);    SIG(BLOCK_CONTROL, ldm_vld, 1);
+  SIG(BLOCK_CONTROL, ldm_change, 1); SIG(BLOCK_CONTROL, ldm_rf_vld, 1);
+
+  tc.resize(since.size());
+  t1.resize(since.size());
+}
+
+void
+Activity::sample()
+{
+  if (!counting) {
+    if (onMarks)
+      return;
+    start();
+  }
+  cycles++;
+
+  bool     multiplying = RTL(tb, cmd_ok) && (RTL(tb, cmd_is_mult) ||
+                                             RTL(tb, cmd_is_multl) ||
+                                             RTL(tb, cmd_is_multlx));
+  uint64_t changed[BLOCKS] = { 0 };
+
+  for (size_t i = 0; i < signals.size(); i++) {
+    Signal  &s = signals[i];
+    uint64_t v = load(s);
+    uint64_t d = v ^ s.value;
+
+    if (!d)
+      continue;
+    changed[s.block] += __builtin_popcountll(d);
+    for (; d; d &= d - 1) {
+      unsigned b = s.bit + __builtin_ctzll(d);
+
+      tc[b]++;
+      if ((s.value >> (b - s.bit)) & 1)
+        t1[b] += cycles - since[b];
+      since[b] = cycles;
+    }
+    s.value = v;
+  }
+
+  for (unsigned b = 0; b < BLOCKS; b++) {
+    blockToggles[b] += changed[b];
+    if (!changed[b])
+      blockIdle[b]++;
+  }
+  if (!multiplying)
+    multWasted += changed[BLOCK_MULT];
+}
+
+void
+Activity::mark(uint32_t id)
+{
+  if (!onMarks)
+    return;
+  if (id == 1 && !counting)
+    start();
+  else if (id == 2 && counting)
+    stop();
+}
+
+void
+Activity::write(FILE *f)
+{
+  uint64_t total = 0, bits = 0;
+
+  if (counting)
+    stop();
+  for (unsigned b = 0; b < BLOCKS; b++) {
+    total += blockToggles[b];
+    bits  += blockBits[b];
+  }
+
+  fprintf(f, "SIM: activity cycles=%llu bits=%llu toggles=%llu "
+          "per_cycle=%.1f\n", (unsigned long long)cycles,
+          (unsigned long long)bits, (unsigned long long)total,
+          cycles ? (double)total / cycles : 0.0);
+  for (unsigned b = 0; b < BLOCKS; b++) {
+    fprintf(f, "SIM: activity %-8s bits=%-5llu toggles=%-12llu "
+            "per_cycle=%-7.2f alpha=%.4f share=%5.1f%% idle=%5.1f%%",
+            blockNames[b], (unsigned long long)blockBits[b],
+            (unsigned long long)blockToggles[b],
+            cycles ? (double)blockToggles[b] / cycles : 0.0,
+            cycles ? (double)blockToggles[b] / cycles / blockBits[b] : 0.0,
+            total ? 100.0 * blockToggles[b] / total : 0.0,
+            cycles ? 100.0 * blockIdle[b] / cycles : 0.0);
+    if (b == BLOCK_MULT)
+      fprintf(f, " wasted=%.1f%%", blockToggles[b] ?
+              100.0 * multWasted / blockToggles[b] : 0.0);
+    fprintf(f, "\n");
+  }
+}
+
+bool
+Activity::writeSaif(const std::string &path, double period,
+                    const std::string &instance)
+{
+  FILE                    *f = fopen(path.c_str(), "w");
+  std::vector<std::string> scope;
+  std::string              rest = instance;
+  time_t                   now  = time(0);
+  char                     date[64];
+
+  if (!f)
+    return false;
+  if (counting)
+    stop();
+
+  while (!rest.empty()) {
+    size_t p = rest.find('/');
+
+    scope.push_back(rest.substr(0, p));
+    rest = (p == std::string::npos) ? "" : rest.substr(p + 1);
+  }
+  strftime(date, sizeof(date), "%a %b %d %H:%M:%S %Y", localtime(&now));
+
+  fprintf(f, "(SAIFILE\n(SAIFVERSION \"2.0\")\n(DIRECTION \"backward\")\n"
+          "(DESIGN \"arm9_compatiable_code\")\n(DATE \"%s\")\n"
+          "(VENDOR \"arm9_softcore\")\n(PROGRAM_NAME \"arm9sim\")\n"
+          "(VERSION \"1.0\")\n(DIVIDER / )\n(TIMESCALE 1 ns)\n"
+          "(DURATION %.0f)\n", date, cycles * period);
+  for (size_t i = 0; i < scope.size(); i++)
+    fprintf(f, "%*s(INSTANCE %s\n", (int)(2 * i), "", scope[i].c_str());
+
+  int indent = 2 * scope.size();
+
+  fprintf(f, "%*s(NET\n", indent, "");
+  for (size_t i = 0; i < signals.size(); i++) {
+    const Signal &s = signals[i];
+
+    for (unsigned k = 0; k < s.width; k++) {
+      unsigned b    = s.bit + k;
+      double   one  = t1[b] * period;
+      double   zero = cycles * period - one;
+
+      if (s.width == 1)
+        fprintf(f, "%*s(%s\n", indent + 2, "", s.name);
+      else
+        fprintf(f, "%*s(%s\\[%u\\]\n", indent + 2, "", s.name, k);
+      fprintf(f, "%*s(T0 %.0f) (T1 %.0f) (TX 0)\n%*s(TC %llu) (IG 0)\n"
+              "%*s)\n", indent + 4, "", zero, one, indent + 4, "",
+              (unsigned long long)tc[b], indent + 2, "");
+    }
+  }
+  fprintf(f, "%*s)\n", indent, "");
+  for (size_t i = scope.size(); i-- > 0;)
+    fprintf(f, "%*s)\n", (int)(2 * i), "");
+  fprintf(f, ")\n");
+  return fclose(f) == 0;
+}
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+void
+Activity::add(unsigned block, const char *name, const void *ptr,
+              unsigned bytes, unsigned width)
+{
+  Signal s;
+
+  s.name  = name;
+  s.ptr   = ptr;
+  s.bytes = bytes;
+  s.width = width;
+  s.block = block;
+  s.value = 0;
+  s.bit   = since.size();
+  signals.push_back(s);
+  since.resize(since.size() + width);
+  blockBits[block] += width;
+}
+
+uint64_t
+Activity::load(const Signal &s) const
+{
+  uint64_t v;
+
+  switch (s.bytes) {
+  case 1:  v = *(const uint8_t *)s.ptr;  break;
+  case 2:  v = *(const uint16_t *)s.ptr; break;
+  case 4:  v = *(const uint32_t *)s.ptr; break;
+  default: v = *(const uint64_t *)s.ptr; break;
+  }
+  return s.width < 64 ? v & ((1ull << s.width) - 1) : v;
+}
+
+/* counting starts from the current values: no toggles at the start */
+void
+Activity::start()
+{
+  for (size_t i = 0; i < signals.size(); i++)
+    signals[i].value = load(signals[i]);
+  for (size_t b = 0; b < since.size(); b++)
+    since[b] = cycles;
+  counting = true;
+}
+
+/* the time at 1 up to now */
+void
+Activity::stop()
+{
+  for (size_t i = 0; i < signals.size(); i++) {
+    const Signal &s = signals[i];
+
+    for (unsigned k = 0; k < s.width; k++)
+      if ((s.value >> k) & 1) {
+        t1[s.bit + k] += cycles - since[s.bit + k];
+        since[s.bit + k] = cycles;
+      }
+  }
+  counting = false;
+}
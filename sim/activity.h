@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Switching activity of the core, sampled once per cycle after the
+ *    clock edge: every register and named net of the RTL, bit by bit,
+ *    grouped into functional blocks
+ *
+ *      regfile     banked registers, pc, CPSR/SPSRs and the mode muxes
+ *      decode      instruction word, code_is_* / cmd_is_*, operand numbers
+ *      shifter     the sec_operand path: code_rm/rs, rotate, shift flags
+ *      alu         adder, logic results, dp_ans, flags
+ *      mult        mult_ans and reg_ans (the multiplier is never gated)
+ *      lsu         data and instruction bus, load/store and LDM datapath
+ *      control     interlocks, forwarding, exceptions
+ *
+ *    Toggles are counted once per cycle (zero-delay: no glitches). A
+ *    power estimate scales with the toggles of a block; 'idle' is the
+ *    share of cycles in which none of its bits changed, the upper bound
+ *    clock gating could save on its flops. Multiplier toggles outside
+ *    multiply instructions are reported separately as wasted.
+ *
+ *    write() prints "SIM: activity" lines; writeSaif() exports per-bit
+ *    T0/T1/TC in SAIF 2.0 for power analysis tools.
+ *
+ *****************************************************************************/
+#ifndef _activity_h_
+#define _activity_h_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+class Testbench;
+
+class Activity
+{
+public:
+  explicit Activity(Testbench *tb);
+
+  /* once per cycle, after the clock edge */
+  void sample();
+
+  /* count only between MARK 1 and MARK 2 of the sim control block */
+  bool onMarks;
+  void mark(uint32_t id);
+
+  void write(FILE *f);
+
+  /* 'period' in ns per cycle; 'instance' is the core's hierarchical
+     path in the power tool, '/' separated */
+  bool writeSaif(const std::string &path, double period,
+                 const std::string &instance);
+
+private:
+  struct Signal
+  {
+    const char *name;
+    const void *ptr;
+    unsigned    bytes;                    /* storage in the model */
+    unsigned    width;
+    unsigned    block;
+    uint64_t    value;
+    unsigned    bit;                      /* first of its per-bit counters */
+  };
+
+  void     add(unsigned block, const char *name, const void *ptr,
+               unsigned bytes, unsigned width);
+  uint64_t load(const Signal &s) const;
+  void     start();
+  void     stop();
+
+  Testbench            *tb;
+  std::vector<Signal>   signals;
+  bool                  counting;
+  uint64_t              cycles;           /* cycles counted */
+
+  /* per bit */
+  std::vector<uint64_t> tc, t1, since;
+
+  /* per block */
+  std::vector<uint64_t> blockBits, blockToggles, blockIdle;
+  uint64_t              multWasted;
+};
+
+#endif /* _activity_h_ */
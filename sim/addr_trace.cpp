@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Memory address trace of the core's two buses
+ *
+ *****************************************************************************/
+#include <string.h>
+
+#include "addr_trace.h"
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+AddrTrace::AddrTrace()
+  : f(0), last(0), count(0)
+{
+}
+
+AddrTrace::~AddrTrace()
+{
+  if (f)
+    close(0, 0);
+}
+
+bool
+AddrTrace::open(const char *path)
+{
+  AddrTraceHeader h;
+
+  f = fopen(path, "wb");
+  if (!f)
+    return false;
+
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "ARM9ATR1", 8);
+  fwrite(&h, sizeof(h), 1, f);
+  buf.reserve(1 << 16);
+  return true;
+}
+
+void
+AddrTrace::record(uint64_t cycle, unsigned kind, uint32_t addr, unsigned mask)
+{
+  uint64_t gap = cycle - last;
+
+  for (; gap > TRACE_GAP_MAX; gap -= TRACE_GAP_MAX)
+    buf.push_back(((uint64_t)TRACE_GAP << 30) | TRACE_GAP_MAX);
+
+  buf.push_back(((uint64_t)addr << 32) | ((uint64_t)kind << 30) |
+                ((uint64_t)(mask & 15) << 26) | gap);
+  last = cycle;
+  if (buf.size() >= (1 << 16))
+    flush();
+}
+
+void
+AddrTrace::close(uint64_t cycles, uint64_t instret)
+{
+  AddrTraceHeader h;
+
+  flush();
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "ARM9ATR1", 8);
+  h.cycles  = cycles;
+  h.instret = instret;
+  h.records = count;
+  fseek(f, 0, SEEK_SET);
+  fwrite(&h, sizeof(h), 1, f);
+  fclose(f);
+  f = 0;
+}
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+void
+AddrTrace::flush()
+{
+  fwrite(buf.data(), sizeof(uint64_t), buf.size(), f);
+  count += buf.size();
+  buf.clear();
+}
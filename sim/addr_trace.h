@@ -0,0 +1,65 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Memory address trace of the core's two buses, for trace-driven cache
+ *    studies (memdse.cpp). Written by arm9sim +addr_trace=<file>.
+ *
+ *    File layout: an AddrTraceHeader, then one little-endian 64-bit
+ *    record per bus request in cycle order:
+ *
+ *      63:32   byte address (fetches are word aligned)
+ *      31:30   kind (TRACE_FETCH, TRACE_LOAD, TRACE_STORE, TRACE_GAP)
+ *      29:26   byte lanes (ram_flag) of a data access
+ *      25:0    cycles since the previous record
+ *
+ *    A TRACE_GAP record only advances the time, for idle stretches
+ *    longer than the 26-bit field. The header is completed on close()
+ *    with the cycle and instruction counts of the run.
+ *
+ *****************************************************************************/
+#ifndef _addr_trace_h_
+#define _addr_trace_h_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#define TRACE_FETCH  0
+#define TRACE_LOAD   1
+#define TRACE_STORE  2
+#define TRACE_GAP    3
+
+#define TRACE_GAP_MAX  ((1u << 26) - 1)
+
+struct AddrTraceHeader
+{
+  char     magic[8];                      /* "ARM9ATR1" */
+  uint64_t cycles;
+  uint64_t instret;
+  uint64_t records;
+};
+
+class AddrTrace
+{
+public:
+  AddrTrace();
+  ~AddrTrace();
+
+  bool open(const char *path);
+
+  /* one bus request in cycle 'cycle' */
+  void record(uint64_t cycle, unsigned kind, uint32_t addr, unsigned mask);
+
+  /* flush and write the totals into the header */
+  void close(uint64_t cycles, uint64_t instret);
+
+private:
+  void flush();
+
+  FILE                 *f;
+  uint64_t              last;             /* cycle of the previous record */
+  uint64_t              count;
+  std::vector<uint64_t> buf;
+};
+
+#endif /* _addr_trace_h_ */
@@ -0,0 +1,129 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Architectural state of the core
+ *
+ *****************************************************************************/
+#include <string.h>
+
+#include "arch_state.h"
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static const char *regNames[15] = {
+  "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7",
+  "r8", "r9", "r10", "r11", "r12", "sp", "lr"
+};
+
+static const struct
+{
+  const char *name;
+  unsigned    mode;
+} banks[] = {
+  { "usr", MODE_USR }, { "fiq", MODE_FIQ }, { "irq", MODE_IRQ },
+  { "svc", MODE_SVC }, { "abt", MODE_ABT }, { "und", MODE_UND }
+};
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+ArchState::ArchState()
+{
+  memset(this, 0, sizeof(*this));
+  cpsr = PSR_I | PSR_F | MODE_SVC;
+}
+
+uint32_t &
+ArchState::reg(unsigned n, unsigned mode)
+{
+  if (n < 8)
+    return r[n];
+  if (mode == MODE_FIQ)
+    return fiq[n - 8];
+  if (n < 13)
+    return usr[n - 8];
+
+  switch (mode) {
+  case MODE_IRQ: return irq[n - 13];
+  case MODE_SVC: return svc[n - 13];
+  case MODE_ABT: return abt[n - 13];
+  case MODE_UND: return und[n - 13];
+  default:       return usr[n - 8];
+  }
+}
+
+uint32_t
+ArchState::reg(unsigned n, unsigned mode) const
+{
+  return const_cast<ArchState *>(this)->reg(n, mode);
+}
+
+uint32_t *
+ArchState::spsr(unsigned mode)
+{
+  switch (mode) {
+  case MODE_FIQ: return &spsrFiq;
+  case MODE_IRQ: return &spsrIrq;
+  case MODE_SVC: return &spsrSvc;
+  case MODE_ABT: return &spsrAbt;
+  case MODE_UND: return &spsrUnd;
+  default:       return 0;
+  }
+}
+
+bool
+ArchState::sameRegs(const ArchState &o) const
+{
+  return memcmp(r, o.r, sizeof(r)) == 0 &&
+         memcmp(usr, o.usr, sizeof(usr)) == 0 &&
+         memcmp(fiq, o.fiq, sizeof(fiq)) == 0 &&
+         memcmp(irq, o.irq, sizeof(irq)) == 0 &&
+         memcmp(svc, o.svc, sizeof(svc)) == 0 &&
+         memcmp(abt, o.abt, sizeof(abt)) == 0 &&
+         memcmp(und, o.und, sizeof(und)) == 0 &&
+         cpsr == o.cpsr && spsrFiq == o.spsrFiq && spsrIrq == o.spsrIrq &&
+         spsrSvc == o.spsrSvc && spsrAbt == o.spsrAbt &&
+         spsrUnd == o.spsrUnd;
+}
+
+void
+ArchState::print(FILE *f) const
+{
+  for (unsigned b = 0; b < sizeof(banks) / sizeof(banks[0]); b++) {
+    unsigned first = (b == 0) ? 0 : (banks[b].mode == MODE_FIQ) ? 8 : 13;
+
+    fprintf(f, "%s:", banks[b].name);
+    for (unsigned n = first; n < 15; n++)
+      fprintf(f, " %s=%08x", regNames[n], reg(n, banks[b].mode));
+    fprintf(f, "\n");
+  }
+  fprintf(f, "cpsr=%08x spsr fiq=%08x irq=%08x svc=%08x abt=%08x und=%08x "
+          "pc=%08x\n", cpsr, spsrFiq, spsrIrq, spsrSvc, spsrAbt, spsrUnd, pc);
+}
+
+void
+ArchState::diff(const ArchState &o, FILE *f) const
+{
+  for (unsigned b = 0; b < sizeof(banks) / sizeof(banks[0]); b++) {
+    unsigned first = (b == 0) ? 0 : (banks[b].mode == MODE_FIQ) ? 8 : 13;
+
+    for (unsigned n = first; n < 15; n++)
+      if (reg(n, banks[b].mode) != o.reg(n, banks[b].mode))
+        fprintf(f, "  %s_%s: %08x != %08x\n", regNames[n], banks[b].name,
+                reg(n, banks[b].mode), o.reg(n, banks[b].mode));
+  }
+  if (cpsr != o.cpsr)
+    fprintf(f, "  cpsr: %08x != %08x\n", cpsr, o.cpsr);
+  if (spsrFiq != o.spsrFiq)
+    fprintf(f, "  spsr_fiq: %08x != %08x\n", spsrFiq, o.spsrFiq);
+  if (spsrIrq != o.spsrIrq)
+    fprintf(f, "  spsr_irq: %08x != %08x\n", spsrIrq, o.spsrIrq);
+  if (spsrSvc != o.spsrSvc)
+    fprintf(f, "  spsr_svc: %08x != %08x\n", spsrSvc, o.spsrSvc);
+  if (spsrAbt != o.spsrAbt)
+    fprintf(f, "  spsr_abt: %08x != %08x\n", spsrAbt, o.spsrAbt);
+  if (spsrUnd != o.spsrUnd)
+    fprintf(f, "  spsr_und: %08x != %08x\n", spsrUnd, o.spsrUnd);
+}
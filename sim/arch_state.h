@@ -0,0 +1,63 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Architectural state of the core: the banked register file, CPSR and
+ *    the SPSRs. Status registers use the ARM layout (N Z C V in bits 31:28,
+ *    I and F in bits 7:6, mode in 4:0); the core keeps only those bits.
+ *
+ *****************************************************************************/
+#ifndef _arch_state_h_
+#define _arch_state_h_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define MODE_USR  0x10
+#define MODE_FIQ  0x11
+#define MODE_IRQ  0x12
+#define MODE_SVC  0x13
+#define MODE_ABT  0x17
+#define MODE_UND  0x1b
+#define MODE_SYS  0x1f
+
+#define PSR_N     0x80000000u
+#define PSR_Z     0x40000000u
+#define PSR_C     0x20000000u
+#define PSR_V     0x10000000u
+#define PSR_I     0x00000080u
+#define PSR_F     0x00000040u
+#define PSR_MODE  0x0000001fu
+#define PSR_MASK  (PSR_N | PSR_Z | PSR_C | PSR_V | PSR_I | PSR_F | PSR_MODE)
+
+struct ArchState
+{
+  uint32_t r[8];                          /* r0-r7 */
+  uint32_t usr[7];                        /* r8-r14, usr and sys mode */
+  uint32_t fiq[7];                        /* r8-r14, fiq mode */
+  uint32_t irq[2];                        /* r13-r14 */
+  uint32_t svc[2];
+  uint32_t abt[2];
+  uint32_t und[2];
+  uint32_t cpsr;
+  uint32_t spsrFiq, spsrIrq, spsrSvc, spsrAbt, spsrUnd;
+  uint32_t pc;                            /* next instruction */
+
+  ArchState();
+
+  /* register 'n' (0-14) as seen in mode 'mode' */
+  uint32_t &reg(unsigned n, unsigned mode);
+  uint32_t  reg(unsigned n, unsigned mode) const;
+
+  /* SPSR of 'mode', NULL in usr and sys mode */
+  uint32_t *spsr(unsigned mode);
+
+  /* compare everything but the pc */
+  bool sameRegs(const ArchState &o) const;
+
+  void print(FILE *f) const;
+
+  /* print the registers that differ from 'o' */
+  void diff(const ArchState &o, FILE *f) const;
+};
+
+#endif /* _arch_state_h_ */
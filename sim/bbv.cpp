@@ -0,0 +1,56 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Basic-block vectors
+ *
+ *****************************************************************************/
+#include <algorithm>
+
+#include "bbv.h"
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+uint32_t
+Bbv::id(uint32_t pc)
+{
+  std::unordered_map<uint32_t, uint32_t>::iterator it = ids.find(pc);
+
+  if (it != ids.end())
+    return it->second;
+
+  uint32_t n = pcs.size();
+
+  ids[pc] = n;
+  pcs.push_back(pc);
+  counts.push_back(0);
+  return n;
+}
+
+void
+Bbv::endInterval(FILE *f)
+{
+  if (touched.empty())
+    return;
+
+  std::sort(touched.begin(), touched.end());
+  fputc('T', f);
+  for (size_t i = 0; i < touched.size(); i++) {
+    uint32_t n = touched[i];
+
+    if (counts[n])
+      fprintf(f, ":%u:%llu ", n, (unsigned long long)counts[n]);
+    counts[n] = 0;
+  }
+  fputc('\n', f);
+  touched.clear();
+  intervals++;
+}
+
+void
+Bbv::writeMap(FILE *f) const
+{
+  for (size_t n = 1; n < pcs.size(); n++)
+    fprintf(f, "%zu 0x%08x\n", n, pcs[n]);
+}
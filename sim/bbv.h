@@ -0,0 +1,57 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Basic-block vectors for representative-region selection (SimPoint).
+ *    The block-translating ISS (dbt.h) adds the instructions each
+ *    translated block retires to its counter; every fixed-length interval
+ *    ends with endInterval(), which writes one line in the SimPoint 3
+ *    frequency-vector format and clears the counters:
+ *
+ *      T:<id>:<instructions> :<id>:<instructions> ...
+ *
+ *    Ids start at 1, one per block start address, in the order the blocks
+ *    are first translated. writeMap() lists "<id> <pc>" for reading the
+ *    clusters back in terms of code.
+ *
+ *****************************************************************************/
+#ifndef _bbv_h_
+#define _bbv_h_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <unordered_map>
+#include <vector>
+
+class Bbv
+{
+public:
+  Bbv() : intervals(0), counts(1, 0), pcs(1, 0) {}
+
+  /* id of the block starting at 'pc' */
+  uint32_t id(uint32_t pc);
+
+  void
+  add(uint32_t id, uint64_t n)
+  {
+    if (n == 0)
+      return;
+    if (counts[id] == 0)
+      touched.push_back(id);
+    counts[id] += n;
+  }
+
+  /* write the current interval (if anything ran) and start the next */
+  void endInterval(FILE *f);
+
+  void writeMap(FILE *f) const;
+
+  uint64_t intervals;                     /* lines written */
+
+private:
+  std::unordered_map<uint32_t, uint32_t> ids;
+  std::vector<uint64_t>                  counts;
+  std::vector<uint32_t>                  pcs;
+  std::vector<uint32_t>                  touched;
+};
+
+#endif /* _bbv_h_ */
@@ -0,0 +1,110 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Checkpoints
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "checkpoint.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define CKPT_MAGIC    0x4b433941u         /* "A9CK" */
+#define CKPT_VERSION  1u
+#define STATE_WORDS   (sizeof(ArchState) / 4)
+
+/* ArchState is saved word by word */
+static_assert(sizeof(ArchState) == 37 * 4, "ArchState layout changed");
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+bool
+Checkpoint::save(const std::string &path, const SparseMemory &mem,
+                 std::string &err) const
+{
+  std::vector<uint32_t> all = mem.pages(), used;
+  FILE                 *f;
+  uint32_t              hdr[4];
+  bool                  ok;
+
+  for (size_t i = 0; i < all.size(); i++) {
+    const uint32_t *p = mem.page(all[i]);
+
+    for (unsigned w = 0; w < SparseMemory::PAGE_WORDS; w++)
+      if (p[w]) {
+        used.push_back(all[i]);
+        break;
+      }
+  }
+
+  if (!(f = fopen(path.c_str(), "wb"))) {
+    err = "cannot create " + path;
+    return false;
+  }
+
+  hdr[0] = CKPT_MAGIC;
+  hdr[1] = CKPT_VERSION;
+  hdr[2] = (uint32_t)instret;
+  hdr[3] = (uint32_t)(instret >> 32);
+  ok     = fwrite(hdr, 4, 4, f) == 4 &&
+           fwrite(&st, 4, STATE_WORDS, f) == STATE_WORDS;
+
+  uint32_t n = used.size();
+
+  ok = ok && fwrite(&n, 4, 1, f) == 1;
+  for (size_t i = 0; ok && i < used.size(); i++)
+    ok = fwrite(&used[i], 4, 1, f) == 1 &&
+         fwrite(mem.page(used[i]), 4, SparseMemory::PAGE_WORDS, f) ==
+           SparseMemory::PAGE_WORDS;
+
+  if (fclose(f) != 0 || !ok) {
+    err = "cannot write " + path;
+    return false;
+  }
+  return true;
+}
+
+bool
+Checkpoint::load(const std::string &path, SparseMemory &mem, std::string &err)
+{
+  FILE    *f = fopen(path.c_str(), "rb");
+  uint32_t hdr[4], n = 0;
+  bool     ok;
+
+  if (!f) {
+    err = "cannot open " + path;
+    return false;
+  }
+
+  ok = fread(hdr, 4, 4, f) == 4;
+  if (!ok || hdr[0] != CKPT_MAGIC || hdr[1] != CKPT_VERSION) {
+    fclose(f);
+    err = path + ": not a checkpoint";
+    return false;
+  }
+  instret = hdr[2] | (uint64_t)hdr[3] << 32;
+  ok      = fread(&st, 4, STATE_WORDS, f) == STATE_WORDS &&
+            fread(&n, 4, 1, f) == 1;
+
+  mem.clear();
+  for (uint32_t i = 0; ok && i < n; i++) {
+    uint32_t base;
+
+    ok = fread(&base, 4, 1, f) == 1 &&
+         (base & (SparseMemory::PAGE_SIZE - 1)) == 0 &&
+         fread(mem.pageAlloc(base), 4, SparseMemory::PAGE_WORDS, f) ==
+           SparseMemory::PAGE_WORDS;
+  }
+  fclose(f);
+
+  if (!ok) {
+    err = path + ": truncated";
+    return false;
+  }
+  return true;
+}
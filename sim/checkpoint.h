@@ -0,0 +1,40 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Checkpoints for starting a simulation in the middle of a program:
+ *    the architectural state, the instruction count and every memory page
+ *    that is not all zero. Written by the ISS (iss_main.cpp +simpoints=)
+ *    and restored into the RTL (sample_main.cpp +checkpoints=). Device
+ *    state is not included; the serial port and the sim control block
+ *    keep none that matters to the firmware.
+ *
+ *    File layout, little endian:
+ *
+ *      "A9CK" version instret(8) ArchState(37 words) pages
+ *      { base, 1024 words } * pages
+ *
+ *****************************************************************************/
+#ifndef _checkpoint_h_
+#define _checkpoint_h_
+
+#include <stdint.h>
+#include <string>
+
+#include "arch_state.h"
+#include "memory.h"
+
+struct Checkpoint
+{
+  ArchState st;
+  uint64_t  instret;                      /* instructions before st.pc */
+
+  Checkpoint() : instret(0) {}
+
+  bool save(const std::string &path, const SparseMemory &mem,
+            std::string &err) const;
+
+  /* clears 'mem' first */
+  bool load(const std::string &path, SparseMemory &mem, std::string &err);
+};
+
+#endif /* _checkpoint_h_ */
@@ -0,0 +1,255 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Functional coverage of the core
+ *
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "coverage.h"
+#include "testbench.h"
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static const char *const classNames[] = {
+  "b", "bx", "dp0", "dp1", "dp2", "ldm", "ldr0", "ldr1", "ldrh0", "ldrh1",
+  "ldrsb0", "ldrsb1", "ldrsh0", "ldrsh1", "mrs", "msr0", "msr1", "mult",
+  "multl", "multlx", "swi", "swp", "swpx"
+};
+
+static const char *const condNames[] = {
+  "eq.pass", "eq.fail", "ne.pass", "ne.fail", "cs.pass", "cs.fail",
+  "cc.pass", "cc.fail", "mi.pass", "mi.fail", "pl.pass", "pl.fail",
+  "vs.pass", "vs.fail", "vc.pass", "vc.fail", "hi.pass", "hi.fail",
+  "ls.pass", "ls.fail", "ge.pass", "ge.fail", "lt.pass", "lt.fail",
+  "gt.pass", "gt.fail", "le.pass", "le.fail", "al.pass", "al.fail",
+  "nv.pass", "nv.fail"
+};
+
+static const char *const shiftNames[] = {
+  "lsl.0", "lsl.1-31", "lsl.32", "lsl.gt32",
+  "lsr.0", "lsr.1-31", "lsr.32", "lsr.gt32",
+  "asr.0", "asr.1-31", "asr.32", "asr.gt32",
+  "ror.0", "ror.1-31", "ror.32", "ror.gt32"
+};
+
+/* in the order of the terms of wait_en */
+static const char *const waitNames[] = {
+  "rm_cha", "rm_to", "rm_go", "rs_cha", "rs_to", "rs_go", "rn_cha",
+  "rnhi_cha", "rm_ldm", "rs_ldm"
+};
+
+static const char *const holdNames[] = { "swp", "multl", "ldm" };
+
+/* in the priority order of the cpsr_m update */
+static const char *const excNames[] = {
+  "restart", "fiq", "data_abort", "irq", "prefetch_abort", "undef", "swi"
+};
+
+enum
+{
+  SPECIAL_LDM_USER,                       /* LDM ^ without pc */
+  SPECIAL_STM_USER,                       /* STM ^ */
+  SPECIAL_LDM_PC,                         /* LDM with pc in the list */
+  SPECIAL_LDM_RESTORE,                    /* LDM ^ with pc: CPSR = SPSR */
+  SPECIAL_DP_RESTORE,                     /* ALU op with S to pc */
+  SPECIAL_LDR_PC,                         /* LDR to pc */
+  SPECIAL_MRS_SPSR,
+  SPECIAL_MSR_SPSR,
+  SPECIAL_MSR_USER                        /* MSR to the control bits in user
+                                             mode, ignored */
+};
+
+static const char *const specialNames[] = {
+  "ldm_user_bank", "stm_user_bank", "ldm_pc", "ldm_cpsr_restore",
+  "dp_cpsr_restore", "ldr_pc", "mrs_spsr", "msr_spsr", "msr_user_mode"
+};
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+Coverage::Coverage(Testbench *tb)
+  : tb(tb)
+{
+  classBin   = addBins("class",     classNames,   COUNT(classNames));
+  condBin    = addBins("cond",      condNames,    COUNT(condNames));
+  shiftBin   = addBins("shift_reg", shiftNames,   COUNT(shiftNames));
+  waitBin    = addBins("wait",      waitNames,    COUNT(waitNames));
+  holdBin    = addBins("hold",      holdNames,    COUNT(holdNames));
+  excBin     = addBins("exc",       excNames,     COUNT(excNames));
+  specialBin = addBins("special",   specialNames, COUNT(specialNames));
+}
+
+void
+Coverage::sample()
+{
+  if (!tb->top->cpu_en)
+    return;
+
+  uint32_t cmd     = RTL(tb, cmd);
+  bool     cmdFlag = RTL(tb, cmd_flag);
+  bool     intAll  = RTL(tb, int_all);
+  bool     holdEn  = RTL(tb, hold_en);
+  bool     ok      = cmdFlag && !intAll && RTL(tb, cond_satisfy);
+  bool     first   = cmdFlag && !intAll && !RTL(tb, hold_en_dly);
+  bool     user    = RTL(tb, cpsr_m) == 0x10;
+
+  /* instruction classes, every execute cycle */
+  if (ok) {
+    const uint8_t is[] = {
+      RTL(tb, cmd_is_b),      RTL(tb, cmd_is_bx),     RTL(tb, cmd_is_dp0),
+      RTL(tb, cmd_is_dp1),    RTL(tb, cmd_is_dp2),    RTL(tb, cmd_is_ldm),
+      RTL(tb, cmd_is_ldr0),   RTL(tb, cmd_is_ldr1),   RTL(tb, cmd_is_ldrh0),
+      RTL(tb, cmd_is_ldrh1),  RTL(tb, cmd_is_ldrsb0), RTL(tb, cmd_is_ldrsb1),
+      RTL(tb, cmd_is_ldrsh0), RTL(tb, cmd_is_ldrsh1), RTL(tb, cmd_is_mrs),
+      RTL(tb, cmd_is_msr0),   RTL(tb, cmd_is_msr1),   RTL(tb, cmd_is_mult),
+      RTL(tb, cmd_is_multl),  RTL(tb, cmd_is_multlx), RTL(tb, cmd_is_swi),
+      RTL(tb, cmd_is_swp),    RTL(tb, cmd_is_swpx)
+    };
+
+    for (unsigned i = 0; i < COUNT(is); i++)
+      if (is[i])
+        hit(classBin + i);
+  }
+
+  /* condition codes, once per instruction */
+  if (first)
+    hit(condBin + (cmd >> 28) * 2 + (RTL(tb, cond_satisfy) ? 0 : 1));
+
+  /* register-specified shift amount, latched at decode as
+     {>32, ==32, ==0} */
+  if (ok && RTL(tb, cmd_is_dp1)) {
+    unsigned flag = RTL(tb, code_rs_flag);
+    unsigned amt  = (flag & 1) ? 0 : (flag & 2) ? 2 : (flag & 4) ? 3 : 1;
+
+    hit(shiftBin + ((cmd >> 5) & 3) * 4 + amt);
+  }
+
+  /* operand interlocks, the terms of wait_en */
+  {
+    bool     rmVld   = RTL(tb, code_rm_vld);
+    bool     rsVld   = RTL(tb, code_rs_vld);
+    bool     rnVld   = RTL(tb, code_rn_vld);
+    bool     rnhiVld = RTL(tb, code_rnhi_vld);
+    unsigned rm      = RTL(tb, code_rm_num);
+    unsigned rs      = RTL(tb, code_rs_num);
+    unsigned rn      = RTL(tb, code_rn_num);
+    unsigned rnhi    = RTL(tb, code_rnhi_num);
+    bool     cha     = RTL(tb, cha_vld);
+    bool     to      = RTL(tb, to_vld);
+    bool     go      = RTL(tb, go_vld);
+    bool     ldm     = RTL(tb, ldm_vld) && !holdEn;
+    unsigned chaNum  = (cmd >> 12) & 15;
+    unsigned toNum   = RTL(tb, to_num);
+    unsigned goNum   = RTL(tb, go_num);
+    unsigned ldmNum  = RTL(tb, ldm_num);
+    const bool term[] = {
+      rmVld && cha && chaNum == rm,
+      rmVld && to && toNum == rm,
+      rmVld && go && goNum == rm,
+      rsVld && cha && chaNum == rs,
+      rsVld && to && toNum == rs,
+      rsVld && go && goNum == rs,
+      rnVld && cha && chaNum == rn,
+      rnhiVld && cha && chaNum == rnhi,
+      rmVld && ldm && ldmNum == rm,
+      rsVld && ldm && ldmNum == rs
+    };
+
+    for (unsigned i = 0; i < COUNT(term); i++)
+      if (term[i])
+        hit(waitBin + i);
+  }
+
+  /* multi-cycle instructions */
+  if (holdEn) {
+    if (RTL(tb, cmd_is_swp))
+      hit(holdBin + 0);
+    else if (RTL(tb, cmd_is_multl))
+      hit(holdBin + 1);
+    else
+      hit(holdBin + 2);
+  }
+
+  /* exception entry, as prioritized by the cpsr_m update */
+  if (intAll) {
+    if (tb->top->cpu_restart)
+      hit(excBin + 0);
+    else if (RTL(tb, fiq_en))
+      hit(excBin + 1);
+    else if (tb->top->ram_abort)
+      hit(excBin + 2);
+    else if (RTL(tb, irq_en))
+      hit(excBin + 3);
+    else if (RTL(tb, code_abort))
+      hit(excBin + 4);
+    else if (RTL(tb, code_und))
+      hit(excBin + 5);
+    else
+      hit(excBin + 6);
+  }
+
+  /* corner cases */
+  if (ok && RTL(tb, cmd_is_ldm)) {
+    bool load = cmd & (1u << 20);
+    bool hat  = cmd & (1u << 22);
+    bool pc   = cmd & (1u << 15);
+
+    if (first && load && hat && !pc)
+      hit(specialBin + SPECIAL_LDM_USER);
+    if (first && !load && hat)
+      hit(specialBin + SPECIAL_STM_USER);
+    if (first && load && pc)
+      hit(specialBin + SPECIAL_LDM_PC);
+    if ((cmd & 0xffff) == 0 && RTL(tb, ldm_change) && !user)
+      hit(specialBin + SPECIAL_LDM_RESTORE);
+  }
+  if (ok && (RTL(tb, cmd_is_dp0) || RTL(tb, cmd_is_dp1) ||
+             RTL(tb, cmd_is_dp2)) && ((cmd >> 23) & 3) != 2 &&
+      (cmd & (1u << 20)) && ((cmd >> 12) & 15) == 15 && !user)
+    hit(specialBin + SPECIAL_DP_RESTORE);
+  if (ok && (RTL(tb, cmd_is_ldr0) || RTL(tb, cmd_is_ldr1)) &&
+      (cmd & (1u << 20)) && ((cmd >> 12) & 15) == 15)
+    hit(specialBin + SPECIAL_LDR_PC);
+  if (ok && RTL(tb, cmd_is_mrs) && (cmd & (1u << 22)))
+    hit(specialBin + SPECIAL_MRS_SPSR);
+  if (ok && (RTL(tb, cmd_is_msr0) || RTL(tb, cmd_is_msr1))) {
+    if (cmd & (1u << 22))
+      hit(specialBin + SPECIAL_MSR_SPSR);
+    else if (user && (cmd & (1u << 16)))
+      hit(specialBin + SPECIAL_MSR_USER);
+  }
+}
+
+bool
+Coverage::write(const std::string &path) const
+{
+  FILE *f = fopen(path.c_str(), "w");
+
+  if (!f)
+    return false;
+  fprintf(f, "# arm9sim coverage, %llu cycles\n",
+          (unsigned long long)tb->cycle);
+  for (size_t i = 0; i < names.size(); i++)
+    fprintf(f, "%llu %s\n", (unsigned long long)hits[i], names[i].c_str());
+  return fclose(f) == 0;
+}
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+unsigned
+Coverage::addBins(const char *prefix, const char *const *binNames, unsigned n)
+{
+  unsigned first = names.size();
+
+  for (unsigned i = 0; i < n; i++)
+    names.push_back(std::string(prefix) + "." + binNames[i]);
+  hits.resize(names.size(), 0);
+  return first;
+}
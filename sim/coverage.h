@@ -0,0 +1,63 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Functional coverage of the core, sampled once per cycle from the
+ *    decode and execute signals:
+ *
+ *      class.<cmd_is_*>        execute cycles with the instruction class
+ *                              (cmd_ok), including the second cycles of
+ *                              SWP (swpx) and long multiplies (multlx)
+ *      cond.<cc>.pass/fail     instructions reaching execute, per condition
+ *                              code and cond_satisfy
+ *      shift_reg.<op>.<amt>    register-specified shifts by 0, 1-31, 32
+ *                              and more than 32
+ *      wait.<port>_<source>    cycles with each term of wait_en: operand
+ *                              port of the instruction in decode against
+ *                              the register written by cha (load data),
+ *                              to (ALU result), go or ldm
+ *      hold.<source>           cycles with hold_en, per source
+ *      exc.<type>              exception entries (int_all), by priority
+ *      special.*               corner cases: LDM/STM of the user bank,
+ *                              CPSR restore by LDM ^ and by ALU ops on pc
+ *
+ *    Each run writes all bins, hit or not, to a text file:
+ *
+ *      <hits> <bin>
+ *
+ *    regress/covreport.sh merges the files of a regression.
+ *
+ *****************************************************************************/
+#ifndef _coverage_h_
+#define _coverage_h_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class Testbench;
+
+class Coverage
+{
+public:
+  explicit Coverage(Testbench *tb);
+
+  /* once per cycle, before the clock edge */
+  void sample();
+
+  bool write(const std::string &path) const;
+
+private:
+  unsigned addBins(const char *prefix, const char *const *binNames,
+                   unsigned n);
+  void     hit(unsigned bin) { hits[bin]++; }
+
+  Testbench              *tb;
+  std::vector<std::string> names;
+  std::vector<uint64_t>   hits;
+
+  /* first bin of each group */
+  unsigned                classBin, condBin, shiftBin, waitBin, holdBin;
+  unsigned                excBin, specialBin;
+};
+
+#endif /* _coverage_h_ */
@@ -0,0 +1,589 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Block-translating instruction set simulator
+ *
+ *****************************************************************************/
+#include <string.h>
+
+#include "dbt.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define BIT(x, n)      (((x) >> (n)) & 1)
+#define FIELD(x, h, l) (((x) >> (l)) & ((1u << ((h) - (l) + 1)) - 1))
+
+#define ROR(v, n)      (((n) & 31) ? ((v) >> ((n) & 31)) | ((v) << (32 - ((n) & 31))) : (v))
+
+enum
+{
+  OP_GENERIC,                             /* Iss::execute() */
+  OP_DP,                                  /* data processing */
+  OP_MUL,                                 /* MUL, MLA */
+  OP_LDST,                                /* LDR/STR word and byte */
+  OP_LDLIT,                               /* LDR from a pc-relative literal */
+  OP_BLOCK,                               /* LDM/STM without ^ and pc */
+  OP_B                                    /* B, BL */
+};
+
+#define UF_S     0x01                     /* set flags */
+#define UF_IMM   0x02                     /* immediate operand / offset */
+#define UF_LOAD  0x04
+#define UF_BYTE  0x08
+#define UF_PRE   0x10
+#define UF_UP    0x20
+#define UF_WB    0x40                     /* base written back */
+#define UF_LINK  0x80                     /* BL; MLA for OP_MUL */
+
+/* condition code -> bit set for each passing NZCV value */
+static uint16_t condPass[16];
+
+static inline uint32_t
+pageOf(uint32_t addr)
+{
+  return addr >> SparseMemory::PAGE_BITS;
+}
+
+/* the instruction can change the pc (or take an exception) */
+static bool
+mayWritePc(uint32_t insn)
+{
+  unsigned cls = FIELD(insn, 27, 25);
+
+  if (!Iss::defined(insn) || cls == 7 || cls == 5)
+    return true;
+  if (cls == 4)
+    return BIT(insn, 20) && BIT(insn, 15);
+  if (cls == 0 && FIELD(insn, 24, 20) == 0x12 && FIELD(insn, 7, 4) == 1)
+    return true;                          /* BX */
+  return FIELD(insn, 15, 12) == 15;
+}
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+DbtIss::DbtIss(SparseMemory &mem)
+  : Iss(mem), blocksTranslated(0), blocksInvalidated(0), chainsFollowed(0),
+    bbv(0), bankMode(0), pageFlags(1u << (32 - SparseMemory::PAGE_BITS), 0),
+    stale(false)
+{
+  memset(hash, 0, sizeof(hash));
+  codeMap = &pageFlags[0];
+  bankSelect();
+
+  if (!condPass[0xe]) {
+    uint32_t cpsr = st.cpsr;
+
+    for (unsigned c = 0; c < 16; c++)
+      for (unsigned nzcv = 0; nzcv < 16; nzcv++) {
+        st.cpsr = nzcv << 28;
+        if (cond(c))
+          condPass[c] |= 1u << nzcv;
+      }
+    st.cpsr = cpsr;
+  }
+}
+
+DbtIss::~DbtIss()
+{
+  flush();
+}
+
+void
+DbtIss::reset()
+{
+  Iss::reset();
+  flush();
+  bankSelect();
+}
+
+void
+DbtIss::flush()
+{
+  for (std::unordered_map<uint32_t, Block *>::iterator it = blocks.begin();
+       it != blocks.end(); ++it)
+    delete it->second;
+  for (size_t i = 0; i < retired.size(); i++)
+    delete retired[i];
+  blocks.clear();
+  retired.clear();
+  pageBlocks.clear();
+  std::fill(pageFlags.begin(), pageFlags.end(), 0);
+  memset(hash, 0, sizeof(hash));
+  stale = false;
+}
+
+uint64_t
+DbtIss::run(uint64_t maxInstr)
+{
+  uint64_t steps = 0;
+  Block   *b     = 0;
+
+  if (trace)
+    return Iss::run(maxInstr);
+
+  while (!halted && (maxInstr == 0 || steps < maxInstr)) {
+    if (stale) {
+      for (size_t i = 0; i < retired.size(); i++)
+        delete retired[i];
+      retired.clear();
+      stale = false;
+      b     = 0;
+    }
+
+    /* interrupts are taken between blocks */
+    if ((irq || fiq) && interrupt()) {
+      steps++;
+      b = 0;
+      continue;
+    }
+    if ((st.cpsr & PSR_MODE) != bankMode)
+      bankSelect();
+
+    if (!b)
+      b = lookup(st.pc);
+
+    /* the tail of the step budget runs on the interpreter */
+    if (maxInstr && b->uops.size() > maxInstr - steps) {
+      uint64_t n  = instret;
+      uint32_t pc = st.pc;
+
+      step();
+      if (bbv)
+        bbv->add(bbv->id(pc), instret - n);
+      steps++;
+      b = 0;
+      continue;
+    }
+
+    if (bbv) {
+      uint64_t n  = instret;
+      uint32_t id = b->bbvId;
+
+      b = execBlock(b, steps);
+      bbv->add(id, instret - n);
+    }
+    else
+      b = execBlock(b, steps);
+  }
+  return steps;
+}
+
+/******************************************************************************
+ * Translation
+ *****************************************************************************/
+
+DbtIss::Block *
+DbtIss::lookup(uint32_t pc)
+{
+  Block *&h = hash[(pc >> 2) & (HASH_SIZE - 1)];
+
+  if (h && h->pc == pc)
+    return h;
+
+  std::unordered_map<uint32_t, Block *>::iterator it = blocks.find(pc);
+
+  h = (it != blocks.end()) ? it->second : translate(pc);
+  return h;
+}
+
+DbtIss::Block *
+DbtIss::translate(uint32_t pc)
+{
+  Block   *b = new Block;
+  uint32_t a = pc;
+
+  b->pc      = pc;
+  b->bbvId   = bbv ? bbv->id(pc) : 0;
+  b->link[0] = 0;
+  b->link[1] = 0;
+
+  do {
+    uint32_t insn = mem.read32(a);
+    Uop      u;
+
+    decode(u, insn, a);
+    b->uops.push_back(u);
+    a += 4;
+    if (u.op == OP_B || (u.op == OP_GENERIC && mayWritePc(insn)))
+      break;
+  } while (b->uops.size() < MAX_UOPS &&
+           (a & (SparseMemory::PAGE_SIZE - 1)) != 0);
+
+  b->end = a;
+  blocks[pc] = b;
+  pageBlocks[pageOf(pc)].push_back(b);
+  pageFlags[pageOf(pc)] = 1;
+  blocksTranslated++;
+  return b;
+}
+
+void
+DbtIss::decode(Uop &u, uint32_t insn, uint32_t pc)
+{
+  unsigned cls = FIELD(insn, 27, 25);
+  unsigned d   = FIELD(insn, 15, 12);
+  unsigned n   = FIELD(insn, 19, 16);
+  unsigned m   = FIELD(insn, 3, 0);
+
+  memset(&u, 0, sizeof(u));
+  u.op   = OP_GENERIC;
+  u.cond = insn >> 28;
+  u.insn = insn;
+  u.pc   = pc;
+
+  if (!defined(insn))
+    return;
+
+  switch (cls) {
+  case 0:
+  case 1:
+    /* MSR/MRS, register-specified shifts (and BX), multiplies, SWP and
+       halfword transfers stay generic */
+    if (FIELD(insn, 24, 23) == 2 && !BIT(insn, 20))
+      return;
+    if (cls == 0 && BIT(insn, 4)) {
+      if (FIELD(insn, 7, 4) == 9 && FIELD(insn, 24, 22) == 0 &&
+          d != 15 && n != 15 && m != 15 && FIELD(insn, 11, 8) != 15) {
+        u.op    = OP_MUL;
+        u.d     = n;                      /* Rd is in 19:16 */
+        u.n     = d;                      /* accumulator */
+        u.m     = m;
+        u.s     = FIELD(insn, 11, 8);
+        u.flags = (BIT(insn, 20) ? UF_S : 0) | (BIT(insn, 21) ? UF_LINK : 0);
+      }
+      return;
+    }
+    u.alu = FIELD(insn, 24, 21);
+    if (u.alu == 0xd || u.alu == 0xf)     /* MOV, MVN: no Rn */
+      n = 0;
+    if (d == 15 || n == 15 || (cls == 0 && m == 15))
+      return;
+    u.op    = OP_DP;
+    u.d     = d;
+    u.n     = n;
+    u.m     = m;
+    u.flags = BIT(insn, 20) ? UF_S : 0;
+    if (cls == 1) {
+      u.flags |= UF_IMM;
+      u.imm    = ROR(FIELD(insn, 7, 0), FIELD(insn, 11, 8) * 2);
+      u.shift  = FIELD(insn, 11, 8) != 0; /* carry out = bit 31 */
+    }
+    else
+      u.shift = (FIELD(insn, 6, 5) << 5) | FIELD(insn, 11, 7);
+    return;
+
+  case 2:
+  case 3:
+    if (d == 15 || (cls == 3 && m == 15))
+      return;
+    u.d     = d;
+    u.n     = n;
+    u.m     = m;
+    u.flags = (BIT(insn, 20) ? UF_LOAD : 0) | (BIT(insn, 22) ? UF_BYTE : 0) |
+              (BIT(insn, 24) ? UF_PRE : 0) | (BIT(insn, 23) ? UF_UP : 0) |
+              ((!BIT(insn, 24) || BIT(insn, 21)) ? UF_WB : 0);
+    if (cls == 2) {
+      u.flags |= UF_IMM;
+      u.imm    = FIELD(insn, 11, 0);
+    }
+    else
+      u.shift = (FIELD(insn, 6, 5) << 5) | FIELD(insn, 11, 7);
+
+    if (n == 15) {
+      /* literal pool: the address is known */
+      if (cls != 2 || !(u.flags & UF_LOAD) || (u.flags & UF_WB))
+        return;
+      u.op  = OP_LDLIT;
+      u.imm = (u.flags & UF_UP) ? pc + 8 + u.imm : pc + 8 - u.imm;
+      return;
+    }
+    u.op = OP_LDST;
+    return;
+
+  case 4:
+    if (BIT(insn, 22) || BIT(insn, 15) || n == 15 || FIELD(insn, 15, 0) == 0)
+      return;
+    u.op    = OP_BLOCK;
+    u.n     = n;
+    u.imm   = FIELD(insn, 15, 0);
+    u.flags = (BIT(insn, 20) ? UF_LOAD : 0) | (BIT(insn, 24) ? UF_PRE : 0) |
+              (BIT(insn, 23) ? UF_UP : 0) | (BIT(insn, 21) ? UF_WB : 0);
+    return;
+
+  case 5:
+    u.op    = OP_B;
+    u.imm   = pc + 8 + (uint32_t)((int32_t)(insn << 8) >> 6);
+    u.flags = BIT(insn, 24) ? UF_LINK : 0;
+    return;
+
+  default:
+    return;
+  }
+}
+
+/******************************************************************************
+ * Execution
+ *****************************************************************************/
+
+/* returns the next block when it is known (chained), else NULL */
+DbtIss::Block *
+DbtIss::execBlock(Block *b, uint64_t &steps)
+{
+  const Uop *u   = &b->uops[0];
+  const Uop *end = u + b->uops.size();
+
+  for (; u != end; u++) {
+    steps++;
+
+    if (u->op == OP_GENERIC) {
+      curPc = u->pc;
+      st.pc = u->pc + 4;
+      execute(u->insn);
+      if ((st.cpsr & PSR_MODE) != bankMode)
+        bankSelect();
+      if (st.pc != u->pc + 4 || halted || ioAccess || stale) {
+        ioAccess = false;
+        return 0;
+      }
+      continue;
+    }
+
+    instret++;
+    if (!(condPass[u->cond] >> (st.cpsr >> 28) & 1))
+      continue;
+
+    switch (u->op) {
+    case OP_DP:
+      dataProc(*u);
+      break;
+
+    case OP_MUL: {
+      uint32_t res = *R[u->m] * *R[u->s];
+
+      if (u->flags & UF_LINK)
+        res += *R[u->n];
+      *R[u->d] = res;
+      if (u->flags & UF_S) {
+        st.cpsr &= ~(PSR_N | PSR_Z);
+        st.cpsr |= (res & PSR_N) | (res ? 0 : PSR_Z);
+      }
+      break;
+    }
+
+    case OP_LDLIT:
+      *R[u->d] = (u->flags & UF_BYTE) ? load8(u->imm) : load32(u->imm);
+      break;
+
+    case OP_LDST:
+    case OP_BLOCK:
+      if (u->op == OP_LDST)
+        loadStore(*u);
+      else
+        blockTransfer(*u);
+      /* device accesses and self-modifying stores end the block */
+      if (ioAccess || stale) {
+        ioAccess = false;
+        st.pc    = u->pc + 4;
+        return 0;
+      }
+      break;
+
+    case OP_B:
+      if (u->flags & UF_LINK)
+        *R[14] = u->pc + 4;
+      st.pc = u->imm;
+      if (!b->link[0])
+        b->link[0] = lookup(u->imm);
+      chainsFollowed++;
+      return b->link[0];
+    }
+  }
+
+  /* fell off the end */
+  st.pc = b->end;
+  if (!b->link[1])
+    b->link[1] = lookup(b->end);
+  chainsFollowed++;
+  return b->link[1];
+}
+
+void
+DbtIss::bankSelect()
+{
+  bankMode = st.cpsr & PSR_MODE;
+  for (unsigned n = 0; n < 15; n++)
+    R[n] = &st.reg(n, bankMode);
+}
+
+/* same as Iss::shifter() for immediates and shifts by an immediate */
+uint32_t
+DbtIss::operand(const Uop &u, bool &carry) const
+{
+  bool     c = st.cpsr & PSR_C;
+  uint32_t v, n;
+
+  if (u.flags & UF_IMM) {
+    carry = u.shift ? BIT(u.imm, 31) : c;
+    return u.imm;
+  }
+
+  v = *R[u.m];
+  n = u.shift & 31;
+  switch (u.shift >> 5) {
+  case 0:
+    carry = n ? BIT(v, 32 - n) : c;
+    return n ? v << n : v;
+  case 1:
+    if (n == 0) {
+      carry = BIT(v, 31);
+      return 0;
+    }
+    carry = BIT(v, n - 1);
+    return v >> n;
+  case 2:
+    if (n == 0) {
+      carry = BIT(v, 31);
+      return carry ? 0xffffffffu : 0;
+    }
+    carry = BIT(v, n - 1);
+    return (uint32_t)((int32_t)v >> n);
+  default:
+    if (n == 0) {                         /* RRX */
+      carry = BIT(v, 0);
+      return ((uint32_t)c << 31) | (v >> 1);
+    }
+    carry = BIT(v, n - 1);
+    return ROR(v, n);
+  }
+}
+
+/* Iss::execDataProc() without pc operands */
+void
+DbtIss::dataProc(const Uop &u)
+{
+  uint32_t psr = st.cpsr;
+  bool     shc;
+  uint32_t b   = operand(u, shc);
+  uint32_t res = alu(u.alu, *R[u.n], b, shc, psr);
+
+  if (u.alu < 8 || u.alu > 11)
+    *R[u.d] = res;
+  if (u.flags & UF_S)
+    st.cpsr = psr;
+}
+
+/* Iss::execLdrStr() without pc operands */
+void
+DbtIss::loadStore(const Uop &u)
+{
+  uint32_t base = *R[u.n], off, addr, v;
+  bool     dummy;
+
+  off  = operand(u, dummy);
+  off  = (u.flags & UF_UP) ? off : (uint32_t)-off;
+  addr = (u.flags & UF_PRE) ? base + off : base;
+
+  if (!(u.flags & UF_LOAD)) {
+    if (u.flags & UF_BYTE)
+      store8(addr, *R[u.d]);
+    else
+      store32(addr, *R[u.d]);
+    if (u.flags & UF_WB)
+      *R[u.n] = base + off;
+    return;
+  }
+
+  v = (u.flags & UF_BYTE) ? load8(addr) : load32(addr);
+  if (u.flags & UF_WB)
+    *R[u.n] = base + off;
+  *R[u.d] = v;
+}
+
+/* Iss::execLdmStm() without ^ and pc */
+void
+DbtIss::blockTransfer(const Uop &u)
+{
+  unsigned list  = u.imm;
+  unsigned count = __builtin_popcount(list);
+  uint32_t base  = *R[u.n], addr, wb;
+
+  if (u.flags & UF_UP) {
+    addr = (u.flags & UF_PRE) ? base + 4 : base;
+    wb   = base + 4 * count;
+  }
+  else {
+    addr = (u.flags & UF_PRE) ? base - 4 * count : base - 4 * count + 4;
+    wb   = base - 4 * count;
+  }
+
+  if (!(u.flags & UF_LOAD)) {
+    for (; list; list &= list - 1, addr += 4)
+      store32(addr, *R[__builtin_ctz(list)]);
+    if (u.flags & UF_WB)
+      *R[u.n] = wb;
+    return;
+  }
+
+  if (u.flags & UF_WB)
+    *R[u.n] = wb;
+  for (; list; list &= list - 1, addr += 4)
+    *R[__builtin_ctz(list)] = load32(addr);
+}
+
+/******************************************************************************
+ * Self-modifying code
+ *****************************************************************************/
+
+/* a store hit a page with translated code: drop the blocks covering it */
+void
+DbtIss::codeWritten(uint32_t addr)
+{
+  std::unordered_map<uint32_t, std::vector<Block *> >::iterator it;
+  unsigned dropped = 0;
+
+  it = pageBlocks.find(pageOf(addr));
+  if (it == pageBlocks.end())
+    return;
+
+  std::vector<Block *> &v = it->second;
+
+  for (size_t i = 0; i < v.size(); ) {
+    Block *b = v[i];
+
+    if (addr < b->pc || addr >= b->end) {
+      i++;
+      continue;
+    }
+    blocks.erase(b->pc);
+    if (hash[(b->pc >> 2) & (HASH_SIZE - 1)] == b)
+      hash[(b->pc >> 2) & (HASH_SIZE - 1)] = 0;
+    retired.push_back(b);
+    v[i] = v.back();
+    v.pop_back();
+    dropped++;
+  }
+
+  if (v.empty()) {
+    pageFlags[it->first] = 0;
+    pageBlocks.erase(it);
+  }
+  if (dropped) {
+    blocksInvalidated += dropped;
+    unlinkAll();
+    stale = true;
+  }
+}
+
+/* chains may point at dropped blocks */
+void
+DbtIss::unlinkAll()
+{
+  for (std::unordered_map<uint32_t, Block *>::iterator it = blocks.begin();
+       it != blocks.end(); ++it) {
+    it->second->link[0] = 0;
+    it->second->link[1] = 0;
+  }
+}
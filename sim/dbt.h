@@ -0,0 +1,121 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Block-translating instruction set simulator for long firmware runs.
+ *    Same architecture and core quirks as the interpreter (iss.h), which
+ *    it extends; only the execution engine differs:
+ *
+ *    - ARM code is decoded once per basic block into an array of
+ *      micro-ops with the operands pre-extracted (register numbers,
+ *      rotated immediates, shift type and amount, addressing mode). Data
+ *      processing, MUL/MLA, LDR/STR and LDM/STM without ^ run from the
+ *      micro-op; everything else (PSR transfers, SWP, halfword accesses,
+ *      pc operands, SWI, undefined...) calls the interpreter's execute()
+ *      on the cached instruction word.
+ *    - A block ends at a branch, at an instruction that can write the pc,
+ *      at the end of a 4 KB page or after MAX_UOPS instructions. B and BL
+ *      link their block directly to the target block (and conditional
+ *      ones to the fall-through block), so loops run without a lookup.
+ *    - Stores into a page holding translated code drop the blocks
+ *      covering the address; a block that modifies itself stops after the
+ *      store.
+ *    - Loads and stores in the device region (0xE0000000, ioRead() and
+ *      ioWrite()) leave the block right after the access, so the serial
+ *      output, SIMCTL_EXIT and interrupt requests raised by a device model
+ *      take effect at the exact instruction.
+ *
+ *    Interrupt lines are sampled between blocks. run() stays exact: a
+ *    block longer than the remaining step budget is single-stepped by the
+ *    interpreter, as is everything while 'trace' is set.
+ *
+ *    Memory changed behind the simulator's back (loading an image after
+ *    the first run) needs a flush().
+ *
+ *    With 'bbv' set (before the first run, or followed by a flush()),
+ *    every block adds the instructions it retires to its basic-block
+ *    vector counter (bbv.h); the interpreted tail of a step budget counts
+ *    per instruction.
+ *
+ *****************************************************************************/
+#ifndef _dbt_h_
+#define _dbt_h_
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "bbv.h"
+#include "iss.h"
+
+class DbtIss : public Iss
+{
+public:
+  static const unsigned MAX_UOPS   = 64;
+  static const unsigned HASH_SIZE  = 4096; /* direct-mapped block lookup */
+
+  explicit DbtIss(SparseMemory &mem);
+  ~DbtIss();
+
+  void reset();
+
+  /* drop every translated block */
+  void flush();
+
+  uint64_t run(uint64_t maxInstr);
+
+  /* statistics */
+  uint64_t blocksTranslated;
+  uint64_t blocksInvalidated;
+  uint64_t chainsFollowed;
+
+  Bbv     *bbv;                           /* NULL = no profile */
+
+private:
+  struct Uop
+  {
+    uint8_t  op;                          /* OP_* */
+    uint8_t  cond;
+    uint8_t  alu;                         /* data processing opcode */
+    uint8_t  d, n, m, s;                  /* registers, s = Rs of MUL */
+    uint8_t  shift;                       /* type << 5 | amount */
+    uint8_t  flags;                       /* UF_* */
+    uint32_t imm;                         /* operand, offset or target */
+    uint32_t insn;
+    uint32_t pc;
+  };
+
+  struct Block
+  {
+    uint32_t         pc, end;             /* [pc, end) */
+    uint32_t         bbvId;
+    std::vector<Uop> uops;
+    Block           *link[2];             /* branch taken, fall-through */
+  };
+
+  Block   *lookup(uint32_t pc);
+  Block   *translate(uint32_t pc);
+  void     decode(Uop &u, uint32_t insn, uint32_t pc);
+  Block   *execBlock(Block *b, uint64_t &steps);
+  void     bankSelect();
+  void     codeWritten(uint32_t addr);
+  void     unlinkAll();
+
+  uint32_t operand(const Uop &u, bool &carry) const;
+  void     dataProc(const Uop &u);
+  void     loadStore(const Uop &u);
+  void     blockTransfer(const Uop &u);
+
+  uint32_t                               *R[15];  /* r0-r14 of the mode */
+  unsigned                                bankMode;
+
+  std::unordered_map<uint32_t, Block *>   blocks;
+  std::unordered_map<uint32_t, std::vector<Block *> > pageBlocks;
+  std::vector<uint8_t>                    pageFlags;  /* codeMap */
+  std::vector<Block *>                    retired;    /* freed between
+                                                         blocks */
+  Block                                  *hash[HASH_SIZE];
+  bool                                    stale;      /* a block was
+                                                         dropped */
+};
+
+#endif /* _dbt_h_ */
@@ -0,0 +1,232 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Memory-mapped devices of the simulation testbench
+ *
+ *****************************************************************************/
+#include <sys/time.h>
+#include <string>
+
+#include "devices.h"
+#include "testbench.h"
+
+/******************************************************************************
+ * SerialPort
+ *****************************************************************************/
+uint32_t
+SerialPort::read(uint32_t addr)
+{
+  if (addr == base)
+    return busy != 0;
+  if (addr == base + 12)
+    return ctrl;
+  return 0;
+}
+
+void
+SerialPort::write(uint32_t addr, uint32_t data, unsigned mask)
+{
+  (void)mask;
+  if (addr == base + 4) {
+    putchar(data & 0xff);
+    if (log)
+      fputc(data & 0xff, log);
+    busy = charCycles;
+  } else if (addr == base + 12)
+    ctrl = data & 1;
+}
+
+void
+SerialPort::tick()
+{
+  if (busy)
+    busy--;
+}
+
+/******************************************************************************
+ * TickTimer
+ *****************************************************************************/
+uint32_t
+TickTimer::read(uint32_t addr)
+{
+  return addr == base ? cmp : (uint32_t)cmpEn;
+}
+
+void
+TickTimer::write(uint32_t addr, uint32_t data, unsigned mask)
+{
+  (void)mask;
+  if (addr == base)
+    cmp = data;
+  else
+    cmpEn = data & 1;
+}
+
+void
+TickTimer::tick()
+{
+  if (count >= period - 1)
+    count = 0;
+  else
+    count++;
+}
+
+bool
+TickTimer::irq() const
+{
+  if (cmpEn)
+    return (int32_t)((uint32_t)tb->cycle - cmp) >= 0;
+  return period != 0 && count == period - 1;
+}
+
+/******************************************************************************
+ * SimControl
+ *****************************************************************************/
+SimControl::SimControl(Testbench *tb)
+  : Device(0xe0000010, 0x34), quiet(false), tb(tb), result(0),
+    cycleHi(0), instretHi(0), timeHi(0)
+{
+  arg[0] = arg[1] = arg[2] = 0;
+}
+
+SimControl::~SimControl()
+{
+  for (size_t i = 0; i < files.size(); i++)
+    if (files[i])
+      fclose(files[i]);
+}
+
+uint32_t
+SimControl::read(uint32_t addr)
+{
+  struct timeval tv;
+  uint64_t       us;
+
+  switch (addr - base) {
+  case 0x04:
+    cycleHi = tb->cycle >> 32;
+    return (uint32_t)tb->cycle;
+  case 0x08:
+    return cycleHi;
+  case 0x0c:
+    instretHi = tb->instret >> 32;
+    return (uint32_t)tb->instret;
+  case 0x10:
+    return instretHi;
+  case 0x18:
+    gettimeofday(&tv, 0);
+    us     = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    timeHi = us >> 32;
+    return (uint32_t)us;
+  case 0x1c:
+    return timeHi;
+  case 0x20:
+  case 0x24:
+  case 0x28:
+    return arg[(addr - base - 0x20) >> 2];
+  case 0x2c:
+    return result;
+  default:
+    return 0;
+  }
+}
+
+void
+SimControl::write(uint32_t addr, uint32_t data, unsigned mask)
+{
+  (void)mask;
+  switch (addr - base) {
+  case 0x00:
+    if (!quiet)
+      printf("\nSIM: exit=%d\n", (int32_t)data);
+    tb->exitCode = (int32_t)data;
+    tb->done     = true;
+    break;
+  case 0x14:
+    if (!quiet)
+      printf("SIM: mark=%u cycles=%llu instret=%llu\n", data,
+             (unsigned long long)tb->cycle, (unsigned long long)tb->instret);
+    if (tb->act)
+      tb->act->mark(data);
+    break;
+  case 0x20:
+  case 0x24:
+  case 0x28:
+    arg[(addr - base - 0x20) >> 2] = data;
+    break;
+  case 0x2c:
+    result = command(data);
+    break;
+  case 0x30:
+    if (tb->wave)
+      tb->wave->marker(data);
+    break;
+  default:
+    break;
+  }
+}
+
+FILE *
+SimControl::handle(uint32_t h)
+{
+  if (h == 1)
+    return stdout;
+  if (h == 2)
+    return stderr;
+  if (h < 3 || h - 3 >= files.size())
+    return 0;
+  return files[h - 3];
+}
+
+uint32_t
+SimControl::command(uint32_t cmd)
+{
+  static const char *modes[] = { "rb", "wb", "ab" };
+  SparseMemory      &mem = tb->mem;
+  std::string        path;
+  FILE              *f;
+  uint32_t           n;
+  int                c;
+
+  switch (cmd) {
+  case 1:                                 /* open */
+    for (n = 0; n < 4096 && (c = mem.read8(arg[0] + n)) != 0; n++)
+      path += (char)c;
+    f = fopen(path.c_str(), modes[arg[1] < 2 ? arg[1] : 2]);
+    if (!f)
+      return 0xffffffff;
+    for (n = 0; n < files.size(); n++)
+      if (!files[n])
+        break;
+    if (n == files.size())
+      files.push_back(f);
+    else
+      files[n] = f;
+    return n + 3;
+
+  case 2:                                 /* close */
+    f = handle(arg[0]);
+    if (!f || arg[0] < 3)
+      return 0xffffffff;
+    fclose(f);
+    files[arg[0] - 3] = 0;
+    return 0;
+
+  case 3:                                 /* read */
+    if (!(f = handle(arg[0])) || f == stdout || f == stderr)
+      return arg[0] == 0 ? 0 : 0xffffffff;
+    for (n = 0; n < arg[2] && (c = fgetc(f)) != EOF; n++)
+      mem.write8(arg[1] + n, c);
+    return n;
+
+  case 4:                                 /* write */
+    if (!(f = handle(arg[0])))
+      return 0xffffffff;
+    for (n = 0; n < arg[2]; n++)
+      fputc(mem.read8(arg[1] + n), f);
+    return n;
+
+  default:
+    return 0xffffffff;
+  }
+}
@@ -0,0 +1,127 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Memory-mapped devices of the simulation testbench. A device claims an
+ *    address range on the data bus (ram_*), is clocked once per core cycle
+ *    and may drive the irq/fiq inputs, or a request line of an interrupt
+ *    controller (lpc_periph.h).
+ *
+ *****************************************************************************/
+#ifndef _devices_h_
+#define _devices_h_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+class Testbench;
+
+class Device
+{
+public:
+  Device(uint32_t base, uint32_t size) : base(base), size(size) {}
+  virtual ~Device() {}
+
+  bool claims(uint32_t addr) const { return addr - base < size; }
+
+  virtual uint32_t read(uint32_t addr) { (void)addr; return 0; }
+  virtual void     write(uint32_t addr, uint32_t data, unsigned mask)
+                   { (void)addr; (void)data; (void)mask; }
+
+  /* called once per cycle, after the clock edge */
+  virtual void tick() {}
+
+  virtual bool irq() const { return false; }
+  virtual bool fiq() const { return false; }
+
+  /* request line into an interrupt controller (LpcVic::connect) */
+  virtual bool request() const { return false; }
+
+  const uint32_t base;
+  const uint32_t size;
+};
+
+/*
+ * Serial port of tb.v at 0xE0000000:
+ *    +0 SERIAL_FLAG  bit 0 = transmitter busy, bit 1 = receive data ready
+ *    +4 SERIAL_OUT   transmit data
+ *    +8 SERIAL_IN    receive data
+ *    +C SERIAL_CTRL  bit 0 = TXIE, irq while the transmitter is idle
+ * The transmitter is busy for 'charCycles' cycles after each character
+ * (0 = never busy) and nothing is ever received.
+ */
+class SerialPort : public Device
+{
+public:
+  SerialPort()
+    : Device(0xe0000000, 0x10), log(0), charCycles(0), ctrl(0), busy(0) {}
+
+  uint32_t read(uint32_t addr);
+  void     write(uint32_t addr, uint32_t data, unsigned mask);
+  void     tick();
+  bool     irq() const { return (ctrl & 1) && busy == 0; }
+
+  FILE    *log;                           /* copy of the output, or NULL */
+  unsigned charCycles;                    /* transmit time of a character */
+
+private:
+  uint32_t ctrl;
+  unsigned busy;                          /* cycles left on the character */
+};
+
+/*
+ * Timer tick of tb.v: a one-cycle irq pulse every 'period' cycles (0 =
+ * off), or the tick compare next to the sim control block:
+ *    +0 TICK_CMP   compare value for the low word of the cycle counter
+ *    +4 TICK_CTRL  bit 0 = compare mode: no pulses, irq held while the
+ *                  cycle counter is at or past TICK_CMP (signed distance)
+ */
+class TickTimer : public Device
+{
+public:
+  explicit TickTimer(Testbench *tb)
+    : Device(0xe0000044, 8), period(10000), count(0), tb(tb), cmp(0),
+      cmpEn(false) {}
+
+  uint32_t read(uint32_t addr);
+  void     write(uint32_t addr, uint32_t data, unsigned mask);
+  void     tick();
+  bool     irq() const;
+
+  unsigned period;
+  unsigned count;
+
+private:
+  Testbench *tb;
+  uint32_t   cmp;
+  bool       cmpEn;
+};
+
+/*
+ * Simulation control block at 0xE0000010 (register map in dhry/simctl.h):
+ * exit with status, cycle and instret counters, marks, host timestamp,
+ * host file access and the waveform capture trigger for the firmware.
+ */
+class SimControl : public Device
+{
+public:
+  explicit SimControl(Testbench *tb);
+  ~SimControl();
+
+  uint32_t read(uint32_t addr);
+  void     write(uint32_t addr, uint32_t data, unsigned mask);
+
+  bool                quiet;              /* no "SIM: exit/mark" lines */
+
+private:
+  uint32_t command(uint32_t cmd);
+  FILE    *handle(uint32_t h);
+
+  Testbench          *tb;
+  uint32_t            arg[3];
+  uint32_t            result;
+  uint32_t            cycleHi, instretHi, timeHi;
+  std::vector<FILE *> files;              /* handle 3 + n */
+};
+
+#endif /* _devices_h_ */
@@ -0,0 +1,296 @@
+/******************************************************************************
+ *
+ * Description:
+ *    ELF32 loader for the simulation testbench
+ *
+ *****************************************************************************/
+#include "elf_loader.h"
+
+#include <algorithm>
+#include <string.h>
+
+/******************************************************************************
+ * ELF32 definitions (subset of <elf.h>, which is not available everywhere)
+ *****************************************************************************/
+#define EI_NIDENT     16
+#define ELFCLASS32    1
+#define ELFDATA2LSB   1
+#define ET_EXEC       2
+#define EM_ARM        40
+#define PT_LOAD       1
+#define SHT_SYMTAB    2
+#define STT_FUNC      2
+#define STT_OBJECT    1
+
+typedef struct
+{
+  uint8_t  e_ident[EI_NIDENT];
+  uint16_t e_type;
+  uint16_t e_machine;
+  uint32_t e_version;
+  uint32_t e_entry;
+  uint32_t e_phoff;
+  uint32_t e_shoff;
+  uint32_t e_flags;
+  uint16_t e_ehsize;
+  uint16_t e_phentsize;
+  uint16_t e_phnum;
+  uint16_t e_shentsize;
+  uint16_t e_shnum;
+  uint16_t e_shstrndx;
+} Elf32Ehdr;
+
+typedef struct
+{
+  uint32_t p_type;
+  uint32_t p_offset;
+  uint32_t p_vaddr;
+  uint32_t p_paddr;
+  uint32_t p_filesz;
+  uint32_t p_memsz;
+  uint32_t p_flags;
+  uint32_t p_align;
+} Elf32Phdr;
+
+typedef struct
+{
+  uint32_t sh_name;
+  uint32_t sh_type;
+  uint32_t sh_flags;
+  uint32_t sh_addr;
+  uint32_t sh_offset;
+  uint32_t sh_size;
+  uint32_t sh_link;
+  uint32_t sh_info;
+  uint32_t sh_addralign;
+  uint32_t sh_entsize;
+} Elf32Shdr;
+
+typedef struct
+{
+  uint32_t st_name;
+  uint32_t st_value;
+  uint32_t st_size;
+  uint8_t  st_info;
+  uint8_t  st_other;
+  uint16_t st_shndx;
+} Elf32Sym;
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+static bool
+readFile(const std::string &path, std::vector<uint8_t> &buf, std::string &err)
+{
+  FILE *f = fopen(path.c_str(), "rb");
+  long  n;
+
+  if (!f) {
+    err = "cannot open " + path;
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  n = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  buf.resize(n > 0 ? n : 0);
+  if (n > 0 && fread(&buf[0], 1, n, f) != (size_t)n) {
+    fclose(f);
+    err = "cannot read " + path;
+    return false;
+  }
+  fclose(f);
+  return true;
+}
+
+/* bounds-checked view of a structure inside the file image */
+template <typename T>
+static const T *
+at(const std::vector<uint8_t> &buf, uint32_t off)
+{
+  if ((uint64_t)off + sizeof(T) > buf.size())
+    return 0;
+  return (const T *)&buf[off];
+}
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+bool
+isElfFile(const std::string &path)
+{
+  uint8_t magic[4] = { 0 };
+  FILE   *f        = fopen(path.c_str(), "rb");
+
+  if (!f)
+    return false;
+  size_t n = fread(magic, 1, 4, f);
+  fclose(f);
+  return n == 4 && memcmp(magic, "\177ELF", 4) == 0;
+}
+
+bool
+loadBinary(const std::string &path, uint32_t base, SparseMemory &mem,
+           std::string &err)
+{
+  std::vector<uint8_t> buf;
+
+  if (!readFile(path, buf, err))
+    return false;
+  if (!buf.empty())
+    mem.load(base, &buf[0], buf.size());
+  return true;
+}
+
+bool
+ElfImage::load(const std::string &path, SparseMemory &mem, std::string &err)
+{
+  std::vector<uint8_t> buf;
+
+  if (!readFile(path, buf, err))
+    return false;
+
+  const Elf32Ehdr *eh = at<Elf32Ehdr>(buf, 0);
+  if (!eh || memcmp(eh->e_ident, "\177ELF", 4) != 0) {
+    err = path + ": not an ELF file";
+    return false;
+  }
+  if (eh->e_ident[4] != ELFCLASS32 || eh->e_ident[5] != ELFDATA2LSB ||
+      eh->e_machine != EM_ARM) {
+    err = path + ": not a little-endian 32-bit ARM ELF file";
+    return false;
+  }
+  if (eh->e_type != ET_EXEC) {
+    err = path + ": not an executable (link it first)";
+    return false;
+  }
+
+  entryPoint = eh->e_entry;
+  segs.clear();
+  syms.clear();
+
+  /* program headers: PT_LOAD segments */
+  for (unsigned i = 0; i < eh->e_phnum; i++) {
+    const Elf32Phdr *ph = at<Elf32Phdr>(buf, eh->e_phoff + i * eh->e_phentsize);
+
+    if (!ph) {
+      err = path + ": truncated program header table";
+      return false;
+    }
+    if (ph->p_type != PT_LOAD || ph->p_memsz == 0)
+      continue;
+    if ((uint64_t)ph->p_offset + ph->p_filesz > buf.size()) {
+      err = path + ": segment outside of file";
+      return false;
+    }
+
+    ElfSegment s = { ph->p_paddr, ph->p_vaddr, ph->p_filesz, ph->p_memsz,
+                     ph->p_flags };
+    segs.push_back(s);
+
+    /* load image (what a flash programmer would write) */
+    if (ph->p_filesz)
+      mem.load(ph->p_paddr, &buf[ph->p_offset], ph->p_filesz);
+
+    /* run image: preload relocated sections and zero the remainder */
+    if (ph->p_vaddr != ph->p_paddr && ph->p_filesz)
+      mem.load(ph->p_vaddr, &buf[ph->p_offset], ph->p_filesz);
+    if (ph->p_memsz > ph->p_filesz)
+      mem.fill(ph->p_vaddr + ph->p_filesz, 0, ph->p_memsz - ph->p_filesz);
+  }
+
+  /* section headers: symbol table (optional, stripped images have none) */
+  for (unsigned i = 0; i < eh->e_shnum; i++) {
+    const Elf32Shdr *sh = at<Elf32Shdr>(buf, eh->e_shoff + i * eh->e_shentsize);
+
+    if (!sh || sh->sh_type != SHT_SYMTAB)
+      continue;
+
+    const Elf32Shdr *str = at<Elf32Shdr>(buf, eh->e_shoff +
+                                              sh->sh_link * eh->e_shentsize);
+    if (!str || (uint64_t)str->sh_offset + str->sh_size > buf.size())
+      continue;
+
+    for (uint32_t off = 0; off + sizeof(Elf32Sym) <= sh->sh_size;
+         off += sizeof(Elf32Sym)) {
+      const Elf32Sym *sym = at<Elf32Sym>(buf, sh->sh_offset + off);
+
+      if (!sym || sym->st_name == 0 || sym->st_name >= str->sh_size ||
+          sym->st_shndx == 0)
+        continue;
+
+      const char *name = (const char *)&buf[str->sh_offset + sym->st_name];
+      size_t      len  = strnlen(name, str->sh_size - sym->st_name);
+
+      /* skip ARM mapping symbols ($a, $d, $t) */
+      if (name[0] == '$')
+        continue;
+
+      ElfSymbol s;
+      s.name  = std::string(name, len);
+      s.value = sym->st_value;
+      s.size  = sym->st_size;
+      s.type  = sym->st_info & 0xf;
+      syms.push_back(s);
+    }
+  }
+
+  std::sort(syms.begin(), syms.end(),
+            [](const ElfSymbol &a, const ElfSymbol &b) {
+              return a.value < b.value;
+            });
+  return true;
+}
+
+bool
+ElfImage::lookup(const std::string &name, uint32_t &addr) const
+{
+  for (size_t i = 0; i < syms.size(); i++) {
+    if (syms[i].name == name) {
+      addr = syms[i].value;
+      return true;
+    }
+  }
+  return false;
+}
+
+const ElfSymbol *
+ElfImage::symbolAt(uint32_t addr) const
+{
+  /* last symbol with value <= addr, then check it covers addr */
+  std::vector<ElfSymbol>::const_iterator it =
+    std::upper_bound(syms.begin(), syms.end(), addr,
+                     [](uint32_t a, const ElfSymbol &s) { return a < s.value; });
+
+  while (it != syms.begin()) {
+    --it;
+    if (it->type != STT_FUNC && it->type != STT_OBJECT)
+      continue;
+    if (addr < it->value + (it->size ? it->size : 1))
+      return &*it;
+    break;
+  }
+  return 0;
+}
+
+void
+ElfImage::printSummary(FILE *f) const
+{
+  fprintf(f, "elf: entry 0x%08x, %u symbols\n", entryPoint,
+          (unsigned)syms.size());
+  for (size_t i = 0; i < segs.size(); i++)
+    fprintf(f, "elf:   load 0x%08x run 0x%08x filesz 0x%06x memsz 0x%06x %c%c%c\n",
+            segs[i].paddr, segs[i].vaddr, segs[i].filesz, segs[i].memsz,
+            (segs[i].flags & 4) ? 'r' : '-', (segs[i].flags & 2) ? 'w' : '-',
+            (segs[i].flags & 1) ? 'x' : '-');
+}
+
+void
+ElfImage::printSymbols(FILE *f) const
+{
+  for (size_t i = 0; i < syms.size(); i++)
+    fprintf(f, "%08x %6u %s %s\n", syms[i].value, syms[i].size,
+            syms[i].type == STT_FUNC ? "F" : (syms[i].type == STT_OBJECT ? "O" : " "),
+            syms[i].name.c_str());
+}
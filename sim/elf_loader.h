@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ * Description:
+ *    ELF32 (little endian, ARM) loader. PT_LOAD segments are placed at
+ *    their load address in a SparseMemory; segments whose run address
+ *    differs (e.g. .data linked to RAM, stored after .text) are also
+ *    preloaded at the run address, zero-filled up to p_memsz. The symbol
+ *    table is kept for address lookups.
+ *
+ *****************************************************************************/
+#ifndef _elf_loader_h_
+#define _elf_loader_h_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "memory.h"
+
+struct ElfSymbol
+{
+  std::string name;
+  uint32_t    value;
+  uint32_t    size;
+  uint8_t     type;                       /* STT_* */
+};
+
+struct ElfSegment
+{
+  uint32_t paddr;
+  uint32_t vaddr;
+  uint32_t filesz;
+  uint32_t memsz;
+  uint32_t flags;                         /* PF_* */
+};
+
+class ElfImage
+{
+public:
+  ElfImage() : entryPoint(0) {}
+
+  /* returns false and sets 'err' when the file is not a loadable ARM ELF */
+  bool load(const std::string &path, SparseMemory &mem, std::string &err);
+
+  uint32_t entry() const { return entryPoint; }
+  const std::vector<ElfSegment> &segments() const { return segs; }
+  const std::vector<ElfSymbol>  &symbols() const { return syms; }
+
+  /* symbol by name; false when absent */
+  bool lookup(const std::string &name, uint32_t &addr) const;
+
+  /* function/object symbol covering 'addr', or NULL */
+  const ElfSymbol *symbolAt(uint32_t addr) const;
+
+  void printSummary(FILE *f) const;
+  void printSymbols(FILE *f) const;
+
+private:
+  uint32_t                entryPoint;
+  std::vector<ElfSegment> segs;
+  std::vector<ElfSymbol>  syms;           /* sorted by value */
+};
+
+/* checks the ELF magic only */
+bool isElfFile(const std::string &path);
+
+/* raw binary image at 'base', as $fread does in tb.v */
+bool loadBinary(const std::string &path, uint32_t base, SparseMemory &mem,
+                std::string &err);
+
+#endif /* _elf_loader_h_ */
@@ -0,0 +1,598 @@
+/******************************************************************************
+ *
+ * Description:
+ *    GDB remote serial protocol server for the Verilated core
+ *
+ *****************************************************************************/
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "gdb_stub.h"
+#include "testbench.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define REG_CPSR    25                    /* GDB's number of cpsr */
+#define REG_BANKED  26                    /* first of the banked registers */
+#define NUM_BANKED  27
+
+/* cycles between two polls of the socket for Ctrl-C while running */
+#define POLL_CYCLES 4096
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static const char *bankedNames[NUM_BANKED] = {
+  "r8_usr", "r9_usr", "r10_usr", "r11_usr", "r12_usr", "r13_usr", "r14_usr",
+  "r8_fiq", "r9_fiq", "r10_fiq", "r11_fiq", "r12_fiq", "r13_fiq", "r14_fiq",
+  "r13_irq", "r14_irq", "r13_svc", "r14_svc", "r13_abt", "r14_abt",
+  "r13_und", "r14_und",
+  "spsr_fiq", "spsr_irq", "spsr_svc", "spsr_abt", "spsr_und"
+};
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+static std::string
+hex32(uint32_t v)
+{
+  char buf[9];
+
+  /* target byte order */
+  snprintf(buf, sizeof(buf), "%02x%02x%02x%02x", v & 0xff, (v >> 8) & 0xff,
+           (v >> 16) & 0xff, v >> 24);
+  return buf;
+}
+
+static int
+hexDigit(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+static uint32_t
+parseHex32(const char *s)
+{
+  uint32_t v = 0;
+
+  for (int i = 0; i < 4 && hexDigit(s[0]) >= 0 && hexDigit(s[1]) >= 0; i++) {
+    v |= (uint32_t)(hexDigit(s[0]) * 16 + hexDigit(s[1])) << (8 * i);
+    s += 2;
+  }
+  return v;
+}
+
+/* target description: the standard core registers plus the banked ones */
+static std::string
+targetXml()
+{
+  std::string xml;
+  char        buf[96];
+
+  xml = "<?xml version=\"1.0\"?>"
+        "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">"
+        "<target version=\"1.0\"><architecture>arm</architecture>"
+        "<feature name=\"org.gnu.gdb.arm.core\">";
+  for (int i = 0; i < 13; i++) {
+    snprintf(buf, sizeof(buf), "<reg name=\"r%d\" bitsize=\"32\"/>", i);
+    xml += buf;
+  }
+  xml += "<reg name=\"sp\" bitsize=\"32\" type=\"data_ptr\"/>"
+         "<reg name=\"lr\" bitsize=\"32\"/>"
+         "<reg name=\"pc\" bitsize=\"32\" type=\"code_ptr\"/>"
+         "<reg name=\"cpsr\" bitsize=\"32\" regnum=\"25\"/>"
+         "</feature><feature name=\"org.gnu.gdb.arm9.banked\">";
+  for (int i = 0; i < NUM_BANKED; i++) {
+    snprintf(buf, sizeof(buf),
+             "<reg name=\"%s\" bitsize=\"32\" group=\"banked\"/>",
+             bankedNames[i]);
+    xml += buf;
+  }
+  xml += "</feature></target>";
+  return xml;
+}
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+GdbStub::GdbStub(Testbench *tb)
+  : tb(tb), listenFd(-1), fd(-1), dirty(false), lastStop("S05"), exited(false),
+    detached(false)
+{
+}
+
+GdbStub::~GdbStub()
+{
+  if (fd >= 0)
+    close(fd);
+  if (listenFd >= 0)
+    close(listenFd);
+}
+
+bool
+GdbStub::listen(unsigned port)
+{
+  struct sockaddr_in addr;
+  int                one = 1;
+
+  listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenFd < 0)
+    return false;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      ::listen(listenFd, 1) < 0) {
+    perror("gdb");
+    return false;
+  }
+
+  fprintf(stderr, "GDB: waiting on localhost:%u\n", port);
+  fd = accept(listenFd, 0, 0);
+  if (fd < 0)
+    return false;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  fprintf(stderr, "GDB: connected\n");
+  return true;
+}
+
+bool
+GdbStub::serve()
+{
+  std::string pkt;
+
+  halt(tb->execPc() != ~0u ? tb->execPc() : RTL(tb, rf));
+
+  while (getPacket(pkt)) {
+    if (!handle(pkt))
+      break;
+  }
+  return detached;
+}
+
+/******************************************************************************
+ * Packets
+ *****************************************************************************/
+
+int
+GdbStub::getChar()
+{
+  unsigned char c;
+  ssize_t       n;
+
+  do
+    n = read(fd, &c, 1);
+  while (n < 0 && errno == EINTR);
+  return n == 1 ? c : -1;
+}
+
+bool
+GdbStub::getPacket(std::string &pkt)
+{
+  int c;
+
+  for (;;) {
+    do {
+      if ((c = getChar()) < 0)
+        return false;
+    } while (c != '$');
+
+    unsigned sum = 0;
+
+    pkt.clear();
+    while ((c = getChar()) >= 0 && c != '#') {
+      pkt += (char)c;
+      sum += c;
+    }
+    if (c < 0)
+      return false;
+
+    int hi = hexDigit(getChar()), lo = hexDigit(getChar());
+
+    if (hi >= 0 && lo >= 0 && (unsigned)(hi * 16 + lo) == (sum & 0xff)) {
+      if (write(fd, "+", 1) != 1)
+        return false;
+      return true;
+    }
+    if (write(fd, "-", 1) != 1)
+      return false;
+  }
+}
+
+void
+GdbStub::putPacket(const std::string &pkt)
+{
+  std::string out = "$" + pkt + "#";
+  unsigned    sum = 0;
+  char        buf[3];
+  int         c;
+
+  for (size_t i = 0; i < pkt.size(); i++)
+    sum += (unsigned char)pkt[i];
+  snprintf(buf, sizeof(buf), "%02x", sum & 0xff);
+  out += buf;
+
+  do {
+    if (write(fd, out.data(), out.size()) != (ssize_t)out.size())
+      return;
+    c = getChar();
+  } while (c == '-');
+}
+
+/* Ctrl-C (0x03) from GDB while the target runs */
+bool
+GdbStub::interruptPending()
+{
+  struct pollfd p;
+
+  p.fd     = fd;
+  p.events = POLLIN;
+  while (poll(&p, 1, 0) > 0 && (p.revents & POLLIN)) {
+    int c = getChar();
+
+    if (c == 0x03 || c < 0)
+      return true;
+  }
+  return false;
+}
+
+/* one packet; false ends the session */
+bool
+GdbStub::handle(const std::string &pkt)
+{
+  const char *p = pkt.c_str();
+  std::string reply;
+  char       *end;
+
+  switch (p[0]) {
+  case '?':
+    reply = lastStop;
+    break;
+
+  case 'g':
+    reply = readRegs();
+    break;
+
+  case 'G':
+    for (unsigned n = 0, i = 1; i + 8 <= pkt.size(); n++, i += 8) {
+      unsigned  r = (n < 16) ? n : (n == 16) ? REG_CPSR : REG_BANKED + n - 17;
+      uint32_t *v = regPtr(r);
+
+      if (v)
+        *v = parseHex32(p + i);
+    }
+    dirty = true;
+    reply = "OK";
+    break;
+
+  case 'p':
+    {
+      uint32_t *v = regPtr(strtoul(p + 1, 0, 16));
+
+      reply = v ? hex32(*v) : "E01";
+    }
+    break;
+
+  case 'P':
+    {
+      uint32_t *v = regPtr(strtoul(p + 1, &end, 16));
+
+      if (v && *end == '=') {
+        *v    = parseHex32(end + 1);
+        dirty = true;
+        reply = "OK";
+      }
+      else
+        reply = "E01";
+    }
+    break;
+
+  case 'm':
+    {
+      uint32_t addr = strtoul(p + 1, &end, 16);
+      uint32_t len  = strtoul(end + 1, 0, 16);
+
+      reply = readMem(addr, len);
+    }
+    break;
+
+  case 'M':
+    {
+      uint32_t    addr = strtoul(p + 1, &end, 16);
+      uint32_t    len  = strtoul(end + 1, &end, 16);
+      const char *d    = end + 1;
+
+      for (uint32_t i = 0; i < len && d[0] && d[1]; i++, d += 2)
+        tb->mem.write8(addr + i, hexDigit(d[0]) * 16 + hexDigit(d[1]));
+      reply = "OK";
+    }
+    break;
+
+  case 'c':
+  case 's':
+    if (p[1]) {
+      st.pc = strtoul(p + 1, 0, 16);
+      dirty = true;
+    }
+    reply = resume(p[0] == 's');
+    break;
+
+  case 'Z':
+  case 'z':
+    {
+      unsigned type = p[1] - '0';
+      uint32_t addr = strtoul(p + 3, &end, 16);
+      uint32_t len  = strtoul(end + 1, 0, 16);
+
+      if (type <= 1) {
+        if (p[0] == 'Z')
+          breakpoints.insert(addr);
+        else
+          breakpoints.erase(addr);
+        reply = "OK";
+      }
+      else if (type <= 4) {
+        if (p[0] == 'Z') {
+          Watch w = { addr, len, type };
+          watches.push_back(w);
+        }
+        else
+          for (size_t i = 0; i < watches.size(); i++)
+            if (watches[i].addr == addr && watches[i].len == len &&
+                watches[i].type == type) {
+              watches.erase(watches.begin() + i);
+              break;
+            }
+        reply = "OK";
+      }
+    }
+    break;
+
+  case 'H':
+    reply = "OK";
+    break;
+
+  case 'k':
+    return false;
+
+  case 'D':
+    putPacket("OK");
+    if (dirty)
+      tb->setArchState(st);
+    else
+      tb->setPc(st.pc);
+    tb->top->cpu_en = 1;
+    detached = true;
+    return false;
+
+  case 'q':
+    if (strncmp(p, "qSupported", 10) == 0)
+      reply = "PacketSize=1000;qXfer:features:read+";
+    else if (strcmp(p, "qAttached") == 0)
+      reply = "1";
+    else if (strcmp(p, "qC") == 0)
+      reply = "QC1";
+    else if (strcmp(p, "qfThreadInfo") == 0)
+      reply = "m1";
+    else if (strcmp(p, "qsThreadInfo") == 0)
+      reply = "l";
+    else if (strncmp(p, "qXfer:features:read:target.xml:", 31) == 0) {
+      std::string xml = targetXml();
+      uint32_t    off = strtoul(p + 31, &end, 16);
+      uint32_t    len = strtoul(end + 1, 0, 16);
+
+      if (off >= xml.size())
+        reply = "l";
+      else {
+        std::string part = xml.substr(off, len);
+
+        reply = (off + part.size() < xml.size() ? "m" : "l") + part;
+      }
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  putPacket(reply);
+  return !exited;
+}
+
+/******************************************************************************
+ * Run control
+ *****************************************************************************/
+
+/* stop before the instruction at 'pc' and read the state */
+void
+GdbStub::halt(uint32_t pc)
+{
+  tb->drain(pc);
+  tb->top->cpu_en = 0;
+  tb->top->eval();
+  tb->archState(st);
+  st.pc = pc;
+  dirty = false;
+}
+
+/* data access of the instruction in execute hitting a watchpoint */
+const GdbStub::Watch *
+GdbStub::watchHit(uint32_t &addr)
+{
+  if (!tb->top->ram_cen)
+    return 0;
+
+  for (unsigned b = 0; b < 4; b++) {
+    uint32_t a = tb->top->ram_addr + b;
+
+    if (!(tb->top->ram_flag & (1u << b)))
+      continue;
+    for (size_t i = 0; i < watches.size(); i++) {
+      const Watch &w = watches[i];
+
+      if (a - w.addr >= w.len)
+        continue;
+      if ((w.type == 2 && !tb->top->ram_wen) ||
+          (w.type == 3 && tb->top->ram_wen))
+        continue;
+      addr = a;
+      return &w;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Run until a breakpoint, a watchpoint, Ctrl-C or the end of the
+ * program, or for one instruction. An instruction counts as executed
+ * once it retired or was flushed by an exception; the core then stops
+ * in front of the next one to reach execute.
+ */
+std::string
+GdbStub::resume(bool step)
+{
+  static const char *watchNames[5] = { 0, 0, "watch", "rwatch", "awatch" };
+  uint64_t     instret = tb->instret;
+  uint32_t     start   = st.pc;
+  bool         moved   = false;
+  bool         stop    = step;
+  const Watch *hit     = 0;
+  uint32_t     hitAddr = 0;
+  char         buf[64];
+
+  if (dirty)
+    tb->setArchState(st);
+  else
+    tb->setPc(st.pc);
+  tb->top->cpu_en = 1;
+
+  for (uint64_t n = 0;; n++) {
+    uint32_t x = tb->execPc();
+
+    if (x != ~0u) {
+      if (moved && (stop || hit)) {
+        halt(x);
+        break;
+      }
+      if (breakpoints.count(x) && (moved || x != start)) {
+        halt(x);
+        break;
+      }
+    }
+
+    if (tb->done) {
+      snprintf(buf, sizeof(buf), "W%02x", tb->exitCode & 0xff);
+      exited   = true;
+      lastStop = buf;
+      return lastStop;
+    }
+    if (n % POLL_CYCLES == POLL_CYCLES - 1 && interruptPending())
+      stop = true;
+
+    if (!hit)
+      hit = watchHit(hitAddr);
+    if (RTL(tb, int_all))
+      moved = true;
+
+    tb->tick();
+
+    if (tb->instret != instret)
+      moved = true;
+  }
+
+  if (hit) {
+    snprintf(buf, sizeof(buf), "T05%s:%x;", watchNames[hit->type], hitAddr);
+    lastStop = buf;
+  }
+  else
+    lastStop = stop && !step ? "S02" : "S05";
+  return lastStop;
+}
+
+/******************************************************************************
+ * Registers and memory
+ *****************************************************************************/
+
+/* GDB register number -> state while halted, NULL if not described */
+uint32_t *
+GdbStub::regPtr(unsigned n)
+{
+  unsigned mode = st.cpsr & PSR_MODE;
+
+  if (n < 15)
+    return &st.reg(n, mode);
+  if (n == 15)
+    return &st.pc;
+  if (n == REG_CPSR)
+    return &st.cpsr;
+  if (n < REG_BANKED || n >= REG_BANKED + NUM_BANKED)
+    return 0;
+
+  n -= REG_BANKED;
+  if (n < 7)
+    return &st.usr[n];
+  if (n < 14)
+    return &st.fiq[n - 7];
+  switch (n) {
+  case 14: return &st.irq[0];
+  case 15: return &st.irq[1];
+  case 16: return &st.svc[0];
+  case 17: return &st.svc[1];
+  case 18: return &st.abt[0];
+  case 19: return &st.abt[1];
+  case 20: return &st.und[0];
+  case 21: return &st.und[1];
+  case 22: return &st.spsrFiq;
+  case 23: return &st.spsrIrq;
+  case 24: return &st.spsrSvc;
+  case 25: return &st.spsrAbt;
+  default: return &st.spsrUnd;
+  }
+}
+
+/* 'g' layout: registers in GDB number order, undescribed ones left out */
+std::string
+GdbStub::readRegs()
+{
+  std::string s;
+
+  for (unsigned n = 0; n < 16; n++)
+    s += hex32(*regPtr(n));
+  s += hex32(st.cpsr);
+  for (unsigned n = 0; n < NUM_BANKED; n++)
+    s += hex32(*regPtr(REG_BANKED + n));
+  return s;
+}
+
+std::string
+GdbStub::readMem(uint32_t addr, uint32_t len)
+{
+  std::string s;
+  char        buf[3];
+
+  for (uint32_t i = 0; i < len; i++) {
+    snprintf(buf, sizeof(buf), "%02x", tb->mem.read8(addr + i));
+    s += buf;
+  }
+  return s;
+}
@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ * Description:
+ *    GDB remote serial protocol server for the Verilated core:
+ *
+ *      ./arm9sim dhry.elf +gdb=3333
+ *      arm-none-eabi-gdb dhry.elf -ex "target remote :3333"
+ *
+ *    The core is halted by holding cpu_en low (nothing is clocked while
+ *    GDB has control) and always stops at an instruction boundary: the
+ *    next instruction is flushed from the pipeline and refetched on
+ *    resume, so register and memory writes from GDB are seen by it.
+ *
+ *    Registers: r0-r15 and cpsr as seen in the current mode, plus every
+ *    banked register and SPSR (r8_usr ... spsr_und, "info registers all"),
+ *    described to GDB with a target description. Breakpoints (Z0 and Z1)
+ *    are address compares on the instruction in execute, so code is
+ *    never patched; watchpoints (Z2-Z4) compare the data bus. Ctrl-C
+ *    stops a running target.
+ *
+ *****************************************************************************/
+#ifndef _gdb_stub_h_
+#define _gdb_stub_h_
+
+#include <stdint.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "arch_state.h"
+
+class Testbench;
+
+class GdbStub
+{
+public:
+  explicit GdbStub(Testbench *tb);
+  ~GdbStub();
+
+  /* wait for GDB on localhost:'port' */
+  bool listen(unsigned port);
+
+  /*
+   * Serve the session; the core is halted on entry. Returns true when
+   * GDB detached (the caller lets the simulation run on), false after a
+   * kill, an exit of the program or a lost connection.
+   */
+  bool serve();
+
+private:
+  struct Watch
+  {
+    uint32_t addr, len;
+    unsigned type;                        /* 2 write, 3 read, 4 access */
+  };
+
+  int         getChar();
+  bool        getPacket(std::string &pkt);
+  void        putPacket(const std::string &pkt);
+  bool        interruptPending();
+
+  bool        handle(const std::string &pkt);
+  std::string resume(bool step);
+  void        halt(uint32_t pc);
+  const Watch *watchHit(uint32_t &addr);
+
+  uint32_t    *regPtr(unsigned n);
+  std::string readRegs();
+  std::string readMem(uint32_t addr, uint32_t len);
+
+  Testbench            *tb;
+  int                   listenFd, fd;
+
+  ArchState             st;               /* state while halted, st.pc is
+                                             the next instruction */
+  bool                  dirty;            /* st changed by GDB */
+  std::string           lastStop;
+  bool                  exited;
+  bool                  detached;
+
+  std::set<uint32_t>    breakpoints;
+  std::vector<Watch>    watches;
+};
+
+#endif /* _gdb_stub_h_ */
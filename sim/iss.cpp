@@ -0,0 +1,673 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Instruction set simulator of the core (reference model)
+ *
+ *****************************************************************************/
+#include "iss.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define BIT(x, n)      (((x) >> (n)) & 1)
+#define FIELD(x, h, l) (((x) >> (l)) & ((1u << ((h) - (l) + 1)) - 1))
+
+#define ROR(v, n)      (((n) & 31) ? ((v) >> ((n) & 31)) | ((v) << (32 - ((n) & 31))) : (v))
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+Iss::Iss(SparseMemory &mem)
+  : mem(mem), irq(false), fiq(false), halted(false), exitCode(0),
+    instret(0), trace(0), ioAccess(false), codeMap(0), curPc(0)
+{
+}
+
+void
+Iss::reset()
+{
+  st       = ArchState();
+  st.pc    = 0;
+  halted   = false;
+  exitCode = 0;
+  instret  = 0;
+}
+
+bool
+Iss::defined(uint32_t c)
+{
+  switch (FIELD(c, 27, 25)) {
+  case 0:
+    if (!BIT(c, 4)) {
+      if (FIELD(c, 24, 23) == 2 && !BIT(c, 20)) {
+        if (!BIT(c, 21))
+          return FIELD(c, 19, 16) == 0xf && FIELD(c, 11, 0) == 0;
+        return FIELD(c, 18, 17) == 0 && FIELD(c, 15, 12) == 0xf &&
+               FIELD(c, 11, 4) == 0;
+      }
+      return FIELD(c, 24, 23) != 2 || BIT(c, 20);
+    }
+    if (!BIT(c, 7)) {
+      if (FIELD(c, 24, 20) == 0x12)
+        return FIELD(c, 19, 4) == 0xfff1;
+      return FIELD(c, 24, 23) != 2 || BIT(c, 20);
+    }
+    if (FIELD(c, 6, 5) == 0) {
+      if (FIELD(c, 24, 22) == 0 || FIELD(c, 24, 23) == 1)
+        return true;
+      if (FIELD(c, 24, 23) == 2)
+        return FIELD(c, 21, 20) == 0 && FIELD(c, 11, 8) == 0;
+      return false;
+    }
+    if (FIELD(c, 6, 5) == 1)
+      return BIT(c, 22) || FIELD(c, 11, 8) == 0;
+    return BIT(c, 20) && (BIT(c, 22) || FIELD(c, 11, 8) == 0);
+  case 1:
+    if (FIELD(c, 24, 23) == 2 && !BIT(c, 20))
+      return BIT(c, 21) && FIELD(c, 18, 17) == 0 && FIELD(c, 15, 12) == 0xf;
+    return FIELD(c, 24, 23) != 2 || BIT(c, 20);
+  case 3:
+    return !BIT(c, 4);
+  case 7:
+    return BIT(c, 24);
+  case 6:
+    return false;
+  default:
+    return true;
+  }
+}
+
+bool
+Iss::step()
+{
+  uint32_t insn;
+
+  if (halted)
+    return false;
+
+  /* interrupts are taken between instructions */
+  if (interrupt())
+    return true;
+
+  curPc = st.pc;
+  insn  = mem.read32(curPc & ~3u);
+  st.pc = curPc + 4;
+
+  if (trace)
+    fprintf(trace, "%08x %08x\n", curPc, insn);
+
+  execute(insn);
+  return !halted;
+}
+
+uint64_t
+Iss::run(uint64_t maxInstr)
+{
+  uint64_t n = 0;
+
+  while (!halted && (maxInstr == 0 || n < maxInstr)) {
+    step();
+    n++;
+  }
+  return n;
+}
+
+bool
+Iss::interrupt()
+{
+  if (fiq && !(st.cpsr & PSR_F)) {
+    exception(MODE_FIQ, 0x1c, st.pc + 4);
+    return true;
+  }
+  if (irq && !(st.cpsr & PSR_I)) {
+    exception(MODE_IRQ, 0x18, st.pc + 4);
+    return true;
+  }
+  return false;
+}
+
+void
+Iss::execute(uint32_t insn)
+{
+  if (!defined(insn)) {
+    exception(MODE_UND, 0x04, curPc + 4);
+    return;
+  }
+  if (!cond(insn >> 28)) {
+    instret++;
+    return;
+  }
+
+  switch (FIELD(insn, 27, 25)) {
+  case 0:
+    if (!BIT(insn, 4)) {
+      if (FIELD(insn, 24, 23) == 2 && !BIT(insn, 20)) {
+        if (BIT(insn, 21))
+          execMsr(insn);
+        else
+          execMrs(insn);
+      }
+      else
+        execDataProc(insn);
+    }
+    else if (!BIT(insn, 7)) {
+      if (FIELD(insn, 24, 20) == 0x12)
+        wr(15, rd(FIELD(insn, 3, 0)));    /* BX */
+      else
+        execDataProc(insn);
+    }
+    else if (FIELD(insn, 6, 5) == 0) {
+      if (FIELD(insn, 24, 23) == 0)
+        execMul(insn);
+      else if (FIELD(insn, 24, 23) == 1)
+        execMull(insn);
+      else
+        execSwap(insn);
+    }
+    else
+      execHalf(insn);
+    break;
+  case 1:
+    if (FIELD(insn, 24, 23) == 2 && !BIT(insn, 20))
+      execMsr(insn);
+    else
+      execDataProc(insn);
+    break;
+  case 2:
+  case 3:
+    execLdrStr(insn);
+    break;
+  case 4:
+    execLdmStm(insn);
+    break;
+  case 5:
+    execBranch(insn);
+    break;
+  default:                                /* SWI */
+    exception(MODE_SVC, 0x08, curPc + 4);
+    return;
+  }
+
+  instret++;
+}
+
+/******************************************************************************
+ * Memory and devices
+ *****************************************************************************/
+
+uint32_t
+Iss::ioRead(uint32_t addr)
+{
+  if (addr == 0xe000000c)                 /* SERIAL_CTRL */
+    return irq;
+  return 0;
+}
+
+void
+Iss::ioWrite(uint32_t addr, uint32_t data, unsigned mask)
+{
+  (void)mask;
+  if (addr == 0xe0000004)
+    putchar(data & 0xff);
+  else if (addr == 0xe000000c)            /* TXIE: the port is never busy */
+    irq = data & 1;
+  else if (addr == 0xe0000010) {
+    halted   = true;
+    exitCode = (int32_t)data;
+  }
+}
+
+static inline bool
+isIo(uint32_t addr)
+{
+  return (addr & 0xffffff80u) == 0xe0000000u;
+}
+
+uint32_t
+Iss::load32(uint32_t addr)
+{
+  addr &= ~3u;
+  if (isIo(addr)) {
+    ioAccess = true;
+    return ioRead(addr);
+  }
+  return mem.read32(addr);
+}
+
+uint32_t
+Iss::load16(uint32_t addr)
+{
+  return (load32(addr) >> ((addr & 2) * 8)) & 0xffff;
+}
+
+uint32_t
+Iss::load8(uint32_t addr)
+{
+  return (load32(addr) >> ((addr & 3) * 8)) & 0xff;
+}
+
+void
+Iss::store32(uint32_t addr, uint32_t data)
+{
+  addr &= ~3u;
+  if (isIo(addr)) {
+    ioAccess = true;
+    ioWrite(addr, data, 0xf);
+  }
+  else if ((addr >> 28) != 0) {
+    mem.write32(addr, data);
+    if (codeMap && codeMap[addr >> SparseMemory::PAGE_BITS])
+      codeWritten(addr);
+  }
+}
+
+void
+Iss::store16(uint32_t addr, uint32_t data)
+{
+  unsigned sh = (addr & 2) * 8;
+
+  data &= 0xffff;
+  if (isIo(addr & ~3u)) {
+    ioAccess = true;
+    ioWrite(addr & ~3u, data << sh, 3u << (addr & 2));
+  }
+  else if ((addr >> 28) != 0) {
+    mem.write32(addr & ~3u, data << sh, 3u << (addr & 2));
+    if (codeMap && codeMap[addr >> SparseMemory::PAGE_BITS])
+      codeWritten(addr & ~3u);
+  }
+}
+
+void
+Iss::store8(uint32_t addr, uint32_t data)
+{
+  data &= 0xff;
+  if (isIo(addr & ~3u)) {
+    ioAccess = true;
+    ioWrite(addr & ~3u, data * 0x01010101u, 1u << (addr & 3));
+  }
+  else if ((addr >> 28) != 0) {
+    mem.write8(addr, data);
+    if (codeMap && codeMap[addr >> SparseMemory::PAGE_BITS])
+      codeWritten(addr & ~3u);
+  }
+}
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+uint32_t
+Iss::rd(unsigned n) const
+{
+  return n == 15 ? curPc + 8 : st.reg(n, mode());
+}
+
+void
+Iss::wr(unsigned n, uint32_t v)
+{
+  if (n == 15)
+    st.pc = v & ~3u;
+  else
+    st.reg(n, mode()) = v;
+}
+
+bool
+Iss::cond(unsigned c) const
+{
+  bool n = st.cpsr & PSR_N, z = st.cpsr & PSR_Z;
+  bool cy = st.cpsr & PSR_C, v = st.cpsr & PSR_V;
+
+  switch (c) {
+  case 0x0: return z;
+  case 0x1: return !z;
+  case 0x2: return cy;
+  case 0x3: return !cy;
+  case 0x4: return n;
+  case 0x5: return !n;
+  case 0x6: return v;
+  case 0x7: return !v;
+  case 0x8: return cy && !z;
+  case 0x9: return !cy || z;
+  case 0xa: return n == v;
+  case 0xb: return n != v;
+  case 0xc: return !z && n == v;
+  case 0xd: return z || n != v;
+  case 0xe: return true;
+  default:  return false;
+  }
+}
+
+void
+Iss::exception(unsigned m, uint32_t vector, uint32_t lr)
+{
+  *st.spsr(m) = st.cpsr;
+  st.cpsr     = (st.cpsr & ~PSR_MODE) | m | PSR_I;
+  if (m == MODE_FIQ)
+    st.cpsr |= PSR_F;
+  st.reg(14, m) = lr;
+  st.pc         = vector;
+}
+
+/* CPSR = SPSR of the current mode (no SPSR in usr/sys: unchanged) */
+void
+Iss::restoreCpsr()
+{
+  uint32_t *spsr = st.spsr(mode());
+
+  if (spsr)
+    st.cpsr = *spsr;
+}
+
+uint32_t
+Iss::shifter(uint32_t insn, bool &carry) const
+{
+  bool     c = st.cpsr & PSR_C;
+  uint32_t v, n;
+
+  if (BIT(insn, 25)) {                    /* immediate */
+    n = FIELD(insn, 11, 8) * 2;
+    v = ROR(FIELD(insn, 7, 0), n);
+    carry = n ? BIT(v, 31) : c;
+    return v;
+  }
+
+  v = rd(FIELD(insn, 3, 0));
+
+  if (!BIT(insn, 4)) {                    /* shift by immediate */
+    n = FIELD(insn, 11, 7);
+    switch (FIELD(insn, 6, 5)) {
+    case 0:
+      carry = n ? BIT(v, 32 - n) : c;
+      return n ? v << n : v;
+    case 1:
+      if (n == 0) {
+        carry = BIT(v, 31);
+        return 0;
+      }
+      carry = BIT(v, n - 1);
+      return v >> n;
+    case 2:
+      if (n == 0) {
+        carry = BIT(v, 31);
+        return carry ? 0xffffffffu : 0;
+      }
+      carry = BIT(v, n - 1);
+      return (uint32_t)((int32_t)v >> n);
+    default:
+      if (n == 0) {                       /* RRX */
+        carry = BIT(v, 0);
+        return ((uint32_t)c << 31) | (v >> 1);
+      }
+      carry = BIT(v, n - 1);
+      return ROR(v, n);
+    }
+  }
+
+  /* shift by register */
+  n = rd(FIELD(insn, 11, 8)) & 0xff;
+  if (n == 0) {
+    carry = c;
+    return v;
+  }
+  switch (FIELD(insn, 6, 5)) {
+  case 0:
+    if (n < 32) {
+      carry = BIT(v, 32 - n);
+      return v << n;
+    }
+    carry = (n == 32) ? BIT(v, 0) : 0;
+    return 0;
+  case 1:
+    if (n < 32) {
+      carry = BIT(v, n - 1);
+      return v >> n;
+    }
+    carry = (n == 32) ? BIT(v, 31) : 0;
+    return 0;
+  case 2:
+    if (n < 32) {
+      carry = BIT(v, n - 1);
+      return (uint32_t)((int32_t)v >> n);
+    }
+    carry = BIT(v, 31);
+    return carry ? 0xffffffffu : 0;
+  default:
+    n &= 31;
+    if (n == 0) {
+      carry = BIT(v, 31);
+      return v;
+    }
+    carry = BIT(v, n - 1);
+    return ROR(v, n);
+  }
+}
+
+void
+Iss::execDataProc(uint32_t insn)
+{
+  unsigned op  = FIELD(insn, 24, 21);
+  unsigned d   = FIELD(insn, 15, 12);
+  uint32_t psr = st.cpsr;
+  bool     shc;
+  uint32_t a   = rd(FIELD(insn, 19, 16));
+  uint32_t b   = shifter(insn, shc);
+  uint32_t res = alu(op, a, b, shc, psr);
+
+  /* TST, TEQ, CMP, CMN have no result */
+  if (op < 8 || op > 11)
+    wr(d, res);
+
+  if (!BIT(insn, 20))
+    return;
+  if (d == 15) {
+    restoreCpsr();
+    return;
+  }
+  st.cpsr = psr;
+}
+
+void
+Iss::execMul(uint32_t insn)
+{
+  uint32_t res = rd(FIELD(insn, 3, 0)) * rd(FIELD(insn, 11, 8));
+
+  if (BIT(insn, 21))
+    res += rd(FIELD(insn, 15, 12));
+  wr(FIELD(insn, 19, 16), res);
+
+  if (BIT(insn, 20)) {
+    st.cpsr &= ~(PSR_N | PSR_Z);
+    st.cpsr |= (res & PSR_N) | (res ? 0 : PSR_Z);
+  }
+}
+
+void
+Iss::execMull(uint32_t insn)
+{
+  unsigned hi = FIELD(insn, 19, 16), lo = FIELD(insn, 15, 12);
+  uint32_t m  = rd(FIELD(insn, 3, 0)), s = rd(FIELD(insn, 11, 8));
+  uint64_t res;
+
+  if (BIT(insn, 22))
+    res = (uint64_t)((int64_t)(int32_t)m * (int64_t)(int32_t)s);
+  else
+    res = (uint64_t)m * s;
+  if (BIT(insn, 21))
+    res += ((uint64_t)rd(hi) << 32) | rd(lo);
+
+  wr(lo, (uint32_t)res);
+  wr(hi, (uint32_t)(res >> 32));
+
+  if (BIT(insn, 20)) {
+    st.cpsr &= ~(PSR_N | PSR_Z);
+    st.cpsr |= ((uint32_t)(res >> 32) & PSR_N) | (res ? 0 : PSR_Z);
+  }
+}
+
+void
+Iss::execSwap(uint32_t insn)
+{
+  uint32_t addr = rd(FIELD(insn, 19, 16));
+  uint32_t src  = rd(FIELD(insn, 3, 0));
+  uint32_t tmp;
+
+  if (BIT(insn, 22)) {
+    tmp = load8(addr);
+    store8(addr, src);
+  }
+  else {
+    tmp = load32(addr);
+    store32(addr, src);
+  }
+  wr(FIELD(insn, 15, 12), tmp);
+}
+
+void
+Iss::execHalf(uint32_t insn)
+{
+  unsigned n = FIELD(insn, 19, 16), d = FIELD(insn, 15, 12);
+  uint32_t off, base = rd(n), addr, v;
+
+  off  = BIT(insn, 22) ? (FIELD(insn, 11, 8) << 4) | FIELD(insn, 3, 0)
+                       : rd(FIELD(insn, 3, 0));
+  off  = BIT(insn, 23) ? off : (uint32_t)-off;
+  addr = BIT(insn, 24) ? base + off : base;
+
+  if (!BIT(insn, 20)) {                   /* STRH */
+    store16(addr, rd(d));
+    if (!BIT(insn, 24) || BIT(insn, 21))
+      wr(n, base + off);
+    return;
+  }
+
+  switch (FIELD(insn, 6, 5)) {
+  case 1:  v = load16(addr); break;
+  case 2:  v = (uint32_t)(int32_t)(int8_t)load8(addr); break;
+  default: v = (uint32_t)(int32_t)(int16_t)load16(addr); break;
+  }
+  if (!BIT(insn, 24) || BIT(insn, 21))
+    wr(n, base + off);
+  wr(d, v);
+}
+
+void
+Iss::execMrs(uint32_t insn)
+{
+  uint32_t *spsr = BIT(insn, 22) ? st.spsr(mode()) : 0;
+
+  wr(FIELD(insn, 15, 12), spsr ? *spsr : st.cpsr);
+}
+
+void
+Iss::execMsr(uint32_t insn)
+{
+  uint32_t v, mask = 0;
+  bool     dummy;
+
+  v = BIT(insn, 25) ? shifter(insn, dummy) : rd(FIELD(insn, 3, 0));
+
+  if (BIT(insn, 19))
+    mask |= PSR_N | PSR_Z | PSR_C | PSR_V;
+
+  if (BIT(insn, 22)) {
+    uint32_t *spsr = st.spsr(mode());
+
+    if (BIT(insn, 16))
+      mask |= PSR_I | PSR_F | PSR_MODE;
+    if (spsr)
+      *spsr = (*spsr & ~mask) | (v & mask);
+    return;
+  }
+
+  if (BIT(insn, 16) && mode() != MODE_USR)
+    mask |= PSR_I | PSR_F | PSR_MODE;
+  st.cpsr = (st.cpsr & ~mask) | (v & mask);
+}
+
+void
+Iss::execLdrStr(uint32_t insn)
+{
+  unsigned n = FIELD(insn, 19, 16), d = FIELD(insn, 15, 12);
+  uint32_t off, base = rd(n), addr, v;
+  bool     dummy;
+
+  if (BIT(insn, 25))
+    off = shifter(insn & ~(1u << 25), dummy);
+  else
+    off = FIELD(insn, 11, 0);
+  off  = BIT(insn, 23) ? off : (uint32_t)-off;
+  addr = BIT(insn, 24) ? base + off : base;
+
+  if (!BIT(insn, 20)) {
+    if (BIT(insn, 22))
+      store8(addr, rd(d));
+    else
+      store32(addr, rd(d));
+    if (!BIT(insn, 24) || BIT(insn, 21))
+      wr(n, base + off);
+    return;
+  }
+
+  v = BIT(insn, 22) ? load8(addr) : load32(addr);
+  if (!BIT(insn, 24) || BIT(insn, 21))
+    wr(n, base + off);
+  wr(d, v);
+}
+
+void
+Iss::execLdmStm(uint32_t insn)
+{
+  unsigned n     = FIELD(insn, 19, 16);
+  unsigned list  = FIELD(insn, 15, 0);
+  unsigned count = __builtin_popcount(list);
+  bool     user  = BIT(insn, 22) && !(BIT(insn, 20) && BIT(insn, 15));
+  unsigned bank  = user ? (unsigned)MODE_USR : mode();
+  uint32_t base  = rd(n), addr, wb;
+
+  if (BIT(insn, 23)) {
+    addr = BIT(insn, 24) ? base + 4 : base;
+    wb   = base + 4 * count;
+  }
+  else {
+    addr = BIT(insn, 24) ? base - 4 * count : base - 4 * count + 4;
+    wb   = base - 4 * count;
+  }
+
+  if (!BIT(insn, 20)) {
+    for (unsigned r = 0; r < 16; r++)
+      if (BIT(list, r)) {
+        store32(addr, r == 15 ? curPc + 12 : st.reg(r, bank));
+        addr += 4;
+      }
+    if (BIT(insn, 21))
+      wr(n, wb);
+    return;
+  }
+
+  if (BIT(insn, 21))
+    wr(n, wb);
+  for (unsigned r = 0; r < 16; r++)
+    if (BIT(list, r)) {
+      uint32_t v = load32(addr);
+
+      if (r == 15)
+        wr(15, v);
+      else
+        st.reg(r, bank) = v;
+      addr += 4;
+    }
+  if (BIT(insn, 22) && BIT(list, 15))
+    restoreCpsr();
+}
+
+void
+Iss::execBranch(uint32_t insn)
+{
+  uint32_t off = (uint32_t)((int32_t)(insn << 8) >> 6);
+
+  if (BIT(insn, 24))
+    wr(14, curPc + 4);
+  wr(15, curPc + 8 + off);
+}
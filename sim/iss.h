@@ -0,0 +1,171 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Instruction set simulator of the core: an ARMv4 (ARM state, no Thumb)
+ *    interpreter used as the reference model. It follows the core where
+ *    the architecture leaves room:
+ *
+ *    - the undefined instruction space is decided like all_code in the
+ *      RTL, before the condition is checked
+ *    - word loads are not rotated, BX ignores bit 0 (no Thumb state)
+ *    - status registers keep N Z C V I F and the mode only
+ *    - MUL/MLA/UMULL/SMULL... set N and Z, C and V are unchanged
+ *    - instructions that take an exception (SWI, undefined) do not count
+ *      as retired, like the instret counter of the testbenches
+ *
+ *    Memory is a SparseMemory; writes below 0x10000000 (flash) are
+ *    ignored. The serial port and the sim control block are handled by
+ *    ioRead()/ioWrite(), which subclasses can override. A subclass that
+ *    caches decoded code (dbt.h) sets codeMap to be told of stores into
+ *    the 4 KB pages it has translated.
+ *
+ *****************************************************************************/
+#ifndef _iss_h_
+#define _iss_h_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "arch_state.h"
+#include "memory.h"
+
+class Iss
+{
+public:
+  explicit Iss(SparseMemory &mem);
+  virtual ~Iss() {}
+
+  /* reset state: svc mode, interrupts disabled, pc = 0 */
+  void reset();
+
+  /* one instruction (or exception entry); false once halted */
+  bool step();
+
+  /* until halted or 'maxInstr' steps (0 = no limit); returns the steps */
+  virtual uint64_t run(uint64_t maxInstr);
+
+  ArchState     st;
+  SparseMemory &mem;
+
+  bool          irq, fiq;                 /* interrupt request lines */
+  bool          halted;                   /* SIMCTL_EXIT written */
+  int           exitCode;
+  uint64_t      instret;
+  FILE         *trace;                    /* "pc insn" per step, or NULL */
+
+  /* undefined instruction space of the core (all_code in the RTL) */
+  static bool defined(uint32_t insn);
+
+protected:
+  virtual uint32_t ioRead(uint32_t addr);
+  virtual void     ioWrite(uint32_t addr, uint32_t data, unsigned mask);
+
+  uint32_t load32(uint32_t addr);
+  uint32_t load16(uint32_t addr);
+  uint32_t load8(uint32_t addr);
+  void     store32(uint32_t addr, uint32_t data);
+  void     store16(uint32_t addr, uint32_t data);
+  void     store8(uint32_t addr, uint32_t data);
+
+  /* pending FIQ/IRQ: enter the handler and return true */
+  bool     interrupt();
+
+  /* 'insn' at curPc, with st.pc already at the next instruction */
+  void     execute(uint32_t insn);
+
+  bool     cond(unsigned c) const;
+
+  /* data-processing operation 'op' on a and the shifter operand b, whose
+   * shifter carry out is 'shc'. 'psr' brings C and V in and takes the
+   * N Z C V the S form sets out; the other bits are unchanged */
+  static uint32_t alu(unsigned op, uint32_t a, uint32_t b, bool shc,
+                      uint32_t &psr);
+
+  bool           ioAccess;                /* set by every device access */
+
+  /* per 4 KB page, nonzero: stores call codeWritten() (NULL = never) */
+  const uint8_t *codeMap;
+  virtual void   codeWritten(uint32_t addr) { (void)addr; }
+
+  uint32_t  curPc;                        /* address of the current insn */
+
+private:
+  unsigned  mode() const { return st.cpsr & PSR_MODE; }
+  uint32_t  rd(unsigned n) const;         /* pc reads as insn + 8 */
+  void      wr(unsigned n, uint32_t v);   /* r15 branches */
+  void      exception(unsigned mode, uint32_t vector, uint32_t lr);
+  void      restoreCpsr();
+  uint32_t  shifter(uint32_t insn, bool &carry) const;
+
+  void execDataProc(uint32_t insn);
+  void execMul(uint32_t insn);
+  void execMull(uint32_t insn);
+  void execSwap(uint32_t insn);
+  void execHalf(uint32_t insn);
+  void execMrs(uint32_t insn);
+  void execMsr(uint32_t insn);
+  void execLdrStr(uint32_t insn);
+  void execLdmStm(uint32_t insn);
+  void execBranch(uint32_t insn);
+};
+
+/* inline: the translated blocks of dbt.cpp call it too */
+inline uint32_t
+Iss::alu(unsigned op, uint32_t a, uint32_t b, bool shc, uint32_t &psr)
+{
+  bool     c = psr & PSR_C, v = psr & PSR_V;
+  uint64_t wide;
+  uint32_t res;
+
+  switch (op) {
+  case 0x0: case 0x8: res = a & b;  c = shc; break;
+  case 0x1: case 0x9: res = a ^ b;  c = shc; break;
+  case 0xc:           res = a | b;  c = shc; break;
+  case 0xd:           res = b;      c = shc; break;
+  case 0xe:           res = a & ~b; c = shc; break;
+  case 0xf:           res = ~b;     c = shc; break;
+  case 0x2: case 0xa:                     /* SUB, CMP */
+    wide = (uint64_t)a + (uint32_t)~b + 1;
+    res  = (uint32_t)wide;
+    c    = wide >> 32;
+    v    = ((a ^ b) & (a ^ res)) >> 31;
+    break;
+  case 0x3:                               /* RSB */
+    wide = (uint64_t)b + (uint32_t)~a + 1;
+    res  = (uint32_t)wide;
+    c    = wide >> 32;
+    v    = ((b ^ a) & (b ^ res)) >> 31;
+    break;
+  case 0x4: case 0xb:                     /* ADD, CMN */
+    wide = (uint64_t)a + b;
+    res  = (uint32_t)wide;
+    c    = wide >> 32;
+    v    = (~(a ^ b) & (a ^ res)) >> 31;
+    break;
+  case 0x5:                               /* ADC */
+    wide = (uint64_t)a + b + c;
+    res  = (uint32_t)wide;
+    c    = wide >> 32;
+    v    = (~(a ^ b) & (a ^ res)) >> 31;
+    break;
+  case 0x6:                               /* SBC */
+    wide = (uint64_t)a + (uint32_t)~b + c;
+    res  = (uint32_t)wide;
+    c    = wide >> 32;
+    v    = ((a ^ b) & (a ^ res)) >> 31;
+    break;
+  default:                                /* RSC */
+    wide = (uint64_t)b + (uint32_t)~a + c;
+    res  = (uint32_t)wide;
+    c    = wide >> 32;
+    v    = ((b ^ a) & (b ^ res)) >> 31;
+    break;
+  }
+
+  psr &= ~(PSR_N | PSR_Z | PSR_C | PSR_V);
+  psr |= (res & PSR_N) | (res ? 0 : PSR_Z) | (c ? PSR_C : 0) |
+         (v ? PSR_V : 0);
+  return res;
+}
+
+#endif /* _iss_h_ */
@@ -0,0 +1,362 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Fast functional simulation of firmware images on the block-translating
+ *    instruction set simulator (dbt.h), for soak tests too long for the
+ *    RTL. Takes the same images and plusargs as arm9sim:
+ *
+ *      +binfile=<file>     raw image at address 0
+ *      +elf=<file>         ELF image (PT_LOAD segments, entry point)
+ *      <file>              either of the above, by file magic
+ *      +max_instr=<n>      stop after n instructions (0 = run forever)
+ *      +uart_log=<file>    copy of the serial output
+ *      +interp             use the interpreter (iss.h), for comparison
+ *
+ *    Representative regions (SimPoint), in instruction intervals:
+ *
+ *      +interval=<n>       interval length (default 100000)
+ *      +bbv=<file>         basic-block vector per interval (bbv.h), and
+ *                          <file>.map with the block addresses
+ *      +simpoints=<file>   "<interval> <cluster>" lines and the matching
+ *      +weights=<file>     "<weight> <cluster>" lines (simpoint.cpp or
+ *                          SimPoint 3): write a checkpoint (checkpoint.h)
+ *                          at each of the intervals
+ *      +checkpoint_dir=<d> where they go (default .), with checkpoints.lst
+ *                          for arm9sample +checkpoints=
+ *      +warmup=<n>         checkpoints start n instructions before their
+ *                          interval (default 1000)
+ *
+ *    The serial port and the sim control block behave as in the
+ *    testbenches, except that there is no clock: the CYCLE registers
+ *    read the instruction count (one cycle per instruction). Host
+ *    performance goes to stderr at the end.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "checkpoint.h"
+#include "dbt.h"
+#include "elf_loader.h"
+#include "plusarg.h"
+
+/******************************************************************************
+ * Local functions and classes
+ *****************************************************************************/
+
+static double
+now()
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/* serial port at 0xE0000000, sim control block at 0xE0000010 */
+class SoakIss : public DbtIss
+{
+public:
+  explicit SoakIss(SparseMemory &mem) : DbtIss(mem), log(0), hi(0) {}
+
+  FILE *log;
+
+protected:
+  uint32_t
+  ioRead(uint32_t addr)
+  {
+    uint64_t v;
+
+    switch (addr) {
+    case 0xe000000c:                      /* SERIAL_CTRL */
+      return irq;
+    case 0xe0000014:                      /* CYCLE */
+    case 0xe000001c:                      /* INSTRET */
+      hi = instret >> 32;
+      return (uint32_t)instret;
+    case 0xe0000018:
+    case 0xe0000020:
+      return hi;
+    case 0xe0000028:                      /* TIME */
+      v  = (uint64_t)(now() * 1e6);
+      hi = v >> 32;
+      return (uint32_t)v;
+    case 0xe000002c:
+      return hi;
+    default:
+      return 0;
+    }
+  }
+
+  void
+  ioWrite(uint32_t addr, uint32_t data, unsigned mask)
+  {
+    (void)mask;
+    switch (addr) {
+    case 0xe0000004:
+      putchar(data & 0xff);
+      if (log)
+        fputc(data & 0xff, log);
+      break;
+    case 0xe000000c:                      /* TXIE: the port is never busy */
+      irq = data & 1;
+      break;
+    case 0xe0000010:
+      printf("\nSIM: exit=%d\n", (int32_t)data);
+      halted   = true;
+      exitCode = (int32_t)data;
+      break;
+    case 0xe0000024:
+      printf("SIM: mark=%u cycles=%llu instret=%llu\n", data,
+             (unsigned long long)instret, (unsigned long long)instret);
+      break;
+    default:
+      break;
+    }
+  }
+
+private:
+  uint32_t hi;
+};
+
+struct SimPoint
+{
+  uint64_t interval;
+  double   weight;
+  uint64_t start;                         /* checkpoint position */
+
+  bool operator<(const SimPoint &o) const { return interval < o.interval; }
+};
+
+/* SimPoint 3 .simpoints and .weights files */
+static bool
+readSimPoints(const char *spFile, const char *wFile,
+              std::vector<SimPoint> &points, std::string &err)
+{
+  std::map<unsigned, double> weights;
+  unsigned long long         interval;
+  unsigned                   cluster;
+  double                     w;
+  FILE                      *f;
+
+  if (!(f = fopen(wFile, "r"))) {
+    err = std::string("cannot open ") + wFile;
+    return false;
+  }
+  while (fscanf(f, "%lf %u", &w, &cluster) == 2)
+    weights[cluster] = w;
+  fclose(f);
+
+  if (!(f = fopen(spFile, "r"))) {
+    err = std::string("cannot open ") + spFile;
+    return false;
+  }
+  while (fscanf(f, "%llu %u", &interval, &cluster) == 2) {
+    SimPoint p;
+
+    if (!weights.count(cluster)) {
+      fclose(f);
+      err = std::string("no weight for a cluster in ") + spFile;
+      return false;
+    }
+    p.interval = interval;
+    p.weight   = weights[cluster];
+    p.start    = 0;
+    points.push_back(p);
+  }
+  fclose(f);
+
+  if (points.empty()) {
+    err = std::string("no simulation points in ") + spFile;
+    return false;
+  }
+  std::sort(points.begin(), points.end());
+  return true;
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(int argc, char **argv)
+{
+  SparseMemory mem;
+  ElfImage     elf;
+  const char  *image, *s;
+  std::string  err;
+  uint64_t     maxInstr = 0, interval = 100000, warmup = 1000, pos;
+  bool         isElf, interp;
+  double       t0, t1;
+  Bbv          bbv;
+  FILE        *bbvFile = 0;
+  const char  *spFile, *wFile;
+  std::string  ckptDir = ".";
+  std::vector<SimPoint> points;
+  size_t       nextPoint = 0;
+
+  image = plusarg(argc, argv, "elf");
+  if (!image)
+    image = plusarg(argc, argv, "binfile");
+  for (int i = 1; !image && i < argc; i++)
+    if (argv[i][0] != '+')
+      image = argv[i];
+  if (!image) {
+    fprintf(stderr, "WARNING! No content specified for program memory\n");
+    return 1;
+  }
+
+  isElf = isElfFile(image);
+  if (isElf ? !elf.load(image, mem, err) : !loadBinary(image, 0, mem, err)) {
+    fprintf(stderr, "ERROR! %s\n", err.c_str());
+    return 1;
+  }
+
+  if ((s = plusarg(argc, argv, "max_instr")) != 0)
+    maxInstr = strtoull(s, 0, 0);
+  interp = plusflag(argc, argv, "interp");
+  if ((s = plusarg(argc, argv, "interval")) != 0)
+    interval = strtoull(s, 0, 0);
+  if ((s = plusarg(argc, argv, "warmup")) != 0)
+    warmup = strtoull(s, 0, 0);
+  if ((s = plusarg(argc, argv, "checkpoint_dir")) != 0)
+    ckptDir = s;
+  if (interval == 0) {
+    fprintf(stderr, "ERROR! +interval must not be 0\n");
+    return 1;
+  }
+  if ((s = plusarg(argc, argv, "bbv")) != 0 && !(bbvFile = fopen(s, "w"))) {
+    fprintf(stderr, "ERROR! Cannot open %s\n", s);
+    return 1;
+  }
+  spFile = plusarg(argc, argv, "simpoints");
+  wFile  = plusarg(argc, argv, "weights");
+  if (spFile || wFile) {
+    if (!spFile || !wFile) {
+      fprintf(stderr, "ERROR! +simpoints needs +weights and vice versa\n");
+      return 1;
+    }
+    if (!readSimPoints(spFile, wFile, points, err)) {
+      fprintf(stderr, "ERROR! %s\n", err.c_str());
+      return 1;
+    }
+    for (size_t i = 0; i < points.size(); i++) {
+      uint64_t at = points[i].interval * interval;
+
+      points[i].start = at > warmup ? at - warmup : 0;
+    }
+  }
+  if ((bbvFile || !points.empty()) && interp) {
+    fprintf(stderr, "ERROR! +bbv and +simpoints need the translated ISS\n");
+    return 1;
+  }
+
+  SoakIss iss(mem);
+
+  if ((s = plusarg(argc, argv, "uart_log")) != 0) {
+    iss.log = fopen(s, "w");
+    if (!iss.log) {
+      fprintf(stderr, "ERROR! Cannot open %s\n", s);
+      return 1;
+    }
+  }
+
+  iss.reset();
+  if (isElf && elf.entry() != 0)
+    iss.st.pc = elf.entry();
+  if (bbvFile)
+    iss.bbv = &bbv;
+
+  t0  = now();
+  pos = 0;
+  if (interp)
+    iss.Iss::run(maxInstr);
+  else if (!bbvFile && points.empty())
+    iss.run(maxInstr);
+  else {
+    /* stop at every interval end and at every checkpoint */
+    for (;;) {
+      while (nextPoint < points.size() && points[nextPoint].start == pos) {
+        Checkpoint ck;
+        char       name[32];
+
+        ck.st      = iss.st;
+        ck.instret = iss.instret;
+        snprintf(name, sizeof(name), "%llu.ckpt",
+                 (unsigned long long)points[nextPoint].interval);
+        if (!ck.save(ckptDir + "/" + name, mem, err)) {
+          fprintf(stderr, "ERROR! %s\n", err.c_str());
+          return 1;
+        }
+        nextPoint++;
+      }
+      if (iss.halted || (maxInstr && pos >= maxInstr))
+        break;
+
+      uint64_t stop = (pos / interval + 1) * interval;
+
+      if (nextPoint < points.size() && points[nextPoint].start < stop)
+        stop = points[nextPoint].start;
+      if (maxInstr && stop > maxInstr)
+        stop = maxInstr;
+
+      pos += iss.run(stop - pos);
+      if (bbvFile && pos % interval == 0)
+        bbv.endInterval(bbvFile);
+    }
+  }
+  t1 = now();
+
+  if (bbvFile) {
+    bbv.endInterval(bbvFile);             /* the partial last interval */
+    fclose(bbvFile);
+    std::string map = std::string(plusarg(argc, argv, "bbv")) + ".map";
+    if ((bbvFile = fopen(map.c_str(), "w")) != 0) {
+      bbv.writeMap(bbvFile);
+      fclose(bbvFile);
+    }
+    printf("SIM: bbv intervals=%llu interval=%llu\n",
+           (unsigned long long)bbv.intervals, (unsigned long long)interval);
+  }
+  if (!points.empty()) {
+    std::string lst = ckptDir + "/checkpoints.lst";
+    FILE       *f   = fopen(lst.c_str(), "w");
+
+    if (!f) {
+      fprintf(stderr, "ERROR! Cannot create %s\n", lst.c_str());
+      return 1;
+    }
+    fprintf(f, "# interval=%llu instret=%llu\n",
+            (unsigned long long)interval, (unsigned long long)iss.instret);
+    for (size_t i = 0; i < nextPoint; i++)
+      fprintf(f, "%llu.ckpt %llu %.6f %llu\n",
+              (unsigned long long)points[i].interval,
+              (unsigned long long)points[i].interval, points[i].weight,
+              (unsigned long long)(points[i].interval * interval -
+                                   points[i].start));
+    fclose(f);
+    printf("SIM: checkpoints=%zu of %zu in %s\n", nextPoint, points.size(),
+           ckptDir.c_str());
+  }
+
+  /* the final line of the testbenches, for regress/run.sh SIM=iss */
+  printf("\nSIM: cycles=%llu instret=%llu\n", (unsigned long long)iss.instret,
+         (unsigned long long)iss.instret);
+  fprintf(stderr, "ISS: %s, %.2f s, %.1f MIPS", interp ? "interpreter" :
+          "translated", t1 - t0, (t1 > t0) ? iss.instret / (t1 - t0) / 1e6 : 0);
+  if (!interp)
+    fprintf(stderr, ", %llu blocks, %llu invalidated, %llu chained",
+            (unsigned long long)iss.blocksTranslated,
+            (unsigned long long)iss.blocksInvalidated,
+            (unsigned long long)iss.chainsFollowed);
+  fprintf(stderr, "\n");
+
+  if (iss.log)
+    fclose(iss.log);
+  return iss.exitCode;
+}
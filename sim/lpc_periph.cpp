@@ -0,0 +1,873 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Models of the LPC2xxx timers, UART0, I2C0 (with LM75 slaves) and VIC
+ *
+ *****************************************************************************/
+#include <math.h>
+#include <string.h>
+
+#include "lpc_periph.h"
+#include "testbench.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define FIFO_DEPTH  16
+
+#define LSR_RDR     0x01
+#define LSR_OE      0x02
+#define LSR_ERRORS  0x1e                  /* OE, PE, FE, BI */
+#define LSR_THRE    0x20
+#define LSR_TEMT    0x40
+
+#define IER_RBR     0x01
+#define IER_THRE    0x02
+#define IER_RLS     0x04
+
+#define I2C_AA      0x04                  /* I2CONSET bits */
+#define I2C_SI      0x08
+#define I2C_STO     0x10
+#define I2C_STA     0x20
+#define I2C_I2EN    0x40
+
+/******************************************************************************
+ * LpcVpb
+ *****************************************************************************/
+void
+LpcVpb::write(uint32_t addr, uint32_t data, unsigned mask)
+{
+  (void)addr;
+  (void)mask;
+  if ((data & 3) != 3)                    /* 3 is reserved: no change */
+    vpbdiv = data & 0x33;
+}
+
+unsigned
+LpcVpb::divider() const
+{
+  switch (vpbdiv & 3) {
+  case 1:
+    return 1;
+  case 2:
+    return 2;
+  default:
+    return 4;
+  }
+}
+
+void
+LpcVpb::tick()
+{
+  edge = ++count >= divider();
+  if (edge)
+    count = 0;
+}
+
+/******************************************************************************
+ * LpcTimer
+ *****************************************************************************/
+LpcTimer::LpcTimer(uint32_t base, const LpcVpb *vpb)
+  : Device(base, 0x4000), vpb(vpb), ir(0), tcr(0), tc(0), pr(0), pc(0),
+    mcr(0), ccr(0), emr(0), ctcr(0), resetPending(false)
+{
+  memset(mr, 0, sizeof(mr));
+  memset(cr, 0, sizeof(cr));
+}
+
+uint32_t
+LpcTimer::read(uint32_t addr)
+{
+  uint32_t off = addr - base;
+
+  switch (off) {
+  case 0x00: return ir;
+  case 0x04: return tcr;
+  case 0x08: return tc;
+  case 0x0c: return pr;
+  case 0x10: return pc;
+  case 0x14: return mcr;
+  case 0x18:
+  case 0x1c:
+  case 0x20:
+  case 0x24: return mr[(off - 0x18) >> 2];
+  case 0x28: return ccr;
+  case 0x2c:
+  case 0x30:
+  case 0x34:
+  case 0x38: return cr[(off - 0x2c) >> 2];
+  case 0x3c: return emr;
+  case 0x70: return ctcr;
+  default:   return 0;
+  }
+}
+
+void
+LpcTimer::write(uint32_t addr, uint32_t data, unsigned mask)
+{
+  uint32_t off = addr - base;
+
+  (void)mask;
+  switch (off) {
+  case 0x00: ir &= ~data; break;          /* write one to clear */
+  case 0x04: tcr = data & 3; break;
+  case 0x08: tc = data; break;
+  case 0x0c: pr = data; break;
+  case 0x10: pc = data; break;
+  case 0x14: mcr = data & 0xfff; break;
+  case 0x18:
+  case 0x1c:
+  case 0x20:
+  case 0x24: mr[(off - 0x18) >> 2] = data; break;
+  case 0x28: ccr = data & 0xfff; break;
+  case 0x3c: emr = data & 0xfff; break;
+  case 0x70: ctcr = data & 0xf; break;
+  default:   break;
+  }
+}
+
+void
+LpcTimer::tick()
+{
+  if (!vpb->pclk())
+    return;
+  if (tcr & 2) {                          /* held in reset */
+    tc = pc = 0;
+    resetPending = false;
+    return;
+  }
+  /* counter mode counts CAP edges: there are no capture pins */
+  if (!(tcr & 1) || (ctcr & 3))
+    return;
+
+  if (pc >= pr) {
+    pc = 0;
+    increment();
+  } else
+    pc++;
+}
+
+void
+LpcTimer::increment()
+{
+  tc = resetPending ? 0 : tc + 1;
+  resetPending = false;
+
+  for (unsigned i = 0; i < 4; i++) {
+    unsigned action = mcr >> (3 * i);
+
+    if (tc != mr[i])
+      continue;
+    if (action & 1)
+      ir |= 1u << i;
+    if (action & 2)
+      resetPending = true;
+    if (action & 4) {
+      tcr &= ~1u;
+      pc = 0;
+    }
+
+    /* external match output: clear, set or toggle */
+    switch ((emr >> (4 + 2 * i)) & 3) {
+    case 1: emr &= ~(1u << i); break;
+    case 2: emr |= 1u << i;    break;
+    case 3: emr ^= 1u << i;    break;
+    default:                   break;
+    }
+  }
+}
+
+/******************************************************************************
+ * LpcUart
+ *****************************************************************************/
+LpcUart::LpcUart(uint32_t base, const LpcVpb *vpb)
+  : Device(base, 0x4000), log(0), rx(0), txChars(0), rxChars(0),
+    overruns(0), txBusy(0), cycles(0), vpb(vpb), ier(0), lcr(0), lsr(0),
+    scr(0), dll(1), dlm(0), fcr(0), fdr(0x10), ter(0x80), thre(false),
+    txShift(-1), txDone(0), rxNext(0), rxIdleSince(0)
+{
+}
+
+uint64_t
+LpcUart::frameCycles() const
+{
+  unsigned bits    = 1 + 5 + (lcr & 3) + ((lcr >> 3) & 1) +
+                     ((lcr & 4) ? 2 : 1);
+  unsigned divisor = (dlm << 8) | dll;
+  unsigned divAdd  = fdr & 15;
+  unsigned mul     = fdr >> 4;
+  double   cycles  = (double)bits * 16 * (divisor ? divisor : 1) *
+                     vpb->divider();
+
+  if (divAdd && mul)
+    cycles *= 1.0 + (double)divAdd / mul;
+  return (uint64_t)(cycles + 0.5);
+}
+
+unsigned
+LpcUart::rxTrigger() const
+{
+  static const unsigned level[4] = { 1, 4, 8, 14 };
+
+  return (fcr & 1) ? level[fcr >> 6] : 1;
+}
+
+/* highest priority pending interrupt, as in U0IIR */
+uint32_t
+LpcUart::iir() const
+{
+  uint32_t fifo = (fcr & 1) ? 0xc0 : 0;
+
+  if ((ier & IER_RLS) && (lsr & LSR_ERRORS))
+    return fifo | 0x06;
+  if ((ier & IER_RBR) && rxFifo.size() >= rxTrigger())
+    return fifo | 0x04;
+  if ((ier & IER_RBR) && !rxFifo.empty() &&
+      cycles - rxIdleSince >= 4 * frameCycles())
+    return fifo | 0x0c;                   /* character time-out */
+  if ((ier & IER_THRE) && thre)
+    return fifo | 0x02;
+  return fifo | 0x01;
+}
+
+uint32_t
+LpcUart::read(uint32_t addr)
+{
+  uint32_t v;
+
+  switch (addr - base) {
+  case 0x00:
+    if (lcr & 0x80)
+      return dll;
+    if (rxFifo.empty())
+      return 0;
+    v = rxFifo.front();
+    rxFifo.pop_front();
+    rxIdleSince = cycles;
+    return v;
+  case 0x04:
+    return (lcr & 0x80) ? dlm : ier;
+  case 0x08:
+    v = iir();
+    if ((v & 0x0f) == 0x02)               /* reading IIR clears THRE */
+      thre = false;
+    return v;
+  case 0x0c:
+    return lcr;
+  case 0x14:
+    v = lsr | (rxFifo.empty() ? 0 : LSR_RDR);
+    if (txFifo.empty())
+      v |= LSR_THRE;
+    if (txFifo.empty() && txShift < 0)
+      v |= LSR_TEMT;
+    lsr &= ~LSR_ERRORS;                   /* cleared on read */
+    return v;
+  case 0x1c:
+    return scr;
+  case 0x28:
+    return fdr;
+  case 0x30:
+    return ter;
+  default:
+    return 0;
+  }
+}
+
+void
+LpcUart::write(uint32_t addr, uint32_t data, unsigned mask)
+{
+  (void)mask;
+  data &= 0xff;
+  switch (addr - base) {
+  case 0x00:
+    if (lcr & 0x80)
+      dll = data;
+    else {
+      if (txFifo.size() < ((fcr & 1) ? FIFO_DEPTH : 1u))
+        txFifo.push_back(data);
+      thre = false;
+    }
+    break;
+  case 0x04:
+    if (lcr & 0x80)
+      dlm = data;
+    else {
+      /* enabling THRE with an empty transmitter interrupts at once */
+      if (!(ier & IER_THRE) && (data & IER_THRE) && txFifo.empty())
+        thre = true;
+      ier = data & 7;
+    }
+    break;
+  case 0x08:
+    fcr = data & 0xc1;
+    if (data & 2)
+      rxFifo.clear();
+    if (data & 4)
+      txFifo.clear();
+    break;
+  case 0x0c:
+    lcr = data;
+    /* the line comes up once the firmware has set the frame format */
+    if (!(lcr & 0x80) && rx && rxNext == 0)
+      rxNext = cycles + frameCycles();
+    break;
+  case 0x1c:
+    scr = data;
+    break;
+  case 0x28:
+    fdr = data;
+    break;
+  case 0x30:
+    ter = data & 0x80;
+    break;
+  default:
+    break;
+  }
+}
+
+void
+LpcUart::tick()
+{
+  cycles++;
+
+  /* transmitter: shift register fed from the FIFO */
+  if (txShift >= 0) {
+    txBusy++;
+    if (cycles >= txDone) {
+      putchar(txShift);
+      if (log)
+        fputc(txShift, log);
+      txChars++;
+      txShift = -1;
+    }
+  }
+  if (txShift < 0 && !txFifo.empty() && (ter & 0x80)) {
+    txShift = txFifo.front();
+    txFifo.pop_front();
+    txDone = cycles + frameCycles();
+    if (txFifo.empty())
+      thre = true;
+  }
+
+  /* receiver: one character per frame time while input lasts */
+  if (rx && rxNext && cycles >= rxNext) {
+    int c = fgetc(rx);
+
+    if (c == EOF) {
+      fclose(rx);
+      rx = 0;
+    }
+    else if (rxFifo.size() < ((fcr & 1) ? FIFO_DEPTH : 1u)) {
+      rxFifo.push_back(c);
+      rxIdleSince = cycles;
+      rxChars++;
+    } else {
+      lsr |= LSR_OE;
+      overruns++;
+    }
+    rxNext = cycles + frameCycles();
+  }
+}
+
+void
+LpcUart::report(FILE *f) const
+{
+  if (txChars == 0 && rxChars == 0)
+    return;
+  fprintf(f, "SIM: uart0 tx=%llu rx=%llu overruns=%llu line_busy=%.1f%% "
+          "frame=%llu cycles\n", (unsigned long long)txChars,
+          (unsigned long long)rxChars, (unsigned long long)overruns,
+          cycles ? 100.0 * txBusy / cycles : 0.0,
+          (unsigned long long)frameCycles());
+}
+
+/******************************************************************************
+ * Lm75
+ *****************************************************************************/
+Lm75::Lm75(uint8_t address)
+  : I2cSlave(address), celsius(25.0), reads(0), pointerWrites(0), pointer(0),
+    config(0), thyst(75 << 8), tos(80 << 8), index(0), latched(0)
+{
+}
+
+uint16_t
+Lm75::reg16(unsigned r) const
+{
+  long t;
+
+  switch (r) {
+  case 0:
+    /* -55 to +125 C in 0.5 C */
+    t = lround(celsius * 2);
+    if (t < -110)
+      t = -110;
+    if (t > 250)
+      t = 250;
+    return (uint16_t)(t << 7);
+  case 1:
+    return config << 8;
+  case 2:
+    return thyst;
+  default:
+    return tos;
+  }
+}
+
+bool
+Lm75::start(bool read)
+{
+  index = 0;
+  if (read) {
+    latched = reg16(pointer);
+    reads++;
+  } else
+    pointerWrites++;
+  return true;
+}
+
+bool
+Lm75::write(uint8_t data)
+{
+  unsigned i = index++;
+
+  if (i == 0)
+    pointer = data & 3;
+  else if (pointer == 1)
+    config = data & 0x1f;
+  else if (pointer >= 2) {
+    uint16_t &r = pointer == 2 ? thyst : tos;
+
+    if (i == 1)
+      r = (r & 0x00ff) | (data << 8);
+    else if (i == 2)
+      r = (r & 0xff00) | (data & 0x80);
+  }
+  return true;
+}
+
+/* MSB then LSB, over and over; the configuration is one byte */
+uint8_t
+Lm75::read()
+{
+  unsigned i = index++;
+
+  if (pointer == 1)
+    return config;
+  return (i & 1) ? latched & 0xff : latched >> 8;
+}
+
+void
+Lm75::report(FILE *f) const
+{
+  if (reads == 0 && pointerWrites == 0)
+    return;
+  fprintf(f, "SIM: lm75 addr=0x%02x reads=%llu pointer_writes=%llu\n",
+          address, (unsigned long long)reads,
+          (unsigned long long)pointerWrites);
+}
+
+/******************************************************************************
+ * LpcI2c
+ *****************************************************************************/
+LpcI2c::LpcI2c(uint32_t base, const LpcVpb *vpb)
+  : Device(base, 0x4000), starts(0), bytes(0), nacks(0), busBusy(0),
+    cycles(0), vpb(vpb), conset(0), stat(0xf8), dat(0), adr(0), sclh(4),
+    scll(4), master(false), slave(0), op(OP_NONE), busy(0)
+{
+}
+
+unsigned
+LpcI2c::bitCycles() const
+{
+  return (sclh < 4 ? 4 : sclh) + (scll < 4 ? 4 : scll);
+}
+
+uint32_t
+LpcI2c::read(uint32_t addr)
+{
+  switch (addr - base) {
+  case 0x00: return conset;
+  case 0x04: return stat;
+  case 0x08: return dat;
+  case 0x0c: return adr;
+  case 0x10: return sclh;
+  case 0x14: return scll;
+  default:   return 0;
+  }
+}
+
+void
+LpcI2c::write(uint32_t addr, uint32_t data, unsigned mask)
+{
+  (void)mask;
+  switch (addr - base) {
+  case 0x00: conset |= data & 0x7c; break;
+  case 0x08: dat = data & 0xff; break;
+  case 0x0c: adr = data & 0xff; break;
+  case 0x10: sclh = data & 0xffff; break;
+  case 0x14: scll = data & 0xffff; break;
+  case 0x18:
+    conset &= ~(data & 0x6c);             /* STO clears itself only */
+    if (!(conset & I2C_I2EN)) {
+      /* disabled: off the bus at once, no STOP */
+      if (slave)
+        slave->stop();
+      slave  = 0;
+      master = false;
+      op     = OP_NONE;
+      busy   = 0;
+      conset &= ~I2C_STO;
+      stat   = 0xf8;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void
+LpcI2c::begin(Op next, unsigned bits)
+{
+  op   = next;
+  busy = bits * bitCycles();
+  stat = 0xf8;                            /* no status while SI = 0 */
+}
+
+void
+LpcI2c::finish()
+{
+  Op   done = op;
+  bool ack, rd;
+
+  op = OP_NONE;
+  switch (done) {
+  case OP_START:
+    if (slave)                            /* repeated START ends it too */
+      slave->stop();
+    stat   = master ? 0x10 : 0x08;
+    master = true;
+    slave  = 0;
+    starts++;
+    break;
+  case OP_STOP:
+    if (slave)
+      slave->stop();
+    slave  = 0;
+    master = false;
+    conset &= ~I2C_STO;
+    return;                               /* no interrupt */
+  case OP_ADDRESS:
+    bytes++;
+    rd    = dat & 1;
+    slave = 0;
+    for (size_t i = 0; i < slaves.size(); i++)
+      if (slaves[i]->address == (dat & 0xfe))
+        slave = slaves[i];
+    ack = slave && slave->start(rd);
+    if (!ack) {
+      slave = 0;
+      nacks++;
+    }
+    stat = rd ? (ack ? 0x40 : 0x48) : (ack ? 0x18 : 0x20);
+    break;
+  case OP_WRITE:
+    bytes++;
+    ack = slave && slave->write(dat);
+    if (!ack)
+      nacks++;
+    stat = ack ? 0x28 : 0x30;
+    break;
+  case OP_READ:
+    bytes++;
+    dat  = slave ? slave->read() : 0xff;
+    stat = (conset & I2C_AA) ? 0x50 : 0x58;
+    break;
+  default:
+    return;
+  }
+  conset |= I2C_SI;
+}
+
+void
+LpcI2c::tick()
+{
+  cycles++;
+  if (master || op != OP_NONE)
+    busBusy++;
+
+  if (!vpb->pclk() || !(conset & I2C_I2EN))
+    return;
+  if (op != OP_NONE) {
+    if (--busy == 0)
+      finish();
+    return;
+  }
+  if (conset & I2C_SI)                    /* the firmware's turn */
+    return;
+
+  if (conset & I2C_STO) {
+    if (master)
+      begin(OP_STOP, 1);
+    else
+      conset &= ~I2C_STO;
+  } else if (conset & I2C_STA)
+    begin(OP_START, 1);
+  else if (master) {
+    switch (stat) {
+    case 0x08:
+    case 0x10:
+      begin(OP_ADDRESS, 9);
+      break;
+    case 0x18:
+    case 0x20:
+    case 0x28:
+    case 0x30:
+      begin(OP_WRITE, 9);
+      break;
+    case 0x40:
+    case 0x50:
+      begin(OP_READ, 9);
+      break;
+    default:                              /* 48h, 58h: STA or STO only */
+      break;
+    }
+  }
+}
+
+void
+LpcI2c::report(FILE *f) const
+{
+  if (starts == 0)
+    return;
+  fprintf(f, "SIM: i2c0 starts=%llu bytes=%llu nacks=%llu bus_busy=%.1f%% "
+          "bit=%u cycles\n", (unsigned long long)starts,
+          (unsigned long long)bytes, (unsigned long long)nacks,
+          cycles ? 100.0 * busBusy / cycles : 0.0,
+          bitCycles() * vpb->divider());
+}
+
+/******************************************************************************
+ * LpcVic
+ *****************************************************************************/
+LpcVic::LpcVic()
+  : Device(0xfffff000, 0x1000), raw(0), select(0), enable(0), soft(0),
+    protection(0), defVectAddr(0), inService(0), active(0), now(0),
+    irqOut(false), fiqOut(false)
+{
+  memset(lines, 0, sizeof(lines));
+  memset(vectAddr, 0, sizeof(vectAddr));
+  memset(vectCntl, 0, sizeof(vectCntl));
+  memset(serviceChannel, 0, sizeof(serviceChannel));
+  memset(serviceSince, 0, sizeof(serviceSince));
+  memset(since, 0, sizeof(since));
+  memset(latency, 0, sizeof(latency));
+}
+
+int
+LpcVic::level() const
+{
+  return inService ? __builtin_ctz(inService) : 17;
+}
+
+int
+LpcVic::pendingSlot() const
+{
+  uint32_t status = irqStatus();
+  int      top    = level() < 16 ? level() : 16;
+
+  for (int s = 0; s < top; s++)
+    if ((vectCntl[s] & 0x20) && ((status >> (vectCntl[s] & 31)) & 1))
+      return s;
+  return -1;
+}
+
+uint32_t
+LpcVic::nonVectored() const
+{
+  uint32_t status = irqStatus();
+
+  for (int s = 0; s < 16; s++)
+    if (vectCntl[s] & 0x20)
+      status &= ~(1u << (vectCntl[s] & 31));
+  return status;
+}
+
+uint32_t
+LpcVic::read(uint32_t addr)
+{
+  uint32_t off = addr - base;
+  uint32_t nv;
+  int      s;
+  unsigned ch;
+
+  if (off >= 0x100 && off < 0x140)
+    return vectAddr[(off - 0x100) >> 2];
+  if (off >= 0x200 && off < 0x240)
+    return vectCntl[(off - 0x200) >> 2];
+
+  switch (off) {
+  case 0x000: return irqStatus();
+  case 0x004: return raw & enable & select;
+  case 0x008: return raw;
+  case 0x00c: return select;
+  case 0x010: return enable;
+  case 0x018: return soft;
+  case 0x020: return protection;
+  case 0x034: return defVectAddr;
+
+  case 0x030:
+    /* the handler fetches its vector: service starts */
+    if ((s = pendingSlot()) < 0) {
+      nv = (inService == 0) ? nonVectored() : 0;
+      if (!nv)
+        return defVectAddr;
+      s  = 16;
+      ch = __builtin_ctz(nv);
+    } else
+      ch = vectCntl[s] & 31;
+
+    inService        |= 1u << s;
+    serviceChannel[s] = ch;
+    serviceSince[s]   = since[ch];
+
+    Latency &l = latency[ch];
+    uint64_t d = now - since[ch];
+
+    if (l.count == 0 || d < l.min)
+      l.min = d;
+    if (d > l.max)
+      l.max = d;
+    l.count++;
+    l.sum += d;
+    return s < 16 ? vectAddr[s] : defVectAddr;
+  }
+  return 0;
+}
+
+void
+LpcVic::write(uint32_t addr, uint32_t data, unsigned mask)
+{
+  uint32_t off = addr - base;
+
+  (void)mask;
+  if (off >= 0x100 && off < 0x140) {
+    vectAddr[(off - 0x100) >> 2] = data;
+    return;
+  }
+  if (off >= 0x200 && off < 0x240) {
+    vectCntl[(off - 0x200) >> 2] = data & 0x3f;
+    return;
+  }
+
+  switch (off) {
+  case 0x00c: select = data;       break;
+  case 0x010: enable |= data;      break;
+  case 0x014: enable &= ~data;     break;
+  case 0x018: soft |= data;        break;
+  case 0x01c: soft &= ~data;       break;
+  case 0x020: protection = data & 1; break;
+  case 0x034: defVectAddr = data;  break;
+
+  case 0x030:
+    /* end of interrupt: the highest priority in service */
+    if (inService) {
+      int      s = __builtin_ctz(inService);
+      Latency &l = latency[serviceChannel[s]];
+      uint64_t d = now - serviceSince[s];
+
+      inService &= ~(1u << s);
+      if (d > l.eoiMax)
+        l.eoiMax = d;
+      l.eoiCount++;
+      l.eoiSum += d;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void
+LpcVic::tick()
+{
+  uint32_t lineState = 0, rise;
+
+  now++;
+  for (unsigned ch = 0; ch < 32; ch++)
+    if (lines[ch] && lines[ch]->request())
+      lineState |= 1u << ch;
+  raw = lineState | soft;
+
+  /* requests that became pending in this cycle */
+  rise   = raw & enable & ~active;
+  active = raw & enable;
+  for (unsigned ch = 0; rise; ch++, rise >>= 1)
+    if (rise & 1)
+      since[ch] = now;
+
+  fiqOut = (raw & enable & select) != 0;
+  irqOut = pendingSlot() >= 0 || (inService == 0 && nonVectored() != 0);
+}
+
+void
+LpcVic::report(FILE *f) const
+{
+  for (unsigned ch = 0; ch < 32; ch++) {
+    const Latency &l = latency[ch];
+
+    if (l.count == 0)
+      continue;
+    fprintf(f, "SIM: vic ch=%u n=%llu latency min=%llu avg=%.1f max=%llu",
+            ch, (unsigned long long)l.count, (unsigned long long)l.min,
+            (double)l.sum / l.count, (unsigned long long)l.max);
+    if (l.eoiCount)
+      fprintf(f, " service avg=%.1f max=%llu", (double)l.eoiSum / l.eoiCount,
+              (unsigned long long)l.eoiMax);
+    fprintf(f, "\n");
+  }
+}
+
+/******************************************************************************
+ * LpcPeripherals
+ *****************************************************************************/
+LpcPeripherals::LpcPeripherals(Testbench &tb)
+{
+  vpb    = new LpcVpb;
+  timer0 = new LpcTimer(0xe0004000, vpb);
+  timer1 = new LpcTimer(0xe0008000, vpb);
+  uart0  = new LpcUart(0xe000c000, vpb);
+  i2c0   = new LpcI2c(0xe001c000, vpb);
+  vic    = new LpcVic;
+
+  addLm75(0x90);
+
+  vic->connect(VIC_TIMER0, timer0);
+  vic->connect(VIC_TIMER1, timer1);
+  vic->connect(VIC_UART0, uart0);
+  vic->connect(VIC_I2C0, i2c0);
+
+  /* the VIC last: it samples the request lines of the same cycle */
+  tb.attach(vpb);
+  tb.attach(timer0);
+  tb.attach(timer1);
+  tb.attach(uart0);
+  tb.attach(i2c0);
+  tb.attach(vic);
+}
+
+void
+LpcPeripherals::addLm75(uint8_t address)
+{
+  lm75.push_back(std::unique_ptr<Lm75>(new Lm75(address)));
+  i2c0->slaves.push_back(lm75.back().get());
+}
+
+void
+LpcPeripherals::report(FILE *f) const
+{
+  vic->report(f);
+  uart0->report(f);
+  i2c0->report(f);
+  for (size_t i = 0; i < lm75.size(); i++)
+    lm75[i]->report(f);
+}
@@ -0,0 +1,302 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Models of the LPC2xxx peripherals the firmware in testcode/ drives,
+ *    at their datasheet addresses (testcode/startup/lpc2xxx.h):
+ *
+ *      LpcVpb    VPBDIV at 0xE01FC100, the peripheral clock divider
+ *      LpcTimer  Timer0 at 0xE0004000, Timer1 at 0xE0008000
+ *      LpcUart   UART0 at 0xE000C000: 16-byte FIFOs, baud-rate timing
+ *      LpcI2c    I2C0 at 0xE001C000, master mode, with Lm75 slaves
+ *      LpcVic    vectored interrupt controller (PL190) at 0xFFFFF000
+ *
+ *    One core cycle is one CCLK. The timers, the UART and I2C count PCLK,
+ *    CCLK divided by VPBDIV (/4 after reset). The peripherals raise
+ *    request lines into the VIC, which alone drives the core's irq and
+ *    fiq inputs and measures the latency from a request to its vector
+ *    read (VICVectAddr) and to the end of its handler (VICVectAddr
+ *    write).
+ *
+ *****************************************************************************/
+#ifndef _lpc_periph_h_
+#define _lpc_periph_h_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "devices.h"
+
+#define VIC_TIMER0  4
+#define VIC_TIMER1  5
+#define VIC_UART0   6
+#define VIC_I2C0    9
+
+/*
+ * VPB divider: PCLK = CCLK / 4, 1 or 2 for VPBDIV 0, 1, 2.
+ */
+class LpcVpb : public Device
+{
+public:
+  LpcVpb() : Device(0xe01fc100, 4), vpbdiv(0), count(0), edge(false) {}
+
+  uint32_t read(uint32_t addr) { (void)addr; return vpbdiv; }
+  void     write(uint32_t addr, uint32_t data, unsigned mask);
+  void     tick();
+
+  /* a PCLK edge in this cycle */
+  bool pclk() const { return edge; }
+
+  /* CCLK cycles per PCLK */
+  unsigned divider() const;
+
+private:
+  uint32_t vpbdiv;
+  unsigned count;
+  bool     edge;
+};
+
+/*
+ * Timer with prescaler, four match registers (interrupt, reset and stop
+ * on match, external match outputs in EMR) and the capture registers,
+ * which never capture: there are no capture pins.
+ */
+class LpcTimer : public Device
+{
+public:
+  LpcTimer(uint32_t base, const LpcVpb *vpb);
+
+  uint32_t read(uint32_t addr);
+  void     write(uint32_t addr, uint32_t data, unsigned mask);
+  void     tick();
+
+  bool request() const { return ir != 0; }
+
+private:
+  void increment();
+
+  const LpcVpb *vpb;
+  uint32_t      ir, tcr, tc, pr, pc, mcr, mr[4], ccr, cr[4], emr, ctcr;
+  bool          resetPending;             /* reset on match, next count */
+};
+
+/*
+ * UART0 (16C550 compatible): RBR/THR, IER, IIR/FCR, LCR, LSR, SCR, the
+ * divisor latches, FDR and TER. A character takes (start + data + parity
+ * + stop bits) * 16 * divisor PCLK cycles on the line; transmitted
+ * characters go to stdout (and 'log') when their stop bit is out.
+ * Received characters come from 'rx', back to back at the line rate,
+ * and are lost (overrun) when the receive FIFO is full.
+ */
+class LpcUart : public Device
+{
+public:
+  LpcUart(uint32_t base, const LpcVpb *vpb);
+
+  uint32_t read(uint32_t addr);
+  void     write(uint32_t addr, uint32_t data, unsigned mask);
+  void     tick();
+
+  bool request() const { return (iir() & 1) == 0; }
+
+  FILE    *log;                           /* copy of the output, or NULL */
+  FILE    *rx;                            /* receive data, closed at EOF */
+
+  void report(FILE *f) const;
+
+  /* statistics */
+  uint64_t txChars, rxChars, overruns;
+  uint64_t txBusy;                        /* cycles the transmitter sent */
+  uint64_t cycles;
+
+private:
+  uint32_t iir() const;
+  uint64_t frameCycles() const;           /* one character, in CCLK */
+  unsigned rxTrigger() const;
+
+  const LpcVpb       *vpb;
+  uint32_t            ier, lcr, lsr, scr, dll, dlm, fcr, fdr, ter;
+  std::deque<uint8_t> txFifo, rxFifo;
+  bool                thre;               /* THRE interrupt pending */
+  int                 txShift;            /* character on the line, or -1 */
+  uint64_t            txDone, rxNext;
+  uint64_t            rxIdleSince;        /* last receive FIFO activity */
+};
+
+/*
+ * A slave on the I2C bus of LpcI2c. 'address' is the SLA+W byte, as the
+ * firmware writes it (LM75_ADDRESS 0x90).
+ */
+class I2cSlave
+{
+public:
+  explicit I2cSlave(uint8_t address) : address(address) {}
+  virtual ~I2cSlave() {}
+
+  /* addressed after a START; false to not acknowledge */
+  virtual bool start(bool read) { (void)read; return true; }
+
+  /* a byte from the master; false to not acknowledge */
+  virtual bool write(uint8_t data) = 0;
+
+  /* the next byte to the master */
+  virtual uint8_t read() = 0;
+
+  virtual void stop() {}
+
+  const uint8_t address;
+};
+
+/*
+ * LM75 temperature sensor: the pointer register and the temperature,
+ * configuration, THYST and TOS registers. The pointer is kept between
+ * transfers, so a read without a pointer write reads the same register
+ * again. Temperatures are 9-bit two's complement in 0.5 C, left aligned
+ * in the 16-bit registers; the temperature register holds 'celsius'.
+ */
+class Lm75 : public I2cSlave
+{
+public:
+  explicit Lm75(uint8_t address = 0x90);
+
+  bool    start(bool read);
+  bool    write(uint8_t data);
+  uint8_t read();
+
+  double   celsius;
+
+  void report(FILE *f) const;
+
+  /* statistics */
+  uint64_t reads;                         /* read transfers */
+  uint64_t pointerWrites;                 /* write transfers */
+
+private:
+  uint16_t reg16(unsigned r) const;
+
+  uint8_t  pointer, config;
+  uint16_t thyst, tos;
+  unsigned index;                         /* byte of the transfer */
+  uint16_t latched;                       /* register being read */
+};
+
+/*
+ * I2C0 in master mode: I2CONSET/I2CONCLR, I2STAT, I2DAT, I2ADR and the
+ * SCL duty cycle registers. A bit takes SCLH + SCLL PCLK cycles: START,
+ * STOP and repeated START one bit, an address or data byte with its
+ * acknowledge nine. The state changes and SI (the VIC request) rise when
+ * the bit time is over, with the master status codes of the datasheet.
+ * Slave mode is not modelled.
+ */
+class LpcI2c : public Device
+{
+public:
+  LpcI2c(uint32_t base, const LpcVpb *vpb);
+
+  uint32_t read(uint32_t addr);
+  void     write(uint32_t addr, uint32_t data, unsigned mask);
+  void     tick();
+
+  bool request() const { return (conset & 0x08) != 0; }
+
+  std::vector<I2cSlave *> slaves;
+
+  void report(FILE *f) const;
+
+  /* statistics */
+  uint64_t starts, bytes, nacks;
+  uint64_t busBusy;                       /* cycles the bus was owned */
+  uint64_t cycles;
+
+private:
+  enum Op { OP_NONE, OP_START, OP_STOP, OP_ADDRESS, OP_WRITE, OP_READ };
+
+  void     begin(Op op, unsigned bits);
+  void     finish();
+  unsigned bitCycles() const;             /* in PCLK */
+
+  const LpcVpb *vpb;
+  uint32_t      conset, stat, dat, adr, sclh, scll;
+  bool          master;                   /* START sent, no STOP yet */
+  I2cSlave     *slave;                    /* addressed, or NULL */
+  Op            op;
+  unsigned      busy;                     /* PCLK cycles left of 'op' */
+};
+
+/*
+ * Vectored interrupt controller: 32 request lines, FIQ/IRQ selection,
+ * enables, software interrupts, 16 prioritized vector slots and the
+ * default vector. Reading VICVectAddr starts the service of the highest
+ * priority pending slot, which masks that and lower priorities until
+ * VICVectAddr is written.
+ */
+class LpcVic : public Device
+{
+public:
+  LpcVic();
+
+  uint32_t read(uint32_t addr);
+  void     write(uint32_t addr, uint32_t data, unsigned mask);
+  void     tick();
+
+  bool irq() const { return irqOut; }
+  bool fiq() const { return fiqOut; }
+
+  /* request line 'channel' follows dev->request() */
+  void connect(unsigned channel, const Device *dev) { lines[channel] = dev; }
+
+  /* latency statistics per channel, in cycles */
+  struct Latency
+  {
+    uint64_t count, sum, min, max;        /* request to vector read */
+    uint64_t eoiCount, eoiSum, eoiMax;    /* request to VICVectAddr write */
+  };
+  Latency  latency[32];
+
+  void report(FILE *f) const;
+
+private:
+  uint32_t irqStatus() const { return raw & enable & ~select; }
+  int      level() const;                 /* priority in service, 17 = none */
+  int      pendingSlot() const;           /* highest vectored above level */
+  uint32_t nonVectored() const;           /* pending without a vector slot */
+
+  const Device   *lines[32];
+  uint32_t        raw, select, enable, soft, protection;
+  uint32_t        vectAddr[16], vectCntl[16], defVectAddr;
+  uint32_t        inService;              /* slots 0-15, 16 = default */
+  unsigned        serviceChannel[17];     /* channel of each in-service slot */
+  uint64_t        serviceSince[17];
+  uint32_t        active;                 /* raw & enable of the last cycle */
+  uint64_t        now;
+  uint64_t        since[32];              /* cycle the request went active */
+  bool            irqOut, fiqOut;
+};
+
+/*
+ * All of the above, attached to a testbench and wired as on the LPC2148:
+ * Timer0 on VIC channel 4, Timer1 on 5, UART0 on 6, I2C0 on 9 with one
+ * LM75 at 0x90; addLm75() puts more on the bus. The testbench owns the
+ * devices, this the LM75s.
+ */
+struct LpcPeripherals
+{
+  explicit LpcPeripherals(Testbench &tb);
+
+  void addLm75(uint8_t address);
+
+  /* "SIM: vic/uart0/i2c0/lm75 ..." statistics lines */
+  void report(FILE *f) const;
+
+  LpcVpb   *vpb;
+  LpcTimer *timer0;
+  LpcTimer *timer1;
+  LpcUart  *uart0;
+  LpcI2c   *i2c0;
+  std::vector<std::unique_ptr<Lm75> > lm75;
+  LpcVic   *vic;
+};
+
+#endif /* _lpc_periph_h_ */
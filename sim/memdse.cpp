@@ -0,0 +1,665 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Trace-driven design-space exploration of the memory system. Replays
+ *    address traces of the core (arm9sim +addr_trace=, addr_trace.h)
+ *    through models of
+ *
+ *      - I-cache and D-cache: size, associativity, line length, LRU;
+ *        the D-cache write-back/write-allocate or write-through
+ *      - a write buffer of N entries in front of memory
+ *      - ITCM at address 0 and DTCM at 0x40000000 (single cycle)
+ *      - an instruction prefetch buffer of N lines, refilled with the
+ *        next sequential line on every instruction miss
+ *
+ *    and estimates the stall cycles each configuration adds to the traced
+ *    run, whose memories answer in one cycle. Memory serves the first
+ *    word of a request after +mem_latency cycles and one more word per
+ *    +mem_beat cycles, one request at a time; the device region at
+ *    0xE0000000 is uncached and never stalls. The estimate is
+ *
+ *      CPI = (traced cycles + stall cycles) / instructions
+ *
+ *    Every list option is swept (cross product), over all traces, in
+ *    parallel:
+ *
+ *      memdse [options] <trace> ...
+ *
+ *      +isize=<list>       I-cache bytes, 0 = none (0,1k,2k,4k,8k,16k)
+ *      +iassoc=<list>      ways (1,2,4)
+ *      +iline=<list>       line bytes (16,32)
+ *      +dsize=<list>       D-cache bytes (0,1k,2k,4k,8k)
+ *      +dassoc=<list>      (1,2,4)
+ *      +dline=<list>       (16,32)
+ *      +dpolicy=<list>     wb (write-back) and/or wt (write-through) (wb)
+ *      +wbuf=<list>        write buffer entries (4)
+ *      +itcm=<list>        ITCM bytes (0)
+ *      +dtcm=<list>        DTCM bytes (0)
+ *      +prefetch=<list>    prefetch buffer lines (0)
+ *      +mem_latency=<n>    cycles to the first word (4)
+ *      +mem_beat=<n>       cycles per further word (1)
+ *      +jobs=<n>           threads (default: all cores)
+ *      +csv=<file>         every result, one row per trace and config
+ *      +top=<n>            rows of the per-trace summary (10)
+ *
+ *    The summary lists, per trace, the configurations no cheaper one
+ *    (cache + TCM bytes) beats on CPI.
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "addr_trace.h"
+#include "plusarg.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define IO_BASE    0xe0000000u
+#define RAM_BASE   0x40000000u
+
+struct Config
+{
+  unsigned isize, iassoc, iline;
+  unsigned dsize, dassoc, dline;
+  bool     writeBack;
+  unsigned wbuf;
+  unsigned itcm, dtcm;
+  unsigned prefetch;
+
+  unsigned bytes() const { return isize + dsize + itcm + dtcm; }
+  std::string key() const;
+};
+
+struct Result
+{
+  uint64_t ifetch, imiss, pfHit;
+  uint64_t dacc, dmiss, writes;
+  uint64_t stall, wbStall;
+  double   cpi;
+};
+
+struct Trace
+{
+  std::string           name;
+  AddrTraceHeader       hdr;
+  std::vector<uint64_t> rec;
+};
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static unsigned memLatency = 4;
+static unsigned memBeat    = 1;
+
+/******************************************************************************
+ * Cache model
+ *****************************************************************************/
+class Cache
+{
+public:
+  Cache(unsigned size, unsigned assoc, unsigned line)
+    : ways(assoc), lineBits(__builtin_ctz(line)), clock(0)
+  {
+    sets = size ? size / (assoc * line) : 0;
+    tag.assign(sets * ways, 0);
+    age.assign(sets * ways, 0);
+    dirty.assign(sets * ways, 0);
+  }
+
+  /* true on a hit; a miss allocates when 'allocate' and reports a dirty
+     victim in 'evictDirty' */
+  bool
+  access(uint32_t addr, bool write, bool allocate, bool &evictDirty)
+  {
+    uint32_t line = (addr >> lineBits) + 1;      /* 0 = invalid */
+    unsigned base = (line % sets) * ways;
+    unsigned victim = base;
+
+    evictDirty = false;
+    clock++;
+    for (unsigned w = base; w < base + ways; w++) {
+      if (tag[w] == line) {
+        age[w] = clock;
+        if (write)
+          dirty[w] = 1;
+        return true;
+      }
+      if (age[w] < age[victim])
+        victim = w;
+    }
+    if (allocate) {
+      evictDirty    = tag[victim] && dirty[victim];
+      tag[victim]   = line;
+      age[victim]   = clock;
+      dirty[victim] = write;
+    }
+    return false;
+  }
+
+  /* the line is present (a write-through store hit updates it) */
+  bool
+  present(uint32_t addr)
+  {
+    uint32_t line = (addr >> lineBits) + 1;
+    unsigned base = (line % sets) * ways;
+
+    for (unsigned w = base; w < base + ways; w++)
+      if (tag[w] == line)
+        return true;
+    return false;
+  }
+
+private:
+  unsigned              sets, ways, lineBits;
+  uint32_t              clock;
+  std::vector<uint32_t> tag, age;
+  std::vector<uint8_t>  dirty;
+};
+
+/******************************************************************************
+ * Memory system
+ *****************************************************************************/
+class MemSystem
+{
+public:
+  explicit MemSystem(const Config &c)
+    : cfg(c),
+      icache(c.isize ? c.isize : c.iline, c.isize ? c.iassoc : 1, c.iline),
+      dcache(c.dsize ? c.dsize : 4, c.dsize ? c.dassoc : 1,
+             c.dsize ? c.dline : 4),
+      busFree(0)
+  {
+    memset(&res, 0, sizeof(res));
+  }
+
+  void replay(const Trace &t);
+
+  Result res;
+
+private:
+  uint64_t lineCost(unsigned bytes) const
+  {
+    return memLatency + (bytes / 4 - 1) * memBeat;
+  }
+  uint64_t read(uint64_t now, unsigned bytes);
+  uint64_t write(uint64_t now, unsigned bytes);
+  uint64_t fetch(uint64_t now, uint32_t addr);
+  uint64_t data(uint64_t now, uint32_t addr, bool store);
+
+  const Config         cfg;
+  Cache                icache, dcache;
+  uint64_t             busFree;           /* memory idle from */
+  std::deque<uint64_t> wbDone;            /* write buffer completion times */
+  struct Prefetch
+  {
+    uint32_t line;
+    uint64_t ready;
+  };
+  std::deque<Prefetch> pf;
+};
+
+/* a read of 'bytes' issued at 'now': returns the stall */
+uint64_t
+MemSystem::read(uint64_t now, unsigned bytes)
+{
+  uint64_t start = std::max(now, busFree);
+
+  busFree = start + lineCost(bytes);
+  return busFree - now - 1;
+}
+
+/* a write into the write buffer (or straight to memory without one) */
+uint64_t
+MemSystem::write(uint64_t now, unsigned bytes)
+{
+  uint64_t stall = 0, start;
+
+  res.writes++;
+  if (cfg.wbuf == 0) {
+    start   = std::max(now, busFree);
+    busFree = start + lineCost(bytes);
+    res.wbStall += busFree - now - 1;
+    return busFree - now - 1;
+  }
+
+  while (!wbDone.empty() && wbDone.front() <= now)
+    wbDone.pop_front();
+  if (wbDone.size() >= cfg.wbuf) {
+    stall = wbDone.front() - now;
+    now   = wbDone.front();
+    wbDone.pop_front();
+    res.wbStall += stall;
+  }
+  start   = std::max(now, busFree);
+  busFree = start + lineCost(bytes);
+  wbDone.push_back(busFree);
+  return stall;
+}
+
+uint64_t
+MemSystem::fetch(uint64_t now, uint32_t addr)
+{
+  bool     dummy;
+  uint32_t line;
+
+  res.ifetch++;
+  if (addr < cfg.itcm)
+    return 0;
+
+  if (cfg.isize == 0 && cfg.prefetch == 0) {
+    res.imiss++;
+    return read(now, 4);
+  }
+  /* without an I-cache, a single line buffer */
+  if (icache.access(addr, false, true, dummy))
+    return 0;
+  res.imiss++;
+
+  if (cfg.prefetch == 0)
+    return read(now, cfg.iline);
+
+  /* prefetch buffer: a hit waits for the line to arrive */
+  uint64_t stall = 0;
+  bool     hit   = false;
+
+  line = addr / cfg.iline;
+  for (size_t i = 0; i < pf.size(); i++)
+    if (pf[i].line == line) {
+      stall = pf[i].ready > now ? pf[i].ready - now : 0;
+      pf.erase(pf.begin() + i);
+      hit = true;
+      res.pfHit++;
+      break;
+    }
+  if (!hit)
+    stall = read(now, cfg.iline);
+
+  /* next sequential line, behind the demand fetch */
+  uint32_t next = line + 1;
+  bool     have = false;
+
+  for (size_t i = 0; i < pf.size(); i++)
+    if (pf[i].line == next)
+      have = true;
+  if (!have && !icache.present(next * cfg.iline)) {
+    Prefetch p;
+
+    if (pf.size() >= cfg.prefetch)
+      pf.pop_front();
+    p.line  = next;
+    p.ready = std::max(now + stall, busFree) + lineCost(cfg.iline);
+    busFree = p.ready;
+    pf.push_back(p);
+  }
+  return stall;
+}
+
+uint64_t
+MemSystem::data(uint64_t now, uint32_t addr, bool store)
+{
+  bool evictDirty;
+
+  if (addr >= IO_BASE)
+    return 0;
+  res.dacc++;
+  if (addr < cfg.itcm ||
+      (addr >= RAM_BASE && addr - RAM_BASE < cfg.dtcm))
+    return 0;
+
+  if (cfg.dsize == 0) {
+    res.dmiss++;
+    return store ? write(now, 4) : read(now, 4);
+  }
+
+  if (cfg.writeBack) {
+    if (dcache.access(addr, store, true, evictDirty))
+      return 0;
+    res.dmiss++;
+
+    uint64_t stall = 0;
+
+    /* the victim goes to the write buffer before the fill */
+    if (evictDirty)
+      stall = write(now, cfg.dline);
+    return stall + read(now + stall, cfg.dline);
+  }
+
+  /* write-through, no allocation on a write miss */
+  if (store) {
+    if (!dcache.present(addr))
+      res.dmiss++;
+    return write(now, 4);
+  }
+  if (dcache.access(addr, false, true, evictDirty))
+    return 0;
+  res.dmiss++;
+  return read(now, cfg.dline);
+}
+
+void
+MemSystem::replay(const Trace &t)
+{
+  uint64_t cycle = 0, stall = 0;
+
+  /* a fetch and a data access of the same cycle both stall: the core has
+     one bus interface towards the caches' shared memory port */
+  for (size_t i = 0; i < t.rec.size(); i++) {
+    uint64_t r    = t.rec[i];
+    uint32_t addr = r >> 32;
+    unsigned kind = (r >> 30) & 3;
+    uint64_t s;
+
+    cycle += r & TRACE_GAP_MAX;
+    if (kind == TRACE_GAP)
+      continue;
+
+    if (kind == TRACE_FETCH)
+      s = fetch(cycle + stall, addr);
+    else
+      s = data(cycle + stall, addr, kind == TRACE_STORE);
+    stall += s;
+  }
+
+  res.stall = stall;
+  res.cpi   = t.hdr.instret ?
+              (double)(t.hdr.cycles + stall) / t.hdr.instret : 0;
+}
+
+/******************************************************************************
+ * Configurations
+ *****************************************************************************/
+std::string
+Config::key() const
+{
+  char buf[160];
+
+  snprintf(buf, sizeof(buf), "%u,%u,%u,%u,%u,%u,%s,%u,%u,%u,%u", isize, iassoc,
+           iline, dsize, dassoc, dline, writeBack ? "wb" : "wt", wbuf, itcm,
+           dtcm, prefetch);
+  return buf;
+}
+
+/* "1k,2k,4096" */
+static std::vector<unsigned>
+parseList(const char *s)
+{
+  std::vector<unsigned> v;
+
+  while (s && *s) {
+    char         *end;
+    unsigned long n = strtoul(s, &end, 0);
+
+    if (*end == 'k' || *end == 'K') {
+      n *= 1024;
+      end++;
+    }
+    v.push_back(n);
+    s = (*end == ',') ? end + 1 : end;
+    if (*end != ',')
+      break;
+  }
+  return v;
+}
+
+static std::vector<unsigned>
+option(int argc, char **argv, const char *name, const char *dflt)
+{
+  const char *s = plusarg(argc, argv, name);
+
+  return parseList(s ? s : dflt);
+}
+
+static bool
+validCache(unsigned size, unsigned assoc, unsigned line)
+{
+  if (size == 0)
+    return true;
+  if (assoc == 0 || line < 4 || (line & (line - 1)) || size % (assoc * line))
+    return false;
+  return true;
+}
+
+static std::vector<Config>
+sweep(int argc, char **argv)
+{
+  std::vector<unsigned> isize    = option(argc, argv, "isize", "0,1k,2k,4k,8k,16k");
+  std::vector<unsigned> iassoc   = option(argc, argv, "iassoc", "1,2,4");
+  std::vector<unsigned> iline    = option(argc, argv, "iline", "16,32");
+  std::vector<unsigned> dsize    = option(argc, argv, "dsize", "0,1k,2k,4k,8k");
+  std::vector<unsigned> dassoc   = option(argc, argv, "dassoc", "1,2,4");
+  std::vector<unsigned> dline    = option(argc, argv, "dline", "16,32");
+  std::vector<unsigned> wbuf     = option(argc, argv, "wbuf", "4");
+  std::vector<unsigned> itcm     = option(argc, argv, "itcm", "0");
+  std::vector<unsigned> dtcm     = option(argc, argv, "dtcm", "0");
+  std::vector<unsigned> prefetch = option(argc, argv, "prefetch", "0");
+  const char           *pol      = plusarg(argc, argv, "dpolicy");
+  std::vector<bool>     policy;
+  std::vector<Config>   out;
+  std::set<std::string> seen;
+
+  if (!pol || strstr(pol, "wb"))
+    policy.push_back(true);
+  if (pol && strstr(pol, "wt"))
+    policy.push_back(false);
+
+  for (size_t a = 0; a < isize.size(); a++)
+  for (size_t b = 0; b < iassoc.size(); b++)
+  for (size_t c = 0; c < iline.size(); c++)
+  for (size_t d = 0; d < dsize.size(); d++)
+  for (size_t e = 0; e < dassoc.size(); e++)
+  for (size_t f = 0; f < dline.size(); f++)
+  for (size_t g = 0; g < policy.size(); g++)
+  for (size_t h = 0; h < wbuf.size(); h++)
+  for (size_t i = 0; i < itcm.size(); i++)
+  for (size_t j = 0; j < dtcm.size(); j++)
+  for (size_t k = 0; k < prefetch.size(); k++) {
+    Config cfg;
+
+    cfg.isize     = isize[a];
+    cfg.iassoc    = iassoc[b];
+    cfg.iline     = iline[c];
+    cfg.dsize     = dsize[d];
+    cfg.dassoc    = dassoc[e];
+    cfg.dline     = dline[f];
+    cfg.writeBack = policy[g];
+    cfg.wbuf      = wbuf[h];
+    cfg.itcm      = itcm[i];
+    cfg.dtcm      = dtcm[j];
+    cfg.prefetch  = prefetch[k];
+
+    /* parameters without effect collapse */
+    if (cfg.isize == 0)
+      cfg.iassoc = 1;
+    if (cfg.isize == 0 && cfg.prefetch == 0)
+      cfg.iline = 4;
+    if (cfg.dsize == 0) {
+      cfg.dassoc    = 1;
+      cfg.dline     = 4;
+      cfg.writeBack = false;
+    }
+    if (!validCache(cfg.isize, cfg.iassoc, cfg.iline) ||
+        !validCache(cfg.dsize, cfg.dassoc, cfg.dline))
+      continue;
+    if (seen.insert(cfg.key()).second)
+      out.push_back(cfg);
+  }
+  return out;
+}
+
+/******************************************************************************
+ * Traces
+ *****************************************************************************/
+static bool
+loadTrace(const char *path, Trace &t)
+{
+  FILE *f = fopen(path, "rb");
+
+  if (!f)
+    return false;
+  if (fread(&t.hdr, sizeof(t.hdr), 1, f) != 1 ||
+      memcmp(t.hdr.magic, "ARM9ATR1", 8) != 0) {
+    fclose(f);
+    return false;
+  }
+  t.rec.resize(t.hdr.records);
+  if (fread(t.rec.data(), sizeof(uint64_t), t.rec.size(), f) !=
+      t.rec.size()) {
+    fclose(f);
+    return false;
+  }
+  fclose(f);
+
+  /* base name without directory and extension */
+  t.name = path;
+  if (t.name.rfind('/') != std::string::npos)
+    t.name = t.name.substr(t.name.rfind('/') + 1);
+  if (t.name.rfind('.') != std::string::npos)
+    t.name = t.name.substr(0, t.name.rfind('.'));
+  return true;
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(int argc, char **argv)
+{
+  std::vector<Trace>       traces;
+  std::vector<Config>      configs;
+  std::vector<Result>      results;
+  std::vector<std::thread> threads;
+  std::atomic<size_t>      next(0);
+  unsigned                 jobs = std::thread::hardware_concurrency();
+  unsigned                 top  = 10;
+  const char              *s;
+  FILE                    *csv  = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] == '+')
+      continue;
+    traces.push_back(Trace());
+    if (!loadTrace(argv[i], traces.back())) {
+      fprintf(stderr, "ERROR! %s is not an address trace\n", argv[i]);
+      return 1;
+    }
+  }
+  if (traces.empty()) {
+    fprintf(stderr, "usage: memdse [+option=list ...] <trace> ...\n");
+    return 2;
+  }
+
+  if ((s = plusarg(argc, argv, "mem_latency")) != 0)
+    memLatency = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "mem_beat")) != 0)
+    memBeat = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "jobs")) != 0)
+    jobs = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "top")) != 0)
+    top = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "csv")) != 0 && !(csv = fopen(s, "w"))) {
+    fprintf(stderr, "ERROR! Cannot open %s\n", s);
+    return 1;
+  }
+  if (jobs == 0)
+    jobs = 1;
+
+  configs = sweep(argc, argv);
+  results.resize(traces.size() * configs.size());
+  printf("MEMDSE: %zu traces x %zu configurations on %u threads\n",
+         traces.size(), configs.size(), jobs);
+
+  for (unsigned j = 0; j < jobs; j++)
+    threads.push_back(std::thread([&]() {
+      size_t n;
+
+      while ((n = next++) < results.size()) {
+        MemSystem m(configs[n % configs.size()]);
+
+        m.replay(traces[n / configs.size()]);
+        results[n] = m.res;
+      }
+    }));
+  for (size_t j = 0; j < threads.size(); j++)
+    threads[j].join();
+
+  if (csv) {
+    fprintf(csv, "trace,isize,iassoc,iline,dsize,dassoc,dline,dpolicy,wbuf,"
+                 "itcm,dtcm,prefetch,bytes,ihit,dhit,stall,wb_stall,cpi\n");
+    for (size_t n = 0; n < results.size(); n++) {
+      const Config &c = configs[n % configs.size()];
+      const Result &r = results[n];
+
+      fprintf(csv, "%s,%s,%u,%.4f,%.4f,%llu,%llu,%.4f\n",
+              traces[n / configs.size()].name.c_str(), c.key().c_str(),
+              c.bytes(),
+              r.ifetch ? 1.0 - (double)r.imiss / r.ifetch : 1.0,
+              r.dacc ? 1.0 - (double)r.dmiss / r.dacc : 1.0,
+              (unsigned long long)r.stall, (unsigned long long)r.wbStall,
+              r.cpi);
+    }
+    fclose(csv);
+  }
+
+  /* per trace: the cheapest configurations that improve the CPI */
+  for (size_t t = 0; t < traces.size(); t++) {
+    const Trace        &tr = traces[t];
+    std::vector<size_t> order;
+    double              best = 1e30;
+    unsigned            rows = 0;
+
+    for (size_t c = 0; c < configs.size(); c++)
+      order.push_back(c);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      const Result &ra = results[t * configs.size() + a];
+      const Result &rb = results[t * configs.size() + b];
+
+      if (configs[a].bytes() != configs[b].bytes())
+        return configs[a].bytes() < configs[b].bytes();
+      return ra.cpi < rb.cpi;
+    });
+
+    printf("\n=== %s: %llu cycles, %llu instructions, CPI %.3f with "
+           "single-cycle memory ===\n\n", tr.name.c_str(),
+           (unsigned long long)tr.hdr.cycles,
+           (unsigned long long)tr.hdr.instret,
+           tr.hdr.instret ? (double)tr.hdr.cycles / tr.hdr.instret : 0);
+    printf("%7s %-14s %-17s %5s %4s %6s %6s %3s %7s %7s %7s\n", "BYTES",
+           "ICACHE", "DCACHE", "WBUF", "PF", "ITCM", "DTCM", "",
+           "I-HIT", "D-HIT", "CPI");
+    for (size_t i = 0; i < order.size() && rows < top; i++) {
+      const Config &c = configs[order[i]];
+      const Result &r = results[t * configs.size() + order[i]];
+      char          ic[32], dc[32];
+
+      if (r.cpi >= best)
+        continue;
+      best = r.cpi;
+      rows++;
+      if (c.isize)
+        snprintf(ic, sizeof(ic), "%uK/%uw/%uB", c.isize / 1024, c.iassoc,
+                 c.iline);
+      else
+        snprintf(ic, sizeof(ic), "-");
+      if (c.dsize)
+        snprintf(dc, sizeof(dc), "%uK/%uw/%uB/%s", c.dsize / 1024, c.dassoc,
+                 c.dline, c.writeBack ? "wb" : "wt");
+      else
+        snprintf(dc, sizeof(dc), "-");
+      printf("%7u %-14s %-17s %5u %4u %6u %6u %3s %6.2f%% %6.2f%% %7.3f\n",
+             c.bytes(), ic, dc, c.wbuf, c.prefetch, c.itcm, c.dtcm, "",
+             r.ifetch ? 100.0 - 100.0 * r.imiss / r.ifetch : 100.0,
+             r.dacc ? 100.0 - 100.0 * r.dmiss / r.dacc : 100.0, r.cpi);
+    }
+  }
+  printf("\n");
+  return 0;
+}
@@ -0,0 +1,73 @@
+#!/bin/bash
+#
+# Memory-system design-space exploration
+#
+# Traces every image of regress/tests.lst on the Verilator simulation
+# (arm9sim +addr_trace=) and replays the traces through memdse for every
+# cache, TCM, write buffer and prefetch configuration of the sweep.
+#
+# usage: sim/memdse.sh [options] [test ...] [-- memdse options]
+#
+#   -o <dir>     output directory (default: sim/dse_out)
+#   -l <file>    test list (default: regress/tests.lst)
+#   -n           reuse the traces already in <dir>
+#
+# Writes <dir>/<test>.atr (trace), <dir>/<test>.txt (serial output),
+# <dir>/results.csv (every configuration) and <dir>/summary.txt (the
+# CPI/SRAM frontier per test). Options after -- go to memdse, e.g.
+#
+#   sim/memdse.sh dhry -- +isize=0,4k +dsize=0,4k +mem_latency=8
+#
+
+SIM_DIR=$(cd "$(dirname "$0")" && pwd)
+TOP_DIR=$(cd "$SIM_DIR/.." && pwd)
+
+OUT=$SIM_DIR/dse_out
+TESTS=$TOP_DIR/regress/tests.lst
+TRACE=1
+
+while getopts "o:l:n" opt; do
+  case $opt in
+    o) OUT=$OPTARG ;;
+    l) TESTS=$OPTARG ;;
+    n) TRACE=0 ;;
+    *) sed -n '3,19p' "$0"; exit 2 ;;
+  esac
+done
+shift $((OPTIND - 1))
+
+SELECT=""
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+  SELECT="$SELECT $1"
+  shift
+done
+[ "$1" = "--" ] && shift
+
+mkdir -p "$OUT"
+make -s -C "$SIM_DIR" memdse || exit 1
+[ $TRACE -eq 1 ] && { make -s -C "$SIM_DIR" || exit 1; }
+
+TRACES=""
+while read -r name image cycles; do
+  case $name in ''|\#*) continue ;; esac
+  if [ -n "$SELECT" ] && ! echo " $SELECT " | grep -q " $name "; then
+    continue
+  fi
+  if [ $TRACE -eq 1 ]; then
+    if [ ! -f "$TOP_DIR/$image" ]; then
+      echo "SKIP  $name: $image not built"
+      continue
+    fi
+    echo "TRACE $name"
+    "$SIM_DIR/arm9sim" "$TOP_DIR/$image" +max_cycles="$cycles" \
+      +addr_trace="$OUT/$name.atr" > "$OUT/$name.txt" 2>&1
+  fi
+  [ -f "$OUT/$name.atr" ] && TRACES="$TRACES $OUT/$name.atr"
+done < "$TESTS"
+
+if [ -z "$TRACES" ]; then
+  echo "no traces"
+  exit 1
+fi
+
+"$SIM_DIR/memdse" +csv="$OUT/results.csv" "$@" $TRACES | tee "$OUT/summary.txt"
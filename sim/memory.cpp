@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Page-granular sparse memory
+ *
+ *****************************************************************************/
+#include "memory.h"
+
+#include <algorithm>
+#include <string.h>
+
+const uint32_t *
+SparseMemory::page(uint32_t addr) const
+{
+  uint32_t tag = addr >> PAGE_BITS;
+
+  if (tag == lastTag)
+    return lastPage;
+
+  PageMap::const_iterator it = pageMap.find(tag);
+  if (it == pageMap.end())
+    return 0;
+
+  lastTag  = tag;
+  lastPage = it->second.get();
+  return lastPage;
+}
+
+uint32_t *
+SparseMemory::pageAlloc(uint32_t addr)
+{
+  uint32_t tag = addr >> PAGE_BITS;
+
+  if (tag == lastTag)
+    return lastPage;
+
+  std::unique_ptr<uint32_t[]> &p = pageMap[tag];
+  if (!p) {
+    p.reset(new uint32_t[PAGE_WORDS]);
+    memset(p.get(), 0, PAGE_SIZE);
+  }
+
+  lastTag  = tag;
+  lastPage = p.get();
+  return lastPage;
+}
+
+void
+SparseMemory::load(uint32_t addr, const uint8_t *data, size_t len)
+{
+  /* unaligned head and tail byte-wise, the rest a page at a time */
+  while (len && (addr & 3)) {
+    write8(addr++, *data++);
+    len--;
+  }
+  while (len >= 4) {
+    uint32_t  off   = addr & (PAGE_SIZE - 1);
+    size_t    chunk = std::min<size_t>(len & ~(size_t)3, PAGE_SIZE - off);
+    uint32_t *p     = pageAlloc(addr);
+
+    memcpy((uint8_t *)p + off, data, chunk);   /* host is little endian */
+    addr += chunk;
+    data += chunk;
+    len  -= chunk;
+  }
+  while (len) {
+    write8(addr++, *data++);
+    len--;
+  }
+}
+
+void
+SparseMemory::fill(uint32_t addr, uint8_t value, size_t len)
+{
+  while (len--)
+    write8(addr++, value);
+}
+
+void
+SparseMemory::clear()
+{
+  pageMap.clear();
+  lastTag  = ~0u;
+  lastPage = 0;
+}
+
+std::vector<uint32_t>
+SparseMemory::pages() const
+{
+  std::vector<uint32_t> v;
+
+  v.reserve(pageMap.size());
+  for (PageMap::const_iterator it = pageMap.begin(); it != pageMap.end(); ++it)
+    v.push_back(it->first << PAGE_BITS);
+  std::sort(v.begin(), v.end());
+  return v;
+}
@@ -0,0 +1,83 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Page-granular sparse memory covering the full 32-bit address space.
+ *    Pages are allocated on first write; reads of unmapped addresses
+ *    return zero without allocating. All accesses are word-wide, with a
+ *    byte mask for sub-word writes, matching the core's ram_flag bus.
+ *
+ *****************************************************************************/
+#ifndef _memory_h_
+#define _memory_h_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class SparseMemory
+{
+public:
+  static const unsigned PAGE_BITS  = 12;
+  static const uint32_t PAGE_SIZE  = 1u << PAGE_BITS;
+  static const uint32_t PAGE_WORDS = PAGE_SIZE / 4;
+
+  SparseMemory() : lastTag(~0u), lastPage(0) {}
+
+  uint32_t
+  read32(uint32_t addr) const
+  {
+    const uint32_t *p = page(addr);
+    return p ? p[(addr & (PAGE_SIZE - 1)) >> 2] : 0;
+  }
+
+  void
+  write32(uint32_t addr, uint32_t data, unsigned byteMask = 0xf)
+  {
+    uint32_t *w = &pageAlloc(addr)[(addr & (PAGE_SIZE - 1)) >> 2];
+    if (byteMask == 0xf)
+      *w = data;
+    else {
+      uint32_t m = ((byteMask & 1) ? 0x000000ffu : 0) |
+                   ((byteMask & 2) ? 0x0000ff00u : 0) |
+                   ((byteMask & 4) ? 0x00ff0000u : 0) |
+                   ((byteMask & 8) ? 0xff000000u : 0);
+      *w = (*w & ~m) | (data & m);
+    }
+  }
+
+  uint8_t
+  read8(uint32_t addr) const
+  {
+    return (uint8_t)(read32(addr & ~3u) >> ((addr & 3) * 8));
+  }
+
+  void
+  write8(uint32_t addr, uint8_t data)
+  {
+    write32(addr & ~3u, (uint32_t)data << ((addr & 3) * 8), 1u << (addr & 3));
+  }
+
+  void load(uint32_t addr, const uint8_t *data, size_t len);
+  void fill(uint32_t addr, uint8_t value, size_t len);
+  void clear();
+
+  /* page lookup; NULL when the page has never been written */
+  const uint32_t *page(uint32_t addr) const;
+  uint32_t *pageAlloc(uint32_t addr);
+
+  /* base addresses of all allocated pages, ascending */
+  std::vector<uint32_t> pages() const;
+
+private:
+  typedef std::unordered_map<uint32_t, std::unique_ptr<uint32_t[]> > PageMap;
+
+  PageMap pageMap;
+
+  /* one-entry lookup cache; instruction fetch hits it almost always */
+  mutable uint32_t  lastTag;
+  mutable uint32_t *lastPage;
+};
+
+#endif /* _memory_h_ */
@@ -0,0 +1,34 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Plusarg options
+ *
+ *****************************************************************************/
+#include <string.h>
+
+#include "plusarg.h"
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+const char *
+plusarg(int argc, char **argv, const char *name)
+{
+  size_t n = strlen(name);
+
+  for (int i = 1; i < argc; i++)
+    if (argv[i][0] == '+' && strncmp(argv[i] + 1, name, n) == 0 &&
+        argv[i][n + 1] == '=')
+      return argv[i] + n + 2;
+  return 0;
+}
+
+bool
+plusflag(int argc, char **argv, const char *name)
+{
+  for (int i = 1; i < argc; i++)
+    if (argv[i][0] == '+' && strcmp(argv[i] + 1, name) == 0)
+      return true;
+  return false;
+}
@@ -0,0 +1,18 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Options in the form of Verilog plusargs, shared by the simulators and
+ *    tools of this directory: "+name=value" and "+name". Anything else on
+ *    the command line (an image name) is left to the caller.
+ *
+ *****************************************************************************/
+#ifndef _plusarg_h_
+#define _plusarg_h_
+
+/* "+name=value" -> value, or NULL */
+const char *plusarg(int argc, char **argv, const char *name);
+
+/* "+name" given */
+bool plusflag(int argc, char **argv, const char *name);
+
+#endif /* _plusarg_h_ */
@@ -0,0 +1,191 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Differential random testing of the core: constrained-random programs
+ *    (randgen.h) run on the instruction set simulator (iss.h) and on the
+ *    Verilated RTL; after the exit the banked registers, the CPSR, the
+ *    SPSRs and the RAM must match.
+ *
+ *      +seed=<n>           first seed (default 1)
+ *      +count=<n>          number of programs, seeds seed..seed+n-1 (100)
+ *      +length=<n>         random instructions per program (500)
+ *      +jobs=<n>           worker threads (default: all cores)
+ *      +save=<dir>         keep every program as <dir>/rand_<seed>.bin;
+ *                          failing ones go to rand_fail/ without +save
+ *      +trace              print the ISS trace of failing programs
+ *
+ *    A saved program runs on its own with arm9sim or tb.v (+binfile=).
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "verilated.h"
+
+#include "iss.h"
+#include "plusarg.h"
+#include "randgen.h"
+#include "testbench.h"
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static uint32_t             firstSeed = 1;
+static unsigned             count     = 100;
+static unsigned             length    = 500;
+static const char          *saveDir   = 0;
+static bool                 trace     = false;
+
+static std::atomic<unsigned> nextSeed(0);
+static std::atomic<unsigned> failures(0);
+static std::mutex           printLock;
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+/* RAM pages of both runs, word by word; first difference into 'diff' */
+static bool
+sameRam(const SparseMemory &iss, const SparseMemory &rtl, std::string &diff)
+{
+  std::vector<uint32_t> pages = iss.pages();
+  std::vector<uint32_t> more  = rtl.pages();
+
+  pages.insert(pages.end(), more.begin(), more.end());
+  for (size_t i = 0; i < pages.size(); i++) {
+    if (pages[i] < RandGen::RAM_BASE)
+      continue;
+    for (uint32_t a = pages[i]; a < pages[i] + SparseMemory::PAGE_SIZE; a += 4)
+      if (iss.read32(a) != rtl.read32(a)) {
+        char buf[80];
+
+        snprintf(buf, sizeof(buf), "  [%08x]: %08x != %08x\n", a,
+                 iss.read32(a), rtl.read32(a));
+        diff = buf;
+        return false;
+      }
+  }
+  return true;
+}
+
+/* one program on both models; false on a mismatch */
+static bool
+runSeed(uint32_t seed)
+{
+  RandGen          gen(seed);
+  SparseMemory     issMem;
+  VerilatedContext ctx;
+  ArchState        rtlState;
+  std::string      ramDiff;
+  bool             ok;
+
+  gen.generate(length);
+
+  /* reference */
+  gen.load(issMem);
+  Iss iss(issMem);
+  iss.reset();
+  iss.run((uint64_t)length * 64 + 1000);
+
+  /* RTL, same image */
+  Testbench tb(&ctx);
+  gen.load(tb.mem);
+  tb.timer->period = 0;
+  tb.simctl->quiet = true;
+  tb.reset();
+  tb.run((uint64_t)length * 256 + 10000);
+  tb.archState(rtlState);
+
+  ok = iss.halted && tb.done && iss.st.sameRegs(rtlState) &&
+       sameRam(issMem, tb.mem, ramDiff);
+
+  if (saveDir || !ok) {
+    char path[256];
+
+    snprintf(path, sizeof(path), "%s/rand_%u.bin",
+             saveDir ? saveDir : "rand_fail", seed);
+    mkdir(saveDir ? saveDir : "rand_fail", 0777);
+    if (!gen.save(path))
+      fprintf(stderr, "ERROR! Cannot write %s\n", path);
+  }
+
+  if (!ok) {
+    std::lock_guard<std::mutex> lock(printLock);
+
+    printf("FAIL seed=%u iss_instret=%llu rtl_instret=%llu rtl_cycles=%llu\n",
+           seed, (unsigned long long)iss.instret,
+           (unsigned long long)tb.instret, (unsigned long long)tb.cycle);
+    if (!iss.halted)
+      printf("  iss did not reach the exit (pc=%08x)\n", iss.st.pc);
+    if (!tb.done)
+      printf("  rtl did not reach the exit (pc=%08x)\n", rtlState.pc);
+    iss.st.diff(rtlState, stdout);
+    printf("%s", ramDiff.c_str());
+
+    if (trace) {
+      SparseMemory mem;
+
+      gen.load(mem);
+      Iss again(mem);
+      again.trace = stdout;
+      again.reset();
+      again.run((uint64_t)length * 64 + 1000);
+      iss.st.print(stdout);
+    }
+    fflush(stdout);
+  }
+  return ok;
+}
+
+static void
+worker()
+{
+  unsigned i;
+
+  while ((i = nextSeed++) < count)
+    if (!runSeed(firstSeed + i))
+      failures++;
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(int argc, char **argv)
+{
+  std::vector<std::thread> threads;
+  unsigned                 jobs = std::thread::hardware_concurrency();
+  const char              *s;
+
+  if ((s = plusarg(argc, argv, "seed")) != 0)
+    firstSeed = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "count")) != 0)
+    count = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "length")) != 0)
+    length = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "jobs")) != 0)
+    jobs = strtoul(s, 0, 0);
+  saveDir = plusarg(argc, argv, "save");
+  trace   = plusflag(argc, argv, "trace");
+
+  if (saveDir)
+    mkdir(saveDir, 0777);
+  if (jobs == 0)
+    jobs = 1;
+
+  for (unsigned j = 0; j < jobs && j < count; j++)
+    threads.push_back(std::thread(worker));
+  for (size_t j = 0; j < threads.size(); j++)
+    threads[j].join();
+
+  printf("RAND: seeds=%u..%u length=%u fail=%u\n", firstSeed,
+         firstSeed + count - 1, length, failures.load());
+  return failures ? 1 : 0;
+}
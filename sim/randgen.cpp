@@ -0,0 +1,618 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Constrained-random ARM program generator
+ *
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "arch_state.h"
+#include "randgen.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define AL        0xeu
+
+#define OP_ADD    0x4
+#define OP_TST    0x8
+#define OP_CMN    0xb
+#define OP_MOV    0xd
+#define OP_MVN    0xf
+
+#define NOP       0xe1a00000u             /* MOV r0,r0 */
+#define LOOP      0xeafffffeu             /* B . */
+
+#define REG_MASK  0x7fffu                 /* r0-r14 */
+
+/******************************************************************************
+ * Instruction encoders
+ *****************************************************************************/
+
+/* 'value' as a rotated 8-bit immediate (bit 25 set), or ~0 */
+static uint32_t
+immOperand(uint32_t value)
+{
+  for (unsigned rot = 0; rot < 16; rot++) {
+    uint32_t v = rot ? (value << (2 * rot)) | (value >> (32 - 2 * rot)) : value;
+
+    if (v < 256)
+      return (1u << 25) | (rot << 8) | v;
+  }
+  return ~0u;
+}
+
+static uint32_t
+dataProc(unsigned c, unsigned op, bool s, unsigned rn, unsigned rd,
+         uint32_t op2)
+{
+  return (c << 28) | (op << 21) | ((uint32_t)s << 20) | (rn << 16) |
+         (rd << 12) | op2;
+}
+
+static uint32_t
+dataProcImm(unsigned c, unsigned op, unsigned rn, unsigned rd, uint32_t value)
+{
+  uint32_t op2 = immOperand(value);
+
+  if (op2 == ~0u)
+    fprintf(stderr, "randgen: %08x is no immediate\n", value);
+  return dataProc(c, op, false, rn, rd, op2);
+}
+
+static uint32_t
+ldrStr(unsigned c, bool l, bool b, bool p, bool u, bool w, unsigned rn,
+       unsigned rd, uint32_t offset)
+{
+  return (c << 28) | (1u << 26) | ((uint32_t)p << 24) | ((uint32_t)u << 23) |
+         ((uint32_t)b << 22) | ((uint32_t)w << 21) | ((uint32_t)l << 20) |
+         (rn << 16) | (rd << 12) | offset;
+}
+
+static uint32_t
+ldmStm(unsigned c, bool l, bool p, bool u, bool s, bool w, unsigned rn,
+       unsigned list)
+{
+  return (c << 28) | (4u << 25) | ((uint32_t)p << 24) | ((uint32_t)u << 23) |
+         ((uint32_t)s << 22) | ((uint32_t)w << 21) | ((uint32_t)l << 20) |
+         (rn << 16) | list;
+}
+
+static uint32_t
+msr(unsigned c, bool spsr, unsigned fields, uint32_t op2)
+{
+  return (c << 28) | 0x0120f000u | ((uint32_t)spsr << 22) |
+         ((fields & 1) << 16) | ((fields & 8) << 16) | op2;
+}
+
+static uint32_t
+branch(unsigned c, bool link, uint32_t from, uint32_t to)
+{
+  return (c << 28) | (5u << 25) | ((uint32_t)link << 24) |
+         (((to - from - 8) >> 2) & 0xffffff);
+}
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+RandGen::RandGen(uint32_t seed)
+  : rng(seed), mode(MODE_SVC)
+{
+}
+
+void
+RandGen::generate(unsigned length)
+{
+  code.clear();
+  pool.assign(POOL_WORDS, 0);
+
+  genVectors();
+  genInit();
+
+  for (unsigned i = 0; i < length; i++) {
+    unsigned pick = rnd(100);
+
+    if (pick < 30)
+      genDataProc(true);
+    else if (pick < 38)
+      genMul();
+    else if (pick < 42)
+      genSwap();
+    else if (pick < 54)
+      genLdrStr();
+    else if (pick < 62)
+      genHalf();
+    else if (pick < 70)
+      genLdmStm();
+    else if (pick < 74)
+      genLiteral();
+    else if (pick < 84)
+      genPsr();
+    else if (pick < 94)
+      genBranch();
+    else
+      genException();
+  }
+
+  genExit();
+
+  if (here() > POOL_BASE)
+    fprintf(stderr, "randgen: program overlaps the data pool\n");
+}
+
+void
+RandGen::load(SparseMemory &mem) const
+{
+  for (size_t i = 0; i < code.size(); i++)
+    mem.write32(i * 4, code[i]);
+  for (size_t i = 0; i < pool.size(); i++)
+    mem.write32(POOL_BASE + i * 4, pool[i]);
+}
+
+bool
+RandGen::save(const std::string &path) const
+{
+  FILE    *f = fopen(path.c_str(), "wb");
+  uint32_t size = POOL_BASE + POOL_WORDS * 4;
+
+  if (!f)
+    return false;
+  for (uint32_t addr = 0; addr < size; addr += 4) {
+    uint32_t w = 0;
+    uint8_t  b[4];
+
+    if (addr < code.size() * 4)
+      w = code[addr / 4];
+    else if (addr >= POOL_BASE)
+      w = pool[(addr - POOL_BASE) / 4];
+    b[0] = w;
+    b[1] = w >> 8;
+    b[2] = w >> 16;
+    b[3] = w >> 24;
+    fwrite(b, 1, 4, f);
+  }
+  return fclose(f) == 0;
+}
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+/* register and data values, biased towards the corner cases */
+uint32_t
+RandGen::value()
+{
+  switch (rnd(8)) {
+  case 0:  return 0;
+  case 1:  return 1;
+  case 2:  return 0xffffffffu;
+  case 3:  return 0x80000000u;
+  case 4:  return 0x7fffffffu;
+  case 5:  return rnd(256);
+  case 6:  return 1u << rnd(32);
+  default: return rng();
+  }
+}
+
+/* one of r0-r14, not in the 'exclude' mask */
+unsigned
+RandGen::reg(unsigned exclude)
+{
+  unsigned r;
+
+  do
+    r = rnd(15);
+  while (exclude & (1u << r));
+  return r;
+}
+
+unsigned
+RandGen::cond()
+{
+  return chance(60) ? AL : rnd(15);
+}
+
+bool
+RandGen::privileged() const
+{
+  return mode != MODE_USR;
+}
+
+bool
+RandGen::hasSpsr() const
+{
+  return mode != MODE_USR && mode != MODE_SYS;
+}
+
+/* rb = addr, for RAM_BASE/POOL_BASE plus up to 0xfff */
+void
+RandGen::setBase(unsigned rb, uint32_t addr)
+{
+  emit(dataProcImm(AL, OP_MOV, 0, rb, addr & ~0xfffu));
+  if (addr & 0xf00)
+    emit(dataProcImm(AL, OP_ADD, rb, rb, addr & 0xf00));
+  if (addr & 0xff)
+    emit(dataProcImm(AL, OP_ADD, rb, rb, addr & 0xff));
+}
+
+/* 'n' instructions that may be skipped by a branch */
+void
+RandGen::filler(unsigned n)
+{
+  while (n--)
+    genDataProc(false);
+}
+
+/* make the ADD rX,pc,#0 at index 'at' point at the index 'target' */
+void
+RandGen::patchAddPc(size_t at, size_t target)
+{
+  code[at] |= immOperand(target * 4 - (at * 4 + 8));
+}
+
+void
+RandGen::genVectors()
+{
+  unsigned list, list2;
+  size_t   und, swi;
+
+  emit(0);                                /* reset, patched below */
+  emit(0);                                /* undefined instruction */
+  emit(0);                                /* SWI */
+  emit(LOOP);                             /* prefetch abort */
+  emit(LOOP);                             /* data abort */
+  emit(NOP);
+  emit(LOOP);                             /* irq, masked */
+  emit(LOOP);                             /* fiq, masked */
+
+  /* undefined instruction: skip it */
+  und = code.size();
+  emit(0xe1b0f00eu);                      /* MOVS pc,lr */
+
+  /*
+   * SWI: store and reload user registers (STM/LDM with ^), return by
+   * LDM {pc}^. The register lists are random per program.
+   */
+  swi = code.size();
+  list  = 1 + rnd(REG_MASK);
+  list2 = 1 + rnd(REG_MASK);
+  emit(dataProcImm(AL, OP_MOV, 0, 13, SAVE_AREA & ~0xfffu));
+  emit(dataProcImm(AL, OP_ADD, 13, 13, SAVE_AREA & 0xfff));
+  emit(ldmStm(AL, false, false, true, true, false, 13, list));
+  emit(ldmStm(AL, true, false, true, true, false, 13, list2));
+  emit(NOP);
+  emit(ldrStr(AL, false, false, true, true, false, 13, 14, 0x80));
+  emit(dataProcImm(AL, OP_ADD, 13, 13, 0x80));
+  emit(ldmStm(AL, true, false, true, true, false, 13, 1u << 15));
+
+  code[0] = branch(AL, false, 0x00, here());
+  code[1] = branch(AL, false, 0x04, und * 4);
+  code[2] = branch(AL, false, 0x08, swi * 4);
+}
+
+/*
+ * Every mode gets random banked registers and SPSR from the pool, the
+ * body starts with random flags in a random mode (I and F set).
+ */
+void
+RandGen::genInit()
+{
+  static const unsigned modes[5] = {
+    MODE_FIQ, MODE_IRQ, MODE_SVC, MODE_ABT, MODE_UND
+  };
+  static const unsigned all[7] = {
+    MODE_USR, MODE_FIQ, MODE_IRQ, MODE_SVC, MODE_ABT, MODE_UND, MODE_SYS
+  };
+  unsigned n = 0;
+
+  emit(dataProcImm(AL, OP_MOV, 0, 0, POOL_BASE));
+
+  for (unsigned m = 0; m < 5; m++) {
+    unsigned list = (modes[m] == MODE_FIQ) ? 0x7f00 : 0x6000;
+
+    emit(msr(AL, false, 1, immOperand(0xc0 | modes[m])));
+    emit(ldmStm(AL, true, false, true, false, true, 0, 1u << 1));
+    emit(msr(AL, true, 9, 1));
+    emit(ldmStm(AL, true, false, true, false, true, 0, list));
+
+    pool[n++] = rng();
+    for (unsigned r = 0; r < 15; r++)
+      if (list & (1u << r))
+        pool[n++] = value();
+  }
+
+  emit(msr(AL, false, 1, immOperand(0xc0 | MODE_SYS)));
+  emit(ldmStm(AL, true, false, true, false, true, 0, 0x7ffe));
+  emit(ldrStr(AL, true, false, true, true, false, 0, 0, 0));
+  for (unsigned r = 0; r < 15; r++)
+    pool[n++] = value();
+
+  emit(msr(AL, false, 8, immOperand(rnd(16) << 28)));
+  mode = all[rnd(7)];
+  emit(msr(AL, false, 1, immOperand(0xc0 | mode)));
+
+  while (n < POOL_WORDS)
+    pool[n++] = value();
+}
+
+void
+RandGen::genExit()
+{
+  emit(dataProcImm(AL, OP_MOV, 0, 0, 0xe0000000u));
+  emit(dataProcImm(AL, OP_MOV, 0, 1, 0));
+  emit(ldrStr(AL, false, false, true, true, false, 0, 1, 0x10));
+  emit(LOOP);
+}
+
+/* 'allowPc': r15 may be read as Rn or Rm (never written) */
+void
+RandGen::genDataProc(bool allowPc)
+{
+  unsigned op = rnd(16);
+  bool     s  = (op >= OP_TST && op <= OP_CMN) || chance(40);
+  unsigned rd = (op >= OP_TST && op <= OP_CMN) ? 0 : reg();
+  unsigned rn = (op == OP_MOV || op == OP_MVN) ? 0 :
+                (allowPc && chance(5)) ? 15 : reg();
+  unsigned rm = (allowPc && chance(5)) ? 15 : reg();
+  uint32_t op2;
+
+  switch (rnd(3)) {
+  case 0:
+    op2 = (1u << 25) | (rnd(16) << 8) | rnd(256);
+    break;
+  case 1:
+    op2 = (rnd(32) << 7) | (rnd(4) << 5) | rm;
+    break;
+  default:
+    /* register-specified shift: no PC operand */
+    if (rn == 15)
+      rn = reg();
+    op2 = (reg() << 8) | (rnd(4) << 5) | (1u << 4) | (rm == 15 ? reg() : rm);
+    break;
+  }
+  emit(dataProc(cond(), op, s, rn, rd, op2));
+}
+
+void
+RandGen::genMul()
+{
+  unsigned c = cond();
+  bool     s = chance(40);
+
+  if (chance(50)) {
+    unsigned rd = reg();
+    unsigned rm = reg(1u << rd);
+    bool     a  = chance(50);
+
+    emit((c << 28) | ((uint32_t)a << 21) | ((uint32_t)s << 20) | (rd << 16) |
+         ((a ? reg() : 0) << 12) | (reg() << 8) | 0x90 | rm);
+  }
+  else {
+    unsigned hi = reg();
+    unsigned lo = reg(1u << hi);
+    unsigned rm = reg((1u << hi) | (1u << lo));
+
+    emit((c << 28) | (1u << 23) | ((uint32_t)chance(50) << 22) |
+         ((uint32_t)chance(50) << 21) | ((uint32_t)s << 20) | (hi << 16) |
+         (lo << 12) | (reg() << 8) | 0x90 | rm);
+  }
+}
+
+void
+RandGen::genSwap()
+{
+  unsigned rn = reg();
+  unsigned rd = reg(1u << rn);
+  unsigned rm = reg(1u << rn);
+  bool     b  = chance(30);
+
+  setBase(rn, RAM_BASE + (b ? rnd(0xc00) : rnd(0x300) * 4));
+  emit((cond() << 28) | (1u << 24) | ((uint32_t)b << 22) | (rn << 16) |
+       (rd << 12) | 0x90 | rm);
+}
+
+/*
+ * Base at +0x400..0x7fc of RAM or of the pool (loads only), offsets up
+ * to 0x3ff either way: every access stays within the first 3 KB.
+ */
+void
+RandGen::genLdrStr()
+{
+  bool     l  = chance(50);
+  bool     b  = chance(30);
+  bool     p  = chance(70);
+  bool     w  = p && chance(30);
+  bool     u  = chance(60);
+  unsigned rn = reg();
+  unsigned rd = reg(1u << rn);
+  uint32_t offset;
+
+  if (chance(60))
+    offset = b ? rnd(0x400) : rnd(0x100) * 4;
+  else {
+    unsigned ro = reg((1u << rn) | (1u << rd));
+    unsigned sh = rnd(3);
+    uint32_t k  = rnd(256);
+
+    if (!b)
+      k &= ~(3u >> sh);
+    emit(dataProcImm(AL, OP_MOV, 0, ro, k));
+    offset = (1u << 25) | (sh << 7) | ro;
+  }
+
+  setBase(rn, ((l && chance(50)) ? POOL_BASE : RAM_BASE) + 0x400 +
+          rnd(0x100) * 4);
+  emit(ldrStr(cond(), l, b, p, u, w, rn, rd, offset));
+}
+
+void
+RandGen::genHalf()
+{
+  bool     l  = chance(50);
+  unsigned sh = l ? 1 + rnd(3) : 1;       /* H, SB, SH */
+  bool     p  = chance(70);
+  bool     w  = p && chance(30);
+  bool     u  = chance(60);
+  unsigned rn = reg();
+  unsigned rd = reg(1u << rn);
+  uint32_t offset;
+
+  if (chance(60)) {
+    uint32_t k = rnd(256) & (sh == 2 ? ~0u : ~1u);
+
+    offset = (1u << 22) | ((k >> 4) << 8) | (k & 0xf);
+  }
+  else {
+    unsigned ro = reg((1u << rn) | (1u << rd));
+
+    emit(dataProcImm(AL, OP_MOV, 0, ro, rnd(256) & (sh == 2 ? ~0u : ~1u)));
+    offset = ro;
+  }
+
+  setBase(rn, ((l && chance(50)) ? POOL_BASE : RAM_BASE) + 0x400 +
+          rnd(0x100) * 4);
+  emit((cond() << 28) | ((uint32_t)p << 24) | ((uint32_t)u << 23) |
+       ((uint32_t)w << 21) | ((uint32_t)l << 20) | (rn << 16) | (rd << 12) |
+       (1u << 7) | (sh << 5) | (1u << 4) | offset);
+}
+
+void
+RandGen::genLdmStm()
+{
+  bool     l  = chance(50);
+  bool     w  = chance(40);
+  bool     s  = !w && hasSpsr() && chance(20);
+  unsigned rn = reg();
+  unsigned list;
+
+  do
+    list = rnd(REG_MASK + 1) & ~(1u << rn);
+  while (!list);
+
+  setBase(rn, ((l && chance(50)) ? POOL_BASE : RAM_BASE) + 0x400 +
+          rnd(0x100) * 4);
+  emit(ldmStm(cond(), l, chance(50), chance(50), s, w, rn, list));
+
+  /* no banked register access right after LDM ^ */
+  if (s && l)
+    emit(NOP);
+}
+
+/* LDR/LDRB PC-relative, reads back code words */
+void
+RandGen::genLiteral()
+{
+  bool     b      = chance(20);
+  bool     u      = here() < 0x400 || chance(50);
+  uint32_t offset = b ? rnd(0x400) : rnd(0x100) * 4;
+
+  emit(ldrStr(cond(), true, b, true, u, false, 15, reg(), offset));
+}
+
+void
+RandGen::genPsr()
+{
+  static const unsigned all[7] = {
+    MODE_USR, MODE_FIQ, MODE_IRQ, MODE_SVC, MODE_ABT, MODE_UND, MODE_SYS
+  };
+  static const unsigned fields[3] = { 1, 8, 9 };
+
+  switch (rnd(5)) {
+  case 0:                                 /* MRS */
+    emit((cond() << 28) | 0x010f0000u |
+         ((uint32_t)(hasSpsr() && chance(50)) << 22) | (reg() << 12));
+    break;
+  case 1:                                 /* MSR CPSR_f */
+    emit(msr(cond(), false, 8, chance(50) ? immOperand(rnd(16) << 28)
+                                          : reg()));
+    break;
+  case 2:                                 /* MSR SPSR */
+    if (hasSpsr()) {
+      emit(msr(cond(), true, fields[rnd(3)],
+               chance(50) ? (1u << 25) | (rnd(16) << 8) | rnd(256) : reg()));
+      break;
+    }
+    /* fall through */
+  default:                                /* mode change, ignored in usr */
+    {
+      unsigned m = all[rnd(7)];
+
+      emit(msr(AL, false, 1, immOperand(0xc0 | m)));
+      if (privileged())
+        mode = m;
+    }
+    break;
+  }
+}
+
+/* forward PC writes, the skipped instructions are random fillers */
+void
+RandGen::genBranch()
+{
+  unsigned k  = rnd(4);
+  unsigned rx = reg();
+  unsigned rb = reg(1u << rx);
+  size_t   at;
+
+  switch (rnd(5)) {
+  case 0:                                 /* ADD pc,pc,#4k */
+    emit(dataProcImm(cond(), OP_ADD, 15, 15, 4 * k));
+    filler(k + 1);
+    break;
+  case 1:                                 /* B/BL */
+    emit(branch(cond(), chance(50), here(), here() + 8 + 4 * k));
+    filler(k + 1);
+    break;
+  case 2:                                 /* MOV pc,rX or BX rX */
+    at = code.size();
+    emit(dataProc(AL, OP_ADD, false, 15, rx, 0));
+    if (chance(50))
+      emit(dataProc(cond(), OP_MOV, false, 0, 15, rx));
+    else
+      emit((cond() << 28) | 0x012fff10u | rx);
+    filler(k);
+    patchAddPc(at, code.size());
+    break;
+  case 3:                                 /* LDR pc */
+    at = code.size();
+    emit(dataProc(AL, OP_ADD, false, 15, rx, 0));
+    setBase(rb, RAM_BASE + rnd(0x300) * 4);
+    emit(ldrStr(AL, false, false, true, true, false, rb, rx, 0));
+    emit(ldrStr(cond(), true, false, true, true, false, rb, 15, 0));
+    filler(k);
+    patchAddPc(at, code.size());
+    break;
+  default:                                /* LDMIA {..., pc} */
+    {
+      unsigned list = rnd(REG_MASK + 1) & ~(1u << rb);
+      unsigned n    = __builtin_popcount(list);
+
+      at = code.size();
+      emit(dataProc(AL, OP_ADD, false, 15, rx, 0));
+      setBase(rb, RAM_BASE + 0x400 + rnd(0x100) * 4);
+      emit(ldrStr(AL, false, false, true, true, false, rb, rx, 4 * n));
+      emit(ldmStm(cond(), true, false, true, false, false, rb,
+                  list | (1u << 15)));
+      filler(k);
+      patchAddPc(at, code.size());
+    }
+    break;
+  }
+}
+
+void
+RandGen::genException()
+{
+  if (chance(60)) {
+    emit((cond() << 28) | 0x0f000000u | rnd(0x1000000));
+    return;
+  }
+
+  /* undefined: coprocessor space and the media space (bit 4 set) */
+  switch (rnd(3)) {
+  case 0:  emit(0xec000000u | rnd(0x2000000)); break;
+  case 1:  emit(0xee000000u | rnd(0x1000000)); break;
+  default: emit(0xe6000010u | rnd(0x2000000)); break;
+  }
+}
@@ -0,0 +1,92 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Constrained-random ARM program generator for the differential runner
+ *    (rand_main.cpp). A program is a raw image loaded at address 0:
+ *
+ *    0x00000000  vectors, SWI and undefined instruction handlers, init
+ *                code setting every banked register and SPSR, then the
+ *                random body and the exit sequence (SIMCTL_EXIT)
+ *    0x00010000  init values and a pool of random data words
+ *    0x40000000  RAM; every store of the body lands in the first 3 KB,
+ *                the SWI handler saves registers at 0x40000F00
+ *
+ *    The body draws from every instruction class the core decodes (data
+ *    processing in all operand forms, MUL/MULL, SWP, LDR/STR, halfword
+ *    and signed loads, LDM/STM, B/BL/BX, MRS/MSR, SWI, undefined) with a
+ *    random condition code. The constraints keep the program inside
+ *    architecturally defined behaviour: aligned accesses, no PC operand in
+ *    register-specified shifts, no base written back and loaded by the
+ *    same instruction, MUL/MULL register rules, PC writes only forward,
+ *    and mode changes only through MSR CPSR_c with a constant, so the
+ *    current mode (and with it the legality of SPSR accesses and of
+ *    LDM/STM with ^) is known at generation time. IRQ and FIQ stay masked.
+ *
+ *****************************************************************************/
+#ifndef _randgen_h_
+#define _randgen_h_
+
+#include <stdint.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "memory.h"
+
+class RandGen
+{
+public:
+  static const uint32_t POOL_BASE  = 0x00010000;
+  static const uint32_t POOL_WORDS = 1024;
+  static const uint32_t RAM_BASE   = 0x40000000;
+  static const uint32_t SAVE_AREA  = 0x40000f00;
+
+  explicit RandGen(uint32_t seed);
+
+  /* build a program with 'length' random body instructions (or groups) */
+  void generate(unsigned length);
+
+  /* copy the image into 'mem' */
+  void load(SparseMemory &mem) const;
+
+  /* write the image as a raw binary (runs with arm9sim and tb.v) */
+  bool save(const std::string &path) const;
+
+  std::vector<uint32_t> code;             /* at address 0 */
+  std::vector<uint32_t> pool;             /* at POOL_BASE */
+
+private:
+  uint32_t rnd(uint32_t n) { return n ? rng() % n : 0; }
+  bool     chance(unsigned percent) { return rnd(100) < percent; }
+  uint32_t value();
+  unsigned reg(unsigned exclude = 0);
+  unsigned cond();
+  bool     privileged() const;
+  bool     hasSpsr() const;
+
+  void emit(uint32_t insn) { code.push_back(insn); }
+  uint32_t here() const { return code.size() * 4; }
+  void setBase(unsigned rb, uint32_t addr);
+  void filler(unsigned n);
+  void patchAddPc(size_t at, size_t target);
+
+  void genVectors();
+  void genInit();
+  void genExit();
+
+  void genDataProc(bool allowPc);
+  void genMul();
+  void genSwap();
+  void genLdrStr();
+  void genHalf();
+  void genLdmStm();
+  void genLiteral();
+  void genPsr();
+  void genBranch();
+  void genException();
+
+  std::mt19937 rng;
+  unsigned     mode;                      /* mode of the next instruction */
+};
+
+#endif /* _randgen_h_ */
@@ -0,0 +1,450 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Sampled simulation: the block-translating ISS (dbt.h) fast-forwards
+ *    between sample points, the Verilated RTL runs a detailed window at
+ *    each of them, and the CPI of the whole run is extrapolated from the
+ *    windows (systematic sampling, as in SMARTS).
+ *
+ *    Both models work on the testbench memory, so only the architectural
+ *    state moves: into the RTL with Testbench::setArchState() (banked
+ *    registers, CPSR, SPSRs, pc) and back with drain() and archState()
+ *    at the first instruction boundary after the window. Every sample
+ *    point is 'period' instructions after the previous one:
+ *
+ *      fast-forward | warm-up (RTL) | window (RTL, measured) | ...
+ *
+ *    Options as for arm9sim (image, +uart_log), plus
+ *
+ *      +period=<n>         instructions from one sample point to the next
+ *                          (default 1000000)
+ *      +window=<n>         measured instructions per sample (1000)
+ *      +warmup=<n>         RTL instructions before each window, to fill
+ *                          the pipeline and interlock state (200)
+ *      +skip=<n>           instructions before the first sample point (0)
+ *      +max_instr=<n>      stop after n instructions (0 = until the exit)
+ *      +confidence=<p>     90, 95 (default) or 99 percent
+ *      +csv=<file>         one row per sample
+ *
+ *    The firmware sees the serial port and the sim control block in both
+ *    models; while fast-forwarding, CYCLE advances by the running CPI
+ *    estimate (1.0 before the first window). There is no timer tick.
+ *
+ *    With +checkpoints=<dir>/checkpoints.lst (arm9iss +simpoints=, see
+ *    simpoint.cpp) there is no fast-forward and no image: every
+ *    representative interval starts from its checkpoint on the RTL, runs
+ *    its warm-up and is measured in full. The CPI of the program is the
+ *    weighted mean of the intervals' CPIs.
+ *
+ *****************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <string>
+#include <vector>
+
+#include "verilated.h"
+
+#include "checkpoint.h"
+#include "dbt.h"
+#include "plusarg.h"
+#include "testbench.h"
+
+/******************************************************************************
+ * Local functions and classes
+ *****************************************************************************/
+
+static double
+now()
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/*
+ * The ISS with the testbench's serial port and sim control block. The
+ * testbench counters follow the fast-forward: instret exactly, cycle by
+ * the CPI estimate.
+ */
+class SampleIss : public DbtIss
+{
+public:
+  SampleIss(Testbench &tb)
+    : DbtIss(tb.mem), cpi(1.0), tb(tb), issBase(0), cycleBase(0),
+      instretBase(0) {}
+
+  /* start of a fast-forward stretch */
+  void
+  begin()
+  {
+    issBase     = instret;
+    cycleBase   = tb.cycle;
+    instretBase = tb.instret;
+  }
+
+  /* bring the testbench counters up to date */
+  void
+  sync()
+  {
+    uint64_t n = instret - issBase;
+
+    tb.instret = instretBase + n;
+    tb.cycle   = cycleBase + (uint64_t)(n * cpi + 0.5);
+  }
+
+  double cpi;
+
+protected:
+  uint32_t
+  ioRead(uint32_t addr)
+  {
+    sync();
+    if (tb.serial->claims(addr))
+      return tb.serial->read(addr);
+    if (tb.simctl->claims(addr))
+      return tb.simctl->read(addr);
+    return 0;
+  }
+
+  void
+  ioWrite(uint32_t addr, uint32_t data, unsigned mask)
+  {
+    sync();
+    if (tb.serial->claims(addr)) {
+      tb.serial->write(addr, data, mask);
+      irq = tb.serial->irq();             /* TXIE, never busy here */
+    } else if (tb.simctl->claims(addr))
+      tb.simctl->write(addr, data, mask);
+    if (tb.done) {
+      halted   = true;
+      exitCode = tb.exitCode;
+    }
+  }
+
+private:
+  Testbench &tb;
+  uint64_t   issBase, cycleBase, instretBase;
+};
+
+struct Sample
+{
+  uint64_t at;                            /* instructions before the window */
+  uint32_t pc;
+  uint64_t cycles, instret;
+  double   cpi;
+};
+
+/*
+ * Detailed window on the RTL from the state in 'st'. Returns false when
+ * the program exits inside it (or the core hangs); otherwise 'st' is the
+ * state after it.
+ */
+static bool
+detailed(Testbench &tb, ArchState &st, uint64_t warmup, uint64_t window,
+         Sample &smp)
+{
+  uint64_t start, c0 = 0, i0 = 0, limit;
+  bool     measuring = false;
+
+  tb.setArchState(st);
+  start = tb.instret;
+  limit = tb.cycle + (warmup + window) * 64 + 10000;
+
+  while (!tb.done) {
+    if (tb.cycle >= limit) {
+      fprintf(stderr, "ERROR! No progress in the RTL window at %08x\n",
+              st.pc);
+      return false;
+    }
+
+    uint32_t x = tb.execPc();
+
+    if (!measuring && tb.instret - start >= warmup) {
+      measuring = true;
+      c0        = tb.cycle;
+      i0        = tb.instret;
+    }
+    /* stop at the first cycle of the next instruction */
+    if (measuring && tb.instret - i0 >= window && x != ~0u &&
+        !RTL(&tb, hold_en_dly) && !RTL(&tb, int_all)) {
+      smp.cycles  = tb.cycle - c0;
+      smp.instret = tb.instret - i0;
+      smp.cpi     = (double)smp.cycles / smp.instret;
+
+      /* the drain cycles are not part of the program */
+      uint64_t cycle = tb.cycle, instret = tb.instret;
+
+      tb.drain(x);
+      tb.archState(st);
+      st.pc      = x;
+      tb.cycle   = cycle;
+      tb.instret = instret;
+      return true;
+    }
+    tb.tick();
+  }
+  return false;
+}
+
+/* two-sided standard normal quantile */
+static double
+zValue(unsigned confidence)
+{
+  switch (confidence) {
+  case 90: return 1.645;
+  case 99: return 2.576;
+  default: return 1.960;
+  }
+}
+
+/*
+ * Representative intervals from their checkpoints. The list has a
+ * "# interval=<n> instret=<n>" header and "<file> <interval> <weight>
+ * <warmup>" lines, files relative to the list.
+ */
+static int
+simPoints(Testbench &tb, const char *list, FILE *csv)
+{
+  FILE              *f = fopen(list, "r");
+  std::string        dir(list), err;
+  unsigned long long interval = 0, total = 0, index, warmup;
+  char               name[256], line[512];
+  double             weight, sumW = 0, sumCpi = 0;
+  uint64_t           rtlInstr = 0;
+  unsigned           n = 0;
+
+  if (!f) {
+    fprintf(stderr, "ERROR! Cannot open %s\n", list);
+    return 1;
+  }
+  dir = dir.find('/') == std::string::npos ? "." :
+        dir.substr(0, dir.rfind('/'));
+
+  while (fgets(line, sizeof(line), f)) {
+    Checkpoint ck;
+    Sample     smp;
+
+    if (line[0] == '#') {
+      sscanf(line, "# interval=%llu instret=%llu", &interval, &total);
+      continue;
+    }
+    if (sscanf(line, "%255s %llu %lf %llu", name, &index, &weight,
+               &warmup) != 4)
+      continue;
+    if (interval == 0) {
+      fprintf(stderr, "ERROR! %s has no interval header\n", list);
+      fclose(f);
+      return 1;
+    }
+    if (!ck.load(dir + "/" + name, tb.mem, err)) {
+      fprintf(stderr, "ERROR! %s\n", err.c_str());
+      fclose(f);
+      return 1;
+    }
+
+    tb.reset();
+    tb.cycle   = ck.instret;
+    tb.instret = ck.instret;
+    smp.at     = ck.instret + warmup;
+    smp.pc     = ck.st.pc;
+    if (!detailed(tb, ck.st, warmup, interval, smp)) {
+      /* the program ended (or the core hung) inside the interval */
+      printf("SAMPLE: simpoint=%llu ends inside its interval, skipped\n",
+             index);
+      continue;
+    }
+    rtlInstr += tb.instret - ck.instret;
+    n++;
+    sumW     += weight;
+    sumCpi   += weight * smp.cpi;
+
+    printf("SAMPLE: simpoint=%llu weight=%.4f pc=%08x cpi=%.4f\n", index,
+           weight, smp.pc, smp.cpi);
+    if (csv)
+      fprintf(csv, "%llu,%llu,0x%08x,%llu,%llu,%.6f\n", index,
+              (unsigned long long)smp.at, smp.pc,
+              (unsigned long long)smp.cycles,
+              (unsigned long long)smp.instret, smp.cpi);
+  }
+  fclose(f);
+
+  if (n == 0 || sumW <= 0) {
+    printf("SAMPLE: no simulation point measured\n");
+    return 1;
+  }
+
+  /* the weights of the points that ran are renormalised */
+  double cpi = sumCpi / sumW;
+
+  printf("\nSAMPLE: simpoints=%u weight=%.4f detailed=%llu (%.2f%% of "
+         "%llu)\n", n, sumW, (unsigned long long)rtlInstr,
+         total ? 100.0 * rtlInstr / total : 0.0, total);
+  printf("SAMPLE: cpi=%.4f cycles=%.0f\n", cpi, cpi * total);
+  return 0;
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(int argc, char **argv)
+{
+  VerilatedContext    ctx;
+  const char         *image, *s, *ckList;
+  std::string         err;
+  uint64_t            period = 1000000, window = 1000, warmup = 200;
+  uint64_t            skip = 0, maxInstr = 0, ffInstr = 0, rtlInstr = 0;
+  unsigned            confidence = 95;
+  std::vector<Sample> samples;
+  FILE               *csv = 0;
+  double              t0, sum = 0, sumSq = 0;
+
+  ctx.commandArgs(argc, argv);
+
+  ckList = plusarg(argc, argv, "checkpoints");
+  image  = plusarg(argc, argv, "elf");
+  if (!image)
+    image = plusarg(argc, argv, "binfile");
+  for (int i = 1; !image && i < argc; i++)
+    if (argv[i][0] != '+')
+      image = argv[i];
+  if (!image && !ckList) {
+    fprintf(stderr, "WARNING! No content specified for program memory\n");
+    return 1;
+  }
+
+  Testbench tb(&ctx);
+
+  if (!ckList && !tb.loadImage(image, err)) {
+    fprintf(stderr, "ERROR! %s\n", err.c_str());
+    return 1;
+  }
+
+  if ((s = plusarg(argc, argv, "period")) != 0)
+    period = strtoull(s, 0, 0);
+  if ((s = plusarg(argc, argv, "window")) != 0)
+    window = strtoull(s, 0, 0);
+  if ((s = plusarg(argc, argv, "warmup")) != 0)
+    warmup = strtoull(s, 0, 0);
+  if ((s = plusarg(argc, argv, "skip")) != 0)
+    skip = strtoull(s, 0, 0);
+  if ((s = plusarg(argc, argv, "max_instr")) != 0)
+    maxInstr = strtoull(s, 0, 0);
+  if ((s = plusarg(argc, argv, "confidence")) != 0)
+    confidence = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "uart_log")) != 0 &&
+      !(tb.serial->log = fopen(s, "w"))) {
+    fprintf(stderr, "ERROR! Cannot open %s\n", s);
+    return 1;
+  }
+  if ((s = plusarg(argc, argv, "csv")) != 0) {
+    if (!(csv = fopen(s, "w"))) {
+      fprintf(stderr, "ERROR! Cannot open %s\n", s);
+      return 1;
+    }
+    fprintf(csv, "sample,at,pc,cycles,instret,cpi\n");
+  }
+
+  tb.timer->period = 0;
+  if (ckList) {
+    int rc = simPoints(tb, ckList, csv);
+
+    if (csv)
+      fclose(csv);
+    if (tb.serial->log)
+      fclose(tb.serial->log);
+    return rc;
+  }
+  if (window == 0 || period < warmup + window) {
+    fprintf(stderr, "ERROR! +period must cover +warmup and +window\n");
+    return 1;
+  }
+
+  tb.reset();
+
+  SampleIss iss(tb);
+
+  iss.reset();
+  if (tb.isElf && tb.elf.entry() != 0)
+    iss.st.pc = tb.elf.entry();
+
+  t0 = now();
+  for (uint64_t next = skip;;) {
+    uint64_t pos = ffInstr + rtlInstr;
+    uint64_t ff  = next > pos ? next - pos : 0;
+    Sample   smp;
+
+    if (maxInstr && pos + ff >= maxInstr)
+      ff = maxInstr - pos;
+
+    /* fast-forward */
+    iss.begin();
+    ffInstr += iss.run(ff);
+    iss.sync();
+    if (iss.halted || (maxInstr && ffInstr + rtlInstr >= maxInstr))
+      break;
+
+    /* detailed window */
+    uint64_t before = tb.instret;
+
+    smp.at = ffInstr + rtlInstr + warmup;
+    smp.pc = iss.st.pc;
+    if (!detailed(tb, iss.st, warmup, window, smp)) {
+      rtlInstr += tb.instret - before;
+      break;
+    }
+    rtlInstr += tb.instret - before;
+    iss.flush();                          /* the RTL may have written code */
+
+    samples.push_back(smp);
+    sum   += smp.cpi;
+    sumSq += smp.cpi * smp.cpi;
+    iss.cpi = sum / samples.size();
+
+    printf("SAMPLE: n=%zu at=%llu pc=%08x cpi=%.4f\n", samples.size(),
+           (unsigned long long)smp.at, smp.pc, smp.cpi);
+    if (csv)
+      fprintf(csv, "%zu,%llu,0x%08x,%llu,%llu,%.6f\n", samples.size(),
+              (unsigned long long)smp.at, smp.pc,
+              (unsigned long long)smp.cycles,
+              (unsigned long long)smp.instret, smp.cpi);
+    next += period;
+  }
+
+  /* mean CPI and its confidence interval (normal approximation) */
+  uint64_t total = ffInstr + rtlInstr;
+  size_t   n     = samples.size();
+  double   mean  = n ? sum / n : 0;
+  double   var   = n > 1 ? (sumSq - n * mean * mean) / (n - 1) : 0;
+  double   half  = n > 1 ? zValue(confidence) * sqrt(var > 0 ? var : 0) /
+                           sqrt((double)n) : 0;
+
+  printf("\nSAMPLE: instret=%llu fast_forward=%llu detailed=%llu "
+         "(%.2f%%) exit=%s\n", (unsigned long long)total,
+         (unsigned long long)ffInstr, (unsigned long long)rtlInstr,
+         total ? 100.0 * rtlInstr / total : 0.0,
+         iss.halted || tb.done ? "yes" : "no");
+  if (n) {
+    printf("SAMPLE: samples=%zu cpi=%.4f +/- %.4f (%u%%, %.2f%%) "
+           "cycles=%.0f +/- %.0f\n", n, mean, half, confidence,
+           mean ? 100.0 * half / mean : 0.0, mean * total, half * total);
+    /* samples for +/-3% at the same confidence */
+    if (n > 1 && mean > 0)
+      printf("SAMPLE: cv=%.3f, %.0f samples for +/-3%%\n",
+             sqrt(var) / mean,
+             ceil(pow(zValue(confidence) * sqrt(var) / mean / 0.03, 2)));
+  }
+  else
+    printf("SAMPLE: no sample point reached; lower +skip or +period\n");
+  fprintf(stderr, "SAMPLE: %.2f s host time\n", now() - t0);
+
+  if (csv)
+    fclose(csv);
+  if (tb.serial->log)
+    fclose(tb.serial->log);
+  return iss.halted ? iss.exitCode : tb.exitCode;
+}
@@ -0,0 +1,216 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Verilator simulation of the core. Options follow the tb.v plusargs:
+ *
+ *      +binfile=<file>     raw image at address 0
+ *      +elf=<file>         ELF image (PT_LOAD segments, entry point)
+ *      <file>              either of the above, by file magic
+ *      +max_cycles=<n>     stop after n cycles (0 = run forever)
+ *      +uart_log=<file>    copy of the serial output
+ *      +irq_period=<n>     timer tick period in cycles (0 = no tick)
+ *      +serial_cycles=<n>  serial transmitter busy time per character
+ *                          (0 = never busy, the default)
+ *      +symbols            print the ELF symbol table and exit
+ *
+ *    Waveform capture (wave.h):
+ *
+ *      +wave=<prefix>      FST segments <prefix>-<n>.fst
+ *      +wave_window=<n>    ring segment length in cycles (default 10000)
+ *      +wave_post=<n>      capture length when no stop trigger fires
+ *      +wave_start_pc=<a>  start when the instruction at <a> executes
+ *      +wave_stop_pc=<a>   stop when the instruction at <a> executes
+ *      +wave_from=<n>      start at cycle n
+ *      +wave_to=<n>        stop at cycle n
+ *      +wave_exception     start on exception entry (int_all)
+ *
+ *    The firmware can start/stop a capture with SIMCTL_WAVE.
+ *
+ *      +cov=<file>         functional coverage (coverage.h) into <file>
+ *      +addr_trace=<file>  instruction and data address trace
+ *                          (addr_trace.h) for memdse
+ *
+ *    Switching activity (activity.h):
+ *
+ *      +activity           toggle counts per block, printed at the end
+ *      +activity_marks     count only from MARK 1 to MARK 2
+ *      +saif=<file>        per-bit SAIF export (implies +activity)
+ *      +saif_period=<ns>   clock period for the SAIF times (1000, tb.v)
+ *      +saif_instance=<p>  hierarchy of the core in the power tool
+ *                          (default arm9_compatiable_code)
+ *
+ *    LPC2xxx peripherals (lpc_periph.h):
+ *
+ *      +lpc                Timer0/1, UART0, I2C0 with an LM75, VIC and
+ *                          VPBDIV models; the timer tick is off unless
+ *                          +irq_period is given. Prints interrupt latency,
+ *                          UART and I2C statistics.
+ *      +uart0_in=<file>    UART0 receive data, at the line rate
+ *      +lm75_count=<n>     LM75s on I2C0, at 0x90, 0x92, ... (1 to 8)
+ *      +lm75_temp=<C>      temperature the first LM75 reads (default 25),
+ *                          each further one reads 1 C more
+ *
+ *      +gdb=<port>         wait for GDB on localhost:<port> (gdb_stub.h),
+ *                          the core is halted at the reset vector or the
+ *                          ELF entry point
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "verilated.h"
+
+#include "gdb_stub.h"
+#include "lpc_periph.h"
+#include "plusarg.h"
+#include "testbench.h"
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(int argc, char **argv)
+{
+  VerilatedContext ctx;
+  const char      *image, *s;
+  std::string      err;
+  uint64_t         maxCycles = 0;
+  LpcPeripherals  *lpc = 0;
+
+  ctx.commandArgs(argc, argv);
+
+  image = plusarg(argc, argv, "elf");
+  if (!image)
+    image = plusarg(argc, argv, "binfile");
+  for (int i = 1; !image && i < argc; i++)
+    if (argv[i][0] != '+')
+      image = argv[i];
+  if (!image) {
+    fprintf(stderr, "WARNING! No content specified for program memory\n");
+    return 1;
+  }
+
+  Testbench tb(&ctx);
+
+  if (!tb.loadImage(image, err)) {
+    fprintf(stderr, "ERROR! %s\n", err.c_str());
+    return 1;
+  }
+  if (tb.isElf) {
+    tb.elf.printSummary(stderr);
+    if (plusflag(argc, argv, "symbols")) {
+      tb.elf.printSymbols(stdout);
+      return 0;
+    }
+  }
+
+  if (plusflag(argc, argv, "lpc")) {
+    lpc = new LpcPeripherals(tb);
+    tb.timer->period = 0;
+    if ((s = plusarg(argc, argv, "uart0_in")) != 0 &&
+        !(lpc->uart0->rx = fopen(s, "rb"))) {
+      fprintf(stderr, "ERROR! Cannot open %s\n", s);
+      return 1;
+    }
+    if ((s = plusarg(argc, argv, "lm75_count")) != 0)
+      for (unsigned i = 1; i < strtoul(s, 0, 0) && i < 8; i++)
+        lpc->addLm75(0x90 + 2 * i);
+    if ((s = plusarg(argc, argv, "lm75_temp")) != 0)
+      for (size_t i = 0; i < lpc->lm75.size(); i++)
+        lpc->lm75[i]->celsius = strtod(s, 0) + i;
+  }
+
+  if ((s = plusarg(argc, argv, "max_cycles")) != 0)
+    maxCycles = strtoull(s, 0, 0);
+  if ((s = plusarg(argc, argv, "irq_period")) != 0)
+    tb.timer->period = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "serial_cycles")) != 0)
+    tb.serial->charCycles = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "uart_log")) != 0) {
+    tb.serial->log = fopen(s, "w");
+    if (!tb.serial->log) {
+      fprintf(stderr, "ERROR! Cannot open %s\n", s);
+      return 1;
+    }
+    if (lpc)
+      lpc->uart0->log = tb.serial->log;
+  }
+
+  if ((s = plusarg(argc, argv, "wave")) != 0) {
+    tb.wave = new Wave(&tb);
+    if (!tb.wave->open(s)) {
+      fprintf(stderr, "ERROR! Built without waveform support (WAVES=0)\n");
+      return 1;
+    }
+    if ((s = plusarg(argc, argv, "wave_window")) != 0)
+      tb.wave->window = strtoull(s, 0, 0);
+    if ((s = plusarg(argc, argv, "wave_post")) != 0)
+      tb.wave->post = strtoull(s, 0, 0);
+    if ((s = plusarg(argc, argv, "wave_start_pc")) != 0)
+      tb.wave->startPc = strtoul(s, 0, 16);
+    if ((s = plusarg(argc, argv, "wave_stop_pc")) != 0)
+      tb.wave->stopPc = strtoul(s, 0, 16);
+    if ((s = plusarg(argc, argv, "wave_from")) != 0)
+      tb.wave->fromCycle = strtoull(s, 0, 0);
+    if ((s = plusarg(argc, argv, "wave_to")) != 0)
+      tb.wave->toCycle = strtoull(s, 0, 0);
+    tb.wave->onException = plusflag(argc, argv, "wave_exception");
+  }
+
+  if (plusarg(argc, argv, "cov"))
+    tb.cov = new Coverage(&tb);
+  if ((s = plusarg(argc, argv, "addr_trace")) != 0) {
+    tb.atrace = new AddrTrace;
+    if (!tb.atrace->open(s)) {
+      fprintf(stderr, "ERROR! Cannot open %s\n", s);
+      return 1;
+    }
+  }
+
+  if (plusflag(argc, argv, "activity") || plusarg(argc, argv, "saif")) {
+    tb.act = new Activity(&tb);
+    tb.act->onMarks = plusflag(argc, argv, "activity_marks");
+  }
+
+  tb.reset();
+  if ((s = plusarg(argc, argv, "gdb")) != 0) {
+    GdbStub gdb(&tb);
+
+    if (!gdb.listen(strtoul(s, 0, 0))) {
+      fprintf(stderr, "ERROR! Cannot listen on port %s\n", s);
+      return 1;
+    }
+    /* after a detach the program runs on */
+    if (gdb.serve())
+      tb.run(maxCycles);
+  }
+  else
+    tb.run(maxCycles);
+
+  printf("\nSIM: cycles=%llu instret=%llu\n", (unsigned long long)tb.cycle,
+         (unsigned long long)tb.instret);
+  if (lpc) {
+    lpc->report(stdout);
+    delete lpc;
+  }
+  if (tb.act) {
+    tb.act->write(stdout);
+    if ((s = plusarg(argc, argv, "saif")) != 0) {
+      const char *period   = plusarg(argc, argv, "saif_period");
+      const char *instance = plusarg(argc, argv, "saif_instance");
+
+      if (!tb.act->writeSaif(s, period ? strtod(period, 0) : 1000.0,
+                             instance ? instance : "arm9_compatiable_code"))
+        fprintf(stderr, "ERROR! Cannot write %s\n", s);
+    }
+  }
+  if (tb.atrace)
+    tb.atrace->close(tb.cycle, tb.instret);
+  if (tb.cov && !tb.cov->write(plusarg(argc, argv, "cov")))
+    fprintf(stderr, "ERROR! Cannot write %s\n", plusarg(argc, argv, "cov"));
+  if (tb.serial->log)
+    fclose(tb.serial->log);
+  return tb.exitCode;
+}
@@ -0,0 +1,355 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Representative-region selection from basic-block vectors (arm9iss
+ *    +bbv=, bbv.h), following SimPoint 3:
+ *
+ *      - each interval's vector is normalised to a sum of 1 and projected
+ *        to a few dimensions with a fixed random matrix
+ *      - k-means for every k up to +maxk, best of several seeds each
+ *      - the Bayesian information criterion (BIC) of each clustering; the
+ *        smallest k that reaches +bic of the way from the worst to the
+ *        best score wins
+ *      - per cluster, the interval closest to the centroid represents it,
+ *        weighted by the cluster's share of the instructions
+ *
+ *      simpoint [options] <file.bb>
+ *
+ *      +maxk=<n>           largest number of clusters (10)
+ *      +dim=<n>            projected dimensions (15)
+ *      +inits=<n>          k-means seeds per k (5)
+ *      +seed=<n>           random seed (1)
+ *      +bic=<t>            BIC threshold (0.9)
+ *      +simpoints=<file>   "<interval> <cluster>" per point
+ *                          (default <file.bb>.simpoints)
+ *      +weights=<file>     "<weight> <cluster>" per point
+ *                          (default <file.bb>.weights)
+ *
+ *    Both outputs are in the SimPoint 3 format, for arm9iss +simpoints=
+ *    +weights= to write the checkpoints. Interval numbers start at 0.
+ *
+ *****************************************************************************/
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "plusarg.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+typedef std::vector<double> Vec;
+
+struct Interval
+{
+  std::vector<std::pair<uint32_t, double> > bbv;   /* id, share */
+  uint64_t                                  instr;
+  Vec                                       x;     /* projected */
+};
+
+struct Clustering
+{
+  unsigned              k;
+  std::vector<unsigned> member;           /* cluster of each interval */
+  std::vector<Vec>      centre;
+  double                distortion;       /* sum of squared distances */
+  double                bic;
+};
+
+/******************************************************************************
+ * Local functions
+ *****************************************************************************/
+
+/* "T:id:count :id:count ..." lines */
+static bool
+loadBbv(const char *path, std::vector<Interval> &iv)
+{
+  FILE *f = fopen(path, "r");
+  char *line = 0;
+  size_t cap = 0;
+
+  if (!f)
+    return false;
+
+  while (getline(&line, &cap, f) > 0) {
+    Interval     t;
+    char        *p = line;
+    unsigned     id;
+    unsigned long long n;
+    int          used;
+
+    if (*p != 'T')
+      continue;
+    p++;
+    t.instr = 0;
+    while (sscanf(p, " :%u:%llu%n", &id, &n, &used) == 2) {
+      t.bbv.push_back(std::make_pair((uint32_t)id, (double)n));
+      t.instr += n;
+      p += used;
+    }
+    if (t.instr == 0)
+      continue;
+    for (size_t i = 0; i < t.bbv.size(); i++)
+      t.bbv[i].second /= t.instr;
+    iv.push_back(t);
+  }
+  free(line);
+  fclose(f);
+  return !iv.empty();
+}
+
+/* entry (id, j) of the projection matrix, uniform in [-1, 1) */
+static double
+projection(uint32_t id, unsigned j, uint32_t seed)
+{
+  uint64_t h = ((uint64_t)id << 32 | j) ^ ((uint64_t)seed << 17);
+
+  /* splitmix64 */
+  h += 0x9e3779b97f4a7c15ull;
+  h  = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+  h  = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return (h >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+static double
+dist2(const Vec &a, const Vec &b)
+{
+  double d = 0;
+
+  for (size_t i = 0; i < a.size(); i++)
+    d += (a[i] - b[i]) * (a[i] - b[i]);
+  return d;
+}
+
+static void
+kmeans(const std::vector<Interval> &iv, unsigned k, std::mt19937 &rng,
+       Clustering &c)
+{
+  size_t   n   = iv.size();
+  unsigned dim = iv[0].x.size();
+
+  c.k = k;
+  c.member.assign(n, 0);
+  c.centre.clear();
+
+  /* furthest-first from a random interval */
+  std::vector<double> d(n, DBL_MAX);
+
+  c.centre.push_back(iv[rng() % n].x);
+  while (c.centre.size() < k) {
+    size_t far = 0;
+
+    for (size_t i = 0; i < n; i++) {
+      d[i] = std::min(d[i], dist2(iv[i].x, c.centre.back()));
+      if (d[i] > d[far])
+        far = i;
+    }
+    c.centre.push_back(iv[far].x);
+  }
+
+  for (unsigned iter = 0; iter < 100; iter++) {
+    bool changed = false;
+
+    for (size_t i = 0; i < n; i++) {
+      unsigned best = 0;
+      double   bd   = DBL_MAX;
+
+      for (unsigned j = 0; j < k; j++) {
+        double dd = dist2(iv[i].x, c.centre[j]);
+
+        if (dd < bd) {
+          bd   = dd;
+          best = j;
+        }
+      }
+      if (iter == 0 || c.member[i] != best)
+        changed = true;
+      c.member[i] = best;
+    }
+    if (!changed)
+      break;
+
+    std::vector<unsigned> size(k, 0);
+
+    for (unsigned j = 0; j < k; j++)
+      c.centre[j].assign(dim, 0);
+    for (size_t i = 0; i < n; i++) {
+      size[c.member[i]]++;
+      for (unsigned m = 0; m < dim; m++)
+        c.centre[c.member[i]][m] += iv[i].x[m];
+    }
+    for (unsigned j = 0; j < k; j++)
+      for (unsigned m = 0; m < dim; m++)
+        c.centre[j][m] = size[j] ? c.centre[j][m] / size[j] : 0;
+  }
+
+  c.distortion = 0;
+  for (size_t i = 0; i < n; i++)
+    c.distortion += dist2(iv[i].x, c.centre[c.member[i]]);
+}
+
+/* BIC of a spherical Gaussian mixture (Pelleg and Moore, X-means) */
+static double
+bic(const Clustering &c, size_t n, unsigned dim)
+{
+  std::vector<unsigned> size(c.k, 0);
+  double                var, l = 0;
+
+  for (size_t i = 0; i < n; i++)
+    size[c.member[i]]++;
+
+  var = n > c.k ? c.distortion / (n - c.k) : 0;
+  if (var < 1e-12)
+    var = 1e-12;
+
+  for (unsigned j = 0; j < c.k; j++)
+    if (size[j])
+      l += size[j] * log((double)size[j]) - size[j] * log((double)n);
+  l -= 0.5 * n * dim * log(2 * M_PI * var) + 0.5 * dim * (n - c.k);
+
+  double params = (c.k - 1) + dim * c.k + 1;
+
+  return l - 0.5 * params * log((double)n);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(int argc, char **argv)
+{
+  std::vector<Interval>   iv;
+  std::vector<Clustering> runs;
+  const char             *bbFile = 0, *s;
+  unsigned                maxK = 10, dim = 15, inits = 5, seed = 1;
+  double                  threshold = 0.9, lo = DBL_MAX, hi = -DBL_MAX;
+  uint64_t                total = 0;
+  uint32_t                blocks = 0;
+  std::string             spFile, wFile;
+
+  for (int i = 1; !bbFile && i < argc; i++)
+    if (argv[i][0] != '+')
+      bbFile = argv[i];
+  if (!bbFile) {
+    fprintf(stderr, "usage: simpoint [+option=value ...] <file.bb>\n");
+    return 2;
+  }
+  if (!loadBbv(bbFile, iv)) {
+    fprintf(stderr, "ERROR! %s has no basic-block vectors\n", bbFile);
+    return 1;
+  }
+
+  if ((s = plusarg(argc, argv, "maxk")) != 0)
+    maxK = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "dim")) != 0)
+    dim = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "inits")) != 0)
+    inits = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "seed")) != 0)
+    seed = strtoul(s, 0, 0);
+  if ((s = plusarg(argc, argv, "bic")) != 0)
+    threshold = strtod(s, 0);
+  spFile = (s = plusarg(argc, argv, "simpoints")) != 0 ? s :
+           std::string(bbFile) + ".simpoints";
+  wFile  = (s = plusarg(argc, argv, "weights")) != 0 ? s :
+           std::string(bbFile) + ".weights";
+  if (maxK == 0 || dim == 0 || inits == 0) {
+    fprintf(stderr, "ERROR! +maxk, +dim and +inits must not be 0\n");
+    return 1;
+  }
+  if (maxK > iv.size())
+    maxK = iv.size();
+
+  /* random projection */
+  for (size_t i = 0; i < iv.size(); i++) {
+    iv[i].x.assign(dim, 0);
+    for (size_t b = 0; b < iv[i].bbv.size(); b++) {
+      uint32_t id = iv[i].bbv[b].first;
+
+      blocks = std::max(blocks, id);
+      for (unsigned j = 0; j < dim; j++)
+        iv[i].x[j] += iv[i].bbv[b].second * projection(id, j, seed);
+    }
+    total += iv[i].instr;
+  }
+  printf("SIMPOINT: intervals=%zu blocks=%u instructions=%llu dim=%u\n",
+         iv.size(), blocks, (unsigned long long)total, dim);
+
+  /* k-means and BIC for each k */
+  std::mt19937 rng(seed);
+
+  for (unsigned k = 1; k <= maxK; k++) {
+    Clustering best;
+
+    best.distortion = DBL_MAX;
+    for (unsigned r = 0; r < inits; r++) {
+      Clustering c;
+
+      kmeans(iv, k, rng, c);
+      if (c.distortion < best.distortion)
+        best = c;
+    }
+    best.bic = bic(best, iv.size(), dim);
+    lo       = std::min(lo, best.bic);
+    hi       = std::max(hi, best.bic);
+    printf("SIMPOINT: k=%u bic=%.1f distortion=%.6f\n", k, best.bic,
+           best.distortion);
+    runs.push_back(best);
+  }
+
+  size_t pick = 0;
+
+  while (pick + 1 < runs.size() &&
+         runs[pick].bic < lo + threshold * (hi - lo))
+    pick++;
+
+  const Clustering &c = runs[pick];
+
+  /* representatives and weights */
+  FILE *sp = fopen(spFile.c_str(), "w");
+  FILE *w  = fopen(wFile.c_str(), "w");
+
+  if (!sp || !w) {
+    fprintf(stderr, "ERROR! Cannot create %s\n",
+            !sp ? spFile.c_str() : wFile.c_str());
+    return 1;
+  }
+
+  printf("SIMPOINT: chose k=%u\n", c.k);
+  for (unsigned j = 0; j < c.k; j++) {
+    size_t   rep = iv.size();
+    double   bd  = DBL_MAX;
+    uint64_t instr = 0;
+    unsigned size  = 0;
+
+    for (size_t i = 0; i < iv.size(); i++)
+      if (c.member[i] == j) {
+        double d = dist2(iv[i].x, c.centre[j]);
+
+        size++;
+        instr += iv[i].instr;
+        if (d < bd) {
+          bd  = d;
+          rep = i;
+        }
+      }
+    if (rep == iv.size())
+      continue;                           /* empty cluster */
+
+    fprintf(sp, "%zu %u\n", rep, j);
+    fprintf(w, "%.6f %u\n", (double)instr / total, j);
+    printf("SIMPOINT: cluster=%u interval=%zu weight=%.4f intervals=%u\n",
+           j, rep, (double)instr / total, size);
+  }
+  fclose(sp);
+  fclose(w);
+  printf("SIMPOINT: wrote %s and %s\n", spFile.c_str(), wFile.c_str());
+  return 0;
+}
@@ -0,0 +1,78 @@
+#!/bin/bash
+#
+# Representative-region (SimPoint) characterisation of a long run
+#
+# Profiles basic-block vectors on the ISS (arm9iss +bbv=), clusters the
+# intervals (simpoint), writes a checkpoint at each representative
+# interval (arm9iss +simpoints=) and runs those on the RTL (arm9sample
+# +checkpoints=) for the weighted CPI.
+#
+# usage: sim/simpoint.sh [options] <image> [-- simpoint options]
+#
+#   -o <dir>     output directory (default: sim/simpoint_out/<image name>)
+#   -i <n>       interval length in instructions (default 100000)
+#   -w <n>       warm-up instructions before each interval (default 1000)
+#   -m <n>       stop the profile after n instructions (default: the exit)
+#   -n           no RTL: stop after writing the checkpoints
+#
+# Writes <dir>/bbv.bb (+ .map, .simpoints, .weights), the checkpoints
+# and checkpoints.lst, and <dir>/summary.txt. Options after -- go to
+# simpoint, e.g.
+#
+#   sim/simpoint.sh -i 50000 soak.elf -- +maxk=20
+#
+
+set -o pipefail
+SIM_DIR=$(cd "$(dirname "$0")" && pwd)
+
+OUT=""
+INTERVAL=100000
+WARMUP=1000
+MAX=0
+RTL=1
+
+while getopts "o:i:w:m:n" opt; do
+  case $opt in
+    o) OUT=$OPTARG ;;
+    i) INTERVAL=$OPTARG ;;
+    w) WARMUP=$OPTARG ;;
+    m) MAX=$OPTARG ;;
+    n) RTL=0 ;;
+    *) sed -n '3,22p' "$0"; exit 2 ;;
+  esac
+done
+shift $((OPTIND - 1))
+
+IMAGE=$1
+[ -n "$IMAGE" ] || { sed -n '3,22p' "$0"; exit 2; }
+shift
+[ "$1" = "--" ] && shift
+[ -f "$IMAGE" ] || { echo "no image $IMAGE"; exit 1; }
+IMAGE=$(cd "$(dirname "$IMAGE")" && pwd)/$(basename "$IMAGE")
+[ -n "$OUT" ] || OUT=$SIM_DIR/simpoint_out/$(basename "${IMAGE%.*}")
+
+mkdir -p "$OUT"
+make -s -C "$SIM_DIR" arm9iss simpoint || exit 1
+[ $RTL -eq 1 ] && { make -s -C "$SIM_DIR" sample || exit 1; }
+
+echo "PROFILE $IMAGE"
+"$SIM_DIR/arm9iss" "$IMAGE" +interval="$INTERVAL" +max_instr="$MAX" \
+  +bbv="$OUT/bbv.bb" > "$OUT/profile.txt" 2>&1
+[ -s "$OUT/bbv.bb" ] || { echo "no profile, see $OUT/profile.txt"; exit 1; }
+
+echo "CLUSTER"
+"$SIM_DIR/simpoint" "$@" "$OUT/bbv.bb" | tee "$OUT/summary.txt" || exit 1
+
+echo "CHECKPOINT"
+"$SIM_DIR/arm9iss" "$IMAGE" +interval="$INTERVAL" +max_instr="$MAX" \
+  +warmup="$WARMUP" +simpoints="$OUT/bbv.bb.simpoints" \
+  +weights="$OUT/bbv.bb.weights" +checkpoint_dir="$OUT" \
+  > "$OUT/checkpoint.txt" 2>&1
+grep '^SIM: checkpoints' "$OUT/checkpoint.txt" | tee -a "$OUT/summary.txt" ||
+  { echo "no checkpoints, see $OUT/checkpoint.txt"; exit 1; }
+
+if [ $RTL -eq 1 ]; then
+  echo "RTL"
+  "$SIM_DIR/arm9sample" +checkpoints="$OUT/checkpoints.lst" \
+    +csv="$OUT/simpoints.csv" | grep '^SAMPLE' | tee -a "$OUT/summary.txt"
+fi
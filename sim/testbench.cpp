@@ -0,0 +1,336 @@
+/******************************************************************************
+ *
+ * Description:
+ *    C++ testbench around the Verilated core
+ *
+ *****************************************************************************/
+#include "testbench.h"
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+Testbench::Testbench(VerilatedContext *ctx)
+  : isElf(false), wave(0), cov(0), atrace(0), act(0), cycle(0), instret(0), done(false), exitCode(0), romData(0), ramRdata(0)
+{
+  top = new Varm9_compatiable_code(ctx);
+
+  top->clk         = 0;
+  top->rst         = 1;
+  top->cpu_en      = 1;
+  top->cpu_restart = 0;
+  top->fiq         = 0;
+  top->irq         = 0;
+  top->ram_abort   = 0;
+  top->rom_abort   = 0;
+  top->ram_rdata   = 0;
+  top->rom_data    = 0;
+
+  serial = new SerialPort;
+  timer  = new TickTimer(this);
+  simctl = new SimControl(this);
+  attach(serial);
+  attach(timer);
+  attach(simctl);
+}
+
+Testbench::~Testbench()
+{
+  delete wave;
+  delete cov;
+  delete atrace;
+  delete act;
+  top->final();
+  for (size_t i = 0; i < devices.size(); i++)
+    delete devices[i];
+  delete top;
+}
+
+bool
+Testbench::loadImage(const std::string &path, std::string &err)
+{
+  isElf = isElfFile(path);
+  if (isElf)
+    return elf.load(path, mem, err);
+  return loadBinary(path, 0, mem, err);
+}
+
+void
+Testbench::attach(Device *dev)
+{
+  devices.push_back(dev);
+}
+
+void
+Testbench::reset()
+{
+  top->rst = 1;
+  top->clk = 0;
+  top->eval();
+  top->clk = 1;
+  top->eval();
+  top->clk = 0;
+  top->eval();
+  top->rst = 0;
+  top->eval();
+
+  cycle    = 0;
+  instret  = 0;
+  done     = false;
+  exitCode = 0;
+
+  /* images linked to run elsewhere than the reset vector */
+  if (isElf && elf.entry() != 0)
+    setPc(elf.entry());
+}
+
+void
+Testbench::setPc(uint32_t pc)
+{
+  RTL(this, rf)        = pc;
+  RTL(this, cmd_flag)  = 0;
+  RTL(this, code_flag) = 0;
+  top->eval();
+}
+
+void
+Testbench::tick()
+{
+  /* last execute cycle of an instruction not flushed by an exception */
+  if (RTL(this, cmd_flag) && !RTL(this, int_all) && !RTL(this, hold_en))
+    instret++;
+  if (cov)
+    cov->sample();
+
+  /* requests the core presents in this cycle */
+  uint32_t nextRom = romData;
+  uint32_t nextRam = ramRdata;
+
+  if (top->rom_en) {
+    nextRom = mem.read32(top->rom_addr & ~3u);
+    if (atrace)
+      atrace->record(cycle, TRACE_FETCH, top->rom_addr & ~3u, 0xf);
+  }
+
+  if (top->ram_cen) {
+    if (atrace)
+      atrace->record(cycle, top->ram_wen ? TRACE_STORE : TRACE_LOAD,
+                     top->ram_addr, top->ram_flag);
+    if (top->ram_wen)
+      busWrite(top->ram_addr, top->ram_wdata, top->ram_flag);
+    else
+      nextRam = busRead(top->ram_addr);
+  }
+
+  /* clock edge: the core samples the previous memory outputs */
+  top->clk = 1;
+  top->eval();
+
+  romData  = nextRom;
+  ramRdata = nextRam;
+
+  bool irq = false, fiq = false;
+  for (size_t i = 0; i < devices.size(); i++) {
+    devices[i]->tick();
+    irq |= devices[i]->irq();
+    fiq |= devices[i]->fiq();
+  }
+
+  top->rom_data  = romData;
+  top->ram_rdata = ramRdata;
+  top->irq       = irq;
+  top->fiq       = fiq;
+  top->eval();
+  if (act)
+    act->sample();
+  if (wave)
+    wave->dump(true);
+
+  top->clk = 0;
+  top->eval();
+  if (wave)
+    wave->dump(false);
+
+  cycle++;
+}
+
+void
+Testbench::run(uint64_t maxCycles)
+{
+  while (!done && (maxCycles == 0 || cycle < maxCycles))
+    tick();
+}
+
+/* the core keeps status registers as {n,z,c,v,i,f,m[4:0]} */
+static uint32_t
+toPsr(uint32_t v)
+{
+  return ((v & 0x780) << 21) | ((v & 0x60) << 1) | (v & 0x1f);
+}
+
+void
+Testbench::archState(ArchState &st)
+{
+  st.r[0]   = RTL(this, r0);
+  st.r[1]   = RTL(this, r1);
+  st.r[2]   = RTL(this, r2);
+  st.r[3]   = RTL(this, r3);
+  st.r[4]   = RTL(this, r4);
+  st.r[5]   = RTL(this, r5);
+  st.r[6]   = RTL(this, r6);
+  st.r[7]   = RTL(this, r7);
+
+  st.usr[0] = RTL(this, r8_usr);
+  st.usr[1] = RTL(this, r9_usr);
+  st.usr[2] = RTL(this, ra_usr);
+  st.usr[3] = RTL(this, rb_usr);
+  st.usr[4] = RTL(this, rc_usr);
+  st.usr[5] = RTL(this, rd_usr);
+  st.usr[6] = RTL(this, re_usr);
+
+  st.fiq[0] = RTL(this, r8_fiq);
+  st.fiq[1] = RTL(this, r9_fiq);
+  st.fiq[2] = RTL(this, ra_fiq);
+  st.fiq[3] = RTL(this, rb_fiq);
+  st.fiq[4] = RTL(this, rc_fiq);
+  st.fiq[5] = RTL(this, rd_fiq);
+  st.fiq[6] = RTL(this, re_fiq);
+
+  st.irq[0] = RTL(this, rd_irq);
+  st.irq[1] = RTL(this, re_irq);
+  st.svc[0] = RTL(this, rd_svc);
+  st.svc[1] = RTL(this, re_svc);
+  st.abt[0] = RTL(this, rd_abt);
+  st.abt[1] = RTL(this, re_abt);
+  st.und[0] = RTL(this, rd_und);
+  st.und[1] = RTL(this, re_und);
+
+  st.cpsr    = ((uint32_t)RTL(this, cpsr_n) << 31) |
+               ((uint32_t)RTL(this, cpsr_z) << 30) |
+               ((uint32_t)RTL(this, cpsr_c) << 29) |
+               ((uint32_t)RTL(this, cpsr_v) << 28) |
+               ((uint32_t)RTL(this, cpsr_i) << 7) |
+               ((uint32_t)RTL(this, cpsr_f) << 6) |
+               RTL(this, cpsr_m);
+  st.spsrFiq = toPsr(RTL(this, spsr_fiq));
+  st.spsrIrq = toPsr(RTL(this, spsr_irq));
+  st.spsrSvc = toPsr(RTL(this, spsr_svc));
+  st.spsrAbt = toPsr(RTL(this, spsr_abt));
+  st.spsrUnd = toPsr(RTL(this, spsr_und));
+
+  /* fetch address minus the instructions in flight */
+  st.pc      = RTL(this, rf) - (RTL(this, cmd_flag) ? 8 :
+                                RTL(this, code_flag) ? 4 : 0);
+}
+
+static uint32_t
+fromPsr(uint32_t v)
+{
+  return ((v >> 21) & 0x780) | ((v >> 1) & 0x60) | (v & 0x1f);
+}
+
+void
+Testbench::setArchState(const ArchState &st)
+{
+  RTL(this, r0)     = st.r[0];
+  RTL(this, r1)     = st.r[1];
+  RTL(this, r2)     = st.r[2];
+  RTL(this, r3)     = st.r[3];
+  RTL(this, r4)     = st.r[4];
+  RTL(this, r5)     = st.r[5];
+  RTL(this, r6)     = st.r[6];
+  RTL(this, r7)     = st.r[7];
+
+  RTL(this, r8_usr) = st.usr[0];
+  RTL(this, r9_usr) = st.usr[1];
+  RTL(this, ra_usr) = st.usr[2];
+  RTL(this, rb_usr) = st.usr[3];
+  RTL(this, rc_usr) = st.usr[4];
+  RTL(this, rd_usr) = st.usr[5];
+  RTL(this, re_usr) = st.usr[6];
+
+  RTL(this, r8_fiq) = st.fiq[0];
+  RTL(this, r9_fiq) = st.fiq[1];
+  RTL(this, ra_fiq) = st.fiq[2];
+  RTL(this, rb_fiq) = st.fiq[3];
+  RTL(this, rc_fiq) = st.fiq[4];
+  RTL(this, rd_fiq) = st.fiq[5];
+  RTL(this, re_fiq) = st.fiq[6];
+
+  RTL(this, rd_irq) = st.irq[0];
+  RTL(this, re_irq) = st.irq[1];
+  RTL(this, rd_svc) = st.svc[0];
+  RTL(this, re_svc) = st.svc[1];
+  RTL(this, rd_abt) = st.abt[0];
+  RTL(this, re_abt) = st.abt[1];
+  RTL(this, rd_und) = st.und[0];
+  RTL(this, re_und) = st.und[1];
+
+  RTL(this, cpsr_n) = (st.cpsr >> 31) & 1;
+  RTL(this, cpsr_z) = (st.cpsr >> 30) & 1;
+  RTL(this, cpsr_c) = (st.cpsr >> 29) & 1;
+  RTL(this, cpsr_v) = (st.cpsr >> 28) & 1;
+  RTL(this, cpsr_i) = (st.cpsr >> 7) & 1;
+  RTL(this, cpsr_f) = (st.cpsr >> 6) & 1;
+  RTL(this, cpsr_m) = st.cpsr & 0x1f;
+
+  RTL(this, spsr_fiq) = fromPsr(st.spsrFiq);
+  RTL(this, spsr_irq) = fromPsr(st.spsrIrq);
+  RTL(this, spsr_svc) = fromPsr(st.spsrSvc);
+  RTL(this, spsr_abt) = fromPsr(st.spsrAbt);
+  RTL(this, spsr_und) = fromPsr(st.spsrUnd);
+
+  setPc(st.pc);
+}
+
+void
+Testbench::drain(uint32_t pc)
+{
+  for (int i = 0; i < 4; i++) {
+    setPc(pc);
+    if (!RTL(this, go_vld) && !RTL(this, cha_vld) && !RTL(this, ldm_vld))
+      return;
+    tick();
+  }
+  setPc(pc);
+}
+
+uint32_t
+Testbench::execPc()
+{
+  return RTL(this, cmd_flag) ? RTL(this, rf) - 8 : ~0u;
+}
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+Device *
+Testbench::findDevice(uint32_t addr)
+{
+  for (size_t i = 0; i < devices.size(); i++)
+    if (devices[i]->claims(addr))
+      return devices[i];
+  return 0;
+}
+
+uint32_t
+Testbench::busRead(uint32_t addr)
+{
+  Device *dev = findDevice(addr);
+
+  if (dev)
+    return dev->read(addr);
+  return mem.read32(addr);
+}
+
+void
+Testbench::busWrite(uint32_t addr, uint32_t data, unsigned mask)
+{
+  Device *dev = findDevice(addr);
+
+  if (dev)
+    dev->write(addr, data, mask);
+  else if ((addr >> 28) != 0)             /* flash at 0x0xxxxxxx is read-only */
+    mem.write32(addr, data, mask);
+}
@@ -0,0 +1,101 @@
+/******************************************************************************
+ *
+ * Description:
+ *    C++ testbench around the Verilated core. Behaves like tb.v: the
+ *    instruction port and the data port are single-cycle synchronous
+ *    memories, serial output at 0xE0000000 and a periodic irq tick. Memory
+ *    is a sparse 32-bit address space loaded from an ELF file or a raw
+ *    binary at address 0. The sim control block at 0xE0000010 lets the
+ *    firmware end the run and read the cycle and instret counters.
+ *
+ *****************************************************************************/
+#ifndef _testbench_h_
+#define _testbench_h_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Varm9_compatiable_code.h"
+#include "Varm9_compatiable_code___024root.h"
+
+#include "activity.h"
+#include "addr_trace.h"
+#include "arch_state.h"
+#include "coverage.h"
+#include "devices.h"
+#include "elf_loader.h"
+#include "memory.h"
+#include "wave.h"
+
+/* backdoor access to a register (flop or net) inside the core */
+#define RTL(tb, sig) ((tb)->top->rootp->arm9_compatiable_code__DOT__##sig)
+
+class Testbench
+{
+public:
+  explicit Testbench(VerilatedContext *ctx);
+  ~Testbench();
+
+  /* ELF files by magic, anything else as raw binary at address 0 */
+  bool loadImage(const std::string &path, std::string &err);
+
+  /* add a device; the testbench takes ownership */
+  void attach(Device *dev);
+
+  void reset();
+
+  /* restart instruction fetch at 'pc' (pipeline flushed) */
+  void setPc(uint32_t pc);
+
+  /* one clock cycle */
+  void tick();
+
+  /* until 'maxCycles' (0 = no limit) or a device sets 'done' */
+  void run(uint64_t maxCycles);
+
+  /* backdoor read of the register file and status registers */
+  void archState(ArchState &st);
+
+  /* backdoor write of the same, then restart fetch at st.pc */
+  void setArchState(const ArchState &st);
+
+  /*
+   * Stop at the instruction boundary before 'pc': the pipeline is
+   * flushed and register writes still in flight (load data, LDM) are
+   * clocked in without executing anything else.
+   */
+  void drain(uint32_t pc);
+
+  /* address of the instruction in execute, ~0 while the pipeline refills */
+  uint32_t execPc();
+
+  Varm9_compatiable_code *top;
+  SparseMemory            mem;
+  ElfImage                elf;
+  bool                    isElf;
+
+  SerialPort             *serial;
+  TickTimer              *timer;
+  SimControl             *simctl;
+  Wave                   *wave;           /* NULL unless +wave */
+  Coverage               *cov;            /* NULL unless +cov */
+  AddrTrace              *atrace;         /* NULL unless +addr_trace */
+  Activity               *act;            /* NULL unless +activity/+saif */
+
+  uint64_t                cycle;          /* cycles since reset */
+  uint64_t                instret;        /* instructions retired */
+  bool                    done;
+  int                     exitCode;
+
+private:
+  uint32_t busRead(uint32_t addr);
+  void     busWrite(uint32_t addr, uint32_t data, unsigned mask);
+  Device  *findDevice(uint32_t addr);
+
+  std::vector<Device *>   devices;
+  uint32_t                romData;
+  uint32_t                ramRdata;
+};
+
+#endif /* _testbench_h_ */
@@ -0,0 +1,175 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Triggered FST waveform capture
+ *
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "testbench.h"
+#include "wave.h"
+
+#if VM_TRACE
+#include "verilated_fst_c.h"
+#endif
+
+/* half clock period in ns, same 1 MHz clock as tb.v */
+#define HALF_PERIOD 500
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+Wave::Wave(Testbench *tb)
+  : startPc(~0u), stopPc(~0u), fromCycle(~0ull), toCycle(~0ull),
+    onException(false), window(10000), post(0),
+    tb(tb), fst(0), seg(0), segStart(0), capturing(false), stopAt(~0ull)
+{
+}
+
+Wave::~Wave()
+{
+  close();
+}
+
+bool
+Wave::open(const std::string &name)
+{
+#if VM_TRACE
+  Verilated::traceEverOn(true);
+  prefix = name;
+  seg    = 0;
+  keep.assign(1, false);
+  fst    = new VerilatedFstC;
+  tb->top->trace(fst, 99);
+  fst->open(segmentName(seg).c_str());
+  segStart = tb->cycle;
+  return true;
+#else
+  (void)name;
+  return false;
+#endif
+}
+
+void
+Wave::dump(bool level)
+{
+#if VM_TRACE
+  if (!fst)
+    return;
+
+  /* triggers and segment rotation once per cycle, on the rising edge */
+  if (level) {
+    uint64_t cycle = tb->cycle;
+    uint32_t pc    = RTL(tb, rf) - 8;
+    bool     exec  = RTL(tb, cmd_flag);
+
+    if (!capturing) {
+      if (exec && pc == startPc)
+        start("pc");
+      else if (cycle == fromCycle)
+        start("cycle");
+      else if (onException && RTL(tb, int_all)) {
+        start("exception");
+        if (post == 0)
+          stopAt = cycle + window;
+      }
+    }
+    else {
+      if (exec && pc == stopPc)
+        stop("pc");
+      else if (cycle == toCycle)
+        stop("cycle");
+      else if (cycle >= stopAt)
+        stop("length");
+    }
+
+    if (cycle - segStart >= window)
+      nextSegment();
+  }
+
+  fst->dump((uint64_t)(tb->cycle * 2 + (level ? 1 : 2)) * HALF_PERIOD);
+#else
+  (void)level;
+#endif
+}
+
+void
+Wave::marker(uint32_t value)
+{
+  if (!fst)
+    return;
+  if (value && !capturing)
+    start("marker");
+  else if (!value && capturing)
+    stop("marker");
+}
+
+void
+Wave::close()
+{
+#if VM_TRACE
+  if (!fst)
+    return;
+  fst->close();
+  delete fst;
+  fst = 0;
+  fprintf(stderr, "wave: last cycles in %s%s\n",
+          seg > 0 ? (segmentName(seg - 1) + " and ").c_str() : "",
+          segmentName(seg).c_str());
+#endif
+}
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+void
+Wave::start(const char *why)
+{
+  capturing  = true;
+  keep[seg]  = true;
+  if (seg > 0)
+    keep[seg - 1] = true;
+  stopAt = post ? tb->cycle + post : ~0ull;
+
+  fprintf(stderr, "wave: start (%s) at cycle %llu, history from %s\n", why,
+          (unsigned long long)tb->cycle,
+          segmentName(seg > 0 ? seg - 1 : 0).c_str());
+}
+
+void
+Wave::stop(const char *why)
+{
+  capturing = false;
+  fprintf(stderr, "wave: stop (%s) at cycle %llu in %s\n", why,
+          (unsigned long long)tb->cycle, segmentName(seg).c_str());
+
+  /* whatever follows goes back into the ring */
+  nextSegment();
+}
+
+void
+Wave::nextSegment()
+{
+#if VM_TRACE
+  fst->close();
+  seg++;
+  keep.push_back(capturing);
+  fst->open(segmentName(seg).c_str());
+  segStart = tb->cycle;
+
+  /* ring of two segments while armed */
+  if (seg >= 2 && !keep[seg - 2])
+    remove(segmentName(seg - 2).c_str());
+#endif
+}
+
+std::string
+Wave::segmentName(unsigned n) const
+{
+  char num[16];
+
+  snprintf(num, sizeof(num), "-%u.fst", n);
+  return prefix + num;
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Triggered FST waveform capture. While armed, the trace goes to a ring
+ *    of segment files <prefix>-<n>.fst of 'window' cycles each; only the
+ *    last two segments are kept. When a start trigger fires, the segments
+ *    holding the preceding history are kept and capture continues until a
+ *    stop trigger (or 'post' cycles), after which the ring resumes. The
+ *    segments left at the end of the run hold the last cycles before a
+ *    hang or timeout.
+ *
+ *    Triggers: PC of the instruction in execute, cycle range, exception
+ *    entry (int_all) and the WAVE register of the sim control block.
+ *
+ *****************************************************************************/
+#ifndef _wave_h_
+#define _wave_h_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class Testbench;
+class VerilatedFstC;
+
+class Wave
+{
+public:
+  explicit Wave(Testbench *tb);
+  ~Wave();
+
+  /* returns false if the simulator was built without --trace-fst */
+  bool open(const std::string &prefix);
+
+  /* after each clock edge; 'level' is the new clk value */
+  void dump(bool level);
+
+  /* WAVE register: nonzero starts, zero stops a capture */
+  void marker(uint32_t value);
+
+  void close();
+
+  /* trigger settings, ~0 = unused */
+  uint32_t startPc, stopPc;
+  uint64_t fromCycle, toCycle;
+  bool     onException;
+  uint64_t window;                        /* ring segment length in cycles */
+  uint64_t post;                          /* capture length without a stop
+                                             trigger (0 = until stopped) */
+
+private:
+  void start(const char *why);
+  void stop(const char *why);
+  void nextSegment();
+  std::string segmentName(unsigned n) const;
+
+  Testbench            *tb;
+  VerilatedFstC        *fst;
+  std::string           prefix;
+  unsigned              seg;              /* current segment number */
+  uint64_t              segStart;         /* first cycle in this segment */
+  std::vector<bool>     keep;             /* per segment */
+  bool                  capturing;
+  uint64_t              stopAt;
+};
+
+#endif /* _wave_h_ */
@@ -68,6 +68,28 @@ reg [31:0] ram [4095:0];
 
 reg [31:0] ram_rdata;
 
+// Serial port: SERIAL_CTRL at 0xE000000C, bit 0 (TXIE) requests irq while
+// the transmitter is idle. +serial_cycles=<n> keeps the transmitter busy
+// (SERIAL_FLAG bit 0) for n cycles per character (0 = never busy).
+integer serial_cycles = 0;
+integer serial_busy = 0;
+reg     serial_txie = 1'b0;
+initial dummy = $value$plusargs("serial_cycles=%d", serial_cycles);
+
+always @ (posedge clk)
+if (ram_cen & ram_wen & (ram_addr==32'he0000004))
+    serial_busy <= #`DEL serial_cycles;
+else if (serial_busy != 0)
+    serial_busy <= #`DEL serial_busy - 1;
+else;
+
+always @ (posedge clk)
+if (ram_cen & ram_wen & (ram_addr==32'he000000c))
+    serial_txie <= #`DEL ram_wdata[0];
+else;
+
+wire serial_irq = serial_txie & (serial_busy == 0);
+
 initial begin
   for(i=0;i<4096;i=i+1)
       ram[i] = 32'h00000000;
@@ -76,7 +98,11 @@ end
 always @ (posedge clk )
 if ( ram_cen & ~ram_wen )
     if (ram_addr==32'he0000000)
-	    ram_rdata <= #`DEL 32'h0;
+	    ram_rdata <= #`DEL {31'h0, serial_busy != 0};
+    else if (ram_addr==32'he000000c)
+	    ram_rdata <= #`DEL {31'h0, serial_txie};
+	else if (ram_addr[31:7]==25'h1c00000)
+	    ram_rdata <= #`DEL simctl_read(ram_addr);
 	else if (ram_addr[31:28]==4'h0)
 	    ram_rdata <= #`DEL  {rom[ram_addr+3],rom[ram_addr+2],rom[ram_addr+1],rom[ram_addr]};
     else if (ram_addr[31:28]==4'h4)
@@ -101,21 +127,45 @@ end
 else;
 
 
+// +uart_log=<file> additionally copies the serial output to a file
+integer uart_fd = 0;
+reg [1023:0] uart_file;
+initial begin
+  uart_file = 0;
+  if ($value$plusargs("uart_log=%s", uart_file))
+    uart_fd = $fopen(uart_file, "w");
+end
+
 always @ (posedge clk)
-if (ram_cen & ram_wen & (ram_addr==32'he0000004) )
+if (ram_cen & ram_wen & (ram_addr==32'he0000004) ) begin
     $write("%s",ram_wdata[7:0]);
+    if (uart_fd != 0)
+        $fwrite(uart_fd, "%s", ram_wdata[7:0]);
+end
 else;
 
 wire irq;
 
+// +irq_period=<n> sets the timer tick period in cycles (0 = no tick)
+integer irq_period = 10000;
+initial dummy = $value$plusargs("irq_period=%d", irq_period);
+
 integer timer_cnt = 0;
 always @ (posedge clk)
-if (timer_cnt == 9999 )
+if (timer_cnt >= irq_period - 1 )
     timer_cnt <= #`DEL 0;
 else
     timer_cnt <= #`DEL timer_cnt + 1'b1;
 
-assign irq = (timer_cnt == 9999);
+// Tick compare (TICK_CMP and TICK_CTRL in the sim control block): with
+// TICK_CTRL bit 0 set the periodic tick is off and irq is held while the low
+// word of the cycle counter is at or past TICK_CMP, until TICK_CMP moves on.
+reg [31:0]   tick_cmp = 0;
+reg          tick_cmp_en = 1'b0;
+wire         tick_cmp_irq;
+
+assign irq = (~tick_cmp_en & (irq_period != 0) & (timer_cnt == irq_period - 1)) |
+             tick_cmp_irq | serial_irq;
 
 arm9_compatiable_code u_arm9(
           .clk                 (    clk                   ),
@@ -138,6 +188,583 @@ arm9_compatiable_code u_arm9(
           .rom_en              (    rom_en                )
         );
 
+//------------------------------------------------------------------------------
+// run control
+//
+//   +max_cycles=<n>   stop after n cycles
+//
+// The final "SIM:" line is what the regression runner (regress/run.sh) reads.
+// An instruction retires in its last execute cycle (cmd_flag without hold_en);
+// instructions flushed by an exception (int_all) are not counted.
+//------------------------------------------------------------------------------
+reg [63:0]   cycle_cnt = 0;
+always @ (posedge clk)
+if (~rst)
+    cycle_cnt <= #`DEL cycle_cnt + 1'b1;
+else;
+
+reg [63:0]   instret_cnt = 0;
+always @ (posedge clk)
+if (~rst & u_arm9.cmd_flag & ~u_arm9.int_all & ~u_arm9.hold_en)
+    instret_cnt <= #`DEL instret_cnt + 1'b1;
+else;
+
+reg [63:0]   max_cycles;
+initial begin
+  max_cycles = 0;
+  dummy = $value$plusargs("max_cycles=%d", max_cycles);
+end
+
+task sim_finish;
+begin
+  $display("");
+  $display("SIM: cycles=%0d instret=%0d", cycle_cnt, instret_cnt);
+  if (uart_fd != 0)
+    $fclose(uart_fd);
+  $finish();
+end
+endtask
+
+always @ (negedge clk)
+if ((max_cycles != 0) && (cycle_cnt >= max_cycles))
+    sim_finish;
+else;
+
+//------------------------------------------------------------------------------
+// sim control block at 0xE0000010, next to the serial port (dhry/simctl.h)
+//
+//   0x10 EXIT        W  print "SIM: exit=<status>" and end the simulation
+//   0x14 CYCLE_LO    R  cycle_cnt, reading LO latches HI
+//   0x18 CYCLE_HI    R
+//   0x1c INSTRET_LO  R  instret_cnt, reading LO latches HI
+//   0x20 INSTRET_HI  R
+//   0x24 MARK        W  print "SIM: mark=<value> cycles=<n> instret=<n>"
+//   0x28 TIME_LO     R  timestamp in us, reading LO latches HI
+//   0x2c TIME_HI     R
+//   0x30 ARG0..ARG2  RW arguments of CMD
+//   0x3c CMD         W  host file command, R its result
+//   0x40 WAVE        W  nonzero starts, zero stops a waveform capture
+//   0x44 TICK_CMP    RW tick compare: while TICK_CTRL bit 0 is set, irq is
+//   0x48 TICK_CTRL   RW held as long as CYCLE_LO - TICK_CMP >= 0 (signed)
+//                       and the +irq_period tick is off
+//
+// CMD 1 = open (ARG0 path, ARG1 0 read / 1 write / 2 append) -> handle or -1,
+//     2 = close (ARG0 handle), 3 = read / 4 = write (ARG0 handle, ARG1 buffer,
+//     ARG2 length) -> bytes transferred. Handles 1 and 2 write to the
+// simulator's stdout. Buffers and paths may be in rom or ram.
+// Verilog-2001 has no host clock: TIME is the simulated time here.
+//------------------------------------------------------------------------------
+reg [31:0]    simctl_arg0 = 0;
+reg [31:0]    simctl_arg1 = 0;
+reg [31:0]    simctl_arg2 = 0;
+reg [31:0]    simctl_result = 0;
+reg [31:0]    simctl_cycle_hi = 0;
+reg [31:0]    simctl_instret_hi = 0;
+reg [31:0]    simctl_time_hi = 0;
+reg [63:0]    simctl_time;
+reg [8*256:1] simctl_path;
+
+wire [31:0]   tick_cmp_diff = cycle_cnt[31:0] - tick_cmp;
+assign tick_cmp_irq = tick_cmp_en & ~tick_cmp_diff[31];
+
+function [31:0] simctl_read;
+input [31:0] addr;
+begin
+  simctl_time = $time / 1000;
+  case (addr[6:2])
+  5'h05:    simctl_read = cycle_cnt[31:0];
+  5'h06:    simctl_read = simctl_cycle_hi;
+  5'h07:    simctl_read = instret_cnt[31:0];
+  5'h08:    simctl_read = simctl_instret_hi;
+  5'h0a:    simctl_read = simctl_time[31:0];
+  5'h0b:    simctl_read = simctl_time_hi;
+  5'h0c:    simctl_read = simctl_arg0;
+  5'h0d:    simctl_read = simctl_arg1;
+  5'h0e:    simctl_read = simctl_arg2;
+  5'h0f:    simctl_read = simctl_result;
+  5'h11:    simctl_read = tick_cmp;
+  5'h12:    simctl_read = {31'h0, tick_cmp_en};
+  default: simctl_read = 32'h0;
+  endcase
+end
+endfunction
+
+function [7:0] mem_byte;
+input [31:0] addr;
+begin
+  if (addr[31:28] == 4'h0)
+    mem_byte = rom[addr[16:0]];
+  else if (addr[31:28] == 4'h4)
+    mem_byte = ram[addr[13:2]] >> (8 * addr[1:0]);
+  else
+    mem_byte = 8'h0;
+end
+endfunction
+
+task mem_store_byte;
+input [31:0] addr;
+input [7:0]  b;
+reg   [31:0] w;
+begin
+  if (addr[31:28] == 4'h4) begin
+    w = ram[addr[13:2]];
+    case (addr[1:0])
+    2'h0: w[7:0]   = b;
+    2'h1: w[15:8]  = b;
+    2'h2: w[23:16] = b;
+    2'h3: w[31:24] = b;
+    endcase
+    ram[addr[13:2]] = w;
+  end
+end
+endtask
+
+// host files are Verilog descriptors with the MSB stripped (always > 2)
+task simctl_cmd;
+input [31:0] cmd;
+integer n, c, hfd;
+begin
+  hfd = simctl_arg0 | 32'h80000000;
+  case (cmd)
+  1: begin
+       simctl_path = 0;
+       for (n = 0; (n < 255) && (mem_byte(simctl_arg0 + n) != 0); n = n + 1)
+         simctl_path = {simctl_path[8*255:1], mem_byte(simctl_arg0 + n)};
+       case (simctl_arg1)
+       0:       hfd = $fopen(simctl_path, "rb");
+       1:       hfd = $fopen(simctl_path, "wb");
+       default: hfd = $fopen(simctl_path, "ab");
+       endcase
+       simctl_result = (hfd == 0) ? 32'hffffffff : (hfd & 32'h7fffffff);
+     end
+  2: begin
+       if (simctl_arg0 > 2)
+         $fclose(hfd);
+       simctl_result = (simctl_arg0 > 2) ? 0 : 32'hffffffff;
+     end
+  3: begin
+       c = 0;
+       for (n = 0; (simctl_arg0 > 2) && (n < simctl_arg2) && (c != -1); n = n + 1) begin
+         c = $fgetc(hfd);
+         if (c != -1)
+           mem_store_byte(simctl_arg1 + n, c);
+       end
+       simctl_result = (c == -1) ? n - 1 : n;
+     end
+  4: begin
+       for (n = 0; n < simctl_arg2; n = n + 1)
+         if ((simctl_arg0 == 1) || (simctl_arg0 == 2))
+           $write("%c", mem_byte(simctl_arg1 + n));
+         else if (simctl_arg0 > 2)
+           $fwrite(hfd, "%c", mem_byte(simctl_arg1 + n));
+       simctl_result = (simctl_arg0 != 0) ? simctl_arg2 : 32'hffffffff;
+     end
+  default: simctl_result = 32'hffffffff;
+  endcase
+end
+endtask
+
+always @ (posedge clk)
+if (ram_cen & (ram_addr[31:7]==25'h1c00000))
+    if (ram_wen)
+        case (ram_addr[6:2])
+        5'h04: begin
+                $display("");
+                $display("SIM: exit=%0d", $signed(ram_wdata));
+                sim_finish;
+              end
+        5'h09: $display("SIM: mark=%0d cycles=%0d instret=%0d",
+                       ram_wdata, cycle_cnt, instret_cnt);
+        5'h0c: simctl_arg0 = ram_wdata;
+        5'h0d: simctl_arg1 = ram_wdata;
+        5'h0e: simctl_arg2 = ram_wdata;
+        5'h0f: simctl_cmd(ram_wdata);
+        5'h10: if (ram_wdata != 0) wave_start("marker"); else wave_stop("marker");
+        5'h11: tick_cmp    <= #`DEL ram_wdata;
+        5'h12: tick_cmp_en <= #`DEL ram_wdata[0];
+        default: ;
+        endcase
+    else
+        case (ram_addr[6:2])
+        5'h05: simctl_cycle_hi   <= #`DEL cycle_cnt[63:32];
+        5'h07: simctl_instret_hi <= #`DEL instret_cnt[63:32];
+        5'h0a: simctl_time_hi    <= #`DEL ($time / 1000) >> 32;
+        default: ;
+        endcase
+else;
+
+//------------------------------------------------------------------------------
+// triggered waveform capture
+//
+//   +wave=<file>          dump file, off until a trigger fires (vvp -fst
+//                         writes FST instead of VCD)
+//   +wave_start_pc=<hex>  start / stop when the instruction at this address
+//   +wave_stop_pc=<hex>   executes (rf - 8 while cmd_flag)
+//   +wave_from=<n>        start / stop at a cycle
+//   +wave_to=<n>
+//   +wave_exception       start on exception entry (int_all)
+//   +wave_post=<n>        capture length without a stop trigger (0 = until
+//                         stopped; exception captures default to 10000)
+//
+// SIMCTL_WAVE lets the firmware start and stop a capture. Only the triggered
+// windows are dumped; the Verilator testbench in sim/ also keeps the cycles
+// leading up to each trigger.
+//------------------------------------------------------------------------------
+reg [1023:0] wave_file;
+reg          wave_en = 1'b0;
+reg          wave_on = 1'b0;
+reg          wave_exception = 1'b0;
+reg [31:0]   wave_start_pc = 32'hffffffff;
+reg [31:0]   wave_stop_pc = 32'hffffffff;
+reg [63:0]   wave_from = 64'hffffffffffffffff;
+reg [63:0]   wave_to = 64'hffffffffffffffff;
+reg [63:0]   wave_post = 0;
+reg [63:0]   wave_stop_at = 64'hffffffffffffffff;
+wire [31:0]  wave_pc = u_arm9.rf - 32'd8;
+
+initial begin
+  wave_file = 0;
+  if ($value$plusargs("wave=%s", wave_file)) begin
+    wave_en = 1'b1;
+    $dumpfile(wave_file);
+    $dumpvars(0, tb);
+    $dumpoff;
+  end
+  dummy = $value$plusargs("wave_start_pc=%h", wave_start_pc);
+  dummy = $value$plusargs("wave_stop_pc=%h", wave_stop_pc);
+  dummy = $value$plusargs("wave_from=%d", wave_from);
+  dummy = $value$plusargs("wave_to=%d", wave_to);
+  dummy = $value$plusargs("wave_post=%d", wave_post);
+  wave_exception = $test$plusargs("wave_exception");
+end
+
+task wave_start;
+input [8*16:1] why;
+if (wave_en & ~wave_on) begin
+  wave_on = 1'b1;
+  wave_stop_at = (wave_post != 0) ? cycle_cnt + wave_post : 64'hffffffffffffffff;
+  $dumpon;
+  $display("wave: start (%0s) at cycle %0d", why, cycle_cnt);
+end
+endtask
+
+task wave_stop;
+input [8*16:1] why;
+if (wave_on) begin
+  wave_on = 1'b0;
+  $dumpoff;
+  $display("wave: stop (%0s) at cycle %0d", why, cycle_cnt);
+end
+endtask
+
+always @ (posedge clk)
+if (wave_en & ~rst)
+    if (~wave_on)
+        if (u_arm9.cmd_flag & (wave_pc == wave_start_pc))
+            wave_start("pc");
+        else if (cycle_cnt == wave_from)
+            wave_start("cycle");
+        else if (wave_exception & u_arm9.int_all) begin
+            wave_start("exception");
+            if (wave_post == 0)
+                wave_stop_at = cycle_cnt + 10000;
+        end
+        else;
+    else if (u_arm9.cmd_flag & (wave_pc == wave_stop_pc))
+        wave_stop("pc");
+    else if (cycle_cnt == wave_to)
+        wave_stop("cycle");
+    else if (cycle_cnt >= wave_stop_at)
+        wave_stop("length");
+    else;
+else;
+
+//------------------------------------------------------------------------------
+// checkpoint / restore
+//
+//   +ckpt_save=<file> +ckpt_cycle=<n>  dump core + memory state after cycle n
+//   +ckpt_exit                          stop the run once the dump is written
+//   +ckpt_load=<file>                   backdoor-load a dump right after reset
+//
+// The dump is plain text, one "<name> <hex>" pair per line, followed by the
+// rom and ram images ("rom <words>" / "ram <words>", then one hex word per
+// line). Every flop of u_arm9 is saved, so the pipeline resumes mid-flight
+// exactly where it was stopped; combinational nets follow from the flops.
+// The state is sampled and restored on the falling clock edge, when all
+// flops and the #`DEL delayed memory writes have settled. The testbench
+// registers the firmware can see (simctl ARG/result and the latched HI
+// halves) and a capture running through the checkpoint are saved as well.
+//------------------------------------------------------------------------------
+
+reg [1023:0] ckpt_load_file;
+reg [1023:0] ckpt_save_file;
+reg [63:0]   ckpt_cycle;
+reg          ckpt_exit;
+
+task ckpt_save;
+input [1023:0] fname;
+integer f, k;
+begin
+  f = $fopen(fname, "w");
+  if (f == 0) begin
+    $display("ERROR! Cannot open checkpoint file %0s", fname);
+    $finish();
+  end
+  $fdisplay(f, "ARM9CKPT 1");
+  $fdisplay(f, "cycle %h", cycle_cnt);
+  $fdisplay(f, "instret %h", instret_cnt);
+  $fdisplay(f, "timer_cnt %h", timer_cnt);
+  $fdisplay(f, "serial_busy %h", serial_busy);
+  $fdisplay(f, "serial_txie %h", serial_txie);
+  $fdisplay(f, "tick_cmp %h", tick_cmp);
+  $fdisplay(f, "tick_cmp_en %h", tick_cmp_en);
+  $fdisplay(f, "rom_data %h", rom_data);
+  $fdisplay(f, "ram_rdata %h", ram_rdata);
+  $fdisplay(f, "simctl_arg0 %h", simctl_arg0);
+  $fdisplay(f, "simctl_arg1 %h", simctl_arg1);
+  $fdisplay(f, "simctl_arg2 %h", simctl_arg2);
+  $fdisplay(f, "simctl_result %h", simctl_result);
+  $fdisplay(f, "simctl_cycle_hi %h", simctl_cycle_hi);
+  $fdisplay(f, "simctl_instret_hi %h", simctl_instret_hi);
+  $fdisplay(f, "simctl_time_hi %h", simctl_time_hi);
+  $fdisplay(f, "wave_on %h", wave_on);
+  $fdisplay(f, "wave_stop_at %h", wave_stop_at);
+  // architectural registers
+  $fdisplay(f, "r0 %h", u_arm9.r0);
+  $fdisplay(f, "r1 %h", u_arm9.r1);
+  $fdisplay(f, "r2 %h", u_arm9.r2);
+  $fdisplay(f, "r3 %h", u_arm9.r3);
+  $fdisplay(f, "r4 %h", u_arm9.r4);
+  $fdisplay(f, "r5 %h", u_arm9.r5);
+  $fdisplay(f, "r6 %h", u_arm9.r6);
+  $fdisplay(f, "r7 %h", u_arm9.r7);
+  $fdisplay(f, "r8_usr %h", u_arm9.r8_usr);
+  $fdisplay(f, "r9_usr %h", u_arm9.r9_usr);
+  $fdisplay(f, "ra_usr %h", u_arm9.ra_usr);
+  $fdisplay(f, "rb_usr %h", u_arm9.rb_usr);
+  $fdisplay(f, "rc_usr %h", u_arm9.rc_usr);
+  $fdisplay(f, "rd_usr %h", u_arm9.rd_usr);
+  $fdisplay(f, "re_usr %h", u_arm9.re_usr);
+  $fdisplay(f, "r8_fiq %h", u_arm9.r8_fiq);
+  $fdisplay(f, "r9_fiq %h", u_arm9.r9_fiq);
+  $fdisplay(f, "ra_fiq %h", u_arm9.ra_fiq);
+  $fdisplay(f, "rb_fiq %h", u_arm9.rb_fiq);
+  $fdisplay(f, "rc_fiq %h", u_arm9.rc_fiq);
+  $fdisplay(f, "rd_fiq %h", u_arm9.rd_fiq);
+  $fdisplay(f, "re_fiq %h", u_arm9.re_fiq);
+  $fdisplay(f, "rd_irq %h", u_arm9.rd_irq);
+  $fdisplay(f, "re_irq %h", u_arm9.re_irq);
+  $fdisplay(f, "rd_svc %h", u_arm9.rd_svc);
+  $fdisplay(f, "re_svc %h", u_arm9.re_svc);
+  $fdisplay(f, "rd_abt %h", u_arm9.rd_abt);
+  $fdisplay(f, "re_abt %h", u_arm9.re_abt);
+  $fdisplay(f, "rd_und %h", u_arm9.rd_und);
+  $fdisplay(f, "re_und %h", u_arm9.re_und);
+  $fdisplay(f, "rf %h", u_arm9.rf);
+  $fdisplay(f, "cpsr_n %h", u_arm9.cpsr_n);
+  $fdisplay(f, "cpsr_z %h", u_arm9.cpsr_z);
+  $fdisplay(f, "cpsr_c %h", u_arm9.cpsr_c);
+  $fdisplay(f, "cpsr_v %h", u_arm9.cpsr_v);
+  $fdisplay(f, "cpsr_i %h", u_arm9.cpsr_i);
+  $fdisplay(f, "cpsr_f %h", u_arm9.cpsr_f);
+  $fdisplay(f, "cpsr_m %h", u_arm9.cpsr_m);
+  $fdisplay(f, "spsr_svc %h", u_arm9.spsr_svc);
+  $fdisplay(f, "spsr_abt %h", u_arm9.spsr_abt);
+  $fdisplay(f, "spsr_irq %h", u_arm9.spsr_irq);
+  $fdisplay(f, "spsr_fiq %h", u_arm9.spsr_fiq);
+  $fdisplay(f, "spsr_und %h", u_arm9.spsr_und);
+  // pipeline state
+  $fdisplay(f, "cmd %h", u_arm9.cmd);
+  $fdisplay(f, "cmd_flag %h", u_arm9.cmd_flag);
+  $fdisplay(f, "code_flag %h", u_arm9.code_flag);
+  $fdisplay(f, "code_abort %h", u_arm9.code_abort);
+  $fdisplay(f, "code_und %h", u_arm9.code_und);
+  $fdisplay(f, "code_rs_flag %h", u_arm9.code_rs_flag);
+  $fdisplay(f, "fiq_flag %h", u_arm9.fiq_flag);
+  $fdisplay(f, "irq_flag %h", u_arm9.irq_flag);
+  $fdisplay(f, "go_fmt %h", u_arm9.go_fmt);
+  $fdisplay(f, "go_num %h", u_arm9.go_num);
+  $fdisplay(f, "go_vld %h", u_arm9.go_vld);
+  $fdisplay(f, "hold_en_dly %h", u_arm9.hold_en_dly);
+  $fdisplay(f, "ldm_change %h", u_arm9.ldm_change);
+  $fdisplay(f, "ldm_num %h", u_arm9.ldm_num);
+  $fdisplay(f, "ldm_usr %h", u_arm9.ldm_usr);
+  $fdisplay(f, "ldm_vld %h", u_arm9.ldm_vld);
+  $fdisplay(f, "mult_z %h", u_arm9.mult_z);
+  $fdisplay(f, "multl_extra_num %h", u_arm9.multl_extra_num);
+  $fdisplay(f, "reg_ans %h", u_arm9.reg_ans);
+  $fdisplay(f, "rm_msb %h", u_arm9.rm_msb);
+  $fdisplay(f, "rs_msb %h", u_arm9.rs_msb);
+  $fdisplay(f, "rn_register %h", u_arm9.rn_register);
+  $fdisplay(f, "sum_m %h", u_arm9.sum_m);
+  // memories
+  $fdisplay(f, "rom %h", 131072/4);
+  for (k = 0; k < 131072; k = k + 4)
+    $fdisplay(f, "%h", {rom[k+3],rom[k+2],rom[k+1],rom[k]});
+  $fdisplay(f, "ram %h", 4096);
+  for (k = 0; k < 4096; k = k + 1)
+    $fdisplay(f, "%h", ram[k]);
+  $fdisplay(f, "end 0");
+  $fclose(f);
+  $display("checkpoint: cycle %0d saved to %0s", cycle_cnt, fname);
+end
+endtask
+
+task ckpt_load;
+input [1023:0] fname;
+integer f, k, n, r;
+reg [8*24:1] name;
+reg [63:0]   val;
+reg [31:0]   w;
+begin
+  f = $fopen(fname, "r");
+  if (f == 0) begin
+    $display("ERROR! Cannot open checkpoint file %0s", fname);
+    $finish();
+  end
+  r = $fscanf(f, "%s %h\n", name, val);
+  if (name != "ARM9CKPT" || val != 1) begin
+    $display("ERROR! %0s is not a checkpoint file", fname);
+    $finish();
+  end
+  name = 0;
+  while (name != "end" && !$feof(f)) begin
+    r = $fscanf(f, "%s %h\n", name, val);
+    case (name)
+    "cycle"           : cycle_cnt = val;
+    "instret"         : instret_cnt = val;
+    "timer_cnt"       : timer_cnt = val;
+    "serial_busy"     : serial_busy = val;
+    "serial_txie"     : serial_txie = val;
+    "tick_cmp"        : tick_cmp = val;
+    "tick_cmp_en"     : tick_cmp_en = val;
+    "rom_data"        : rom_data = val;
+    "ram_rdata"       : ram_rdata = val;
+    "simctl_arg0"     : simctl_arg0 = val;
+    "simctl_arg1"     : simctl_arg1 = val;
+    "simctl_arg2"     : simctl_arg2 = val;
+    "simctl_result"   : simctl_result = val;
+    "simctl_cycle_hi" : simctl_cycle_hi = val;
+    "simctl_instret_hi" : simctl_instret_hi = val;
+    "simctl_time_hi"  : simctl_time_hi = val;
+    "wave_on"         : if (val[0]) wave_start("checkpoint");
+    "wave_stop_at"    : wave_stop_at = val;
+    "r0"              : u_arm9.r0 = val;
+    "r1"              : u_arm9.r1 = val;
+    "r2"              : u_arm9.r2 = val;
+    "r3"              : u_arm9.r3 = val;
+    "r4"              : u_arm9.r4 = val;
+    "r5"              : u_arm9.r5 = val;
+    "r6"              : u_arm9.r6 = val;
+    "r7"              : u_arm9.r7 = val;
+    "r8_usr"          : u_arm9.r8_usr = val;
+    "r9_usr"          : u_arm9.r9_usr = val;
+    "ra_usr"          : u_arm9.ra_usr = val;
+    "rb_usr"          : u_arm9.rb_usr = val;
+    "rc_usr"          : u_arm9.rc_usr = val;
+    "rd_usr"          : u_arm9.rd_usr = val;
+    "re_usr"          : u_arm9.re_usr = val;
+    "r8_fiq"          : u_arm9.r8_fiq = val;
+    "r9_fiq"          : u_arm9.r9_fiq = val;
+    "ra_fiq"          : u_arm9.ra_fiq = val;
+    "rb_fiq"          : u_arm9.rb_fiq = val;
+    "rc_fiq"          : u_arm9.rc_fiq = val;
+    "rd_fiq"          : u_arm9.rd_fiq = val;
+    "re_fiq"          : u_arm9.re_fiq = val;
+    "rd_irq"          : u_arm9.rd_irq = val;
+    "re_irq"          : u_arm9.re_irq = val;
+    "rd_svc"          : u_arm9.rd_svc = val;
+    "re_svc"          : u_arm9.re_svc = val;
+    "rd_abt"          : u_arm9.rd_abt = val;
+    "re_abt"          : u_arm9.re_abt = val;
+    "rd_und"          : u_arm9.rd_und = val;
+    "re_und"          : u_arm9.re_und = val;
+    "rf"              : u_arm9.rf = val;
+    "cpsr_n"          : u_arm9.cpsr_n = val;
+    "cpsr_z"          : u_arm9.cpsr_z = val;
+    "cpsr_c"          : u_arm9.cpsr_c = val;
+    "cpsr_v"          : u_arm9.cpsr_v = val;
+    "cpsr_i"          : u_arm9.cpsr_i = val;
+    "cpsr_f"          : u_arm9.cpsr_f = val;
+    "cpsr_m"          : u_arm9.cpsr_m = val;
+    "spsr_svc"        : u_arm9.spsr_svc = val;
+    "spsr_abt"        : u_arm9.spsr_abt = val;
+    "spsr_irq"        : u_arm9.spsr_irq = val;
+    "spsr_fiq"        : u_arm9.spsr_fiq = val;
+    "spsr_und"        : u_arm9.spsr_und = val;
+    "cmd"             : u_arm9.cmd = val;
+    "cmd_flag"        : u_arm9.cmd_flag = val;
+    "code_flag"       : u_arm9.code_flag = val;
+    "code_abort"      : u_arm9.code_abort = val;
+    "code_und"        : u_arm9.code_und = val;
+    "code_rs_flag"    : u_arm9.code_rs_flag = val;
+    "fiq_flag"        : u_arm9.fiq_flag = val;
+    "irq_flag"        : u_arm9.irq_flag = val;
+    "go_fmt"          : u_arm9.go_fmt = val;
+    "go_num"          : u_arm9.go_num = val;
+    "go_vld"          : u_arm9.go_vld = val;
+    "hold_en_dly"     : u_arm9.hold_en_dly = val;
+    "ldm_change"      : u_arm9.ldm_change = val;
+    "ldm_num"         : u_arm9.ldm_num = val;
+    "ldm_usr"         : u_arm9.ldm_usr = val;
+    "ldm_vld"         : u_arm9.ldm_vld = val;
+    "mult_z"          : u_arm9.mult_z = val;
+    "multl_extra_num" : u_arm9.multl_extra_num = val;
+    "reg_ans"         : u_arm9.reg_ans = val;
+    "rm_msb"          : u_arm9.rm_msb = val;
+    "rs_msb"          : u_arm9.rs_msb = val;
+    "rn_register"     : u_arm9.rn_register = val;
+    "sum_m"           : u_arm9.sum_m = val;
+    "rom"             : begin
+                          n = val;
+                          for (k = 0; k < n; k = k + 1) begin
+                            r = $fscanf(f, "%h\n", w);
+                            if (4*k < 131072)
+                              {rom[4*k+3],rom[4*k+2],rom[4*k+1],rom[4*k]} = w;
+                          end
+                        end
+    "ram"             : begin
+                          n = val;
+                          for (k = 0; k < n; k = k + 1) begin
+                            r = $fscanf(f, "%h\n", w);
+                            if (k < 4096)
+                              ram[k] = w;
+                          end
+                        end
+    "end"             : ;
+    default           : $display("WARNING! Unknown checkpoint field %0s", name);
+    endcase
+  end
+  $fclose(f);
+  $display("checkpoint: cycle %0d restored from %0s", cycle_cnt, fname);
+end
+endtask
+
+initial begin
+  ckpt_load_file = 0;
+  if ($value$plusargs("ckpt_load=%s", ckpt_load_file)) begin
+    @ (negedge rst);
+    @ (negedge clk);
+    ckpt_load(ckpt_load_file);
+  end
+end
+
+initial begin
+  ckpt_save_file = 0;
+  ckpt_cycle = 0;
+  ckpt_exit = $test$plusargs("ckpt_exit");
+  if ($value$plusargs("ckpt_save=%s", ckpt_save_file)) begin
+    dummy = $value$plusargs("ckpt_cycle=%d", ckpt_cycle);
+    @ (negedge rst);
+    @ (negedge clk);
+    while (cycle_cnt < ckpt_cycle)
+      @ (negedge clk);
+    ckpt_save(ckpt_save_file);
+    if (ckpt_exit)
+      sim_finish;
+  end
+end
+
 //always @ (posedge clk)
 //	$display("rom_addr: %x", rom_addr);
 //if (ram_addr[31:28]==4'h4)
@@ -20,6 +20,20 @@ architecture RTL of tb is
     return l.all;
   end function to_hexstr;
 
+  function to_decstr(u : unsigned) return string is
+    variable v : unsigned(u'length - 1 downto 0) := u;
+    variable s : string(1 to 20);
+    variable i : natural := 20;
+  begin
+    loop
+      s(i) := character'val(character'pos('0') + to_integer(v mod 10));
+      v := v / 10;
+      exit when v = 0;
+      i := i - 1;
+    end loop;
+    return s(i to 20);
+  end function to_decstr;
+
   procedure print(str : in string) is
     variable l : line;
   begin
@@ -91,8 +105,26 @@ architecture RTL of tb is
 
   signal timer_cnt : integer := 0;
 
+  -- serial control at 0xE000000C: bit 0 (TXIE) requests irq, the
+  -- transmitter is never busy
+  signal serial_txie : std_logic := '0';
+
   signal stop_condition : std_logic := '0';
 
+  -- sim control block at 0xE0000010 (see tb.v and dhry/simctl.h); only
+  -- exit, mark, the counters and the tick compare, no host files
+  signal cycle_cnt   : unsigned(63 downto 0) := (others => '0');
+  signal instret_cnt : unsigned(63 downto 0) := (others => '0');
+  signal cycle_hi    : std_logic_vector(31 downto 0) := x"00000000";
+  signal instret_hi  : std_logic_vector(31 downto 0) := x"00000000";
+
+  -- tick compare at 0xE0000044/48 (TICK_CMP, TICK_CTRL): with TICK_CTRL
+  -- bit 0 set the periodic tick is off and irq is held while the low word
+  -- of cycle_cnt is at or past TICK_CMP
+  signal tick_cmp    : std_logic_vector(31 downto 0) := x"00000000";
+  signal tick_cmp_en : std_logic := '0';
+  signal tick_diff   : unsigned(31 downto 0);
+
 begin
 
   read_bf: process is
@@ -134,6 +166,7 @@ begin
     wait until stop_condition;
     wait for (10 * clk_period);
     report "STOP SIMULATION";
+    print("SIM: cycles=" & to_decstr(cycle_cnt) & " instret=" & to_decstr(instret_cnt));
     std.env.finish;
     wait;
   end process;
@@ -170,6 +203,20 @@ begin
       if (ram_cen and not ram_wen) then
         if (ram_addr = X"e0000000") then
           ram_rdata <= 32X"0";
+        elsif (ram_addr = X"e000000c") then
+          ram_rdata <= (0 => serial_txie, others => '0');
+        elsif (ram_addr = X"e0000014") then
+          ram_rdata <= std_logic_vector(cycle_cnt(31 downto 0));
+        elsif (ram_addr = X"e0000018") then
+          ram_rdata <= cycle_hi;
+        elsif (ram_addr = X"e000001c") then
+          ram_rdata <= std_logic_vector(instret_cnt(31 downto 0));
+        elsif (ram_addr = X"e0000020") then
+          ram_rdata <= instret_hi;
+        elsif (ram_addr = X"e0000044") then
+          ram_rdata <= tick_cmp;
+        elsif (ram_addr = X"e0000048") then
+          ram_rdata <= (0 => tick_cmp_en, others => '0');
         elsif (ram_addr(31 downto 28) = X"0") then
           ram_rdata <= rom(to_integer(unsigned(ram_addr)) + 3) &
             rom(to_integer(unsigned(ram_addr)) + 2) &
@@ -241,6 +288,19 @@ begin
 	if (to_integer(unsigned(ram_wdata)) /= 17) then
           stop_condition <= '1';
         end if;
+      elsif (ram_cen = '1' and ram_wen = '1' and ram_addr = x"e000000c") then
+        serial_txie <= ram_wdata(0);
+      elsif (ram_cen = '1' and ram_wen = '1' and ram_addr = x"e0000010") then
+        print("");
+        print("SIM: exit=" & integer'image(to_integer(signed(ram_wdata))));
+        stop_condition <= '1';
+      elsif (ram_cen = '1' and ram_wen = '1' and ram_addr = x"e0000024") then
+        print("SIM: mark=" & to_decstr(unsigned(ram_wdata)) &
+              " cycles=" & to_decstr(cycle_cnt) & " instret=" & to_decstr(instret_cnt));
+      elsif (ram_cen = '1' and ram_wen = '1' and ram_addr = x"e0000044") then
+        tick_cmp <= ram_wdata;
+      elsif (ram_cen = '1' and ram_wen = '1' and ram_addr = x"e0000048") then
+        tick_cmp_en <= ram_wdata(0);
       else
         null;
       end if;
@@ -258,7 +318,11 @@ begin
     end if;
   end process;
 
-  irq <= '1' when (timer_cnt = 9999) else
+  tick_diff <= cycle_cnt(31 downto 0) - unsigned(tick_cmp);
+
+  irq <= '1' when ((tick_cmp_en = '0' and timer_cnt = 9999) or
+                   (tick_cmp_en = '1' and tick_diff(31) = '0') or
+                   serial_txie = '1') else
          '0';
 
   u_arm9 : component arm9_compatiable_code
@@ -283,4 +347,27 @@ begin
       rom_en    => rom_en
     );
 
+  -- an instruction retires in its last execute cycle (cmd_flag without
+  -- hold_en), exceptions (int_all) flush it; reading a LO word latches HI
+  counter_proc : process (clk) is
+    alias cmd_flag is <<signal .tb.u_arm9.cmd_flag : std_logic>>;
+    alias int_all  is <<signal .tb.u_arm9.int_all  : std_logic>>;
+    alias hold_en  is <<signal .tb.u_arm9.hold_en  : std_logic>>;
+  begin
+    if (rising_edge(clk)) then
+      if (rst = '0') then
+        cycle_cnt <= cycle_cnt + 1;
+        if (cmd_flag = '1' and int_all = '0' and hold_en = '0') then
+          instret_cnt <= instret_cnt + 1;
+        end if;
+      end if;
+      if (ram_cen = '1' and ram_wen = '0' and ram_addr = x"e0000014") then
+        cycle_hi <= std_logic_vector(cycle_cnt(63 downto 32));
+      end if;
+      if (ram_cen = '1' and ram_wen = '0' and ram_addr = x"e000001c") then
+        instret_hi <= std_logic_vector(instret_cnt(63 downto 32));
+      end if;
+    end if;
+  end process;
+
 end architecture RTL;
@@ -32,7 +32,7 @@
 #define PWM_0_IRQ_NO    (8)
 #define PWM_0_IRQ       _BIT(PWM_0_NO)
 #define I2C_0_IRQ_NO    (9)
-#define I2C_0_IRQ       _BIT(I2C_0_NO)
+#define I2C_0_IRQ       _BIT(I2C_0_IRQ_NO)
 #define SPI_0_IRQ_NO    (10)
 #define SPI_0_IRQ       _BIT(SPI_0_NO)
 #define SPI_1_IRQ_NO    (11)
@@ -52,7 +52,7 @@
 #define ADC_0_IRQ_NO    (18)
 #define ADC_0_IRQ       _BIT(ADC_0_NO)
 #define I2C_1_IRQ_NO    (19)
-#define I2C_1_IRQ       _BIT(I2C_1_NO)
+#define I2C_1_IRQ       _BIT(I2C_1_IRQ_NO)
 #define BOD_IRQ_NO      (20)
 #define BOD_IRQ         _BIT(BOD_NO)
 #define ADC_1_IRQ_NO    (21)
@@ -6,8 +6,11 @@
  * Includes
  *****************************************************************************/
 
+#include <stddef.h>
+
 #include "../../general.h"
 #include "i2c.h"
+#include "../../VIC.h"
 #include <lpc2xxx.h>
 
 /******************************************************************************
@@ -34,6 +37,18 @@
 #define I2C_REG_SCLL        0x00000040 /* SCL Duty Cycle low register  */
 #define I2C_REG_SCLL_MASK   0x0000FFFF /* Used bits                    */
 
+/* keep the I2C interrupt out while the queue is changed */
+#define I2C_IRQ_OFF()       (VICIntEnClr  = I2C_0_IRQ)
+#define I2C_IRQ_ON()        (VICIntEnable = I2C_0_IRQ)
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+
+/* queued transfers; the head one is on the bus */
+static tI2cXfer* volatile pHead = NULL;
+static tI2cXfer*          pTail = NULL;
+
 /******************************************************************************
  *
  * Description:
@@ -643,5 +658,265 @@ i2cRead(tU8  addr,
   return retCode;
 }
 
+/******************************************************************************
+ *
+ * Description:
+ *    Loads the address byte after a (repeated) START: SLA+W while there
+ *    is data to write, or for a transfer with neither part (a probe),
+ *    else SLA+R.
+ *
+ *****************************************************************************/
+static void
+i2cSendAddress(tI2cXfer* pXfer)
+{
+  if((pXfer->txCount < pXfer->txLen) || (pXfer->rxLen == 0))
+    I2C_DATA = pXfer->addr & 0xfe;
+  else
+    I2C_DATA = pXfer->addr | 0x01;
+}
 
+/******************************************************************************
+ *
+ * Description:
+ *    Finishes the transfer at the head of the queue. The bus is kept for
+ *    the next queued one with a repeated START, so a batch of transfers
+ *    costs no STOP and bus free time in between; the last one ends with
+ *    a STOP. The callback runs last, so it may submit again.
+ *
+ * Params:
+ *    [in] status - final status of the transfer
+ *
+ *****************************************************************************/
+static void
+i2cComplete(tS8 status)
+{
+  tI2cXfer* pXfer = pHead;
+
+  pHead = pXfer->pNext;
+  if(pHead == NULL)
+  {
+    pTail = NULL;
+    I2C_CONSET = I2C_CONSET_STO;
+  }
+  else
+    I2C_CONSET = I2C_CONSET_STA;
+
+  pXfer->pNext  = NULL;
+  pXfer->status = status;
+
+  if(pXfer->pCallback != NULL)
+    pXfer->pCallback(pXfer);
+}
 
+/******************************************************************************
+ *
+ * Description:
+ *    Resets the I2C module and installs i2cIsr() in a vectored slot of
+ *    the VIC for queued transfers.
+ *
+ * Params:
+ *    [in] vicSlot - vector slot 0-15, its priority
+ *
+ *****************************************************************************/
+void
+i2cInitAsync(tU8 vicSlot)
+{
+  i2cInit();
+
+  pHead = NULL;
+  pTail = NULL;
+
+  VICIntSelect &= ~I2C_0_IRQ;
+  (&VICVectAddr0)[vicSlot] = (tU32)i2cIsr;
+  (&VICVectCntl0)[vicSlot] = VIC_ENABLE_SLOT | I2C_0_IRQ_NO;
+  VICIntEnable  = I2C_0_IRQ;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Queues a transfer. It starts at once when the bus is idle, else
+ *    after the transfers queued before it. May be called from tasks,
+ *    from other interrupt handlers and from the completion callbacks.
+ *
+ * Params:
+ *    [in] pXfer - the transfer; addr, pTx/txLen, pRx/rxLen, timeout and
+ *                 pCallback set by the caller
+ *
+ * Returns:
+ *    I2C_CODE_OK   - queued
+ *    I2C_CODE_BUSY - pXfer is still queued from an earlier submit
+ *
+ *****************************************************************************/
+tS8
+i2cSubmit(tI2cXfer* pXfer)
+{
+  if(pXfer->status == I2C_CODE_BUSY)
+    return I2C_CODE_BUSY;
+
+  pXfer->txCount = 0;
+  pXfer->rxCount = 0;
+  pXfer->ticks   = 0;
+  pXfer->pNext   = NULL;
+  pXfer->status  = I2C_CODE_BUSY;
+
+  I2C_IRQ_OFF();
+  if(pTail == NULL)
+  {
+    pHead = pXfer;
+    pTail = pXfer;
+    I2C_CONSET = I2C_CONSET_STA;
+  }
+  else
+  {
+    pTail->pNext = pXfer;
+    pTail        = pXfer;
+  }
+  I2C_IRQ_ON();
+
+  return I2C_CODE_OK;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Waits for a submitted transfer to finish. Not from interrupt
+ *    handlers.
+ *
+ * Returns:
+ *    the final status of the transfer
+ *
+ *****************************************************************************/
+tS8
+i2cWait(tI2cXfer* pXfer)
+{
+  while(pXfer->status == I2C_CODE_BUSY)
+  {
+    ;
+  }
+
+  return pXfer->status;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Checks if no transfer is queued or on the bus.
+ *
+ *****************************************************************************/
+tBool
+i2cIdle(void)
+{
+  return (pHead == NULL) ? TRUE : FALSE;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Counts a tick for the transfer on the bus and aborts it when its
+ *    timeout is reached: a slave that holds SCL low, or a controller
+ *    that stopped interrupting, would otherwise stall the queue. The
+ *    controller is disabled and enabled again, which leaves the bus, and
+ *    the next transfer starts.
+ *
+ *****************************************************************************/
+void
+i2cTimeoutTick(void)
+{
+  tI2cXfer* pXfer;
+
+  I2C_IRQ_OFF();
+  pXfer = pHead;
+  if((pXfer != NULL) && (pXfer->timeout != 0) &&
+     (++pXfer->ticks >= pXfer->timeout))
+  {
+    I2C_CONCLR = I2C_CONCLR_I2ENC | I2C_CONCLR_STAC | I2C_CONCLR_SIC |
+                 I2C_CONCLR_AAC;
+    I2C_CONSET = I2C_CONSET_I2EN;
+    i2cComplete(I2C_CODE_TIMEOUT);
+  }
+  I2C_IRQ_ON();
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    I2C interrupt: one step of the transfer at the head of the queue
+ *    per master status code (see i2cCheckStatus()). The write part goes
+ *    out after SLA+W, a repeated START turns the bus around for the read
+ *    part, whose last byte is not acknowledged, and i2cComplete() ends
+ *    it.
+ *
+ *****************************************************************************/
+void
+i2cIsr(void)
+{
+  tI2cXfer* pXfer  = pHead;
+  tU8       status = I2C_STAT;
+
+  if(pXfer == NULL)
+  {
+    /* aborted by a timeout meanwhile: release the bus */
+    I2C_CONSET = I2C_CONSET_STO;
+  }
+  else
+  {
+    switch(status)
+    {
+      /* START or repeated START transmitted */
+      case 0x08:
+      case 0x10:
+        I2C_CONCLR = I2C_CONCLR_STAC;
+        i2cSendAddress(pXfer);
+        break;
+
+      /* SLA+W or data byte transmitted, ACK received */
+      case 0x18:
+      case 0x28:
+        if(pXfer->txCount < pXfer->txLen)
+          I2C_DATA = pXfer->pTx[pXfer->txCount++];
+        else if(pXfer->rxLen != 0)
+          I2C_CONSET = I2C_CONSET_STA;
+        else
+        {
+          i2cComplete(I2C_CODE_OK);
+        }
+        break;
+
+      /* data byte received, ACK returned */
+      case 0x50:
+        pXfer->pRx[pXfer->rxCount++] = I2C_DATA;
+        /* fall through */
+
+      /* SLA+R transmitted, ACK received: acknowledge all but the last */
+      case 0x40:
+        if(pXfer->rxCount + 1 < pXfer->rxLen)
+          I2C_CONSET = I2C_CONSET_AA;
+        else
+          I2C_CONCLR = I2C_CONCLR_AAC;
+        break;
+
+      /* last data byte received, NACK returned */
+      case 0x58:
+        pXfer->pRx[pXfer->rxCount++] = I2C_DATA;
+        i2cComplete(I2C_CODE_OK);
+        break;
+
+      /* SLA+W, data byte or SLA+R not acknowledged */
+      case 0x20:
+      case 0x30:
+      case 0x48:
+        i2cComplete(I2C_CODE_NACK);
+        break;
+
+      /* bus error, arbitration lost: STOP before anything else */
+      default:
+        I2C_CONSET = I2C_CONSET_STO;
+        i2cComplete(I2C_CODE_ERROR);
+        break;
+    }
+  }
+
+  I2C_CONCLR  = I2C_CONCLR_SIC;
+  VICVectAddr = 0;
+}
@@ -17,6 +17,8 @@
 #define I2C_CODE_FULL  -2
 #define I2C_CODE_EMPTY -3
 #define I2C_CODE_BUSY  -4
+#define I2C_CODE_NACK    -5
+#define I2C_CODE_TIMEOUT -6
 
 
 
@@ -100,6 +102,58 @@ tS8  i2cWrite(tU8  addr, tU8* pData, tU32 len);
 tS8  i2cRead(tU8  addr, tU8* pBuf, tU32 len);
 
 
+/******************************************************************************
+ *
+ * Interrupt driven transfers (i2c.c).
+ *
+ * A transfer descriptor writes txLen bytes, then, after a repeated start,
+ * reads rxLen bytes, both to/from the same slave; either part may be
+ * empty. i2cSubmit() queues the descriptor and returns at once, the I2C
+ * interrupt (VIC channel 9) moves it through the bus states and calls
+ * pCallback from the interrupt when it is done, successful or not. The
+ * descriptor and its buffers belong to the driver until then. Transfers
+ * queued back to back follow each other with a repeated START; a STOP
+ * comes when the queue runs empty.
+ *
+ * i2cTimeoutTick() is meant to be called from a periodic timer interrupt;
+ * a transfer that is still on the bus after 'timeout' ticks is aborted
+ * with I2C_CODE_TIMEOUT and the controller is reset.
+ *
+ * Do not mix the polling functions above with queued transfers.
+ *
+ *****************************************************************************/
+typedef struct tI2cXfer tI2cXfer;
+
+struct tI2cXfer
+{
+  tU8           addr;       /* slave address, SLA+W (e.g. LM75_ADDRESS) */
+  tU8*          pTx;        /* written first                            */
+  tU32          txLen;
+  tU8*          pRx;        /* then read after a repeated start         */
+  tU32          rxLen;
+  tU32          timeout;    /* i2cTimeoutTick() calls, 0 = none         */
+  void        (*pCallback)(tI2cXfer* pXfer);  /* from the ISR, or NULL  */
+  void*         pArg;       /* free for the owner                       */
+
+  /* I2C_CODE_BUSY while queued, then I2C_CODE_OK, _NACK, _ERROR or
+   * _TIMEOUT */
+  volatile tS8  status;
+
+  /* driver state */
+  tU32          txCount;
+  tU32          rxCount;
+  tU32          ticks;
+  tI2cXfer*     pNext;
+};
+
+void  i2cInitAsync(tU8 vicSlot);
+tS8   i2cSubmit(tI2cXfer* pXfer);
+tS8   i2cWait(tI2cXfer* pXfer);
+tBool i2cIdle(void);
+void  i2cTimeoutTick(void);
+void  i2cIsr(void) __attribute__ ((interrupt("IRQ")));
+
+
 
 
 #endif
@@ -6,17 +6,36 @@
 static tU8 lm75Address = LM75_ADDRESS;
 static tU8 lm75LastRegister = LM75_REGISTER_TEMPERATURE;
 static tU8 lm75Mode = 1;
+static tBool lm75PointerValid = TRUE;   // lm75LastRegister is in the device
 
 
-static int lm75Read8 (tU8 reg, int *value)
+//
+//  Point the device at 'reg' unless it points there already: a read of the
+//  same register as last time costs no pointer write on the bus
+//
+static int lm75SetPointer (tU8 reg)
 {
+  if (lm75PointerValid && lm75LastRegister == reg)
+    return 0;
+
   lm75LastRegister = reg;
+  lm75PointerValid = FALSE;
+
+  if (i2cWrite (lm75Address, &reg, sizeof (tU8)) != I2C_CODE_OK)
+    return -1;
+
+  lm75PointerValid = TRUE;
+  return 0;
+}
+
+static int lm75Read8 (tU8 reg, int *value)
+{
   *value = 0;
 
-  if (i2cWrite (lm75Address, (tU8 *) &reg, sizeof (tU8)))
+  if (lm75SetPointer (reg))
     return -1;
 
-  return i2cRead (lm75Address, (tU8 *) value, sizeof (tU8));
+  return i2cRead (lm75Address, (tU8 *) value, sizeof (tU8)) == I2C_CODE_OK ? 0 : -1;
 }
 
 static int lm75Write8 (tU8 reg, int value)
@@ -26,7 +45,24 @@ static int lm75Write8 (tU8 reg, int value)
   buffer [0] = lm75LastRegister = reg;
   buffer [1] = value;
 
-  return i2cWrite (lm75Address, buffer, sizeof (buffer));
+  lm75PointerValid = i2cWrite (lm75Address, buffer, sizeof (buffer)) == I2C_CODE_OK;
+  return lm75PointerValid ? 0 : -1;
+}
+
+//
+//  Register bytes, MSB first, to temperature * 2
+//
+int lm75Convert (const tU8 *buffer)
+{
+  int value = ((buffer [0] << 8) | buffer [1]) >> 7;
+
+  //
+  //  Sign extend negative numbers
+  //
+  if (buffer [0] & 0x80)
+    value |= 0xfffffe00;
+
+  return value;
 }
 
 //
@@ -38,30 +74,24 @@ static int lm75Read16 (tU8 reg, int *value)
 {
   tU8 buffer [2];
 
-  buffer [0] = lm75LastRegister = reg;
-
   if (!lm75Mode)
   {
+    buffer [0] = lm75LastRegister = reg;
+
     // NOT IMPLEMENTED!!!
     // if (i2cWriteReadBuffer (lm75Address, buffer, sizeof (tU8), sizeof (buffer)))
       return -1;
   }
   else
   {
-    if (i2cWrite (lm75Address, (tU8 *) &reg, sizeof (tU8)))
+    if (lm75SetPointer (reg))
       return -1;
 
-    if (i2cRead (lm75Address, buffer, sizeof (buffer)))
+    if (i2cRead (lm75Address, buffer, sizeof (buffer)) != I2C_CODE_OK)
       return -1;
   }
 
-  //
-  //  Sign extend negative numbers
-  //
-  *value = ((buffer [0] << 8) | buffer [1]) >> 7;
-
-  if (buffer [0] & 0x80)
-    *value |= 0xfffffe00;
+  *value = lm75Convert (buffer);
 
   return 0; // I2CERR_NONE
 }
@@ -76,7 +106,8 @@ static int lm75Write16 (tU8 reg, int value)
   buffer [1] = value >> 8;
   buffer [2] = value;
 
-  return i2cWrite (lm75Address, buffer, sizeof (buffer));
+  lm75PointerValid = i2cWrite (lm75Address, buffer, sizeof (buffer)) == I2C_CODE_OK;
+  return lm75PointerValid ? 0 : -1;
 }
 
 //
@@ -97,6 +128,7 @@ void lm75SetMode (int mode)
 void lm75SetAddress (tU8 address)
 {
   lm75Address = address;
+  lm75PointerValid = FALSE;
 }
 
 int lm75ReRead (int *value)
@@ -104,12 +136,12 @@ int lm75ReRead (int *value)
   *value = 0;
 
   if (lm75LastRegister == LM75_REGISTER_CONFIGURATION)
-    return i2cRead (lm75Address, (tU8 *) value, sizeof (tU8));
+    return i2cRead (lm75Address, (tU8 *) value, sizeof (tU8)) == I2C_CODE_OK ? 0 : -1;
   else
   {
     tU8 buffer [2];
 
-    if (i2cRead (lm75Address, buffer, sizeof (buffer)))
+    if (i2cRead (lm75Address, buffer, sizeof (buffer)) != I2C_CODE_OK)
       return -1;
 
     *value = ((buffer [0] << 8) | buffer [1]) >> 7;
@@ -152,3 +184,44 @@ int lm75TOSWrite (int thystValue)
 {
   return lm75Write16 (LM75_REGISTER_TOS, thystValue);
 }
+
+//
+//  Completion of a queued read
+//
+static void lm75AsyncDone (tI2cXfer *pXfer)
+{
+  tLm75Async *pAsync = (tLm75Async *) pXfer;
+
+  if (pXfer->status == I2C_CODE_OK)
+    pAsync->value = lm75Convert (pAsync->buffer);
+  else
+    lm75PointerValid = FALSE;
+
+  if (pAsync->pDone)
+    pAsync->pDone (pAsync);
+}
+
+//
+//  Pointer write and 2-byte read in one transfer, with a repeated start in
+//  between, queued on the interrupt driven I2C driver (i2cInitAsync()):
+//  returns at once and the caller goes on computing while the bus works.
+//  When the pointer is at the temperature already, only the read goes out.
+//  A transfer queued before this one completes first, so the pointer is
+//  taken as set from here on.
+//
+int lm75TemperatureReadAsync (tLm75Async *pAsync, void (*pDone) (tLm75Async *pAsync))
+{
+  tBool cached = lm75PointerValid && lm75LastRegister == LM75_REGISTER_TEMPERATURE;
+
+  pAsync->reg             = lm75LastRegister = LM75_REGISTER_TEMPERATURE;
+  lm75PointerValid        = TRUE;
+  pAsync->pDone           = pDone;
+  pAsync->xfer.addr       = lm75Address;
+  pAsync->xfer.pTx        = &pAsync->reg;
+  pAsync->xfer.txLen      = cached ? 0 : sizeof (tU8);
+  pAsync->xfer.pRx        = pAsync->buffer;
+  pAsync->xfer.rxLen      = sizeof (pAsync->buffer);
+  pAsync->xfer.pCallback  = lm75AsyncDone;
+
+  return i2cSubmit (&pAsync->xfer) == I2C_CODE_OK ? 0 : -1;
+}
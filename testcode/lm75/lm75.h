@@ -1,4 +1,5 @@
 #include "../general.h"
+#include "i2c/i2c.h"
 
 #ifndef _LM75_H_
 #define _LM75_H_
@@ -11,6 +12,21 @@
 #define LM75_REGISTER_THYST         (0x02)
 #define LM75_REGISTER_TOS           (0x03)
 
+//
+//  Temperature read by a queued I2C transfer (lm75TemperatureReadAsync).
+//  'value' is the temperature * 2 as for lm75TemperatureRead(), valid in
+//  pDone when xfer.status is I2C_CODE_OK.
+//
+typedef struct tLm75Async tLm75Async;
+
+struct tLm75Async
+{
+  tI2cXfer xfer;            // first: the I2C callback gets &xfer
+  tU8      reg;
+  tU8      buffer [2];
+  int      value;
+  void   (*pDone) (tLm75Async *pAsync);   // from the I2C interrupt, or NULL
+};
 
 int  lm75Init (void);
 void lm75SetMode (int mode);
@@ -23,5 +39,7 @@ int  lm75THYSTRead (int *thystValue);
 int  lm75THYSTWrite (int thystValue);
 int  lm75TOSTRead (int *thystValue);
 int  lm75TOSWrite (int thystValue);
+int  lm75Convert (const tU8 *buffer);
+int  lm75TemperatureReadAsync (tLm75Async *pAsync, void (*pDone) (tLm75Async *pAsync));
 
 #endif
@@ -0,0 +1,290 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Batched LM75 sampling (see lm75sample.h).
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * Includes
+ *****************************************************************************/
+
+#include <stddef.h>
+
+#include "../general.h"
+#include "i2c/i2c.h"
+#include "lm75.h"
+#include "lm75sample.h"
+
+/******************************************************************************
+ * Defines and typedefs
+ *****************************************************************************/
+
+/* no reordering of memory accesses across it by the compiler; the core
+ * itself does not reorder */
+#define BARRIER()  asm volatile ("" ::: "memory")
+
+typedef struct
+{
+  tI2cXfer xfer;                  /* first: the callback gets &xfer       */
+  tU8      reg;
+  tU8      buffer[2];
+  tBool    pointerSet;            /* at the temperature register          */
+} tSensor;
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static tSensor        sensors[LM75_SAMPLER_SENSORS];
+static tU32           sensorCount;
+static tU32         (*pClockFn)(void);
+
+static volatile tBool running;    /* a batch is queued                    */
+static volatile tBool continuous;
+static tU32           batch;
+static tU32           pending;    /* reads of the batch not completed     */
+
+/* single-producer single-consumer ring; free running indices */
+static tLm75Sample    ring[LM75_RING_SIZE];
+static volatile tU32  head;       /* written by the producer only         */
+static volatile tU32  tail;       /* written by the consumer only         */
+static volatile tU32  lost;
+
+/******************************************************************************
+ *
+ * Description:
+ *    Queues one read per sensor. Only a sensor whose pointer register is
+ *    not known to be at the temperature gets the pointer write first.
+ *
+ *****************************************************************************/
+static void
+queueBatch(void)
+{
+  tSensor* pSensor;
+  tU32     i;
+
+  batch++;
+  pending = sensorCount;
+
+  for(i = 0; i < sensorCount; i++)
+  {
+    pSensor = &sensors[i];
+    pSensor->xfer.txLen = pSensor->pointerSet ? 0 : sizeof(tU8);
+    pSensor->pointerSet = TRUE;
+    i2cSubmit(&pSensor->xfer);
+  }
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Puts a sample into the ring, or counts it lost when the ring is
+ *    full. The slot is written before 'head' moves past it.
+ *
+ *****************************************************************************/
+static void
+publish(const tLm75Sample* pSample)
+{
+  tU32 h = head;
+
+  if(h - tail == LM75_RING_SIZE)
+  {
+    lost++;
+    return;
+  }
+
+  ring[h & (LM75_RING_SIZE - 1)] = *pSample;
+  BARRIER();
+  head = h + 1;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Completion of a read, from the I2C interrupt. The last read of a
+ *    batch queues the next batch in continuous mode.
+ *
+ *****************************************************************************/
+static void
+sampleDone(tI2cXfer* pXfer)
+{
+  tSensor*    pSensor = (tSensor*)pXfer;
+  tLm75Sample sample;
+
+  sample.time    = (pClockFn != NULL) ? pClockFn() : 0;
+  sample.batch   = batch;
+  sample.address = pXfer->addr;
+  sample.status  = pXfer->status;
+  sample.value   = 0;
+
+  if(pXfer->status == I2C_CODE_OK)
+    sample.value = lm75Convert(pSensor->buffer);
+  else
+    pSensor->pointerSet = FALSE;
+
+  publish(&sample);
+
+  if(--pending == 0)
+  {
+    if(continuous)
+      queueBatch();
+    else
+      running = FALSE;
+  }
+}
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+
+/******************************************************************************
+ *
+ * Description:
+ *    Sets up the sensors to sample and empties the ring. Not while a
+ *    batch is running.
+ *
+ * Params:
+ *    [in] pAddresses - SLA+W of each sensor (LM75_ADDRESS 0x90 to 0x9E)
+ *    [in] count      - number of sensors, at most LM75_SAMPLER_SENSORS
+ *    [in] pClock     - time stamp of the samples, or NULL for 0
+ *
+ *****************************************************************************/
+void
+lm75SamplerInit(const tU8* pAddresses,
+                tU32       count,
+                tU32     (*pClock)(void))
+{
+  tSensor* pSensor;
+  tU32     i;
+
+  if(count > LM75_SAMPLER_SENSORS)
+    count = LM75_SAMPLER_SENSORS;
+
+  for(i = 0; i < count; i++)
+  {
+    pSensor = &sensors[i];
+    pSensor->reg            = LM75_REGISTER_TEMPERATURE;
+    pSensor->pointerSet     = FALSE;
+    pSensor->xfer.addr      = pAddresses[i];
+    pSensor->xfer.pTx       = &pSensor->reg;
+    pSensor->xfer.txLen     = sizeof(tU8);
+    pSensor->xfer.pRx       = pSensor->buffer;
+    pSensor->xfer.rxLen     = sizeof(pSensor->buffer);
+    pSensor->xfer.timeout   = LM75_SAMPLER_TIMEOUT;
+    pSensor->xfer.pCallback = sampleDone;
+    pSensor->xfer.pArg      = NULL;
+    pSensor->xfer.status    = I2C_CODE_OK;
+  }
+
+  sensorCount = count;
+  pClockFn    = pClock;
+  running     = FALSE;
+  continuous  = FALSE;
+  batch       = 0;
+  head        = 0;
+  tail        = 0;
+  lost        = 0;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Starts sampling: one batch, or batch after batch until
+ *    lm75SamplerStop().
+ *
+ * Returns:
+ *    0, or -1 when a batch is still running or there are no sensors
+ *
+ *****************************************************************************/
+tS8
+lm75SamplerStart(tBool cont)
+{
+  if(running || (sensorCount == 0))
+    return -1;
+
+  continuous = cont;
+  running    = TRUE;
+  queueBatch();
+
+  return 0;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Ends continuous sampling after the batch in progress.
+ *
+ *****************************************************************************/
+void
+lm75SamplerStop(void)
+{
+  continuous = FALSE;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Checks if a batch is running.
+ *
+ *****************************************************************************/
+tBool
+lm75SamplerBusy(void)
+{
+  return running;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Forgets where the pointer registers are: the next batch writes them.
+ *
+ *****************************************************************************/
+void
+lm75SamplerInvalidate(void)
+{
+  tU32 i;
+
+  for(i = 0; i < sensorCount; i++)
+    sensors[i].pointerSet = FALSE;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Takes the oldest sample out of the ring. The slot is read after
+ *    'head' and before 'tail' gives it back to the producer.
+ *
+ * Params:
+ *    [out] pSample - the sample
+ *
+ * Returns:
+ *    TRUE, or FALSE when the ring is empty
+ *
+ *****************************************************************************/
+tBool
+lm75SampleGet(tLm75Sample* pSample)
+{
+  tU32 t = tail;
+
+  if(head == t)
+    return FALSE;
+
+  BARRIER();
+  *pSample = ring[t & (LM75_RING_SIZE - 1)];
+  BARRIER();
+  tail = t + 1;
+
+  return TRUE;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Samples dropped because the ring was full.
+ *
+ *****************************************************************************/
+tU32
+lm75SamplesLost(void)
+{
+  return lost;
+}
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Batched sampling of several LM75 sensors on the interrupt driven I2C
+ *    driver (i2c.h), into a lock-free ring of timestamped samples
+ *    (lm75sample.c).
+ *
+ *    One batch queues a temperature read per sensor; the driver runs them
+ *    back to back with repeated STARTs. The pointer register of an LM75
+ *    keeps its value, so it is written once, in the first batch and again
+ *    after a failed read, and every other read is SLA+R and two data
+ *    bytes: 28 bit times instead of 47.
+ *
+ *    In continuous mode the end of a batch queues the next one from the
+ *    I2C interrupt, so the sensors are read at the bus rate and the CPU
+ *    only runs the interrupt.
+ *
+ *      static const tU8 addr[] = { 0x90, 0x92, 0x94 };
+ *      tLm75Sample      s;
+ *
+ *      i2cInitAsync(1);
+ *      lm75SamplerInit(addr, 3, readClock);
+ *      lm75SamplerStart(TRUE);
+ *      for(;;)
+ *      {
+ *        while(lm75SampleGet(&s))
+ *          send(&s);
+ *        compute();
+ *      }
+ *
+ *    The ring has one producer, the I2C completion callback (or the timer
+ *    interrupt of i2cTimeoutTick(); interrupts do not nest), and one
+ *    consumer, lm75SampleGet() from one task or the main loop. Each side
+ *    writes only its own index, so neither takes a lock or turns
+ *    interrupts off. A sample that finds the ring full is dropped and
+ *    counted.
+ *
+ *    The sampler owns the pointer registers of its sensors: after another
+ *    register of one of them is read or written through lm75.h, call
+ *    lm75SamplerInvalidate().
+ *
+ *****************************************************************************/
+#ifndef _LM75SAMPLE_H_
+#define _LM75SAMPLE_H_
+
+#include "../general.h"
+
+/******************************************************************************
+ * Defines and typedefs
+ *****************************************************************************/
+#define LM75_SAMPLER_SENSORS 8    /* A2-A0: 0x90 to 0x9E                 */
+#define LM75_SAMPLER_TIMEOUT 2    /* i2cTimeoutTick() calls per read      */
+#define LM75_RING_SIZE       64   /* samples, a power of two              */
+
+typedef struct
+{
+  tU32 time;                      /* pClock() when the read completed     */
+  tU32 batch;                     /* batch number, from 1                 */
+  tU8  address;                   /* of the sensor                        */
+  tS8  status;                    /* I2C_CODE_OK, else 'value' is invalid */
+  tS16 value;                     /* temperature * 2                      */
+} tLm75Sample;
+
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+void  lm75SamplerInit(const tU8* pAddresses, tU32 count,
+                      tU32 (*pClock)(void));
+tS8   lm75SamplerStart(tBool continuous);
+void  lm75SamplerStop(void);
+tBool lm75SamplerBusy(void);
+void  lm75SamplerInvalidate(void);
+tBool lm75SampleGet(tLm75Sample* pSample);
+tU32  lm75SamplesLost(void);
+
+#endif
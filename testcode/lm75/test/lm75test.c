@@ -0,0 +1,311 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Regression image of the interrupt driven I2C driver (i2c.h) against
+ *    the LM75 models of the simulator (sim/, SIM=verilator), run with
+ *    +lpc +lm75_count=2 +lm75_temp=21.5, so 0x90 reads 21.5 C, 0x92 reads
+ *    22.5 C and nothing answers at 0x94. See regress/tests.lst.
+ *
+ *    A read through lm75TemperatureReadAsync(), then four transfers queued
+ *    back to back, which the driver joins with repeated STARTs: a read with
+ *    the pointer write, a read without, one to the missing sensor, which
+ *    has to end in I2C_CODE_NACK and leave the queue running, and a read of
+ *    TOS (80 C after reset). A descriptor submitted again while it is still
+ *    queued is turned away with I2C_CODE_BUSY.
+ *
+ *    Then the batched sampler (lm75sample.h) over 0x90, 0x92 and 0x94:
+ *    BATCHES single batches without draining, which fill the ring and
+ *    drop the rest, a count per sensor of what the ring kept, and one
+ *    batch after lm75SamplerInvalidate(). Only the first batch and the one
+ *    after the invalidate write the pointer of a sensor that answers; the
+ *    missing one gets it every time, as every read of it fails.
+ *
+ *    The sampler is timed with Timer0 at PCLK, the clock of the I2C bit
+ *    time (I2SCLH + I2SCLL). The ring has to hand the samples back in
+ *    order, with their batch numbers and rising time stamps, and the 0x92
+ *    read, which follows the 0x90 one of its batch, has to take at least
+ *    the bit times of its bytes: 45 with the pointer write in the first
+ *    batch, 27 after, and less time than the first.
+ *
+ *    Every result is printed and checked; the number of wrong ones is the
+ *    exit status. The SIM: lm75 lines of the simulator count the SLA+R
+ *    and the pointer writes each sensor saw.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * Includes
+ *****************************************************************************/
+#include <stddef.h>
+
+#include "../../general.h"
+#include <lpc2xxx.h>
+#include <config.h>
+#include <ea_init.h>
+#include <consol.h>
+#include "../i2c/i2c.h"
+#include "../lm75.h"
+#include "../lm75sample.h"
+
+/******************************************************************************
+ * Defines and typedefs
+ *****************************************************************************/
+#define SIM_EXIT    (*(volatile unsigned int *)0xE0000010)
+
+#define TEMP_0x90   43            /* 21.5 C, temperature * 2              */
+#define TEMP_0x92   45
+#define TEMP_TOS    160           /* 80 C, the reset value                */
+
+#define SENSORS     3
+#define BATCHES     30            /* 90 samples into LM75_RING_SIZE       */
+#define KEPT        LM75_RING_SIZE
+#define LOST        (BATCHES * SENSORS - LM75_RING_SIZE)
+
+/* 9 bit times per byte, the STARTs not counted */
+#define BITS_PTR    45            /* SLA+W, register, SLA+R, 2 data bytes */
+#define BITS_CACHED 27            /* SLA+R, 2 data bytes                  */
+
+typedef struct
+{
+  tU32 ok;
+  tU32 nack;
+  tU32 other;                     /* another status or temperature        */
+} tTally;
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static tU32       errors;
+
+static tLm75Async async;
+
+static tU8        regTemp = LM75_REGISTER_TEMPERATURE;
+static tU8        regTos  = LM75_REGISTER_TOS;
+static tU8        rx[4][2];
+
+static tI2cXfer   xfer[4] = {
+  { 0x90, &regTemp, 1, rx[0], 2 },
+  { 0x92, NULL,     0, rx[1], 2 },
+  { 0x94, &regTemp, 1, NULL,  0 },
+  { 0x90, &regTos,  1, rx[3], 2 },
+};
+
+static const tU8  sensorAddr[SENSORS] = { 0x90, 0x92, 0x94 };
+static const tS8  sensorCode[SENSORS] = { I2C_CODE_OK, I2C_CODE_OK,
+                                          I2C_CODE_NACK };
+static const int  sensorTemp[SENSORS] = { TEMP_0x90, TEMP_0x92, 0 };
+static tTally     tally[SENSORS];
+
+static tU32       misordered;     /* address, batch or time out of order  */
+static tU32       readPtr;        /* 0x92 read of batch 1, timer ticks    */
+static tU32       readCached;     /* longest 0x92 read after it           */
+
+/******************************************************************************
+ *
+ * Description:
+ *    Prints a result, "<what>: <status>[ <temperature> C]", and counts it
+ *    when it is not the expected one. The temperature is only compared
+ *    for I2C_CODE_OK.
+ *
+ *****************************************************************************/
+static void
+check(const char* pWhat, tS8 status, int value, tS8 expStatus, int expValue)
+{
+  const char* pStatus;
+
+  switch(status)
+  {
+    case I2C_CODE_OK:      pStatus = "ok";      break;
+    case I2C_CODE_NACK:    pStatus = "nack";    break;
+    case I2C_CODE_BUSY:    pStatus = "busy";    break;
+    case I2C_CODE_TIMEOUT: pStatus = "timeout"; break;
+    default:               pStatus = "error";   break;
+  }
+
+  if(status == I2C_CODE_OK)
+    simplePrintf("%s: %s %d.%d C\n", pWhat, pStatus, value / 2,
+                 (value & 1) * 5);
+  else
+    simplePrintf("%s: %s\n", pWhat, pStatus);
+
+  if(status != expStatus || (status == I2C_CODE_OK && value != expValue))
+    errors++;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Time stamp of the samples: Timer0, counting PCLK.
+ *
+ *****************************************************************************/
+static tU32
+readClock(void)
+{
+  return T0TC;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Runs one batch of the sampler to its end.
+ *
+ *****************************************************************************/
+static void
+sampleBatch(void)
+{
+  if(lm75SamplerStart(FALSE) != 0)
+    errors++;
+  while(lm75SamplerBusy())
+    ;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Takes all samples out of the ring and counts them per sensor. The
+ *    first one is of batch 'firstBatch' and sensor 0x90; each is checked
+ *    for its place in the order and timed against the one before.
+ *
+ * Returns:
+ *    the number of samples
+ *
+ *****************************************************************************/
+static tU32
+drain(tU32 firstBatch)
+{
+  tLm75Sample s;
+  tU32        n = 0;
+  tU32        last = 0;
+  tU32        i;
+
+  while(lm75SampleGet(&s))
+  {
+    if(s.address != sensorAddr[n % SENSORS] ||
+       s.batch != firstBatch + n / SENSORS ||
+       (n > 0 && (tS32)(s.time - last) < 0))
+      misordered++;
+    if(s.address == 0x92 && s.batch == 1)
+      readPtr = s.time - last;
+    else if(s.address == 0x92 && firstBatch == 1 &&
+            s.time - last > readCached)
+      readCached = s.time - last;
+    last = s.time;
+
+    n++;
+    for(i = 0; i < SENSORS && sensorAddr[i] != s.address; i++)
+      ;
+    if(i == SENSORS)
+      errors++;
+    else if(s.status != sensorCode[i] ||
+            (s.status == I2C_CODE_OK && s.value != sensorTemp[i]))
+      tally[i].other++;
+    else if(s.status == I2C_CODE_OK)
+      tally[i].ok++;
+    else
+      tally[i].nack++;
+  }
+  return n;
+}
+
+/******************************************************************************
+ *
+ * Description:
+ *    Prints and checks the counts of drain(), then clears them. 'batches'
+ *    is the number of samples of each sensor that should have been kept.
+ *
+ *****************************************************************************/
+static void
+checkTally(const tU32* pBatches)
+{
+  tU32 i;
+
+  for(i = 0; i < SENSORS; i++)
+  {
+    simplePrintf("0x%x: %d ok, %d nack, %d wrong\n", sensorAddr[i],
+                 tally[i].ok, tally[i].nack, tally[i].other);
+    if(tally[i].other != 0 ||
+       (sensorCode[i] == I2C_CODE_OK ? tally[i].ok : tally[i].nack) !=
+       pBatches[i])
+      errors++;
+    tally[i].ok = tally[i].nack = tally[i].other = 0;
+  }
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+int
+main(void)
+{
+  static const tU32 kept[SENSORS] = { KEPT / SENSORS + 1, KEPT / SENSORS,
+                                      KEPT / SENSORS };
+  static const tU32 once[SENSORS] = { 1, 1, 1 };
+  tS8  code;
+  tU32 i, n, bit;
+
+  eaInit();
+  i2cInitAsync(0);
+
+  simplePrintf("lm75test: I2C queue\n");
+
+  lm75TemperatureReadAsync(&async, NULL);
+  check("async 0x90", i2cWait(&async.xfer), async.value, I2C_CODE_OK,
+        TEMP_0x90);
+
+  i2cSubmit(&xfer[0]);
+  code = i2cSubmit(&xfer[0]);
+  i2cSubmit(&xfer[1]);
+  i2cSubmit(&xfer[2]);
+  i2cSubmit(&xfer[3]);
+  check("resubmit", code, 0, I2C_CODE_BUSY, 0);
+
+  i2cWait(&xfer[3]);
+  check("0x90 ptr", xfer[0].status, lm75Convert(rx[0]), I2C_CODE_OK,
+        TEMP_0x90);
+  check("0x92", xfer[1].status, lm75Convert(rx[1]), I2C_CODE_OK, TEMP_0x92);
+  check("0x94", xfer[2].status, 0, I2C_CODE_NACK, 0);
+  check("0x90 tos", xfer[3].status, lm75Convert(rx[3]), I2C_CODE_OK,
+        TEMP_TOS);
+
+  simplePrintf("lm75test: sampler\n");
+
+  T0TCR = 2;                      /* reset */
+  T0PR  = 0;
+  T0TCR = 1;
+  bit   = I2SCLH + I2SCLL;
+
+  lm75SamplerInit(sensorAddr, SENSORS, readClock);
+  for(i = 0; i < BATCHES; i++)
+    sampleBatch();
+  n = drain(1);
+  simplePrintf("kept %d, lost %d\n", n, lm75SamplesLost());
+  if(n != KEPT || lm75SamplesLost() != LOST)
+    errors++;
+  checkTally(kept);
+
+  simplePrintf("0x92 read: pointer write %s, cached %s\n",
+               readPtr >= BITS_PTR * bit ? "ok" : "short",
+               readCached >= BITS_CACHED * bit ? "ok" : "short");
+  simplePrintf("cached read faster: %s\n",
+               readCached < readPtr ? "ok" : "wrong");
+  if(readPtr < BITS_PTR * bit || readCached < BITS_CACHED * bit ||
+     readCached >= readPtr)
+    errors++;
+
+  lm75SamplerInvalidate();
+  sampleBatch();
+  n = drain(BATCHES + 1);
+  simplePrintf("invalidated: kept %d\n", n);
+  if(n != SENSORS)
+    errors++;
+  checkTally(once);
+
+  simplePrintf("order: %s\n", misordered ? "wrong" : "ok");
+  if(misordered)
+    errors++;
+
+  simplePrintf("lm75test: %d errors\n", errors);
+  SIM_EXIT = errors;
+  for(;;)
+    ;
+}
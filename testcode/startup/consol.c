@@ -30,6 +30,9 @@
 #if (CONSOLE_API_PRINTF == 1) || (CONSOLE_API_SCANF == 1) //own simple printf() or scanf()
 #include <stdarg.h>
 #endif
+#if (CONSOLE_API_PRINTF == 1)
+#include "format.h"
+#endif
 
 #define UART_DLL_VALUE (unsigned short)((PCLK / (CONSOL_BITRATE * 16.0)) + 0.5)
 
@@ -48,144 +51,22 @@
 /*****************************************************************************
  *
  * Description:
- *    Print a number. 
- *
- * Params:
- *    [in] outputFnk - Output function where characters to be printed are 
- *                      sent 
- * 
- *                Params (callback):
- *                   ch - Character to be printed 
- *    [in] number    - Number to be printed 
- *    [in] base      - Base when printing number (2-16) 
- *
- ****************************************************************************/
-static void
-printNum(void (*outputFnk) (char ch),
-         unsigned int number,
-         unsigned int base)
-{
-	char *p;
-	char  buf[33];
-	char  hexChars[] = "0123456789abcdef";
-	
-	p = buf;
-	
-	do {
-		*p++ = hexChars[number % base];
-	} while (number /= base);
-	
-	do {
-		outputFnk(*--p);
-	} while (p > buf);
-}
-
-/*****************************************************************************
- *
- * Description:
- *    A simple implementation of printf that uses a minimum of stack space.
+ *    Output function of formatPrint(), sends the text to the consol.
  *
  * Params:
- *    [in] outputFnk - Output function where characters to be printed are 
- *                      sent 
- * 
- *                Params (callback):
- *                   ch - Character to be printed 
- *    [in] fmt       - Format string that specifies what to be printed 
- *    [in] ap        - Structure that hold information about the variable 
- *                     number of parameters 
+ *    [in] arg  - Not used
+ *    [in] pBuf - Characters to be printed
+ *    [in] len  - Number of characters
  *
  ****************************************************************************/
 static void
-simplePrint(void         (*outputFnk) (char ch),
-            const char * fmt,
-            va_list      ap)
+consolSink(void       *arg,
+           const char *pBuf,
+           int         len)
 {
-  char          *p;
-  char           ch;
-  unsigned long  ul;
-  unsigned char  lflag;
-
-  for (;;)
-  {
-    while ((ch = *fmt++) != '%')
-    {
-      if (ch == '\0')
-        	return;
-      outputFnk(ch);
-    }
-    lflag = 0;
-
-reswitch:
-
-    switch (ch = *fmt++)
-    {
-    case '\0':
-      return;
-
-    case 'l':
-      lflag = 1;
-      goto reswitch;
-
-    case 'c':
-	    ch = va_arg(ap, unsigned int);
-	    outputFnk(ch & 0x7f);
-	    break;
-
-    case 's':
-      p = va_arg(ap, char *);
-      while ((ch = *p++) != 0)
-	    {
-          outputFnk(ch);
-		}
-      break;
-
-    case 'd':
-      if (lflag)
-	    {
-		  ul = va_arg(ap, int);
-        }
-		else
-		{
-			ul = va_arg(ap, unsigned int);
-		};
-      if ((long)ul < 0)
-      {
-        outputFnk('-');
-        ul = -(long)ul;
-      }
-      printNum(outputFnk, ul, 10);
-      break;
-
-    case 'o':
-      ul = va_arg(ap, unsigned int);
-      printNum(outputFnk, ul, 8);
-      break;
-
-    case 'u':
-      ul = va_arg(ap, unsigned int);
-      printNum(outputFnk, ul, 10);
-      break;
-
-    case 'p':
-      outputFnk('0');
-      outputFnk('x');
-      lflag = 1;
-      // fall through
-
-    case 'x':
-      ul = va_arg(ap, unsigned int);
-      printNum(outputFnk, ul, 16);
-      break;
-
-    default:
-//      outputFnk('%');
-      if (lflag)
-        outputFnk('l');
-      outputFnk(ch);
-    }
-  }
-  va_end(ap);
+  (void)arg;
+  while (len-- > 0)
+    consolSendCh(*pBuf++);
 }
 #endif
 
@@ -369,7 +250,8 @@ consolSendNumber(unsigned char base,
 /*****************************************************************************
  *
  * Description:
- *    Simple implementation of printf 
+ *    Simple implementation of printf, without heap and floating point
+ *    (conversions in format.h)
  *
  * Params:
  *    [in] fmt - Format string that specifies what to be printed 
@@ -383,7 +265,7 @@ simplePrintf(const char * fmt,
 	va_list ap;
 
 	va_start(ap, fmt);
-	simplePrint(consolSendCh, fmt, ap);
+	formatPrint(consolSink, 0, fmt, ap);
 	va_end(ap);
 }
 #endif
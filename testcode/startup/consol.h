@@ -127,7 +127,8 @@ void consolSendNumber(unsigned char base,
 /*****************************************************************************
  *
  * Description:
- *    Simple implementation of printf 
+ *    Simple implementation of printf, without heap and floating point
+ *    (conversions in format.h)
  *
  * Params:
  *    [in] fmt - Format string that specifies what to be printed 
@@ -0,0 +1,526 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Integer-only formatted output (see format.h). Everything lives on
+ *    the stack of the caller, so the formatter is reentrant and can be
+ *    used from interrupt handlers. The core has no divide instruction:
+ *    decimal digits come from a multiplication with the reciprocal of 10,
+ *    hexadecimal and octal digits from shifts.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * Includes
+ *****************************************************************************/
+#include "format.h"
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+#define FLAG_LEFT   0x01
+#define FLAG_ZERO   0x02
+#define FLAG_PLUS   0x04
+#define FLAG_SPACE  0x08
+#define FLAG_ALT    0x10
+#define FLAG_UPPER  0x20
+#define FLAG_PTR    0x40                        /* 0x even for a zero */
+
+#define MAX_DECIMALS 9
+
+typedef struct
+{
+  tFormatSink sink;
+  void       *arg;
+  int         count;
+} tOut;
+
+typedef struct
+{
+  unsigned char flags;
+  int           width;
+  int           prec;                           /* -1 = none */
+} tSpec;
+
+/******************************************************************************
+ * Local variables
+ *****************************************************************************/
+static const char padSpaces[16] = "                ";
+static const char padZeros[16]  = "0000000000000000";
+static const char digitsLower[] = "0123456789abcdef";
+static const char digitsUpper[] = "0123456789ABCDEF";
+
+static const unsigned int pow10[MAX_DECIMALS + 1] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/******************************************************************************
+ * Implementation of local functions
+ *****************************************************************************/
+
+static void
+emit(tOut *pOut, const char *pBuf, int len)
+{
+  if (len > 0)
+  {
+    pOut->sink(pOut->arg, pBuf, len);
+    pOut->count += len;
+  }
+}
+
+static void
+pad(tOut *pOut, const char *pWith, int count)
+{
+  while (count > (int)sizeof(padSpaces))
+  {
+    emit(pOut, pWith, sizeof(padSpaces));
+    count -= sizeof(padSpaces);
+  }
+  emit(pOut, pWith, count);
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    n / 10: 0xcccccccd / 2^35 is 1/10 closely enough for every 32-bit n.
+ *
+ ****************************************************************************/
+static unsigned int
+div10(unsigned int n)
+{
+  return (unsigned int)(((unsigned long long)n * 0xcccccccdu) >> 35);
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    n / 10 for 64 bits with shifts and adds only (Hacker's Delight,
+ *    divu10), which keeps the 64-bit library division out of the image.
+ *
+ ****************************************************************************/
+static unsigned long long
+div10ll(unsigned long long n)
+{
+  unsigned long long q;
+  unsigned long long r;
+
+  q  = (n >> 1) + (n >> 2);
+  q += q >> 4;
+  q += q >> 8;
+  q += q >> 16;
+  q += q >> 32;
+  q >>= 3;
+  r  = n - ((q << 3) + (q << 1));
+  return q + ((r + 6) >> 4);
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Write the digits of 'number' right to left, ending at 'pEnd'.
+ *
+ * Returns:
+ *    char * - the first digit
+ *
+ ****************************************************************************/
+static char *
+printNum(char               *pEnd,
+         unsigned long long  number,
+         unsigned int        base,
+         const char         *pDigits)
+{
+  if (base == 10)
+  {
+    unsigned int n;
+    unsigned int q;
+
+    while (number >> 32)
+    {
+      unsigned long long q64 = div10ll(number);
+
+      *--pEnd = '0' + (unsigned int)(number - q64 * 10);
+      number  = q64;
+    }
+    n = (unsigned int)number;
+    do {
+      q       = div10(n);
+      *--pEnd = '0' + (n - q * 10);
+      n       = q;
+    } while (n);
+  }
+  else
+  {
+    unsigned int shift = base == 16 ? 4 : 3;
+
+    do {
+      *--pEnd = pDigits[(unsigned int)number & (base - 1)];
+      number >>= shift;
+    } while (number);
+  }
+  return pEnd;
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Output one field: the prefix (sign, 0x), 'zeros' leading zeros and
+ *    the body, padded to the field width.
+ *
+ ****************************************************************************/
+static void
+printField(tOut        *pOut,
+           const tSpec *pSpec,
+           const char  *pPrefix,
+           int          prefixLen,
+           const char  *pBody,
+           int          bodyLen,
+           int          zeros)
+{
+  int len  = prefixLen + zeros + bodyLen;
+  int fill = pSpec->width > len ? pSpec->width - len : 0;
+
+  if (!(pSpec->flags & (FLAG_LEFT | FLAG_ZERO)))
+    pad(pOut, padSpaces, fill);
+  emit(pOut, pPrefix, prefixLen);
+  if ((pSpec->flags & (FLAG_LEFT | FLAG_ZERO)) == FLAG_ZERO)
+    pad(pOut, padZeros, fill);
+  pad(pOut, padZeros, zeros);
+  emit(pOut, pBody, bodyLen);
+  if (pSpec->flags & FLAG_LEFT)
+    pad(pOut, padSpaces, fill);
+}
+
+/* sign character of the flags, or 0 */
+static int
+signPrefix(const tSpec *pSpec, int negative, char *pPrefix)
+{
+  if (negative)
+    *pPrefix = '-';
+  else if (pSpec->flags & FLAG_PLUS)
+    *pPrefix = '+';
+  else if (pSpec->flags & FLAG_SPACE)
+    *pPrefix = ' ';
+  else
+    return 0;
+  return 1;
+}
+
+static void
+printInt(tOut               *pOut,
+         const tSpec        *pSpec,
+         unsigned long long  number,
+         int                 negative,
+         unsigned int        base)
+{
+  char  buf[24];                                /* 64 bits in octal */
+  char *pEnd = buf + sizeof(buf);
+  char *pBuf = pEnd;
+  char  prefix[2];
+  int   prefixLen;
+  int   len;
+
+  if (number != 0 || pSpec->prec != 0)          /* %.0d of 0 is empty */
+    pBuf = printNum(pEnd, number, base,
+                    (pSpec->flags & FLAG_UPPER) ? digitsUpper : digitsLower);
+  len = pEnd - pBuf;
+
+  prefixLen = signPrefix(pSpec, negative, prefix);
+  if (pSpec->flags & FLAG_ALT)
+  {
+    if (base == 16 && (number != 0 || (pSpec->flags & FLAG_PTR)))
+    {
+      prefix[prefixLen++] = '0';
+      prefix[prefixLen++] = (pSpec->flags & FLAG_UPPER) ? 'X' : 'x';
+    }
+    else if (base == 8 && pSpec->prec <= len && (len == 0 || *pBuf != '0'))
+      prefix[prefixLen++] = '0';
+  }
+
+  printField(pOut, pSpec, prefix, prefixLen, pBuf, len,
+             pSpec->prec > len ? pSpec->prec - len : 0);
+}
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Signed fixed point 'value' with 'bits' fraction bits (8-31), rounded
+ *    to the precision in decimals.
+ *
+ ****************************************************************************/
+static void
+printFixed(tOut        *pOut,
+           const tSpec *pSpec,
+           int          value,
+           unsigned int bits)
+{
+  char               buf[24];
+  char              *pEnd = buf + sizeof(buf);
+  char              *pBuf = pEnd;
+  char               prefix[1];
+  unsigned int       mag;
+  unsigned int       intPart;
+  unsigned int       frac;
+  unsigned long long scaled;
+  int                decimals;
+  int                i;
+
+  decimals = pSpec->prec;
+  if (decimals < 0)
+    decimals = (bits * 3 + 9) / 10;             /* resolution of the fraction */
+  if (decimals > MAX_DECIMALS)
+    decimals = MAX_DECIMALS;
+
+  mag     = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+  intPart = mag >> bits;
+  frac    = mag & ((1u << bits) - 1);
+
+  scaled = ((unsigned long long)frac * pow10[decimals] +
+            (1ull << (bits - 1))) >> bits;
+  if (scaled >= pow10[decimals])                /* rounded up to the next unit */
+  {
+    intPart++;
+    scaled -= pow10[decimals];
+  }
+
+  if (decimals > 0)
+  {
+    unsigned int n = (unsigned int)scaled;
+    unsigned int q;
+
+    for (i = 0; i < decimals; i++)
+    {
+      q       = div10(n);
+      *--pBuf = '0' + (n - q * 10);
+      n       = q;
+    }
+    *--pBuf = '.';
+  }
+  pBuf = printNum(pBuf, intPart, 10, digitsLower);
+
+  printField(pOut, pSpec, prefix, signPrefix(pSpec, value < 0, prefix),
+             pBuf, pEnd - pBuf, 0);
+}
+
+/******************************************************************************
+ * Implementation of public functions
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Format 'fmt' with the arguments in 'ap' into 'sink' (see format.h).
+ *
+ * Params:
+ *    [in] sink - Output function, gets the text in chunks
+ *    [in] arg  - Passed on to 'sink'
+ *    [in] fmt  - Format string that specifies what to be printed
+ *    [in] ap   - The arguments
+ *
+ * Returns:
+ *    int - number of characters produced
+ *
+ ****************************************************************************/
+int
+formatPrint(tFormatSink sink, void *arg, const char *fmt, va_list ap)
+{
+  tOut        out;
+  tSpec       spec;
+  const char *pStart;
+  int         length;                           /* -2 hh, -1 h, 1 l, 2 ll */
+
+  out.sink  = sink;
+  out.arg   = arg;
+  out.count = 0;
+
+  for (;;)
+  {
+    pStart = fmt;
+    while (*fmt != '\0' && *fmt != '%')
+      fmt++;
+    emit(&out, pStart, fmt - pStart);
+    if (*fmt == '\0')
+      return out.count;
+    pStart = fmt++;
+
+    /* flags */
+    spec.flags = 0;
+    for (;; fmt++)
+    {
+      if (*fmt == '-')
+        spec.flags |= FLAG_LEFT;
+      else if (*fmt == '0')
+        spec.flags |= FLAG_ZERO;
+      else if (*fmt == '+')
+        spec.flags |= FLAG_PLUS;
+      else if (*fmt == ' ')
+        spec.flags |= FLAG_SPACE;
+      else if (*fmt == '#')
+        spec.flags |= FLAG_ALT;
+      else
+        break;
+    }
+
+    /* width and precision */
+    spec.width = 0;
+    if (*fmt == '*')
+    {
+      spec.width = va_arg(ap, int);
+      if (spec.width < 0)
+      {
+        spec.flags |= FLAG_LEFT;
+        spec.width  = -spec.width;
+      }
+      fmt++;
+    }
+    else
+      while (*fmt >= '0' && *fmt <= '9')
+        spec.width = spec.width * 10 + (*fmt++ - '0');
+
+    spec.prec = -1;
+    if (*fmt == '.')
+    {
+      fmt++;
+      spec.prec = 0;
+      if (*fmt == '*')
+      {
+        spec.prec = va_arg(ap, int);
+        if (spec.prec < 0)
+          spec.prec = -1;
+        fmt++;
+      }
+      else
+        while (*fmt >= '0' && *fmt <= '9')
+          spec.prec = spec.prec * 10 + (*fmt++ - '0');
+    }
+
+    /* length */
+    length = 0;
+    if (*fmt == 'h')
+      length = *++fmt == 'h' ? (fmt++, -2) : -1;
+    else if (*fmt == 'l')
+      length = *++fmt == 'l' ? (fmt++, 2) : 1;
+    else if (*fmt == 'z' || *fmt == 't')
+      fmt++;
+
+    switch (*fmt++)
+    {
+    case 'd':
+    case 'i':
+    {
+      long long value;
+
+      if (spec.prec >= 0)
+        spec.flags &= ~FLAG_ZERO;               /* the precision pads instead */
+      if (length == 2)
+        value = va_arg(ap, long long);
+      else
+      {
+        value = va_arg(ap, int);
+        if (length == -1)
+          value = (short)value;
+        else if (length == -2)
+          value = (signed char)value;
+      }
+      printInt(&out, &spec, value < 0 ? 0ull - (unsigned long long)value :
+               (unsigned long long)value, value < 0, 10);
+      break;
+    }
+
+    case 'X':
+      spec.flags |= FLAG_UPPER;
+      /* fall through */
+    case 'u':
+    case 'x':
+    case 'o':
+    {
+      unsigned long long value;
+
+      if (spec.prec >= 0)
+        spec.flags &= ~FLAG_ZERO;               /* the precision pads instead */
+      if (length == 2)
+        value = va_arg(ap, unsigned long long);
+      else
+      {
+        value = va_arg(ap, unsigned int);
+        if (length == -1)
+          value = (unsigned short)value;
+        else if (length == -2)
+          value = (unsigned char)value;
+      }
+      spec.flags &= ~(FLAG_PLUS | FLAG_SPACE);
+      printInt(&out, &spec, value, 0,
+               fmt[-1] == 'o' ? 8 : fmt[-1] == 'u' ? 10 : 16);
+      break;
+    }
+
+    case 'p':
+      spec.flags = (spec.flags & ~(FLAG_PLUS | FLAG_SPACE)) |
+                   FLAG_ALT | FLAG_PTR;
+      printInt(&out, &spec, (unsigned long)va_arg(ap, void *), 0, 16);
+      break;
+
+    case 'q':
+      if (length == -1)
+        printFixed(&out, &spec, (short)va_arg(ap, int), 8);
+      else
+        printFixed(&out, &spec, va_arg(ap, int), 16);
+      break;
+
+    case 'r':
+      if (length == -1)
+        printFixed(&out, &spec, (short)va_arg(ap, int), 15);
+      else
+        printFixed(&out, &spec, va_arg(ap, int), 31);
+      break;
+
+    case 'c':
+    {
+      char ch = (char)va_arg(ap, int);
+
+      spec.flags &= ~FLAG_ZERO;
+      printField(&out, &spec, 0, 0, &ch, 1, 0);
+      break;
+    }
+
+    case 's':
+    {
+      const char *pString = va_arg(ap, const char *);
+      int         len     = 0;
+
+      if (pString == 0)
+        pString = "(null)";
+      while ((spec.prec < 0 || len < spec.prec) && pString[len] != '\0')
+        len++;
+      spec.flags &= ~FLAG_ZERO;
+      printField(&out, &spec, 0, 0, pString, len, 0);
+      break;
+    }
+
+    case 'n':
+      *va_arg(ap, int *) = out.count;
+      break;
+
+    case '%':
+      emit(&out, "%", 1);
+      break;
+
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      (void)va_arg(ap, double);
+      emit(&out, pStart, fmt - pStart);         /* no floating point */
+      break;
+
+    case '\0':
+      fmt--;
+      /* fall through */
+    default:
+      emit(&out, pStart, fmt - pStart);         /* not supported: as written */
+      break;
+    }
+  }
+}
@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ * Description:
+ *    Integer-only formatted output without heap or static state, used by
+ *    simplePrintf() (consol.c) and by the printf() replacement of the dhry
+ *    runtime (dhry/printf.c). The text goes to a sink in chunks: runs of
+ *    the format string as they are, each field as one piece.
+ *
+ *    %[flags][width][.precision][length]conversion
+ *
+ *    flags       - left-justify, 0 pad with zeros, + and space sign,
+ *                # 0x/0 prefix for x and o
+ *    width       number or *, minimum field width
+ *    precision   number or *, minimum digits (d i u x X o), maximum
+ *                characters (s), decimals (q r)
+ *    length      hh h l ll; l is 32 bits, ll 64
+ *    conversion  d i u x X o c s p %, and for fixed point:
+ *                q   signed Q16.16 (int)     hq  signed Q8.8, e.g. an LM75
+ *                r   signed Q1.31 (int)      hr  signed Q1.15     register
+ *
+ *    q and r round to the precision, by default as many decimals as the
+ *    fraction resolves (5 for Q16.16 and Q1.15, 3 for Q8.8, 9 for Q1.31).
+ *    Floating point conversions (f e g a) are not supported; they, and any
+ *    other unknown conversion, are copied to the output as written.
+ *
+ *****************************************************************************/
+#ifndef _format_h_
+#define _format_h_
+
+/******************************************************************************
+ * Includes
+ *****************************************************************************/
+#include <stdarg.h>
+
+/******************************************************************************
+ * Defines, macros, and typedefs
+ *****************************************************************************/
+
+/* receives 'len' characters at 'buf'; 'arg' is the one given to formatPrint */
+typedef void (*tFormatSink)(void *arg, const char *buf, int len);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * Public functions
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Description:
+ *    Format 'fmt' with the arguments in 'ap' into 'sink'.
+ *
+ * Returns:
+ *    int - number of characters produced
+ *
+ ****************************************************************************/
+int formatPrint(tFormatSink sink, void *arg, const char *fmt, va_list ap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -437,13 +437,15 @@ char * _sbrk_r (struct _reent *ptr, int nbytes)
 
     if (!heap_ptr)  // if it is the very first time for memory allocation.
 //	   heap_ptr = (char *)&_heap_begin;      // the begining of the heap memory.
-	   heap_ptr = pHeapStart;
+	   heap_ptr = (char *)pHeapStart;
 
+    // out of heap memory: the stacks start at pHeapEnd, malloc() returns NULL
+    if ( nbytes > (char *)pHeapEnd - heap_ptr || nbytes < (char *)pHeapStart - heap_ptr ) {
+        ptr->_errno = ENOMEM;
+        return (char *)-1;
+    }
     base = heap_ptr;
     heap_ptr += nbytes;
-//    if ( heap_ptr >= ( char *) &_heap_end )
-    if ( heap_ptr >= pHeapEnd )
-        _exit_r( 666);  // out of heap memory!!!
     return base;
 }
 